@@ -1,62 +1,71 @@
-import hashlib
 import sys
+import time
 import logging
 import glob
-import subprocess
 import re
 import json
 import argparse
 from typing import Optional, List, Dict, Any, Callable
 from PySide6.QtWidgets import (
     QApplication, QMainWindow, QWidget, QVBoxLayout, QHBoxLayout,
-    QTreeWidget, QTreeWidgetItem, QLabel, QStatusBar, QMenu,
+    QTreeView, QAbstractItemView, QLabel, QStatusBar, QMenu,
     QFileDialog, QMessageBox, QInputDialog, QSplitter, QGroupBox,
     QDialog, QDialogButtonBox, QLineEdit, QFormLayout, QPushButton,
     QProgressDialog, QCheckBox, QComboBox
 )
 from PySide6.QtGui import QAction, QDragEnterEvent, QDragLeaveEvent, QDragMoveEvent, QDropEvent
-from PySide6.QtCore import Qt, QPoint, Signal, QThread
+from PySide6.QtCore import Qt, QPoint, Signal, QThread, QTimer, QObject
 import os
 import traceback
-from iso_logic import ISOCore, TreeNode
+from iso_logic import ISOCore, TreeNode, ExtractionEngine, ImportEngine
+from checksums import ALGORITHM_NAMES, default_algorithms, hash_file
+from index_cache import IndexCache
+from tree_model import ISOTreeModel
+from search_index import SearchIndex, SearchQuery
+from ripper import DiscRipper
+from layout_planner import fitting_media
+from scheduler import (Job, JobScheduler, shared_scheduler,
+                       PRIORITY_INTERACTIVE, PRIORITY_NORMAL, PRIORITY_BACKGROUND)
+import profiler
+from profiler import ThroughputMeter
 from commands import (
     CommandHistory, AddFileCommand, RemoveNodeCommand,
-    AddFolderCommand, RenameNodeCommand
+    AddFolderCommand, RenameNodeCommand, ImportCommand
 )
 from constants import (
-    VERSION, APP_NAME,
+    VERSION, APP_NAME, ISO_BLOCK_SIZE,
     MAX_VOLUME_ID_LENGTH, MAX_SYSTEM_ID_LENGTH,
     JOLIET_MAX_FILENAME_LENGTH, MAX_RECENT_FILES,
     DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT,
     DEFAULT_LEFT_PANE_WIDTH, DEFAULT_RIGHT_PANE_WIDTH,
     TREE_COLUMN_NAME_WIDTH, TREE_COLUMN_SIZE_WIDTH,
     TREE_COLUMN_DATE_WIDTH, TREE_COLUMN_TYPE_WIDTH,
-    FILE_READ_BUFFER_SIZE, DVD_SIZE_BYTES,
-    PROCESS_TERMINATE_TIMEOUT_SEC,
     DRAG_BORDER_COLOR, DRAG_BACKGROUND_COLOR,
     BOOT_PLATFORM_X86, BOOT_PLATFORM_POWERPC,
     BOOT_PLATFORM_MAC, BOOT_PLATFORM_EFI,
     CONFIG_DIR_NAME, CONFIG_SUBDIR_NAME,
+    CACHE_DIR_NAME, INDEX_CACHE_SUBDIR_NAME, INDEX_CACHE_MAX_ENTRIES,
     RECENT_FILES_FILENAME, SETTINGS_FILENAME, LOG_FILENAME,
-    ISO_FILE_FILTER, ISO_SAVE_FILTER, BOOT_IMAGE_FILTER,
+    ISO_FILE_FILTER, ISO_SAVE_FILTER, CUE_FILE_FILTER, BOOT_IMAGE_FILTER,
     STATUS_READY, STATUS_MODIFIED_SUFFIX,
-    ITEM_TYPE_FILE, ITEM_TYPE_DIRECTORY,
     DEFAULT_LOG_LEVEL, DEFAULT_LOG_FORMAT,
+    DEFAULT_INCREMENTAL_SAVE, DEFAULT_COMPACT_TREE, DEFAULT_DEDUPLICATE,
+    SEARCH_DEBOUNCE_MS, MEDIA_CAPACITIES, PROGRESS_INTERVAL_SEC,
 )
 
 logger = logging.getLogger(__name__)
 
 IS_LINUX = sys.platform.startswith('linux')
 
-class DroppableTreeWidget(QTreeWidget):
+class DroppableTreeView(QTreeView):
     """
-    A QTreeWidget that supports drag and drop of files and folders.
+    A QTreeView that supports drag and drop of files and folders.
     """
     filesDropped = Signal(list)
 
     def __init__(self, parent: Optional[QWidget] = None) -> None:
         """
-        Initializes the DroppableTreeWidget.
+        Initializes the DroppableTreeView.
 
         Args:
             parent (QWidget, optional): The parent widget.
@@ -79,7 +88,7 @@ class DroppableTreeWidget(QTreeWidget):
             if not self._original_style:
                 self._original_style = self.styleSheet()
             self.setStyleSheet(self._original_style +
-                             f"\nQTreeWidget {{ border: 2px solid {DRAG_BORDER_COLOR}; background-color: {DRAG_BACKGROUND_COLOR}; }}")
+                             f"\nQTreeView {{ border: 2px solid {DRAG_BORDER_COLOR}; background-color: {DRAG_BACKGROUND_COLOR}; }}")
         else:
             super().dragEnterEvent(event)
 
@@ -129,9 +138,15 @@ class DroppableTreeWidget(QTreeWidget):
 class SaveAsDialog(QDialog):
     """
     A dialog for saving an ISO with options for UDF and Hybrid ISO.
+
+    Given the core, it shows the planned size of the image for the chosen
+    options and the media it fits on.
     """
-    def __init__(self, parent: Optional[QWidget] = None) -> None:
+    def __init__(self, parent: Optional[QWidget] = None, core: Optional[ISOCore] = None) -> None:
         super().__init__(parent)
+        self.core: Optional[ISOCore] = core
+        # Plans by (use_udf, make_hybrid), so toggling options does not walk the tree again
+        self._plans: Dict[tuple, Any] = {}
         self.setWindowTitle("Save ISO As")
         self.layout = QVBoxLayout(self)
 
@@ -158,11 +173,42 @@ class SaveAsDialog(QDialog):
         self.hybrid_checkbox.setToolTip("Create a hybrid ISO that can boot from both CD/DVD and USB drives")
         form_layout.addRow(self.hybrid_checkbox)
 
+        self.incremental_checkbox = QCheckBox("Only rewrite changed files when possible")
+        self.incremental_checkbox.setChecked(DEFAULT_INCREMENTAL_SAVE)
+        self.incremental_checkbox.setToolTip("Copy the loaded image and patch only the overwritten files into it. "
+                                             "New boot images of the same size and isohybrid are patched in too. "
+                                             "Falls back to a full rebuild if files were added, removed or renamed")
+        form_layout.addRow(self.incremental_checkbox)
+
+        self.dedup_checkbox = QCheckBox("Store identical files once")
+        self.dedup_checkbox.setChecked(DEFAULT_DEDUPLICATE)
+        self.dedup_checkbox.setToolTip("Files with the same contents share one copy of the data in the image. "
+                                       "Makes the image smaller, but every candidate file is read once more before writing")
+        form_layout.addRow(self.dedup_checkbox)
+
         self.checksum_checkbox = QCheckBox("Verify checksums after saving")
         self.checksum_checkbox.setChecked(True)
         self.checksum_checkbox.setToolTip("Calculate MD5, SHA-1, and SHA-256 checksums after saving for verification")
         form_layout.addRow(self.checksum_checkbox)
 
+        self.media_combo = QComboBox()
+        self.media_combo.addItem("Any size", None)
+        for name, capacity in MEDIA_CAPACITIES.items():
+            self.media_combo.addItem(f"{name} ({capacity / (1024 ** 3):.1f} GB)", capacity)
+        self.media_combo.setToolTip("Stop before writing if the image would not fit on this medium")
+        form_layout.addRow("Target media:", self.media_combo)
+
+        self.plan_label = QLabel()
+        self.plan_label.setWordWrap(True)
+        form_layout.addRow("Planned size:", self.plan_label)
+        if core is None:
+            self.plan_label.setText("-")
+        else:
+            self.udf_checkbox.toggled.connect(self.update_plan)
+            self.hybrid_checkbox.toggled.connect(self.update_plan)
+            self.media_combo.currentIndexChanged.connect(self.update_plan)
+            self.update_plan()
+
         self.layout.addLayout(form_layout)
 
         self.buttons = QDialogButtonBox(QDialogButtonBox.Save | QDialogButtonBox.Cancel, self)
@@ -170,6 +216,20 @@ class SaveAsDialog(QDialog):
         self.buttons.rejected.connect(self.reject)
         self.layout.addWidget(self.buttons)
 
+    def update_plan(self) -> None:
+        """Shows the planned size of the image for the current options."""
+        key = (self.udf_checkbox.isChecked(), self.hybrid_checkbox.isChecked())
+        plan = self._plans.get(key)
+        if plan is None:
+            plan = self._plans[key] = self.core.plan_layout(use_udf=key[0], make_hybrid=key[1])
+        size = plan.total_size
+        media = fitting_media(size)
+        text = f"{size / (1024 * 1024):,.1f} MB ({plan.total_sectors:,} sectors), fits on {', '.join(media) or 'none of the listed media'}"
+        max_size = self.media_combo.currentData()
+        if max_size is not None and size > max_size:
+            text += f"<br><b>Too large for {self.media_combo.currentText()}</b>"
+        self.plan_label.setText(text)
+
     def browse(self) -> None:
         file_path, _ = QFileDialog.getSaveFileName(self, "Save ISO As", "", ISO_SAVE_FILTER)
         if file_path:
@@ -211,7 +271,10 @@ class SaveAsDialog(QDialog):
             'file_path': self.file_path_edit.text().strip(),
             'use_udf': self.udf_checkbox.isChecked(),
             'make_hybrid': self.hybrid_checkbox.isChecked(),
-            'calculate_checksums': self.checksum_checkbox.isChecked()
+            'incremental': self.incremental_checkbox.isChecked(),
+            'deduplicate': self.dedup_checkbox.isChecked(),
+            'calculate_checksums': self.checksum_checkbox.isChecked(),
+            'max_size': self.media_combo.currentData()
         }
 
 class PropertiesDialog(QDialog):
@@ -479,20 +542,52 @@ class RipDiscDialog(QDialog):
 class ISOEditor(QMainWindow):
     """
     The main window of the ISO Editor application.
+
+    Every window is a session of its own with one ISOCore; all of them share
+    the index cache, the image block cache and the job scheduler.
     """
-    def __init__(self):
-        """Initializes the ISOEditor main window."""
+    # Open windows, so that windows opened from a menu are kept alive
+    windows: List['ISOEditor'] = []
+
+    def __init__(self, index_cache: Optional[IndexCache] = None):
+        """
+        Initializes the ISOEditor main window.
+
+        Args:
+            index_cache (IndexCache): The index cache of the window this one was
+                opened from; the first window creates it and warms it.
+        """
         super().__init__()
         self.setWindowTitle(APP_NAME)
         self.setGeometry(100, 100, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT)
-        self.core = ISOCore()
+        self.scheduler: JobScheduler = shared_scheduler()
+        first_window = index_cache is None
+        self.index_cache = index_cache or IndexCache(self.get_index_cache_dir(), max_entries=INDEX_CACHE_MAX_ENTRIES)
+        self.core = ISOCore(compact_tree=DEFAULT_COMPACT_TREE, index_cache=self.index_cache)
         self.command_history = CommandHistory(max_history=50)
-        self.tree_item_map = {}
+        self.search_index = SearchIndex(self.core)
+        self.search_index_thread: Optional[SearchIndexWorker] = None
+        self.search_thread: Optional[SearchWorker] = None
+        # Bumped whenever a running search's result would be out of date
+        self.search_generation = 0
+        self.search_timer = QTimer(self)
+        self.search_timer.setSingleShot(True)
+        self.search_timer.setInterval(SEARCH_DEBOUNCE_MS)
+        self.search_timer.timeout.connect(self.run_search)
         self.show_hidden = False
         self.dark_mode = False
         self.recent_files = self.load_recent_files()
         self.max_recent_files = MAX_RECENT_FILES
 
+        # Index the recent images in the background so reopening them is fast, one job per image.
+        self.index_warm_jobs: List[Job] = []
+        if first_window:
+            for path in self.recent_files:
+                self.index_warm_jobs.append(self.scheduler.submit(
+                    lambda job, path=path: self.index_cache.warm([path], is_cancelled=job.is_cancelled),
+                    name=f"index {os.path.basename(path)}", paths=[path], priority=PRIORITY_BACKGROUND))
+        ISOEditor.windows.append(self)
+
         self.create_menu()
         self.create_main_interface()
         self.create_status_bar()
@@ -518,6 +613,18 @@ class ISOEditor(QMainWindow):
         open_action.triggered.connect(self.open_iso)
         file_menu.addAction(open_action)
 
+        new_window_action = QAction("New &Window", self)
+        new_window_action.setShortcut("Ctrl+Shift+N")
+        new_window_action.setStatusTip("Open another window to edit a second image")
+        new_window_action.triggered.connect(self.new_window)
+        file_menu.addAction(new_window_action)
+
+        open_window_action = QAction("Open in New W&indow...", self)
+        open_window_action.setShortcut("Ctrl+Shift+O")
+        open_window_action.setStatusTip("Open an ISO or CUE file in another window")
+        open_window_action.triggered.connect(self.open_in_new_window)
+        file_menu.addAction(open_window_action)
+
         # Recent Files submenu
         self.recent_menu = file_menu.addMenu("Recent &Files")
         self.update_recent_files_menu()
@@ -529,6 +636,11 @@ class ISOEditor(QMainWindow):
             rip_disc_action.triggered.connect(self.rip_disc)
             file_menu.addAction(rip_disc_action)
 
+        convert_cue_action = QAction("&Convert CUE/BIN to ISO...", self)
+        convert_cue_action.setStatusTip("Write the data track of a CUE/BIN image as an ISO file")
+        convert_cue_action.triggered.connect(self.convert_cue)
+        file_menu.addAction(convert_cue_action)
+
         file_menu.addSeparator()
 
         save_action = QAction("&Save ISO", self)
@@ -547,8 +659,8 @@ class ISOEditor(QMainWindow):
 
         exit_action = QAction("E&xit", self)
         exit_action.setShortcut("Ctrl+Q")
-        exit_action.setStatusTip("Exit the application")
-        exit_action.triggered.connect(self.close)
+        exit_action.setStatusTip("Close every window and exit the application")
+        exit_action.triggered.connect(QApplication.closeAllWindows)
         file_menu.addAction(exit_action)
 
         # Edit Menu
@@ -700,8 +812,12 @@ class ISOEditor(QMainWindow):
         search_layout.addWidget(self.regex_checkbox)
         right_layout.addLayout(search_layout)
 
-        self.tree = DroppableTreeWidget()
-        self.tree.setHeaderLabels(['Name', 'Size', 'Date Modified', 'Type'])
+        self.tree_model = ISOTreeModel(self.core, self.format_file_size, parent=self)
+        self.tree_model.show_hidden = self.show_hidden
+        self.tree = DroppableTreeView()
+        self.tree.setModel(self.tree_model)
+        # Every row has the same height, so Qt can lay out huge directories without measuring them.
+        self.tree.setUniformRowHeights(True)
         self.tree.setToolTip("Drag and drop files or folders here to add them to the ISO.\nRight-click for more options.")
         self.tree.filesDropped.connect(self.handle_drop)
         self.tree.setColumnWidth(0, TREE_COLUMN_NAME_WIDTH)
@@ -710,7 +826,7 @@ class ISOEditor(QMainWindow):
         self.tree.setColumnWidth(3, TREE_COLUMN_TYPE_WIDTH)
         self.tree.setContextMenuPolicy(Qt.CustomContextMenu)
         self.tree.customContextMenuRequested.connect(self.show_context_menu)
-        self.tree.setSelectionMode(self.tree.ExtendedSelection)  # Allow multi-selection
+        self.tree.setSelectionMode(QAbstractItemView.ExtendedSelection)  # Allow multi-selection
         right_layout.addWidget(self.tree)
 
         self.splitter.addWidget(right_pane)
@@ -722,7 +838,7 @@ class ISOEditor(QMainWindow):
         """Undo the last command."""
         description = self.command_history.undo()
         if description:
-            self.refresh_view()
+            self.update_view_state()
             self.update_undo_redo_actions()
             self.update_status(f"Undone: {description}")
             logger.info(f"Undone: {description}")
@@ -731,7 +847,7 @@ class ISOEditor(QMainWindow):
         """Redo the last undone command."""
         description = self.command_history.redo()
         if description:
-            self.refresh_view()
+            self.update_view_state()
             self.update_undo_redo_actions()
             self.update_status(f"Redone: {description}")
             logger.info(f"Redone: {description}")
@@ -809,17 +925,17 @@ class ISOEditor(QMainWindow):
             }
 
             /* Tree Widget */
-            QTreeWidget {
+            QTreeView {
                 background-color: #1e1e1e;
                 color: #d4d4d4;
                 border: 1px solid #3c3c3c;
                 selection-background-color: #37373d;
                 alternate-background-color: #252526;
             }
-            QTreeWidget::item:hover {
+            QTreeView::item:hover {
                 background-color: #2a2d2e;
             }
-            QTreeWidget::item:selected {
+            QTreeView::item:selected {
                 background-color: #37373d;
                 color: #ffffff;
             }
@@ -1044,73 +1160,76 @@ class ISOEditor(QMainWindow):
         self.search_input.selectAll()
 
     def filter_tree(self):
-        """Filters the tree view based on search text."""
-        search_text = self.search_input.text()
-
-        if not search_text:
+        """Filters the tree view based on search text, once typing pauses."""
+        self.search_generation += 1
+        if not self.search_input.text():
             # Show all items if search is empty
-            self._set_all_items_visible(True)
+            self.search_timer.stop()
+            self.tree_model.set_visible_nodes(None)
+            self.tree.expand(self.tree_model.index(0, 0))
             return
+        self.search_timer.start()
 
-        case_sensitive = self.case_sensitive_checkbox.isChecked()
-        use_regex = self.regex_checkbox.isChecked()
-
-        # Prepare search pattern
-        if use_regex:
-            try:
-                import re
-                flags = 0 if case_sensitive else re.IGNORECASE
-                pattern = re.compile(search_text, flags)
-            except re.error as e:
-                logger.warning(f"Invalid regex pattern: {e}")
-                self.update_status(f"Invalid regex: {e}")
-                return
-        else:
-            pattern = search_text if case_sensitive else search_text.lower()
-
-        # Filter items
-        self._filter_tree_items(self.tree.invisibleRootItem(), pattern, use_regex, case_sensitive)
-
-    def _set_all_items_visible(self, visible):
-        """Sets visibility for all tree items."""
-        def set_visible_recursive(item):
-            item.setHidden(not visible)
-            for i in range(item.childCount()):
-                set_visible_recursive(item.child(i))
-
-        root = self.tree.invisibleRootItem()
-        for i in range(root.childCount()):
-            set_visible_recursive(root.child(i))
-
-    def _filter_tree_items(self, parent_item, pattern, use_regex, case_sensitive):
-        """
-        Recursively filters tree items based on pattern.
-        Returns True if this item or any child matches.
-        """
-        any_child_visible = False
-
-        for i in range(parent_item.childCount()):
-            child = parent_item.child(i)
-            child_name = child.text(0).replace(" [NEW]", "")  # Remove [NEW] tag for matching
-
-            # Check if this item matches
-            if use_regex:
-                matches = bool(pattern.search(child_name))
-            else:
-                search_name = child_name if case_sensitive else child_name.lower()
-                matches = pattern in search_name
+    def run_search(self):
+        """Starts a background search of the index for the current filter text."""
+        search_text = self.search_input.text()
+        if not search_text:
+            return
+        if self.search_thread is not None and self.search_thread.isRunning():
+            # finish_search() starts again once the running search stops.
+            self.search_thread.cancel()
+            return
 
-            # Recursively check children
-            child_has_visible_children = self._filter_tree_items(child, pattern, use_regex, case_sensitive)
+        try:
+            query = SearchQuery(search_text, case_sensitive=self.case_sensitive_checkbox.isChecked(),
+                                use_regex=self.regex_checkbox.isChecked())
+        except re.error as e:
+            logger.warning(f"Invalid regex pattern: {e}")
+            self.update_status(f"Invalid regex: {e}")
+            return
 
-            # Show item if it matches or has visible children
-            should_show = matches or child_has_visible_children
-            child.setHidden(not should_show)
+        self.search_thread = SearchWorker(self.search_index, query, self.search_generation)
+        self.search_thread.finished.connect(self.finish_search)
+        self.search_thread.start()
 
-            if should_show:
-                any_child_visible = True
+    def finish_search(self, entries, query, generation):
+        """Shows the matches of a finished search, and their ancestors."""
+        if generation != self.search_generation:
+            if self.search_input.text():
+                self.run_search()
+            return
+        if entries is None:
+            return
 
-        return any_child_visible
+        root = self.core.directory_tree
+        visible = [root] if root is not None else []
+        seen = set()
+        matches = self.search_index.resolve(entries, query)
+        for node in matches:
+            ancestor = node
+            while ancestor is not None and ancestor is not root and id(ancestor) not in seen:
+                seen.add(id(ancestor))
+                visible.append(ancestor)
+                ancestor = ancestor.get('parent')
+        self.tree_model.set_visible_nodes(visible)
+        self.tree.expand(self.tree_model.index(0, 0))
+        self.update_status(f"{len(matches)} match(es) for '{query.text}'")
+
+    def rebuild_search_index(self):
+        """Re-indexes names after the tree was replaced; images are indexed in the background."""
+        self.stop_search_index()
+        self.search_generation += 1
+        self.search_index.reset()
+        if not self.search_index.wait_ready(0):
+            self.search_index_thread = SearchIndexWorker(self.search_index)
+            self.search_index_thread.start()
+
+    def stop_search_index(self):
+        """Stops building the search index, e.g. before the image it reads is closed."""
+        if self.search_index_thread is not None:
+            self.search_index_thread.cancel()
+            self.search_index_thread.wait()
+            self.search_index_thread = None
 
     def open_iso(self):
         """Opens an ISO file and loads it into the editor."""
@@ -1122,6 +1241,19 @@ class ISOEditor(QMainWindow):
 
         self._load_iso_with_progress(file_path)
 
+    def new_window(self) -> 'ISOEditor':
+        """Opens another window with an empty image, sharing this window's caches and scheduler."""
+        window = ISOEditor(index_cache=self.index_cache)
+        window.move(self.pos() + QPoint(30, 30))
+        window.show()
+        return window
+
+    def open_in_new_window(self):
+        """Opens an image in another window, keeping the one in this window open."""
+        file_path, _ = QFileDialog.getOpenFileName(self, "Open Image in New Window", "", ISO_FILE_FILTER)
+        if file_path:
+            self.new_window()._load_iso_with_progress(file_path)
+
     def _load_iso_with_progress(self, file_path):
         """Loads an ISO file with progress dialog."""
         self.load_progress_dialog = QProgressDialog("Loading ISO...", "Cancel", 0, 100, self)
@@ -1130,6 +1262,9 @@ class ISOEditor(QMainWindow):
         self.load_progress_dialog.setAutoClose(True)
         self.load_progress_dialog.setMinimumDuration(0)  # Show immediately
 
+        # The worker replaces the tree, so the view and the search index must stop reading it first.
+        self.tree_model.clear()
+        self.stop_search_index()
         self.load_thread = LoadWorker(self.core, file_path)
         self.load_thread.progress.connect(self.update_load_progress)
         self.load_thread.finished.connect(lambda: self.load_finished(file_path))
@@ -1196,12 +1331,13 @@ class ISOEditor(QMainWindow):
             self.save_iso_as()
         else:
             # When re-saving, we don't show the options dialog, so we use default values.
-            self._perform_save(self.core.current_iso_path, use_udf=True, make_hybrid=False, calculate_checksums=False)
+            self._perform_save(self.core.current_iso_path, use_udf=True, make_hybrid=False, calculate_checksums=False,
+                               incremental=DEFAULT_INCREMENTAL_SAVE)
 
     def save_iso_as(self):
         """Saves the current ISO to a new path."""
         logger.info("Save ISO As action triggered.")
-        dialog = SaveAsDialog(self)
+        dialog = SaveAsDialog(self, self.core)
         if dialog.exec():
             options = dialog.get_options()
             if options['file_path']:
@@ -1209,14 +1345,18 @@ class ISOEditor(QMainWindow):
                     options['file_path'],
                     options['use_udf'],
                     options['make_hybrid'],
-                    options['calculate_checksums']
+                    options['calculate_checksums'],
+                    options['incremental'],
+                    options['deduplicate'],
+                    options['max_size']
                 )
             else:
                 logger.info("Save As dialog cancelled.")
         else:
             logger.info("Save As dialog cancelled.")
 
-    def _perform_save(self, file_path, use_udf, make_hybrid, calculate_checksums=False):
+    def _perform_save(self, file_path, use_udf, make_hybrid, calculate_checksums=False, incremental=False,
+                      deduplicate=DEFAULT_DEDUPLICATE, max_size=None):
         """
         Performs the save operation, including filename validation.
         """
@@ -1246,7 +1386,11 @@ class ISOEditor(QMainWindow):
         self.progress_dialog.setAutoClose(True)
         self.progress_dialog.canceled.connect(self.cancel_save)
 
-        self.save_thread = SaveWorker(self.core, file_path, use_udf, make_hybrid)
+        # Full rebuilds hash the image while writing it; see save_finished()
+        checksum_algorithms = default_algorithms() if calculate_checksums else None
+        self.throughput = ThroughputMeter()
+        self.save_thread = SaveWorker(self.core, file_path, use_udf, make_hybrid, incremental, checksum_algorithms,
+                                      deduplicate, max_size)
         self.save_thread.progress.connect(self.update_progress)
         self.save_thread.finished.connect(self.save_finished)
         self.save_thread.error.connect(self.save_error)
@@ -1254,8 +1398,16 @@ class ISOEditor(QMainWindow):
         self.save_thread.start()
         self.progress_dialog.exec()
 
-    def update_progress(self, value):
-        self.progress_dialog.setValue(value)
+    def update_progress(self, done, total):
+        percent = (done * 100) // total if total else 0
+        self.progress_dialog.setValue(min(percent, 99))
+        self.progress_dialog.setLabelText(f"Writing ISO... {self.format_file_size(done)} of {self.format_file_size(total)}")
+        self.show_throughput("Writing ISO", done)
+
+    def show_throughput(self, activity, done):
+        """Shows the live rate of the running operation in the status bar."""
+        rate = self.throughput.update(done)
+        self.status_bar.showMessage(f"{activity}... {rate / 1e6:.1f} MB/s")
 
     def cancel_save(self):
         if self.save_thread.isRunning():
@@ -1268,7 +1420,10 @@ class ISOEditor(QMainWindow):
         self.update_status(f"Successfully saved to {os.path.basename(file_path)}")
         logger.info(f"ISO saved successfully to {file_path}")
 
-        if self.should_calculate_checksums:
+        if self.should_calculate_checksums and self.save_thread.checksums:
+            self.checksum_finished(self.save_thread.checksums, "")
+        elif self.should_calculate_checksums:
+            # Incremental saves patch a copy of the image, so it has to be read back.
             self.update_status(f"Saved. Now calculating checksums for {os.path.basename(file_path)}...")
             self.checksum_thread = ChecksumWorker(file_path)
             self.checksum_thread.finished.connect(self.checksum_finished)
@@ -1282,10 +1437,8 @@ class ISOEditor(QMainWindow):
             self.update_status("Error calculating checksums.")
             return
 
-        checksum_text = (f"Checksums for {os.path.basename(self.core.current_iso_path)}:\n\n"
-                         f"MD5:    {hashes['md5']}\n"
-                         f"SHA-1:  {hashes['sha1']}\n"
-                         f"SHA-256: {hashes['sha256']}")
+        lines = [f"{ALGORITHM_NAMES.get(name, name)}: {digest}" for name, digest in hashes.items()]
+        checksum_text = f"Checksums for {os.path.basename(self.core.current_iso_path)}:\n\n" + "\n".join(lines)
 
         QMessageBox.information(self, "Checksums", checksum_text)
         self.update_status("Checksum calculation complete.")
@@ -1316,6 +1469,7 @@ class ISOEditor(QMainWindow):
 
             self.rip_thread = RipDiscWorker(options['drive'], options['output_path'])
             self.rip_thread.progress.connect(self.update_rip_progress)
+            self.rip_thread.status.connect(self.rip_progress_dialog.setLabelText)
             self.rip_thread.finished.connect(self.rip_finished)
             self.rip_progress_dialog.canceled.connect(self.rip_thread.stop) # Connect cancel button
 
@@ -1331,262 +1485,61 @@ class ISOEditor(QMainWindow):
             QMessageBox.critical(self, "Ripping Failed", error_message)
             self.update_status("Disc ripping failed.")
         else:
-            QMessageBox.information(self, "Success", "Disc has been successfully ripped to an ISO file.")
+            ripper = self.rip_thread.ripper
+            message = "Disc has been successfully ripped to an ISO file."
+            if ripper.bad_sectors:
+                message += (f"\n\n{len(ripper.bad_sectors)} sector(s) could not be read and were filled with zeros. "
+                            f"They are listed in {os.path.basename(ripper.destination)}.badsectors.")
+            if ripper.checksums:
+                message += "\n\n" + "\n".join(f"{ALGORITHM_NAMES.get(name, name)}: {digest}"
+                                              for name, digest in ripper.checksums.items())
+            QMessageBox.information(self, "Success", message)
             self.update_status("Disc ripping complete.")
 
-class SaveWorker(QThread):
-    progress = Signal(int)
-    finished = Signal(str)
-    error = Signal(str)
-
-    def __init__(self, core: ISOCore, file_path: str, use_udf: bool, make_hybrid: bool) -> None:
-        super().__init__()
-        self.core: ISOCore = core
-        self.file_path: str = file_path
-        self.use_udf: bool = use_udf
-        self.make_hybrid: bool = make_hybrid
-        self._cancelled: bool = False
-
-    def cancel(self) -> None:
-        """Request cancellation of the save operation."""
-        self._cancelled = True
-
-    def run(self) -> None:
-        try:
-            # The progress callback for pycdlib's write method
-            def progress_cb(done, total, opaque):
-                if self._cancelled:
-                    raise InterruptedError("Save operation cancelled by user")
-                percent = (done * 100) // total
-                self.progress.emit(percent)
-
-            self.core.save_iso(self.file_path, use_joliet=True, use_rock_ridge=True, progress_callback=progress_cb, use_udf=self.use_udf, make_hybrid=self.make_hybrid)
-            if not self._cancelled:
-                self.finished.emit(self.file_path)
-        except InterruptedError as e:
-            logger.info(f"Save operation cancelled: {e}")
-            self.error.emit("Save cancelled by user")
-        except Exception as e:
-            logger.exception(f"Error during save operation: {e}")
-            self.error.emit(str(e))
-
-
-class ChecksumWorker(QThread):
-    """
-    A QThread worker for calculating file checksums in the background.
-    """
-    # Signal -> dict: e.g., {'md5': '...', 'sha1': '...', 'sha256': '...'}
-    #           str:  Error message if something goes wrong.
-    finished = Signal(dict, str)
-
-    def __init__(self, file_path: str) -> None:
-        super().__init__()
-        self.file_path: str = file_path
-        self._cancelled: bool = False
-
-    def cancel(self) -> None:
-        """Request cancellation of the checksum calculation."""
-        self._cancelled = True
-
-    def run(self) -> None:
-        """
-        Calculates MD5, SHA1, and SHA256 hashes for the file.
-        """
-        try:
-            hashes = {'md5': hashlib.md5(), 'sha1': hashlib.sha1(), 'sha256': hashlib.sha256()}
-            with open(self.file_path, 'rb') as f:
-                while chunk := f.read(FILE_READ_BUFFER_SIZE):
-                    if self._cancelled:
-                        logger.info("Checksum calculation cancelled by user")
-                        self.finished.emit({}, "Checksum calculation cancelled")
-                        return
-                    for h in hashes.values():
-                        h.update(chunk)
-
-            if not self._cancelled:
-                results = {name: h.hexdigest() for name, h in hashes.items()}
-                self.finished.emit(results, "")
-        except Exception as e:
-            logger.error(f"Checksum calculation failed for {self.file_path}: {e}")
-            self.finished.emit({}, f"Failed to calculate checksums: {e}")
-
-
-class LoadWorker(QThread):
-    """
-    A QThread worker for loading ISO files in the background with progress reporting.
-    """
-    progress = Signal(int, str)  # percent, status message
-    finished = Signal()
-    error = Signal(str)
-
-    def __init__(self, core: ISOCore, file_path: str) -> None:
-        super().__init__()
-        self.core: ISOCore = core
-        self.file_path: str = file_path
-        self._cancelled: bool = False
-
-    def cancel(self) -> None:
-        """Request cancellation of the load operation."""
-        self._cancelled = True
-
-    def run(self) -> None:
-        """Load the ISO with progress updates."""
-        try:
-            self.progress.emit(10, "Opening ISO file...")
-            if self._cancelled:
-                return
-
-            # Initialize
-            self.core.init_new_iso()
-
-            _, extension = os.path.splitext(self.file_path)
-
-            if extension.lower() == '.cue':
-                self.progress.emit(30, "Parsing CUE sheet...")
-                if self._cancelled:
-                    return
-
-                self.core._load_cue_sheet(self.file_path)
-                self.core.current_iso_path = self.file_path
-                self.core.iso_modified = False
-                self.progress.emit(100, "Complete")
-
-            else:
-                # Load regular ISO
-                import pycdlib
-
-                self.progress.emit(25, "Reading ISO structure...")
-                if self._cancelled:
-                    return
-
-                iso = pycdlib.PyCdlib()
-                iso.open(self.file_path)
-
-                self.progress.emit(50, "Reading volume information...")
-                if self._cancelled:
-                    return
-
-                self.core._pycdlib_instance = iso
-                self.core.current_iso_path = self.file_path
-                self.core.is_joliet = iso.has_joliet()
-
-                if self.core.is_joliet and iso.joliet_vd:
-                    self.core.volume_descriptor['volume_id'] = iso.joliet_vd.volume_identifier.decode('utf-16-be', 'ignore').strip()
-                    self.core.volume_descriptor['system_id'] = iso.joliet_vd.system_identifier.decode('utf-16-be', 'ignore').strip()
-                elif iso.pvd:
-                    self.core.volume_descriptor['volume_id'] = iso.pvd.volume_identifier.decode('ascii', 'ignore').strip()
-                    self.core.volume_descriptor['system_id'] = iso.pvd.system_identifier.decode('ascii', 'ignore').strip()
-
-                self.progress.emit(75, "Building directory tree...")
-                if self._cancelled:
-                    return
-
-                self.core.directory_tree = self.core._build_tree_from_pycdlib()
-
-                self.progress.emit(90, "Extracting boot information...")
-                if self._cancelled:
-                    return
-
-                self.core._extract_boot_info()
-                self.core.iso_modified = False
-
-                self.progress.emit(100, "Complete")
-
-            if not self._cancelled:
-                self.finished.emit()
-
-        except FileNotFoundError:
-            self.core.init_new_iso()
-            logger.error(f"ISO file not found at path: {self.file_path}")
-            self.error.emit(f"ISO file not found:\n{self.file_path}\n\nPossible solutions:\n• Check if the file exists\n• Verify you have read permissions\n• Check if the path is correct")
-        except PermissionError:
-            self.core.init_new_iso()
-            logger.error(f"Permission denied accessing ISO: {self.file_path}")
-            self.error.emit(f"Permission denied:\n{self.file_path}\n\nPossible solutions:\n• Check file permissions\n• Try running with appropriate privileges\n• Check if the file is locked by another application")
-        except Exception as e:
-            self.core.init_new_iso()
-            logger.exception(f"An unexpected error occurred while loading the ISO: {e}")
-            self.error.emit(f"Failed to load ISO:\n{str(e)}\n\nPossible solutions:\n• Verify the file is a valid ISO or CUE file\n• Check if the file is corrupted\n• Try opening with another ISO tool to verify\n• Check available disk space")
-
-
-class RipDiscWorker(QThread):
-    """
-    A QThread worker for ripping a disc in the background using dd.
-    """
-    progress = Signal(int) # Percentage
-    finished = Signal(str) # Error message (if any)
-
-    def __init__(self, source_drive: str, dest_path: str) -> None:
-        super().__init__()
-        self.source_drive: str = source_drive
-        self.dest_path: str = dest_path
-        self._is_running: bool = True
-
-    def run(self) -> None:
-        """
-        Executes the dd command to rip the disc.
-        """
-        command = [
-            'dd',
-            f'if={self.source_drive}',
-            f'of={self.dest_path}',
-            'bs=2048',
-            'status=progress'
-        ]
-
-        try:
-            process = subprocess.Popen(command, stderr=subprocess.PIPE, text=True, encoding='utf-8')
-
-            # This is a simplification. A better implementation would get the disc size first.
-            # Using DVD size as the default assumption
-            disc_size_bytes = DVD_SIZE_BYTES
-
-            while self._is_running and process.poll() is None:
-                line = process.stderr.readline()
-                if line:
-                    match = re.search(r'(\d+)\s+bytes', line)
-                    if match:
-                        bytes_copied = int(match.group(1))
-                        percent = int((bytes_copied / disc_size_bytes) * 100)
-                        self.progress.emit(min(percent, 100))
-
-            if not self._is_running:
-                logger.info("Rip disc operation cancelled, terminating dd process")
-                process.terminate()
-                try:
-                    process.wait(timeout=PROCESS_TERMINATE_TIMEOUT_SEC)
-                except subprocess.TimeoutExpired:
-                    logger.warning("dd process did not terminate gracefully, killing it")
-                    process.kill()
-                    process.wait()
-
-                # Clean up partial output file
-                if os.path.exists(self.dest_path):
-                    try:
-                        os.remove(self.dest_path)
-                        logger.info(f"Removed partial output file: {self.dest_path}")
-                    except OSError as e:
-                        logger.error(f"Failed to remove partial output file: {e}")
-
-                self.finished.emit("Ripping cancelled by user.")
-                return
-
-            retcode = process.wait()
-            if retcode == 0:
-                self.progress.emit(100)
-                self.finished.emit("") # Success
-            else:
-                self.finished.emit(f"dd command failed with exit code {retcode}")
-
-        except FileNotFoundError:
-            self.finished.emit("Error: 'dd' command not found. Is it installed and in your PATH?")
-        except Exception as e:
-            logger.error(f"Disc ripping failed: {e}")
-            self.finished.emit(f"An unexpected error occurred: {e}")
-
-    def stop(self):
-        self._is_running = False
+    def convert_cue(self):
+        """Converts the data track of a CUE/BIN image to an ISO file."""
+        logger.info("Convert CUE action triggered.")
+        cue_path, _ = QFileDialog.getOpenFileName(self, "Convert CUE/BIN", "", CUE_FILE_FILTER)
+        if not cue_path:
+            return
+        default_output = os.path.splitext(cue_path)[0] + ".iso"
+        output_path, _ = QFileDialog.getSaveFileName(self, "Save ISO As", default_output, ISO_SAVE_FILTER)
+        if not output_path:
+            logger.info("Convert CUE dialog cancelled.")
+            return
 
+        self.convert_progress_dialog = QProgressDialog(f"Converting {os.path.basename(cue_path)}...", "Cancel", 0, 100, self)
+        self.convert_progress_dialog.setWindowModality(Qt.WindowModal)
+        self.convert_progress_dialog.setAutoClose(True)
+
+        self.throughput = ThroughputMeter()
+        self.convert_thread = ConvertCueWorker(cue_path, output_path)
+        self.convert_thread.progress.connect(self.update_convert_progress)
+        self.convert_thread.finished.connect(self.convert_finished)
+        self.convert_thread.error.connect(self.convert_error)
+        self.convert_progress_dialog.canceled.connect(self.convert_thread.cancel)
+
+        self.convert_thread.start()
+        self.convert_progress_dialog.exec()
+
+    def update_convert_progress(self, done, total):
+        percent = (done * 100) // total if total else 100
+        self.convert_progress_dialog.setValue(min(percent, 99))
+        self.show_throughput("Converting", done)
+
+    def convert_finished(self, path):
+        self.convert_progress_dialog.setValue(100)
+        self.update_status(f"Converted to {os.path.basename(path)}")
+        QMessageBox.information(self, "Success", f"The data track has been written to {os.path.basename(path)}.")
+
+    def convert_error(self, error_message):
+        self.convert_progress_dialog.close()
+        if error_message == "Conversion cancelled by user":
+            self.update_status("Conversion cancelled.")
+            return
+        logger.error(f"Failed to convert CUE/BIN: {error_message}")
+        QMessageBox.critical(self, "Error", f"Failed to convert: {error_message}")
+        self.update_status("Error converting CUE/BIN.")
 
     def get_selected_node(self):
         """
@@ -1595,10 +1548,10 @@ class RipDiscWorker(QThread):
         Returns:
             dict or None: The selected node, or None if no node is selected.
         """
-        selected_items = self.tree.selectedItems()
-        if not selected_items:
+        selected_rows = self.tree.selectionModel().selectedRows()
+        if not selected_rows:
             return None
-        return self.tree_item_map.get(id(selected_items[0]))
+        return self.tree_model.node_from_index(selected_rows[0])
 
     def add_file(self):
         """Adds a file to the ISO."""
@@ -1613,23 +1566,25 @@ class RipDiscWorker(QThread):
             return
 
         success_count = 0
-        for fp in file_paths:
-            try:
-                if any(c['name'].lower() == os.path.basename(fp).lower() for c in target_node['children']):
-                    reply = QMessageBox.question(self, "File Exists", f"File '{os.path.basename(fp)}' already exists. Replace it?",
-                                                   QMessageBox.Yes | QMessageBox.No)
-                    if reply == QMessageBox.No:
-                        continue
-
-                # Use command for undo/redo support
-                cmd = AddFileCommand(self.core, fp, target_node)
-                if self.command_history.execute(cmd):
-                    success_count += 1
-            except Exception as e:
-                logger.exception(f"Failed to add file {fp}: {e}")
-                QMessageBox.critical(self, "Error", f"Failed to add file {os.path.basename(fp)}: {e}")
-
-        self.refresh_view()
+        # The files of one selection are undone together
+        with self.command_history.group(f"Add {len(file_paths)} files"):
+            for fp in file_paths:
+                try:
+                    if self.core.find_child(target_node, os.path.basename(fp)) is not None:
+                        reply = QMessageBox.question(self, "File Exists", f"File '{os.path.basename(fp)}' already exists. Replace it?",
+                                                       QMessageBox.Yes | QMessageBox.No)
+                        if reply == QMessageBox.No:
+                            continue
+
+                    # Use command for undo/redo support
+                    cmd = AddFileCommand(self.core, fp, target_node)
+                    if self.command_history.execute(cmd):
+                        success_count += 1
+                except Exception as e:
+                    logger.exception(f"Failed to add file {fp}: {e}")
+                    QMessageBox.critical(self, "Error", f"Failed to add file {os.path.basename(fp)}: {e}")
+
+        self.update_view_state()
         self.update_undo_redo_actions()
         self.update_status(f"Added {success_count} file(s)")
 
@@ -1646,7 +1601,7 @@ class RipDiscWorker(QThread):
                 logger.info("Add Folder dialog cancelled.")
                 return
 
-            if any(c['name'].lower() == folder_name.lower() for c in target_node.get('children', [])):
+            if self.core.find_child(target_node, folder_name) is not None:
                 logger.warning(f"Attempted to create a folder with an existing name: {folder_name}")
                 QMessageBox.warning(self, "Folder Exists", f"A folder with the name '{folder_name}' already exists.")
                 return
@@ -1654,7 +1609,7 @@ class RipDiscWorker(QThread):
             # Use command for undo/redo support
             cmd = AddFolderCommand(self.core, folder_name, target_node)
             if self.command_history.execute(cmd):
-                self.refresh_view()
+                self.update_view_state()
                 self.update_undo_redo_actions()
                 self.update_status(f"Added folder: {folder_name}")
         except Exception as e:
@@ -1679,7 +1634,7 @@ class RipDiscWorker(QThread):
                 # Use command for undo/redo support
                 cmd = RemoveNodeCommand(self.core, node)
                 if self.command_history.execute(cmd):
-                    self.refresh_view()
+                    self.update_view_state()
                     self.update_undo_redo_actions()
                     self.update_status(f"Removed '{node_name}'")
             else:
@@ -1700,14 +1655,67 @@ class RipDiscWorker(QThread):
             logger.info("Import Directory dialog cancelled.")
             return
 
-        try:
-            self._import_directory_recursive(source_dir, target_node)
-            self.refresh_view()
-            self.update_status(f"Imported directory '{os.path.basename(source_dir)}'")
-            logger.info(f"Successfully imported directory: {source_dir}")
-        except Exception as e:
-            logger.exception(f"Failed to import directory {source_dir}: {e}")
-            QMessageBox.critical(self, "Error", f"Failed to import directory: {e}")
+        name = os.path.basename(source_dir)
+        self._start_import([source_dir], target_node, f"Import directory '{name}'", f"Imported directory '{name}'")
+
+    def _start_import(self, sources, target_node, description, done_message):
+        """
+        Imports local files and directories with an ImportWorker and a progress dialog.
+
+        Args:
+            sources (list): Local paths to import.
+            target_node (dict): The directory node to import into.
+            description (str): Description of the import in the undo history.
+            done_message (str): Status bar text once the import is complete.
+        """
+        self.import_progress_dialog = QProgressDialog("Scanning files to import...", "Cancel", 0, 0, self)
+        self.import_progress_dialog.setWindowTitle("Importing")
+        self.import_progress_dialog.setWindowModality(Qt.WindowModal)
+        self.import_progress_dialog.setMinimumDuration(0)
+        self.import_progress_dialog.canceled.connect(self.cancel_import)
+
+        self.import_thread = ImportWorker(self.core, sources, target_node)
+        self.import_thread.progress.connect(self.update_import_progress)
+        self.import_thread.finished.connect(lambda: self.import_finished(description, done_message))
+        self.import_thread.error.connect(self.import_error)
+
+        self.import_thread.start()
+        self.import_progress_dialog.exec()
+
+    def update_import_progress(self, files, folders):
+        self.import_progress_dialog.setLabelText(f"Scanning files to import... {files} file(s) in {folders} folder(s)")
+
+    def cancel_import(self):
+        if self.import_thread.isRunning():
+            self.import_thread.cancel()
+            self.update_status("Cancelling import...")
+
+    def import_finished(self, description, done_message):
+        """Adds the scanned files to the tree; this runs on the GUI thread, which owns the tree."""
+        engine = self.import_thread.engine
+        # One history entry for the whole import
+        if not self.command_history.execute(ImportCommand(self.core, engine, description)):
+            self.import_progress_dialog.close()
+            QMessageBox.critical(self, "Error", "Failed to add the imported files. See the log for details.")
+            return
+        self.import_progress_dialog.close()
+        self.update_view_state()
+        self.update_undo_redo_actions()
+        self.update_status(f"{done_message} ({engine.file_count} file(s))")
+        logger.info(f"Import complete: {engine.file_count} file(s) from {len(engine.sources)} source(s)")
+        if engine.errors:
+            details = "\n".join(f"{path}: {message}" for path, message in engine.errors[:20])
+            QMessageBox.warning(self, "Import Incomplete",
+                                f"{len(engine.errors)} item(s) could not be read and were skipped:\n{details}")
+
+    def import_error(self, error_message):
+        self.import_progress_dialog.close()
+        if error_message == "Import cancelled by user":
+            self.update_status("Import cancelled.")
+            return
+        logger.error(f"Failed to import: {error_message}")
+        QMessageBox.critical(self, "Error", f"Failed to import: {error_message}")
+        self.update_status("Error importing files.")
 
     def extract_selected(self):
         """Extracts the selected file or folder from the ISO to the local filesystem."""
@@ -1719,7 +1727,8 @@ class RipDiscWorker(QThread):
 
         if node['is_directory']:
             path = QFileDialog.getExistingDirectory(self, "Choose Extraction Location")
-            if path:
+            # The root ('/') is extracted into the chosen folder itself.
+            if path and node.get('parent') is not node:
                 path = os.path.join(path, node['name'])
         else:
             path, _ = QFileDialog.getSaveFileName(self, "Save File As", node['name'])
@@ -1728,65 +1737,50 @@ class RipDiscWorker(QThread):
             logger.info("Extraction dialog cancelled.")
             return
 
-        try:
-            self._extract_node_recursive(node, path)
-            self.update_status(f"Extracted {node['name']}")
-            logger.info(f"Successfully extracted {node['name']} to {path}")
-            QMessageBox.information(self, "Success", "Extraction complete.")
-        except Exception as e:
-            logger.exception(f"Failed to extract {node['name']}: {e}")
-            QMessageBox.critical(self, "Error", f"Failed to extract: {e}")
-
-    def _extract_node_recursive(self, node, extract_path):
-        """
-        Recursively extracts a node and its children. Handles exceptions at each step.
-
-        Args:
-            node (dict): The node to extract.
-            extract_path (str): The path to extract to.
-        """
-        node_name = node.get('name', 'Unnamed')
-        try:
-            if node.get('is_directory'):
-                # Create the directory for the current node
-                os.makedirs(extract_path, exist_ok=True)
-                logger.info(f"Created directory: {extract_path}")
-
-                # Recursively extract children
-                for child in node.get('children', []):
-                    child_path = os.path.join(extract_path, child.get('name', 'Unnamed_Child'))
-                    self._extract_node_recursive(child, child_path) # This will handle its own exceptions
-            else:
-                # Get file data from the core logic
-                file_data = self.core.get_file_data(node)
-                if file_data is None:
-                    # This can happen if get_file_data returns None on error
-                    raise IOError(f"Failed to retrieve data for file '{node_name}' from ISO.")
-
-                # Ensure parent directory exists before writing
-                parent_dir = os.path.dirname(extract_path)
-                os.makedirs(parent_dir, exist_ok=True)
-
-                # Write the file data
-                with open(extract_path, 'wb') as f:
-                    f.write(file_data)
-                logger.info(f"Extracted file: {extract_path}")
-
-        except (IOError, OSError) as e:
-            # Catch file system related errors (permissions, disk full, etc.)
-            error_message = f"A file system error occurred while extracting '{node_name}': {e}"
-            logger.exception(error_message)
-            # We re-raise to let the top-level caller handle the UI notification
-            raise IOError(error_message) from e
-        except Exception as e:
-            # Catch any other unexpected errors
-            error_message = f"An unexpected error occurred during the extraction of '{node_name}': {e}"
-            logger.exception(error_message)
-            raise Exception(error_message) from e
+        self.extract_progress_dialog = QProgressDialog(f"Extracting {node['name']}...", "Cancel", 0, 100, self)
+        self.extract_progress_dialog.setWindowModality(Qt.WindowModal)
+        self.extract_progress_dialog.setAutoClose(True)
+        self.extract_progress_dialog.canceled.connect(self.cancel_extract)
+
+        self.throughput = ThroughputMeter()
+        self.extract_thread = ExtractWorker(self.core, node, path)
+        self.extract_thread.progress.connect(self.update_extract_progress)
+        self.extract_thread.finished.connect(self.extract_finished)
+        self.extract_thread.error.connect(self.extract_error)
+
+        self.extract_thread.start()
+        self.extract_progress_dialog.exec()
+
+    def update_extract_progress(self, done, total):
+        percent = (done * 100) // total if total else 100
+        self.extract_progress_dialog.setLabelText(
+            f"Extracting... {self.format_file_size(done)} of {self.format_file_size(total)}")
+        self.extract_progress_dialog.setValue(min(percent, 99))
+        self.show_throughput("Extracting", done)
+
+    def cancel_extract(self):
+        if self.extract_thread.isRunning():
+            self.extract_thread.cancel()
+            self.update_status("Cancelling extraction...")
+
+    def extract_finished(self, path):
+        self.extract_progress_dialog.setValue(100)
+        self.update_status(f"Extracted {os.path.basename(path)}")
+        logger.info(f"Successfully extracted to {path}")
+        QMessageBox.information(self, "Success", "Extraction complete.")
+
+    def extract_error(self, error_message):
+        self.extract_progress_dialog.close()
+        if error_message == "Extraction cancelled by user":
+            self.update_status("Extraction cancelled.")
+            return
+        logger.error(f"Failed to extract: {error_message}")
+        QMessageBox.critical(self, "Error", f"Failed to extract: {error_message}")
+        self.update_status("Error extracting files.")
 
     def handle_drop(self, urls):
         """
-        Handles the drop event from the DroppableTreeWidget.
+        Handles the drop event from the DroppableTreeView.
 
         Args:
             urls (list): A list of local file paths from the drop event.
@@ -1796,55 +1790,17 @@ class RipDiscWorker(QThread):
         if not target_node['is_directory']:
             target_node = target_node['parent']
 
-        for url in urls:
-            try:
-                if os.path.isfile(url):
-                    self.core.add_file_to_directory(url, target_node)
-                elif os.path.isdir(url):
-                    self._import_directory_recursive(url, target_node)
-            except Exception as e:
-                logger.exception(f"Failed to process dropped item {url}: {e}")
-                QMessageBox.critical(self, "Error", f"Failed to add {os.path.basename(url)}: {e}")
-
-        self.refresh_view()
-        self.update_status(f"Added {len(urls)} items via drag and drop.")
+        self._start_import(urls, target_node, f"Drop {len(urls)} items", f"Added {len(urls)} items via drag and drop")
 
-    def _import_directory_recursive(self, source_dir, target_node):
+    def show_context_menu(self, position: QPoint):
         """
-        Recursively imports a directory and its contents.
+        Shows the context menu for the tree view.
 
         Args:
-            source_dir (str): The source directory to import.
-            target_node (dict): The target node in the ISO to import into.
+            position (QPoint): The position to show the context menu at.
         """
-        dir_name = os.path.basename(source_dir)
-        # Avoid creating a folder if one with the same name already exists.
-        existing_folder = next((c for c in target_node['children'] if c['name'].lower() == dir_name.lower() and c['is_directory']), None)
-        if existing_folder:
-            new_dir_node = existing_folder
-        else:
-            self.core.add_folder_to_directory(dir_name, target_node)
-            new_dir_node = next(c for c in target_node['children'] if c['name'] == dir_name and c.get('is_new'))
-
-        for item in os.listdir(source_dir):
-            item_path = os.path.join(source_dir, item)
-            if os.path.islink(item_path):
-                logger.warning(f"Skipping symbolic link: {item_path}")
-                continue
-            if os.path.isfile(item_path):
-                self.core.add_file_to_directory(item_path, new_dir_node)
-            elif os.path.isdir(item_path):
-                self._import_directory_recursive(item_path, new_dir_node)
-
-    def show_context_menu(self, position: QPoint):
-        """
-        Shows the context menu for the tree view.
-
-        Args:
-            position (QPoint): The position to show the context menu at.
-        """
-        item = self.tree.itemAt(position)
-        if not item:
+        index = self.tree.indexAt(position)
+        if not index.isValid():
             # Show context menu for empty area
             context_menu = QMenu(self)
             new_folder_action = context_menu.addAction("New Folder...")
@@ -1865,7 +1821,7 @@ class RipDiscWorker(QThread):
                 self.import_directory()
             return
 
-        node = self.tree_item_map.get(id(item))
+        node = self.tree_model.node_from_index(index)
         if not node:
             return
 
@@ -1894,7 +1850,7 @@ class RipDiscWorker(QThread):
         action = context_menu.exec(self.tree.mapToGlobal(position))
 
         if action == rename_action:
-            self.rename_node(node, item)
+            self.rename_node(node)
         elif action == properties_action:
             self.show_node_properties(node)
         elif action == copy_path_action:
@@ -1908,7 +1864,7 @@ class RipDiscWorker(QThread):
         elif action == remove_action:
             self.remove_selected()
 
-    def rename_node(self, node, item):
+    def rename_node(self, node):
         """Renames a file or folder in the ISO."""
         old_name = node['name']
         new_name, ok = QInputDialog.getText(
@@ -1925,19 +1881,16 @@ class RipDiscWorker(QThread):
             # Check for duplicates
             parent = node.get('parent')
             if parent:
-                for sibling in parent['children']:
-                    if sibling != node and sibling['name'].lower() == new_name.lower():
-                        QMessageBox.warning(self, "Duplicate Name",
-                                          f"An item with the name '{new_name}' already exists.")
-                        return
+                if any(sibling is not node for sibling in self.core.child_index(parent).named(new_name)):
+                    QMessageBox.warning(self, "Duplicate Name",
+                                      f"An item with the name '{new_name}' already exists.")
+                    return
 
             # Use command for undo/redo support
-            cmd = RenameNodeCommand(node, old_name, new_name)
+            cmd = RenameNodeCommand(node, old_name, new_name, core=self.core)
             if self.command_history.execute(cmd):
                 self.core.iso_modified = True
-
-                # Update the tree item
-                item.setText(0, new_name + (" [NEW]" if node.get('is_new') else ""))
+                self.update_view_state()
                 self.update_status(f"Renamed '{old_name}' to '{new_name}'")
                 self.update_undo_redo_actions()
                 logger.info(f"Renamed node from '{old_name}' to '{new_name}'")
@@ -1965,26 +1918,11 @@ class RipDiscWorker(QThread):
             properties_text += f"<p><b>Status:</b> <i>New (not yet saved)</i></p>"
 
         if is_dir:
-            # Count children
-            def count_items(n):
-                total_files = 0
-                total_dirs = 0
-                total_size = 0
-                for child in n.get('children', []):
-                    if child.get('is_directory'):
-                        total_dirs += 1
-                        f, d, s = count_items(child)
-                        total_files += f
-                        total_dirs += d
-                        total_size += s
-                    else:
-                        total_files += 1
-                        total_size += child.get('size', 0)
-                return total_files, total_dirs, total_size
-
-            files, dirs, size = count_items(node)
-            properties_text += f"<p><b>Contains:</b> {files} file(s), {dirs} folder(s)</p>"
-            properties_text += f"<p><b>Total Size:</b> {self.format_file_size(size)} ({size:,} bytes)</p>"
+            # Kept up to date by the core, so this is only slow the first time
+            stats = self.core.tree_stats(node)
+            properties_text += f"<p><b>Contains:</b> {stats.files} file(s), {stats.directories} folder(s)</p>"
+            properties_text += f"<p><b>Total Size:</b> {self.format_file_size(stats.size)} ({stats.size:,} bytes)</p>"
+            properties_text += f"<p><b>Size on Disc:</b> {self.format_file_size(stats.allocated_size)} ({stats.sectors:,} sectors)</p>"
 
         msg_box = QMessageBox(self)
         msg_box.setWindowTitle("Properties")
@@ -2014,14 +1952,14 @@ class RipDiscWorker(QThread):
                 return
 
             # Check for duplicates
-            for child in target_node['children']:
+            for child in self.core.load_children(target_node):
                 if child['name'].lower() == folder_name.lower():
                     QMessageBox.warning(self, "Duplicate Name",
                                       f"A folder with the name '{folder_name}' already exists.")
                     return
 
             self.core.add_folder_to_directory(folder_name, target_node)
-            self.refresh_view()
+            self.update_view_state()
             self.update_status(f"Added folder '{folder_name}'")
             logger.info(f"Added folder '{folder_name}' to {self.core.get_node_path(target_node)}")
 
@@ -2039,7 +1977,7 @@ class RipDiscWorker(QThread):
                 logger.exception(f"Failed to add file {file_path}: {e}")
                 QMessageBox.critical(self, "Error", f"Failed to add {os.path.basename(file_path)}: {e}")
 
-        self.refresh_view()
+        self.update_view_state()
         self.update_status(f"Added {len(file_paths)} file(s)")
 
     def show_iso_properties(self):
@@ -2067,7 +2005,7 @@ class RipDiscWorker(QThread):
                 self.core.efi_boot_image_path = new_props['efi_boot_image_path']
                 self.core.boot_emulation_type = new_props['boot_emulation_type']
                 self.core.iso_modified = True
-                self.refresh_view()
+                self.update_view_state()
 
     def show_about(self):
         """Shows the About dialog."""
@@ -2103,6 +2041,7 @@ class RipDiscWorker(QThread):
 <tr><td><b>Total Files:</b></td><td>{stats['total_files']:,}</td></tr>
 <tr><td><b>Total Folders:</b></td><td>{stats['total_folders']:,}</td></tr>
 <tr><td><b>Total Size:</b></td><td>{self.format_file_size(stats['total_size'])} ({stats['total_size']:,} bytes)</td></tr>
+<tr><td><b>Size on Disc:</b></td><td>{self.format_file_size(stats['total_sectors'] * ISO_BLOCK_SIZE)} ({stats['total_sectors']:,} sectors)</td></tr>
 </table>
 
 <h3>File Types</h3>
@@ -2128,37 +2067,31 @@ class RipDiscWorker(QThread):
         msg_box.exec()
 
     def _calculate_statistics(self, node):
-        """Recursively calculates statistics for the ISO."""
+        """Calculates statistics for the ISO."""
+        # The totals are kept by the core; only the breakdown needs a walk.
+        totals = self.core.tree_stats(node)
         stats = {
-            'total_files': 0,
-            'total_folders': 0,
-            'total_size': 0,
+            'total_files': totals.files,
+            'total_folders': totals.directories + (1 if node.get('is_directory') else 0),
+            'total_size': totals.size,
+            'total_sectors': totals.sectors,
             'by_extension': {},  # ext -> {count, size}
             'largest_files': []  # list of (name, size)
         }
 
-        def process_node(n):
-            if n.get('is_directory'):
-                stats['total_folders'] += 1
-                for child in n.get('children', []):
-                    process_node(child)
-            else:
-                stats['total_files'] += 1
-                size = n.get('size', 0)
-                stats['total_size'] += size
-
-                # Track by extension
-                name = n.get('name', '')
-                ext = os.path.splitext(name)[1].lower() if '.' in name else ''
-                if ext not in stats['by_extension']:
-                    stats['by_extension'][ext] = {'count': 0, 'size': 0}
-                stats['by_extension'][ext]['count'] += 1
-                stats['by_extension'][ext]['size'] += size
+        for name, is_directory, size in self.core.iter_entries(node):
+            if is_directory:
+                continue
 
-                # Track largest files
-                stats['largest_files'].append((name, size))
+            # Track by extension
+            ext = os.path.splitext(name)[1].lower() if '.' in name else ''
+            if ext not in stats['by_extension']:
+                stats['by_extension'][ext] = {'count': 0, 'size': 0}
+            stats['by_extension'][ext]['count'] += 1
+            stats['by_extension'][ext]['size'] += size
 
-        process_node(node)
+            # Track largest files
+            stats['largest_files'].append((name, size))
 
         # Sort largest files
         stats['largest_files'].sort(key=lambda x: x[1], reverse=True)
@@ -2203,7 +2136,7 @@ class RipDiscWorker(QThread):
 
     def _write_file_list(self, file, node, parent_path, is_csv):
         """Recursively writes the file list."""
-        for child in node.get('children', []):
+        for child in self.core.load_children(node):
             name = child.get('name', '')
             is_dir = child.get('is_directory', False)
             size = child.get('size', 0) if not is_dir else 0
@@ -2249,7 +2182,17 @@ class RipDiscWorker(QThread):
         self.save_window_state()
 
         # Clean up resources
+        for job in self.index_warm_jobs:
+            job.cancel()
+        for job in self.index_warm_jobs:
+            job.wait()
+        self.stop_search_index()
+        if self.search_thread is not None:
+            self.search_thread.cancel()
+            self.search_thread.wait()
         self.core.close_iso()
+        if self in ISOEditor.windows:
+            ISOEditor.windows.remove(self)
         event.accept()
 
     def get_recent_files_path(self):
@@ -2259,6 +2202,11 @@ class RipDiscWorker(QThread):
         os.makedirs(config_dir, exist_ok=True)
         return os.path.join(config_dir, RECENT_FILES_FILENAME)
 
+    def get_index_cache_dir(self):
+        """Returns the directory of the image index cache (see index_cache.py)."""
+        home = os.path.expanduser("~")
+        return os.path.join(home, CACHE_DIR_NAME, CONFIG_SUBDIR_NAME, INDEX_CACHE_SUBDIR_NAME)
+
     def load_recent_files(self):
         """Loads the list of recent files from disk."""
         try:
@@ -2418,17 +2366,23 @@ class RipDiscWorker(QThread):
         logger.debug("Saved window state")
 
     def refresh_view(self):
-        """Refreshes the tree view to show the current state of the ISO."""
+        """Rebuilds the tree view from the current state of the ISO."""
         logger.debug("Refreshing tree view.")
-        self.tree.clear()
-        self.tree_item_map = {}
-        if self.core.directory_tree:
-            root_item = QTreeWidgetItem(self.tree, ['/', '', self.core.directory_tree.get('date', ''), 'Directory'])
-            self.tree.addTopLevelItem(root_item)
-            self.tree_item_map[id(root_item)] = self.core.directory_tree
-            self.populate_tree_node(root_item, self.core.directory_tree)
-            root_item.setExpanded(True)
+        self.tree_model.reset()
+        self.tree.expand(self.tree_model.index(0, 0))
+        self.rebuild_search_index()
+        if self.search_input.text():
+            self.filter_tree()
+        self.update_view_state()
+        self.update_status("View refreshed")
+
+    def update_view_state(self):
+        """
+        Updates the ISO information and window title after an edit.
 
+        The tree view itself follows edits through the model's tree listener,
+        so this does not rebuild it.
+        """
         self.update_iso_info()
 
         title = "ISO Editor"
@@ -2437,34 +2391,6 @@ class RipDiscWorker(QThread):
         if self.core.iso_modified:
             title += " [Modified]"
         self.setWindowTitle(title)
-        self.update_status("View refreshed")
-
-    def populate_tree_node(self, parent_item, parent_node):
-        """
-        Recursively populates the tree view with nodes.
-
-        Args:
-            parent_item (QTreeWidgetItem): The parent tree item.
-            parent_node (dict): The parent node in the directory tree.
-        """
-        # Sort children: directories first, then files, both alphabetically
-        sorted_children = sorted(parent_node.get('children', []), key=lambda x: (not x.get('is_directory', False), x.get('name', '').lower()))
-
-        for child in sorted_children:
-            if child.get('is_hidden') and not self.show_hidden:
-                continue
-
-            size_text = self.format_file_size(child.get('size', 0)) if not child.get('is_directory') else ''
-            file_type = ITEM_TYPE_DIRECTORY if child.get('is_directory') else ITEM_TYPE_FILE
-            display_name = child.get('name', '')
-            if child.get('is_new'):
-                display_name += " [NEW]"
-
-            child_item = QTreeWidgetItem(parent_item, [display_name, size_text, child.get('date', ''), file_type])
-            self.tree_item_map[id(child_item)] = child
-
-            if child.get('children'):
-                self.populate_tree_node(child_item, child)
 
     def update_iso_info(self):
         """Updates the ISO information display."""
@@ -2477,6 +2403,11 @@ class RipDiscWorker(QThread):
         info_text = (f"System ID: {vd.get('system_id', 'N/A')}\n"
                      f"Volume Size: {vd.get('volume_size', 0)} blocks\n"
                      f"Block Size: {vd.get('logical_block_size', 0)} bytes")
+        # Only shown once known, so that refreshing does not read a lazily loaded tree
+        stats = self.core.tree_stats(compute=False)
+        if stats is not None:
+            info_text += (f"\nContents: {stats.files:,} file(s), {stats.directories:,} folder(s)\n"
+                          f"File Data: {self.format_file_size(stats.allocated_size)} ({stats.sectors:,} sectors)")
         self.iso_info.setText(info_text)
         self.volume_name_label.setText(f"Volume Name: {vd.get('volume_id', 'N/A')}")
 
@@ -2496,6 +2427,507 @@ class RipDiscWorker(QThread):
             size /= 1024.0
         return f"{size:.1f} TB"
 
+
+class ScheduledWorker(QObject):
+    """
+    Base of the background operations, each run as a job of the shared scheduler (see scheduler.py).
+
+    Subclasses implement run() as for a QThread, and paths() to name the files
+    they read and write; start(), isRunning() and wait() behave like QThread's.
+    cancel() also drops a job that has not started yet, in which case
+    cancelled_before_start() is called instead of run(). Progress callbacks
+    check progress_due() before emitting a signal.
+    """
+    job_name = 'job'
+    priority = PRIORITY_NORMAL
+    progress_interval = PROGRESS_INTERVAL_SEC
+
+    def __init__(self, scheduler: Optional[JobScheduler] = None) -> None:
+        super().__init__()
+        self.scheduler: JobScheduler = scheduler or shared_scheduler()
+        self.job: Optional[Job] = None
+        self._last_progress: float = 0.0
+
+    def paths(self) -> List[Optional[str]]:
+        return []
+
+    def run(self) -> None:
+        raise NotImplementedError
+
+    def start(self) -> None:
+        self.job = self.scheduler.submit(lambda job: self.run(), name=self.job_name, paths=self.paths(),
+                                         priority=self.priority)
+        self.job.on_cancel(self.cancel)
+        self.job.on_done(self._job_done)
+
+    def cancel(self) -> None:
+        if self.job is not None:
+            self.job.cancel()
+
+    def isRunning(self) -> bool:
+        return self.job is not None and not self.job.done()
+
+    def wait(self, timeout: Optional[float] = None) -> bool:
+        return self.job is None or self.job.wait(timeout)
+
+    def _job_done(self, job: Job) -> None:
+        if not job.started:
+            self.cancelled_before_start()
+
+    def cancelled_before_start(self) -> None:
+        """Reports a cancellation that came before run() started; nothing by default."""
+
+    def progress_due(self, final: bool = False) -> bool:
+        """Whether progress should be signalled now: at most once per progress_interval, and always when final."""
+        now = time.monotonic()
+        if not final and now - self._last_progress < self.progress_interval:
+            return False
+        self._last_progress = now
+        return True
+
+
+class SaveWorker(ScheduledWorker):
+    progress = Signal(object, object)  # bytes written, bytes planned (may exceed 32 bits)
+    finished = Signal(str)
+    error = Signal(str)
+
+    def __init__(self, core: ISOCore, file_path: str, use_udf: bool, make_hybrid: bool,
+                 incremental: bool = False, checksum_algorithms: Optional[List[str]] = None,
+                 deduplicate: bool = False, max_size: Optional[int] = None) -> None:
+        super().__init__()
+        self.job_name = f"save {os.path.basename(file_path)}"
+        self.core: ISOCore = core
+        self.file_path: str = file_path
+        self.use_udf: bool = use_udf
+        self.make_hybrid: bool = make_hybrid
+        self.incremental: bool = incremental
+        self.checksum_algorithms: Optional[List[str]] = checksum_algorithms
+        self.deduplicate: bool = deduplicate
+        self.max_size: Optional[int] = max_size
+        # Digests computed while writing, if the save produced them
+        self.checksums: Optional[Dict[str, str]] = None
+        self._cancelled: bool = False
+
+    def paths(self) -> List[Optional[str]]:
+        return [self.core.current_iso_path, self.file_path]
+
+    def cancel(self) -> None:
+        """Request cancellation of the save operation."""
+        self._cancelled = True
+        super().cancel()
+
+    def cancelled_before_start(self) -> None:
+        self.error.emit("Save cancelled by user")
+
+    def run(self) -> None:
+        try:
+            # Progress is shown against the planned size of the image, known
+            # before pycdlib starts laying it out.
+            planned = None if self.incremental else self.core.plan_layout(use_udf=self.use_udf,
+                                                                          make_hybrid=self.make_hybrid).total_size
+
+            # The progress callback for pycdlib's write method
+            def progress_cb(done, total, opaque):
+                if self._cancelled:
+                    raise InterruptedError("Save operation cancelled by user")
+                if self.progress_due(done == total):
+                    expected = max(planned or total, total)
+                    self.progress.emit(done, expected)
+
+            self.checksums = self.core.save_iso(self.file_path, use_joliet=True, use_rock_ridge=True, progress_callback=progress_cb, use_udf=self.use_udf, make_hybrid=self.make_hybrid,
+                                                incremental=self.incremental, checksum_algorithms=self.checksum_algorithms,
+                                                deduplicate=self.deduplicate, max_size=self.max_size)
+            # A save that returned wrote the whole image, even if a cancel came too late to stop it
+            # (e.g. while patching the loaded image in place)
+            self.finished.emit(self.file_path)
+        except InterruptedError as e:
+            logger.info(f"Save operation cancelled: {e}")
+            self.error.emit("Save cancelled by user")
+        except Exception as e:
+            logger.exception(f"Error during save operation: {e}")
+            self.error.emit(str(e))
+
+
+class ExtractWorker(ScheduledWorker):
+    """
+    A scheduled worker that extracts a file or folder from the loaded image with ExtractionEngine.
+    """
+    progress = Signal(object, object)  # bytes done, bytes total (may exceed 32 bits)
+    finished = Signal(str)  # destination path
+    error = Signal(str)
+
+    def __init__(self, core: ISOCore, node: TreeNode, destination: str) -> None:
+        super().__init__()
+        self.job_name = f"extract {node.get('name')}"
+        self.source: Optional[str] = core.current_iso_path
+        self.destination: str = destination
+        self.engine = ExtractionEngine(core, node, destination, progress_callback=self._on_progress)
+
+    def paths(self) -> List[Optional[str]]:
+        return [self.source, self.destination]
+
+    def cancel(self) -> None:
+        """Request cancellation of the extraction."""
+        self.engine.cancel()
+        super().cancel()
+
+    def cancelled_before_start(self) -> None:
+        self.error.emit("Extraction cancelled by user")
+
+    def _on_progress(self, done: int, total: int) -> None:
+        if self.progress_due(done == total):
+            self.progress.emit(done, total)
+
+    def run(self) -> None:
+        try:
+            self.engine.run()
+            self.finished.emit(self.destination)
+        except InterruptedError as e:
+            logger.info(f"Extraction cancelled: {e}")
+            self.error.emit("Extraction cancelled by user")
+        except Exception as e:
+            logger.exception(f"Error during extraction: {e}")
+            self.error.emit(str(e))
+
+
+class ConvertCueWorker(ScheduledWorker):
+    """
+    A scheduled worker that writes the data track of a CUE/BIN image to an ISO file.
+    """
+    progress = Signal(object, object)  # bytes done, bytes total
+    finished = Signal(str)  # destination path
+    error = Signal(str)
+
+    def __init__(self, cue_path: str, destination: str) -> None:
+        super().__init__()
+        self.job_name = f"convert {os.path.basename(cue_path)}"
+        self.cue_path: str = cue_path
+        self.destination: str = destination
+        self.converter = None
+        self._cancelled: bool = False
+
+    def cancel(self) -> None:
+        """Request cancellation of the conversion."""
+        self._cancelled = True
+        if self.converter:
+            self.converter.cancel()
+        super().cancel()
+
+    def paths(self) -> List[Optional[str]]:
+        return [self.cue_path, self.destination]
+
+    def cancelled_before_start(self) -> None:
+        self.error.emit("Conversion cancelled by user")
+
+    def _on_progress(self, done: int, total: int) -> None:
+        if self.progress_due(done == total):
+            self.progress.emit(done, total)
+
+    def run(self) -> None:
+        try:
+            core = ISOCore()
+            core.load_iso(self.cue_path)
+            self.converter = core.cue_track_converter(self.destination, progress_callback=self._on_progress)
+            if self._cancelled:
+                raise InterruptedError("Conversion cancelled by user")
+            self.converter.run()
+            self.finished.emit(self.destination)
+        except InterruptedError as e:
+            logger.info(f"Conversion cancelled: {e}")
+            self.error.emit("Conversion cancelled by user")
+        except Exception as e:
+            logger.exception(f"Error during conversion: {e}")
+            self.error.emit(str(e))
+
+
+class ChecksumWorker(ScheduledWorker):
+    """
+    A scheduled worker for calculating file checksums in the background.
+    """
+    # Signal -> dict: e.g., {'md5': '...', 'sha1': '...', 'sha256': '...'}
+    #           str:  Error message if something goes wrong.
+    finished = Signal(dict, str)
+    priority = PRIORITY_BACKGROUND
+
+    def __init__(self, file_path: str) -> None:
+        super().__init__()
+        self.job_name = f"checksum {os.path.basename(file_path)}"
+        self.file_path: str = file_path
+        self._cancelled: bool = False
+
+    def paths(self) -> List[Optional[str]]:
+        return [self.file_path]
+
+    def cancel(self) -> None:
+        """Request cancellation of the checksum calculation."""
+        self._cancelled = True
+        super().cancel()
+
+    def cancelled_before_start(self) -> None:
+        self.finished.emit({}, "Checksum calculation cancelled")
+
+    def run(self) -> None:
+        """
+        Calculates MD5, SHA1, and SHA256 hashes for the file (plus BLAKE3/XXH3 when available)
+        in a single read pass, with each algorithm on its own thread.
+        """
+        try:
+            results = hash_file(self.file_path, default_algorithms(), is_cancelled=lambda: self._cancelled)
+            if results is None:
+                logger.info("Checksum calculation cancelled by user")
+                self.finished.emit({}, "Checksum calculation cancelled")
+                return
+            self.finished.emit(results, "")
+        except Exception as e:
+            logger.error(f"Checksum calculation failed for {self.file_path}: {e}")
+            self.finished.emit({}, f"Failed to calculate checksums: {e}")
+
+
+class SearchIndexWorker(QThread):
+    """
+    A QThread worker that builds the search index of a loaded image.
+    """
+
+    def __init__(self, search_index: SearchIndex) -> None:
+        super().__init__()
+        self.search_index: SearchIndex = search_index
+        self._cancelled: bool = False
+
+    def cancel(self) -> None:
+        """Request cancellation of the build."""
+        self._cancelled = True
+
+    def run(self) -> None:
+        self.search_index.build(is_cancelled=lambda: self._cancelled)
+
+
+class SearchWorker(QThread):
+    """
+    A QThread worker that runs one query against the search index.
+    """
+    # Matching entries (None if cancelled), the query, and the generation it was started in
+    finished = Signal(object, object, int)
+
+    def __init__(self, search_index: SearchIndex, query: SearchQuery, generation: int) -> None:
+        super().__init__()
+        self.search_index: SearchIndex = search_index
+        self.query: SearchQuery = query
+        self.generation: int = generation
+        self._cancelled: bool = False
+
+    def cancel(self) -> None:
+        """Request cancellation of the search."""
+        self._cancelled = True
+
+    def run(self) -> None:
+        entries = None
+        try:
+            # The index of a freshly loaded image may still be building.
+            while not self.search_index.wait_ready(0.1):
+                if self._cancelled:
+                    break
+            else:
+                entries = self.search_index.search(self.query, is_cancelled=lambda: self._cancelled)
+        except Exception as e:
+            logger.error(f"Search failed: {e}")
+        self.finished.emit(entries, self.query, self.generation)
+
+
+class ImportWorker(ScheduledWorker):
+    """
+    A scheduled worker that scans local files and directories for import with ImportEngine.
+
+    Only the scan runs here; the GUI attaches the result in its finished handler.
+    """
+    progress = Signal(int, int)  # files found, folders listed
+    finished = Signal()
+    error = Signal(str)
+
+    def __init__(self, core: ISOCore, sources: List[str], target_node: TreeNode) -> None:
+        super().__init__()
+        self.job_name = f"import {len(sources)} item(s)"
+        self.sources: List[str] = sources
+        self.engine = ImportEngine(core, sources, target_node, progress_callback=self._on_progress)
+
+    def paths(self) -> List[Optional[str]]:
+        return list(self.sources)
+
+    def cancel(self) -> None:
+        """Request cancellation of the import."""
+        self.engine.cancel()
+        super().cancel()
+
+    def cancelled_before_start(self) -> None:
+        self.error.emit("Import cancelled by user")
+
+    def _on_progress(self, files: int, folders: int) -> None:
+        if self.progress_due():
+            self.progress.emit(files, folders)
+
+    def run(self) -> None:
+        try:
+            self.engine.scan()
+            self.finished.emit()
+        except InterruptedError as e:
+            logger.info(f"Import cancelled: {e}")
+            self.error.emit("Import cancelled by user")
+        except Exception as e:
+            logger.exception(f"Error during import: {e}")
+            self.error.emit(str(e))
+
+
+class LoadWorker(ScheduledWorker):
+    """
+    A scheduled worker for loading ISO files in the background with progress reporting.
+    """
+    progress = Signal(int, str)  # percent, status message
+    finished = Signal()
+    error = Signal(str)
+    priority = PRIORITY_INTERACTIVE
+
+    def __init__(self, core: ISOCore, file_path: str) -> None:
+        super().__init__()
+        self.job_name = f"load {os.path.basename(file_path)}"
+        self.core: ISOCore = core
+        self.file_path: str = file_path
+        self._cancelled: bool = False
+
+    def paths(self) -> List[Optional[str]]:
+        return [self.file_path]
+
+    def cancel(self) -> None:
+        """Request cancellation of the load operation."""
+        self._cancelled = True
+        super().cancel()
+
+    def run(self) -> None:
+        """Load the ISO with progress updates."""
+        try:
+            self.progress.emit(10, "Opening ISO file...")
+            if self._cancelled:
+                return
+
+            # Initialize
+            self.core.init_new_iso()
+
+            _, extension = os.path.splitext(self.file_path)
+
+            if extension.lower() == '.cue':
+                self.progress.emit(30, "Parsing CUE sheet...")
+                if self._cancelled:
+                    return
+
+                self.core._load_cue_sheet(self.file_path)
+                self.core.current_iso_path = self.file_path
+                self.core.iso_modified = False
+                self.progress.emit(100, "Complete")
+
+            else:
+                # Load regular ISO
+                self.progress.emit(25, "Reading ISO structure...")
+                if self._cancelled:
+                    return
+
+                self.core._open_image(self.file_path)
+
+                self.progress.emit(75, "Reading root directory...")
+                if self._cancelled:
+                    return
+
+                # Only the root is read here; the view fills in directories as they are expanded.
+                self.core.directory_tree = self.core._build_tree_from_pycdlib(lazy=True)
+
+                self.progress.emit(90, "Extracting boot information...")
+                if self._cancelled:
+                    return
+
+                self.core._extract_boot_info()
+                self.core.iso_modified = False
+
+                self.progress.emit(100, "Complete")
+
+            if not self._cancelled:
+                self.finished.emit()
+
+        except FileNotFoundError:
+            self.core.init_new_iso()
+            logger.error(f"ISO file not found at path: {self.file_path}")
+            self.error.emit(f"ISO file not found:\n{self.file_path}\n\nPossible solutions:\n• Check if the file exists\n• Verify you have read permissions\n• Check if the path is correct")
+        except PermissionError:
+            self.core.init_new_iso()
+            logger.error(f"Permission denied accessing ISO: {self.file_path}")
+            self.error.emit(f"Permission denied:\n{self.file_path}\n\nPossible solutions:\n• Check file permissions\n• Try running with appropriate privileges\n• Check if the file is locked by another application")
+        except Exception as e:
+            self.core.init_new_iso()
+            logger.exception(f"An unexpected error occurred while loading the ISO: {e}")
+            self.error.emit(f"Failed to load ISO:\n{str(e)}\n\nPossible solutions:\n• Verify the file is a valid ISO or CUE file\n• Check if the file is corrupted\n• Try opening with another ISO tool to verify\n• Check available disk space")
+
+
+class RipDiscWorker(ScheduledWorker):
+    """
+    A scheduled worker for ripping a disc in the background with a DiscRipper.
+    """
+    progress = Signal(int) # Percentage
+    status = Signal(str) # Amount copied, speed and time left
+    finished = Signal(str) # Error message (if any)
+    # The status line carries the speed and time left, which must stay readable
+    progress_interval = 0.25
+
+    def __init__(self, source_drive: str, dest_path: str) -> None:
+        super().__init__()
+        self.job_name = f"rip {source_drive}"
+        self.source_drive: str = source_drive
+        self.dest_path: str = dest_path
+        self.ripper = DiscRipper(source_drive, dest_path, default_algorithms(),
+                                 progress_callback=self._report_progress)
+
+    def _report_progress(self, done: int, total: int) -> None:
+        if not self.progress_due(done >= total):
+            return
+        if total:
+            self.progress.emit(min(100, done * 100 // total))
+        text = f"Ripping disc... {done // (1024 * 1024)} of {total // (1024 * 1024)} MB"
+        rate = self.ripper.bytes_per_second
+        if rate:
+            text += f" at {rate / (1024 * 1024):.1f} MB/s"
+        remaining = self.ripper.seconds_remaining()
+        if remaining is not None:
+            minutes, seconds = divmod(int(remaining), 60)
+            text += f", {minutes}:{seconds:02d} left"
+        self.status.emit(text)
+
+    def run(self) -> None:
+        """
+        Copies the disc to the output file.
+        """
+        try:
+            self.ripper.run()
+            if self.ripper.bad_sectors:
+                self.ripper.write_bad_sector_map(self.dest_path + '.badsectors')
+            self.progress.emit(100)
+            self.finished.emit("") # Success
+        except InterruptedError:
+            logger.info("Rip disc operation cancelled")
+            self.finished.emit("Ripping cancelled by user.")
+        except Exception as e:
+            logger.error(f"Disc ripping failed: {e}")
+            self.finished.emit(f"An unexpected error occurred: {e}")
+
+    def paths(self) -> List[Optional[str]]:
+        return [self.source_drive, self.dest_path]
+
+    def cancel(self) -> None:
+        """Request cancellation of the rip."""
+        self.ripper.cancel()
+        super().cancel()
+
+    def stop(self):
+        self.cancel()
+
+    def cancelled_before_start(self) -> None:
+        self.finished.emit("Ripping cancelled by user.")
+
+
 def parse_arguments():
     """Parse command-line arguments."""
     parser = argparse.ArgumentParser(
@@ -2517,6 +2949,13 @@ def parse_arguments():
         help='ISO or CUE file to open on startup'
     )
 
+    parser.add_argument(
+        '--convert',
+        nargs=2,
+        metavar=('CUE', 'ISO'),
+        help='Write the data track of a CUE/BIN image to an ISO file and exit, without opening the window'
+    )
+
     parser.add_argument(
         '--log-level',
         choices=['DEBUG', 'INFO', 'WARNING', 'ERROR', 'CRITICAL'],
@@ -2536,6 +2975,19 @@ def parse_arguments():
         help='Disable logging to file (log to console only)'
     )
 
+    parser.add_argument(
+        '--profile',
+        metavar='REPORT',
+        help='Time loading, saving and extracting, and write a JSON report of the phases, bytes read '
+             'and written, peak memory and throughput here on exit ("-" for standard output)'
+    )
+
+    parser.add_argument(
+        '--trace',
+        metavar='TRACE',
+        help='Also write the timed phases here as a Chrome trace (chrome://tracing, Perfetto)'
+    )
+
     return parser.parse_args()
 
 
@@ -2574,6 +3026,35 @@ def setup_logging(log_level, log_file=None):
     )
 
 
+def convert_cue_file(cue_path: str, output_path: str) -> int:
+    """Converts the data track of a CUE/BIN image to an ISO file; returns the exit status."""
+    try:
+        core = ISOCore()
+        core.load_iso(cue_path)
+        converter = core.cue_track_converter(output_path)
+        start = time.monotonic()
+        converter.run()
+        elapsed = time.monotonic() - start
+        rate = converter.bytes_done / elapsed / 1e6 if elapsed > 0 else 0.0
+        print(f"Wrote {converter.bytes_done} bytes to {output_path} ({rate:.1f} MB/s)")
+        return 0
+    except Exception as e:
+        logger.error(f"Conversion failed: {e}")
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+
+
+def write_profile(args):
+    """Writes the --profile report and --trace, if profiling was enabled."""
+    active = profiler.disable()
+    if active is None:
+        return
+    try:
+        active.write(args.profile, args.trace)
+    except OSError as e:
+        print(f"Warning: Could not write the profile: {e}", file=sys.stderr)
+
+
 def main():
     """The main entry point of the application."""
     args = parse_arguments()
@@ -2587,6 +3068,14 @@ def main():
     logger.info(f"Platform: {sys.platform}")
     logger.info(f"Log level: {args.log_level}")
 
+    if args.profile or args.trace:
+        profiler.enable()
+
+    if args.convert:
+        status = convert_cue_file(*args.convert)
+        write_profile(args)
+        sys.exit(status)
+
     try:
         app = QApplication(sys.argv)
         app.setApplicationName(APP_NAME)
@@ -2601,7 +3090,11 @@ def main():
             editor._load_iso_with_progress(args.file)
 
         logger.info("Application window shown, entering main event loop...")
-        sys.exit(app.exec())
+        status = app.exec()
+        # Jobs of windows that are gone have nothing to report to
+        shared_scheduler().shutdown(cancel=True)
+        write_profile(args)
+        sys.exit(status)
 
     except Exception as e:
         logger.exception(f"Fatal error in main: {e}")
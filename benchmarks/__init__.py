@@ -0,0 +1 @@
+"""Benchmarks; see run.py."""
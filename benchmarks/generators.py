@@ -0,0 +1,152 @@
+"""
+Synthetic, reproducible inputs for the benchmarks.
+
+Every generator takes a directory, a scale factor and a seed, and writes the
+same bytes for the same arguments, so timings of different commits are
+taken on identical data. Contents are pseudo-random, with no two files or
+blocks equal, and written a block at a time, so huge files cost no more
+memory than small ones.
+
+  many_small_files   thousands of 0.5-4 KiB files, a few hundred per directory
+  huge_files         a few files of tens of MiB
+  deep_tree          a chain of nested directories with a few files each
+  wide_directory     one directory with tens of thousands of tiny files
+  cue_bin            a CUE sheet for a BIN with a MODE1/2352 data track and an audio track
+"""
+
+import os
+import random
+from typing import Callable, Dict, Iterator
+
+from constants import CD_FRAME_SIZE, ISO_BLOCK_SIZE
+
+BLOCK_SIZE = 1024 * 1024
+
+# Audio CDs start their first track 2 seconds (150 frames) in
+_LEAD_IN_FRAMES = 150
+_SYNC = b'\x00' + b'\xff' * 10 + b'\x00'
+
+
+def _blocks(length: int, seed: int) -> Iterator[bytes]:
+    """Yields length pseudo-random bytes, BLOCK_SIZE at a time, determined by seed."""
+    if length <= 0:
+        return
+    size = min(BLOCK_SIZE, length)
+    block = random.Random(seed).getrandbits(8 * size).to_bytes(size, 'little')
+    offset = 0
+    while offset < length:
+        size = min(BLOCK_SIZE, length - offset)
+        # A different prefix per block keeps the blocks of one file distinct
+        prefix = (seed * 1000003 + offset).to_bytes(16, 'little')
+        yield prefix[:size] + block[16:size]
+        offset += size
+
+
+def _write_file(path: str, length: int, seed: int) -> None:
+    with open(path, 'wb') as f:
+        for block in _blocks(length, seed):
+            f.write(block)
+
+
+def many_small_files(root: str, scale: float = 1.0, seed: int = 1) -> Dict[str, int]:
+    """20000 files of 512 bytes to 4 KiB (at scale 1), 250 per directory."""
+    rng = random.Random(seed)
+    count = max(1, int(20000 * scale))
+    total = 0
+    for number in range(count):
+        directory = os.path.join(root, f"dir{number // 250:04d}")
+        if number % 250 == 0:
+            os.makedirs(directory, exist_ok=True)
+        size = rng.randint(512, 4096)
+        _write_file(os.path.join(directory, f"file{number:06d}.dat"), size, seed + number)
+        total += size
+    return {'files': count, 'bytes': total}
+
+
+def huge_files(root: str, scale: float = 1.0, seed: int = 2) -> Dict[str, int]:
+    """Three files of 64 MiB (at scale 1)."""
+    os.makedirs(root, exist_ok=True)
+    size = max(ISO_BLOCK_SIZE, int(64 * 1024 * 1024 * scale))
+    for number in range(3):
+        _write_file(os.path.join(root, f"huge{number}.bin"), size + number * 12345, seed + number)
+    return {'files': 3, 'bytes': 3 * size + 3 * 12345}
+
+
+def deep_tree(root: str, scale: float = 1.0, seed: int = 3) -> Dict[str, int]:
+    """48 nested directories with max(1, 10 * scale) files of 2 KiB each."""
+    per_level = max(1, int(10 * scale))
+    directory, total, count = root, 0, 0
+    for level in range(48):
+        directory = os.path.join(directory, f"level{level:02d}")
+        os.makedirs(directory, exist_ok=True)
+        for number in range(per_level):
+            _write_file(os.path.join(directory, f"f{number:03d}.txt"), 2048, seed + count)
+            total += 2048
+            count += 1
+    return {'files': count, 'bytes': total}
+
+
+def wide_directory(root: str, scale: float = 1.0, seed: int = 4) -> Dict[str, int]:
+    """30000 files of up to 64 bytes (at scale 1) in a single directory."""
+    directory = os.path.join(root, "wide")
+    os.makedirs(directory, exist_ok=True)
+    rng = random.Random(seed)
+    count = max(1, int(30000 * scale))
+    total = 0
+    for number in range(count):
+        size = rng.randint(0, 64)
+        with open(os.path.join(directory, f"entry_{number:06d}_{rng.getrandbits(32):08x}.txt"), 'wb') as f:
+            f.write(rng.getrandbits(8 * size).to_bytes(size, 'little') if size else b'')
+        total += size
+    return {'files': count, 'bytes': total}
+
+
+def _bcd(value: int) -> int:
+    return (value // 10) << 4 | value % 10
+
+
+def _mode1_sectors(data_sectors: int, seed: int) -> Iterator[bytes]:
+    """Yields raw MODE1/2352 sectors: sync, header with the address, data, and zeroed EDC/ECC."""
+    sector = 0
+    for block in _blocks(data_sectors * ISO_BLOCK_SIZE, seed):
+        for offset in range(0, len(block), ISO_BLOCK_SIZE):
+            minutes, rest = divmod(sector + _LEAD_IN_FRAMES, 60 * 75)
+            seconds, frames = divmod(rest, 75)
+            header = bytes([_bcd(minutes), _bcd(seconds), _bcd(frames), 1])
+            yield _SYNC + header + block[offset:offset + ISO_BLOCK_SIZE] + bytes(CD_FRAME_SIZE - 16 - ISO_BLOCK_SIZE)
+            sector += 1
+
+
+def cue_bin(root: str, scale: float = 1.0, seed: int = 5) -> Dict[str, int]:
+    """
+    image.cue and image.bin: a 100 MiB data track (at scale 1) followed by 30 seconds of audio.
+
+    Returns the sizes of the tracks' contents; the sheet is at 'image.cue' in root.
+    """
+    os.makedirs(root, exist_ok=True)
+    data_sectors = max(16, int(100 * 1024 * 1024 * scale) // ISO_BLOCK_SIZE)
+    audio_sectors = 30 * 75
+    with open(os.path.join(root, "image.bin"), 'wb') as f:
+        for raw in _mode1_sectors(data_sectors, seed):
+            f.write(raw)
+        for block in _blocks(audio_sectors * CD_FRAME_SIZE, seed + 1):
+            f.write(block)
+
+    minutes, rest = divmod(data_sectors, 60 * 75)
+    seconds, frames = divmod(rest, 75)
+    with open(os.path.join(root, "image.cue"), 'w', encoding='utf-8') as f:
+        f.write('FILE "image.bin" BINARY\n'
+                '  TRACK 01 MODE1/2352\n'
+                '    INDEX 01 00:00:00\n'
+                '  TRACK 02 AUDIO\n'
+                f'    INDEX 01 {minutes:02d}:{seconds:02d}:{frames:02d}\n')
+    return {'files': 2, 'bytes': data_sectors * ISO_BLOCK_SIZE + audio_sectors * CD_FRAME_SIZE}
+
+
+GENERATORS: Dict[str, Callable[..., Dict[str, int]]] = {
+    'many_small_files': many_small_files,
+    'huge_files': huge_files,
+    'deep_tree': deep_tree,
+    'wide_directory': wide_directory,
+    'cue_bin': cue_bin,
+}
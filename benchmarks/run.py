@@ -0,0 +1,321 @@
+"""
+Performance benchmarks, run separately from the unit tests.
+
+  python -m benchmarks.run [--scale S] [--scenario NAME]... [--repeat N] [-o RESULTS]
+  python -m benchmarks.run --compare BASELINE RESULTS [--threshold RATIO]
+
+Every scenario generates its input (see generators.py) and then times its
+operations one after another, each on the result of the one before:
+
+  file trees   import, save, open, tree, search, extract, checksum
+  cue_bin      open, extract, convert, checksum
+
+A scenario runs in a process of its own, and on Linux the peak RSS is reset
+before every operation, so peak_rss_bytes is that operation's high-water
+mark (elsewhere it is the process's high-water mark so far). The counters
+of the profiler module (bytes read and written, files) are recorded too.
+
+Results are appended to a JSON Lines file, one record per operation, with
+the commit they were measured at. --compare prints the fastest time of each
+operation in two such files and exits with 1 if any is slower by more than
+the threshold (operations under COMPARE_MIN_SECONDS are not counted), e.g.
+to check a branch against the last release.
+
+Inputs are kept in --work-dir when one is given, so repeated runs and runs of
+other commits reuse them instead of generating them again.
+"""
+
+import argparse
+import gc
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ProcessPoolExecutor
+from datetime import datetime, timezone
+from multiprocessing import get_context
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+_REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+if _REPO not in sys.path:
+    sys.path.insert(0, _REPO)
+
+import iso_scanner  # noqa: E402
+import profiler  # noqa: E402
+from benchmarks.generators import GENERATORS  # noqa: E402
+from checksums import hash_file  # noqa: E402
+from iso_logic import ISOCore, ExtractionEngine, ImportEngine  # noqa: E402
+from search_index import SearchIndex, SearchQuery  # noqa: E402
+
+DEFAULT_RESULTS = 'benchmark-results.jsonl'
+DEFAULT_THRESHOLD = 1.15
+# Operations faster than this in both files are too noisy to report as regressions
+COMPARE_MIN_SECONDS = 0.05
+CHECKSUM_ALGORITHMS = ('md5', 'sha256')
+SEARCH_QUERIES = ('file01', '7', 'no such name')
+
+Operation = Tuple[str, Callable[[], None]]
+
+
+def _tree_operations(source: str, work: str) -> List[Operation]:
+    """The operations of a scenario whose input is a directory tree."""
+    image = os.path.join(work, 'image.iso')
+    state: Dict[str, Any] = {}
+
+    def import_tree() -> None:
+        core = ISOCore()
+        ImportEngine(core, [source], core.directory_tree).run()
+        state['built'] = core
+
+    def save() -> None:
+        state['built'].save_iso(image, use_joliet=True, use_rock_ridge=True)
+
+    def open_image() -> None:
+        core = ISOCore()
+        core.load_iso(image, lazy=True)
+        state['loaded'] = core
+
+    def tree() -> None:
+        state['loaded'].load_all_children()
+
+    def search() -> None:
+        index = SearchIndex(state['loaded'])
+        index.reset()
+        index.build()
+        for text in SEARCH_QUERIES:
+            query = SearchQuery(text)
+            index.resolve(index.search(query), query)
+
+    def extract() -> None:
+        destination = os.path.join(work, 'extracted')
+        core = state['loaded']
+        ExtractionEngine(core, core.directory_tree, destination).run()
+
+    def checksum() -> None:
+        hash_file(image, CHECKSUM_ALGORITHMS)
+
+    return [('import', import_tree), ('save', save), ('open', open_image), ('tree', tree),
+            ('search', search), ('extract', extract), ('checksum', checksum)]
+
+
+def _cue_operations(source: str, work: str) -> List[Operation]:
+    """The operations of the CUE/BIN scenario."""
+    state: Dict[str, Any] = {}
+
+    def open_sheet() -> None:
+        core = ISOCore()
+        core.load_iso(os.path.join(source, 'image.cue'))
+        state['core'] = core
+
+    def extract() -> None:
+        core = state['core']
+        ExtractionEngine(core, core.directory_tree, os.path.join(work, 'tracks')).run()
+
+    def convert() -> None:
+        state['core'].cue_track_converter(os.path.join(work, 'track01.iso')).run()
+
+    def checksum() -> None:
+        hash_file(os.path.join(source, 'image.bin'), CHECKSUM_ALGORITHMS)
+
+    return [('open', open_sheet), ('extract', extract), ('convert', convert), ('checksum', checksum)]
+
+
+def _reset_peak_rss() -> bool:
+    """Resets the peak RSS of this process where the kernel allows it (Linux)."""
+    try:
+        with open('/proc/self/clear_refs', 'w') as f:
+            f.write('5')
+        return True
+    except OSError:
+        return False
+
+
+def _peak_rss(reset: bool) -> Optional[int]:
+    """Returns VmHWM after a reset, otherwise the peak RSS of the process so far."""
+    if reset:
+        try:
+            with open('/proc/self/status') as f:
+                for line in f:
+                    if line.startswith('VmHWM:'):
+                        return int(line.split()[1]) * 1024
+        except (OSError, ValueError, IndexError):
+            pass
+    return profiler.peak_rss()
+
+
+def _prepare_input(scenario: str, scale: float, inputs: str) -> Tuple[str, Dict[str, int]]:
+    """Generates the scenario's input in inputs, unless a complete one is there already."""
+    source = os.path.join(inputs, f"{scenario}-{scale:g}")
+    # Written once the input is complete, next to it so it is not imported with it
+    marker = source + '.json'
+    if os.path.exists(marker):
+        with open(marker, encoding='utf-8') as f:
+            return source, json.load(f)
+    shutil.rmtree(source, ignore_errors=True)
+    os.makedirs(source)
+    stats = GENERATORS[scenario](source, scale)
+    with open(marker, 'w', encoding='utf-8') as f:
+        json.dump(stats, f)
+    return source, stats
+
+
+def run_scenario(scenario: str, scale: float, work_dir: str, repeat: int) -> List[Dict[str, Any]]:
+    """Generates one scenario's input and times its operations repeat times; returns the records."""
+    source, stats = _prepare_input(scenario, scale, os.path.join(work_dir, 'inputs'))
+    make_operations = _cue_operations if scenario == 'cue_bin' else _tree_operations
+    records = []
+    for run in range(repeat):
+        work = tempfile.mkdtemp(prefix=f"{scenario}-", dir=work_dir)
+        failed = None
+        try:
+            for operation, function in make_operations(source, work):
+                record = {'scenario': scenario, 'operation': operation, 'scale': scale, 'run': run,
+                          'input_files': stats['files'], 'input_bytes': stats['bytes']}
+                if failed:
+                    record['error'] = f"skipped after {failed} failed"
+                    records.append(record)
+                    continue
+                gc.collect()
+                reset = _reset_peak_rss()
+                active = profiler.enable()
+                start = time.perf_counter()
+                try:
+                    function()
+                except Exception as e:
+                    failed = operation
+                    record['error'] = f"{type(e).__name__}: {e}"
+                record['seconds'] = round(time.perf_counter() - start, 6)
+                profiler.disable()
+                record['peak_rss_bytes'] = _peak_rss(reset)
+                record.update(active.report()['counters'])
+                records.append(record)
+        finally:
+            shutil.rmtree(work, ignore_errors=True)
+    return records
+
+
+def _environment() -> Dict[str, Any]:
+    """What the results were measured with."""
+    try:
+        commit = subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], cwd=_REPO, capture_output=True,
+                                text=True, check=True).stdout.strip()
+        dirty = subprocess.run(['git', 'status', '--porcelain', '--untracked-files=no'], cwd=_REPO,
+                               capture_output=True, text=True, check=True).stdout.strip()
+        commit += '-dirty' if dirty else ''
+    except (OSError, subprocess.CalledProcessError):
+        commit = None
+    return {
+        'commit': commit,
+        'date': datetime.now(timezone.utc).isoformat(timespec='seconds'),
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'native_scanner': iso_scanner.AVAILABLE,
+    }
+
+
+def run(scenarios: List[str], scale: float, repeat: int, output: str,
+        work_dir: Optional[str] = None, in_process: bool = False) -> int:
+    """Runs the scenarios and appends their records to output; returns the number of failed operations."""
+    environment = _environment()
+    temporary = work_dir is None
+    work_dir = work_dir or tempfile.mkdtemp(prefix='iso-editor-bench-')
+    os.makedirs(work_dir, exist_ok=True)
+    failures = 0
+    try:
+        for scenario in scenarios:
+            print(f"{scenario} (scale {scale:g}):", flush=True)
+            if in_process:
+                records = run_scenario(scenario, scale, work_dir, repeat)
+            else:
+                # A fresh process, so one scenario's memory does not count against the next
+                with ProcessPoolExecutor(max_workers=1, mp_context=get_context('spawn')) as pool:
+                    records = pool.submit(run_scenario, scenario, scale, work_dir, repeat).result()
+            with open(output, 'a', encoding='utf-8') as f:
+                for record in records:
+                    f.write(json.dumps({**environment, **record}) + '\n')
+            for record in records:
+                failures += 'error' in record
+                print(_format_record(record))
+    finally:
+        if temporary:
+            shutil.rmtree(work_dir, ignore_errors=True)
+    print(f"Results appended to {output}")
+    return failures
+
+
+def _format_record(record: Dict[str, Any]) -> str:
+    line = f"  {record['operation']:<9}"
+    if 'seconds' in record:
+        line += f" {record['seconds']:9.3f} s"
+    if record.get('peak_rss_bytes'):
+        line += f" {record['peak_rss_bytes'] / 2**20:8.1f} MiB peak"
+    if 'error' in record:
+        line += f"  {record['error']}"
+    return line
+
+
+def _fastest(path: str) -> Dict[Tuple[str, str], float]:
+    """The fastest successful time of every (scenario, operation) in a results file."""
+    fastest: Dict[Tuple[str, str], float] = {}
+    with open(path, encoding='utf-8') as f:
+        for line in f:
+            if not line.strip():
+                continue
+            record = json.loads(line)
+            if 'error' in record or 'seconds' not in record:
+                continue
+            key = (record['scenario'], record['operation'])
+            fastest[key] = min(fastest.get(key, record['seconds']), record['seconds'])
+    return fastest
+
+
+def compare(baseline: str, results: str, threshold: float = DEFAULT_THRESHOLD) -> int:
+    """Prints the operations of two results files side by side; returns 1 if any got slower than threshold."""
+    old, new = _fastest(baseline), _fastest(results)
+    regressions = 0
+    print(f"{'scenario':<18} {'operation':<9} {'baseline':>10} {'results':>10} {'ratio':>7}")
+    for key in sorted(old.keys() & new.keys()):
+        ratio = new[key] / old[key] if old[key] > 0 else 1.0
+        slower = ratio > threshold and new[key] >= COMPARE_MIN_SECONDS
+        regressions += slower
+        print(f"{key[0]:<18} {key[1]:<9} {old[key]:10.3f} {new[key]:10.3f} {ratio:7.2f}"
+              f"{'  SLOWER' if slower else ''}")
+    if regressions:
+        print(f"{regressions} operation(s) slower than {threshold:.2f}x the baseline")
+    return 1 if regressions else 0
+
+
+def parse_arguments(argv: Optional[List[str]] = None) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(prog='python -m benchmarks.run', description='ISO Editor benchmarks')
+    parser.add_argument('--scenario', action='append', choices=list(GENERATORS),
+                        help='Run only this scenario; may be repeated (default: all)')
+    parser.add_argument('--scale', type=float, default=1.0,
+                        help='Multiplies the number and size of generated files (default: 1)')
+    parser.add_argument('--repeat', type=int, default=1, help='Runs of every scenario (default: 1)')
+    parser.add_argument('-o', '--output', default=DEFAULT_RESULTS,
+                        help=f'The results file records are appended to (default: {DEFAULT_RESULTS})')
+    parser.add_argument('--work-dir', help='Keep generated inputs here and reuse them (default: a temporary directory)')
+    parser.add_argument('--in-process', action='store_true',
+                        help='Run scenarios in this process; peak memory then carries over between them')
+    parser.add_argument('--compare', nargs=2, metavar=('BASELINE', 'RESULTS'),
+                        help='Compare two results files instead of running anything')
+    parser.add_argument('--threshold', type=float, default=DEFAULT_THRESHOLD,
+                        help=f'Slowdown ratio --compare reports as a regression (default: {DEFAULT_THRESHOLD})')
+    return parser.parse_args(argv)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    args = parse_arguments(argv)
+    if args.compare:
+        return compare(*args.compare, threshold=args.threshold)
+    failures = run(args.scenario or list(GENERATORS), args.scale, max(1, args.repeat), args.output,
+                   args.work_dir, args.in_process)
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,315 @@
+"""
+Shared, size-bounded cache of the blocks of opened images.
+
+pycdlib reads an image with many small seeks and reads: volume descriptors,
+directory records, and the extents of every file opened with
+open_file_from_iso(). On a local disk the page cache absorbs them. On a
+network share, though, each one is a round trip. ISOCore therefore hands
+pycdlib a CachedImageFile instead of a plain file:
+
+  blocks       the image is read in BLOCK_SIZE blocks, kept in one LRU that
+               every open image shares, up to the cache's capacity
+  coalescing   the missing blocks of a read are fetched with one read per
+               run of adjacent blocks, not one per block
+  read-ahead   a read that continues where an earlier read of the same handle
+               ended is sequential; the blocks after it are then fetched in
+               the background, over a window that doubles with every
+               sequential read up to READ_AHEAD_MAX. Several interleaved
+               streams (e.g. extraction workers) are followed at once.
+
+Blocks are keyed by the image's path, device, inode, size and modification
+time, so a rewritten image never serves stale data. A capacity of 0 turns
+caching and read-ahead off and reads straight from the file.
+"""
+
+import io
+import logging
+import os
+import threading
+from collections import OrderedDict
+from concurrent.futures import Future, ThreadPoolExecutor
+from typing import Any, Dict, List, Optional, Set, Tuple
+
+import profiler
+from constants import IMAGE_BLOCK_CACHE_SIZE, ISO_BLOCK_SIZE
+
+logger = logging.getLogger(__name__)
+
+BLOCK_SIZE = 32 * ISO_BLOCK_SIZE
+# Read-ahead window after the first sequential read, and the most it grows to
+READ_AHEAD_MIN = 4 * BLOCK_SIZE
+READ_AHEAD_MAX = 64 * BLOCK_SIZE
+# Sequential streams followed per handle; the least recently read one is dropped first
+READ_AHEAD_STREAMS = 8
+READ_AHEAD_WORKERS = 2
+
+_BlockKey = Tuple[Any, int]
+
+_shared: Optional['BlockCache'] = None
+_shared_lock = threading.Lock()
+
+
+def shared_cache() -> 'BlockCache':
+    """Returns the process-wide cache, created with IMAGE_BLOCK_CACHE_SIZE on first use."""
+    global _shared
+    with _shared_lock:
+        if _shared is None:
+            _shared = BlockCache(IMAGE_BLOCK_CACHE_SIZE)
+        return _shared
+
+
+def _runs(indexes: List[int]) -> List[Tuple[int, int]]:
+    """Groups sorted block indexes into (first, count) runs of adjacent blocks."""
+    runs: List[Tuple[int, int]] = []
+    for index in indexes:
+        if runs and runs[-1][0] + runs[-1][1] == index:
+            runs[-1] = (runs[-1][0], runs[-1][1] + 1)
+        else:
+            runs.append((index, 1))
+    return runs
+
+
+class BlockCache:
+    """An LRU of image blocks shared by every CachedImageFile opened through it; thread-safe."""
+
+    def __init__(self, capacity: int = IMAGE_BLOCK_CACHE_SIZE, block_size: int = BLOCK_SIZE) -> None:
+        """
+        Args:
+            capacity (int): Bytes of blocks kept; 0 disables caching and read-ahead.
+            block_size (int): Bytes per block, a multiple of ISO_BLOCK_SIZE.
+        """
+        self.capacity = capacity
+        self.block_size = block_size
+        self.hits = 0
+        self.misses = 0
+        self._blocks: 'OrderedDict[_BlockKey, bytes]' = OrderedDict()
+        self._size = 0
+        # Blocks being read ahead, with the read that delivers them
+        self._pending: Dict[_BlockKey, Future] = {}
+        self._lock = threading.Lock()
+        self._executor: Optional[ThreadPoolExecutor] = None
+
+    def open(self, path: str) -> 'CachedImageFile':
+        """Opens an image for reading through the cache."""
+        return CachedImageFile(path, self)
+
+    @property
+    def size(self) -> int:
+        """Bytes of blocks currently cached."""
+        return self._size
+
+    def clear(self) -> None:
+        with self._lock:
+            self._blocks.clear()
+            self._size = 0
+
+    def forget(self, path: str) -> None:
+        """Drops the cached blocks of path, e.g. after it was written in place."""
+        path = os.path.abspath(path)
+        with self._lock:
+            for key in [key for key in self._blocks if key[0][0] == path]:
+                self._size -= len(self._blocks.pop(key))
+
+    def read(self, file: 'CachedImageFile', offset: int, size: int) -> bytes:
+        """Returns up to size bytes of file at offset, from cached blocks where possible."""
+        size = min(size, file.length - offset)
+        if size <= 0:
+            return b''
+        if self.capacity <= 0:
+            return file.pread(offset, size)
+
+        block_size = self.block_size
+        first, last = offset // block_size, (offset + size - 1) // block_size
+        blocks: Dict[int, bytes] = {}
+        waits: Set[Future] = set()
+        missing: List[int] = []
+        with self._lock:
+            for index in range(first, last + 1):
+                key = (file.key, index)
+                data = self._blocks.get(key)
+                if data is not None:
+                    self._blocks.move_to_end(key)
+                    blocks[index] = data
+                elif key in self._pending:
+                    waits.add(self._pending[key])
+                else:
+                    missing.append(index)
+            self.hits += len(blocks)
+            self.misses += len(missing)
+        profiler.count('block_cache_hits', len(blocks))
+        profiler.count('block_cache_misses', len(missing))
+
+        for start, count in _runs(missing):
+            blocks.update(self._fetch(file, start, count))
+        for future in waits:
+            try:
+                blocks.update(future.result())
+            except Exception as e:
+                logger.debug(f"Read-ahead of {file.name} failed: {e}")
+        # Blocks a failed read-ahead was to deliver
+        for start, count in _runs([index for index in range(first, last + 1) if index not in blocks]):
+            blocks.update(self._fetch(file, start, count))
+
+        data = b''.join(blocks[index] for index in range(first, last + 1))
+        start = offset - first * block_size
+        return data[start:start + size]
+
+    def read_ahead(self, file: 'CachedImageFile', offset: int, length: int) -> None:
+        """Starts fetching the blocks of file in [offset, offset + length) that are neither cached nor pending."""
+        if self.capacity <= 0:
+            return
+        # Never more than half the cache, or the window would evict itself
+        length = min(length, file.length - offset, self.capacity // 2)
+        if length <= 0:
+            return
+        block_size = self.block_size
+        first, last = offset // block_size, (offset + length - 1) // block_size
+        with self._lock:
+            wanted = [index for index in range(first, last + 1)
+                      if (file.key, index) not in self._blocks and (file.key, index) not in self._pending]
+            if not wanted:
+                return
+            if self._executor is None:
+                self._executor = ThreadPoolExecutor(max_workers=READ_AHEAD_WORKERS,
+                                                    thread_name_prefix='image-read-ahead')
+            for start, count in _runs(wanted):
+                future = self._executor.submit(self._read_ahead, file, start, count)
+                file.read_aheads.add(future)
+                future.add_done_callback(file.read_aheads.discard)
+                for index in range(start, start + count):
+                    self._pending[(file.key, index)] = future
+
+    def _read_ahead(self, file: 'CachedImageFile', start: int, count: int) -> Dict[int, bytes]:
+        try:
+            blocks = self._fetch(file, start, count)
+            profiler.count('bytes_read_ahead', sum(len(data) for data in blocks.values()))
+            return blocks
+        finally:
+            with self._lock:
+                for index in range(start, start + count):
+                    self._pending.pop((file.key, index), None)
+
+    def _fetch(self, file: 'CachedImageFile', start: int, count: int) -> Dict[int, bytes]:
+        """Reads count adjacent blocks with one read, caches them and returns them by index."""
+        block_size = self.block_size
+        data = file.pread(start * block_size, count * block_size)
+        blocks = {start + n: data[offset:offset + block_size]
+                  for n, offset in enumerate(range(0, len(data), block_size))}
+        with self._lock:
+            for index, block in blocks.items():
+                key = (file.key, index)
+                old = self._blocks.pop(key, None)
+                if old is not None:
+                    self._size -= len(old)
+                self._blocks[key] = block
+                self._size += len(block)
+            while self._size > self.capacity and self._blocks:
+                _, evicted = self._blocks.popitem(last=False)
+                self._size -= len(evicted)
+        return blocks
+
+
+class CachedImageFile(io.RawIOBase):
+    """
+    A read-only, seekable image file whose reads go through a BlockCache.
+
+    Like any file object, one handle has one position; callers sharing it
+    between threads must serialize their seek() and read() pairs.
+    """
+
+    def __init__(self, path: str, cache: BlockCache) -> None:
+        super().__init__()
+        self.name = path
+        self.mode = 'rb'
+        self._cache = cache
+        self._fd = os.open(path, os.O_RDONLY | getattr(os, 'O_BINARY', 0))
+        stats = os.fstat(self._fd)
+        self.length: int = stats.st_size
+        self.key = (os.path.abspath(path), stats.st_dev, stats.st_ino, stats.st_size, stats.st_mtime_ns)
+        self._pos = 0
+        # Where each followed sequential stream ended, with its read-ahead window
+        self._streams: 'OrderedDict[int, int]' = OrderedDict()
+        # Read-aheads still running for this handle, waited for by close()
+        self.read_aheads: Set[Future] = set()
+        # Serializes the seek and read of pread() where os.pread is not available
+        self._fd_lock = threading.Lock()
+
+    def readable(self) -> bool:
+        return True
+
+    def seekable(self) -> bool:
+        return True
+
+    def fileno(self) -> int:
+        return self._fd
+
+    def tell(self) -> int:
+        return self._pos
+
+    def seek(self, offset: int, whence: int = io.SEEK_SET) -> int:
+        if whence == io.SEEK_SET:
+            new_pos = offset
+        elif whence == io.SEEK_CUR:
+            new_pos = self._pos + offset
+        elif whence == io.SEEK_END:
+            new_pos = self.length + offset
+        else:
+            raise ValueError(f"Invalid whence value: {whence}")
+        if new_pos < 0:
+            raise ValueError("Negative seek position")
+        self._pos = new_pos
+        return self._pos
+
+    def read(self, size: int = -1) -> bytes:
+        if self.closed:
+            raise ValueError("I/O operation on closed file")
+        if size is None or size < 0:
+            size = self.length - self._pos
+        offset = self._pos
+        data = self._cache.read(self, offset, size)
+        self._pos += len(data)
+
+        window = self._streams.pop(offset, None)
+        if data:
+            if window is not None:
+                window = min(max(window * 2, READ_AHEAD_MIN), READ_AHEAD_MAX)
+                self._cache.read_ahead(self, self._pos, window)
+            self._streams[self._pos] = window or 0
+            while len(self._streams) > READ_AHEAD_STREAMS:
+                self._streams.popitem(last=False)
+        return data
+
+    def readinto(self, buffer: Any) -> int:
+        data = self.read(len(buffer))
+        buffer[:len(data)] = data
+        return len(data)
+
+    def pread(self, offset: int, size: int) -> bytes:
+        """Reads size bytes at offset from the file itself, short only at its end."""
+        chunks = []
+        while size > 0:
+            if hasattr(os, 'pread'):
+                chunk = os.pread(self._fd, size, offset)
+            else:
+                with self._fd_lock:
+                    os.lseek(self._fd, offset, os.SEEK_SET)
+                    chunk = os.read(self._fd, size)
+            if not chunk:
+                break
+            chunks.append(chunk)
+            offset += len(chunk)
+            size -= len(chunk)
+        return chunks[0] if len(chunks) == 1 else b''.join(chunks)
+
+    def close(self) -> None:
+        if self.closed:
+            return
+        # The descriptor must outlive every read-ahead that uses it
+        for future in list(self.read_aheads):
+            try:
+                future.result()
+            except Exception:
+                pass
+        self.read_aheads.clear()
+        os.close(self._fd)
+        super().close()
@@ -0,0 +1,333 @@
+"""
+Checksum calculation for ISO images.
+
+MultiHasher feeds every chunk to several hash algorithms at once, each on
+its own thread. hashlib releases the GIL while hashing large buffers, so the
+algorithms run on separate cores. The reader only hands each chunk over and
+moves on. BLAKE3 and xxh3 are offered when the optional `blake3` and `xxhash`
+packages are installed.
+
+HashingWriter is an output file for pycdlib's write_fp() that hashes the
+image while it is written, so a save does not have to read it back.
+"""
+
+import hashlib
+import logging
+import mmap
+import queue
+import threading
+from typing import Any, Callable, Dict, Iterable, List, Optional
+
+from constants import CHECKSUM_BUFFER_SIZE, CHECKSUM_ALGORITHMS, OPTIONAL_CHECKSUM_ALGORITHMS
+
+logger = logging.getLogger(__name__)
+
+try:
+    import blake3 as _blake3
+except ImportError:
+    _blake3 = None
+
+try:
+    import xxhash as _xxhash
+except ImportError:
+    _xxhash = None
+
+# Chunks each hashing thread may have queued before update() blocks
+_QUEUE_DEPTH = 4
+
+# Display names for the algorithms this module knows about
+ALGORITHM_NAMES = {
+    'md5': 'MD5',
+    'sha1': 'SHA-1',
+    'sha256': 'SHA-256',
+    'sha512': 'SHA-512',
+    'blake2b': 'BLAKE2b',
+    'blake3': 'BLAKE3',
+    'xxh3_128': 'XXH3-128',
+}
+
+
+def _new_hash(algorithm: str) -> Any:
+    """Creates a hash object with the hashlib interface for the given algorithm."""
+    if algorithm == 'blake3':
+        if _blake3 is None:
+            raise ValueError("BLAKE3 requires the 'blake3' package")
+        # blake3 spreads large updates over several threads on its own
+        return _blake3.blake3(max_threads=_blake3.blake3.AUTO)
+    if algorithm == 'xxh3_128':
+        if _xxhash is None:
+            raise ValueError("XXH3 requires the 'xxhash' package")
+        return _xxhash.xxh3_128()
+    return hashlib.new(algorithm)
+
+
+def available_algorithms() -> List[str]:
+    """Returns the algorithms from ALGORITHM_NAMES that can be used in this environment."""
+    available = []
+    for algorithm in ALGORITHM_NAMES:
+        try:
+            _new_hash(algorithm)
+        except ValueError:
+            continue
+        available.append(algorithm)
+    return available
+
+
+def content_hash() -> Any:
+    """
+    Returns a new hash object for telling file contents apart, not for publishing.
+
+    xxh3-128 when xxhash is installed, BLAKE2b otherwise; both are much faster than SHA-256.
+    """
+    if _xxhash is not None:
+        return _xxhash.xxh3_128()
+    return hashlib.blake2b(digest_size=16)
+
+
+def default_algorithms() -> List[str]:
+    """Returns CHECKSUM_ALGORITHMS plus the optional algorithms that are installed."""
+    available = available_algorithms()
+    return list(CHECKSUM_ALGORITHMS) + [a for a in OPTIONAL_CHECKSUM_ALGORITHMS if a in available]
+
+
+class _HashThread(threading.Thread):
+    """Runs one hash object over the chunks put into its queue."""
+
+    def __init__(self, algorithm: str) -> None:
+        super().__init__(name=f"hash-{algorithm}", daemon=True)
+        self.algorithm = algorithm
+        self.hasher = _new_hash(algorithm)
+        self.chunks: 'queue.Queue[Optional[Any]]' = queue.Queue(maxsize=_QUEUE_DEPTH)
+        self.error: Optional[BaseException] = None
+
+    def run(self) -> None:
+        while True:
+            chunk = self.chunks.get()
+            if chunk is None:
+                return
+            if self.error is None:
+                try:
+                    self.hasher.update(chunk)
+                except BaseException as e:  # reported by MultiHasher.hexdigests()
+                    self.error = e
+
+
+class MultiHasher:
+    """
+    Computes several digests of one byte stream in a single pass.
+
+    With threaded=True (the default), every algorithm runs on its own thread.
+    Chunks passed to update() must not be modified afterwards, so pass bytes
+    objects rather than a reused buffer.
+    """
+
+    def __init__(self, algorithms: Iterable[str], threaded: bool = True) -> None:
+        self.algorithms: List[str] = list(algorithms)
+        if not self.algorithms:
+            raise ValueError("At least one checksum algorithm is required")
+        self._finished: Optional[Dict[str, str]] = None
+        if threaded and len(self.algorithms) > 1:
+            self._threads: Optional[List[_HashThread]] = [_HashThread(a) for a in self.algorithms]
+            for thread in self._threads:
+                thread.start()
+            self._hashers = None
+        else:
+            self._threads = None
+            self._hashers = {a: _new_hash(a) for a in self.algorithms}
+
+    def update(self, chunk: Any) -> None:
+        """Adds a chunk of data to every digest."""
+        if self._finished is not None:
+            raise ValueError("update() called after hexdigests()")
+        if not chunk:
+            return
+        if self._threads is None:
+            for hasher in self._hashers.values():
+                hasher.update(chunk)
+            return
+        for thread in self._threads:
+            thread.chunks.put(chunk)
+
+    def hexdigests(self) -> Dict[str, str]:
+        """
+        Finishes hashing and returns {algorithm: hex digest}.
+
+        Raises:
+            Exception: Whatever a hashing thread raised while processing a chunk.
+        """
+        if self._finished is None:
+            if self._threads is None:
+                self._finished = {a: h.hexdigest() for a, h in self._hashers.items()}
+            else:
+                self.close()
+                for thread in self._threads:
+                    if thread.error is not None:
+                        raise thread.error
+                self._finished = {t.algorithm: t.hasher.hexdigest() for t in self._threads}
+        return dict(self._finished)
+
+    def close(self) -> None:
+        """Stops the hashing threads; safe to call more than once."""
+        if self._threads is None:
+            return
+        for thread in self._threads:
+            if thread.is_alive():
+                thread.chunks.put(None)
+        for thread in self._threads:
+            thread.join()
+
+
+def _map_file(f: Any, size: int) -> Optional[mmap.mmap]:
+    """Maps an open file for sequential reading; None where it cannot be mapped, e.g. empty files or pipes."""
+    if size <= 0:
+        return None
+    try:
+        mapped = mmap.mmap(f.fileno(), size, access=mmap.ACCESS_READ)
+    except (OSError, ValueError, OverflowError) as e:
+        logger.debug(f"Cannot map {f.name}, reading it instead: {e}")
+        return None
+    if hasattr(mapped, 'madvise') and hasattr(mmap, 'MADV_SEQUENTIAL'):
+        mapped.madvise(mmap.MADV_SEQUENTIAL)
+    return mapped
+
+
+def hash_file(file_path: str, algorithms: Iterable[str], chunk_size: int = CHECKSUM_BUFFER_SIZE,
+              progress_callback: Optional[Callable[[int, int], None]] = None,
+              is_cancelled: Optional[Callable[[], bool]] = None) -> Optional[Dict[str, str]]:
+    """
+    Computes several digests of a file in one read pass.
+
+    The file is memory-mapped where possible, and the hashing threads read
+    chunk_size slices at aligned offsets straight from the page cache, with
+    no copy into Python objects; otherwise it is read chunk by chunk.
+
+    Args:
+        file_path (str): The file to hash.
+        algorithms: Names of the algorithms, e.g. ('md5', 'sha1', 'sha256').
+        chunk_size (int): Bytes read per step.
+        progress_callback: Called as (bytes_done, bytes_total) after every chunk.
+        is_cancelled: Polled between chunks; hashing stops when it returns True.
+
+    Returns:
+        dict: {algorithm: hex digest}, or None if cancelled.
+    """
+    # Unbuffered, so each read returns a fresh bytes object without an extra copy
+    with open(file_path, 'rb', buffering=0) as f:
+        total = f.seek(0, 2)
+        f.seek(0)
+        mapped = _map_file(f, total)
+        view = memoryview(mapped) if mapped is not None else None
+        hasher = MultiHasher(algorithms)
+        try:
+            done = 0
+            while True:
+                if is_cancelled and is_cancelled():
+                    logger.info(f"Checksum calculation for {file_path} cancelled")
+                    return None
+                chunk = view[done:done + chunk_size] if view is not None else f.read(chunk_size)
+                if not chunk:
+                    break
+                hasher.update(chunk)
+                done += len(chunk)
+                if progress_callback:
+                    progress_callback(done, total)
+            return hasher.hexdigests()
+        finally:
+            # The threads must be done with the slices before the map goes away
+            hasher.close()
+            chunk = None
+            if view is not None:
+                view.release()
+                mapped.close()
+
+
+class HashingWriter:
+    """
+    A writable, seekable output file that hashes the data written to it.
+
+    Bytes are hashed in file order as long as every write starts at or after
+    the end of the hashed prefix. Regions skipped with seek() are zeros in
+    the file and are hashed as such. If something overwrites data that was
+    already hashed, hexdigests() falls back to reading the finished file.
+
+    There is deliberately no fileno(): pycdlib would then copy file data
+    with os.sendfile() and bypass write().
+    """
+
+    def __init__(self, file_path: str, algorithms: Iterable[str]) -> None:
+        self.file_path = file_path
+        self.algorithms: List[str] = list(algorithms)
+        self._file = open(file_path, 'wb')
+        self._hasher = MultiHasher(self.algorithms)
+        self._position = 0
+        self._hashed = 0
+        self._in_order = True
+
+    def __enter__(self) -> 'HashingWriter':
+        return self
+
+    def __exit__(self, *exc_info: Any) -> None:
+        self.close()
+
+    def write(self, data: Any) -> int:
+        # The hashing threads keep a reference, so the chunk must not change later.
+        chunk = data if isinstance(data, bytes) else bytes(data)
+        written = self._file.write(chunk)
+        start = self._position
+        self._position += len(chunk)
+        if self._in_order:
+            if start < self._hashed:
+                logger.debug(f"Write at {start} rewrites hashed data; {self.file_path} will be re-read")
+                self._in_order = False
+            else:
+                self._hash_zeros(start)
+                self._hasher.update(chunk)
+                self._hashed = self._position
+        return written
+
+    def seek(self, offset: int, whence: int = 0) -> int:
+        self._position = self._file.seek(offset, whence)
+        return self._position
+
+    def tell(self) -> int:
+        return self._position
+
+    def truncate(self, size: Optional[int] = None) -> int:
+        size = self._file.truncate(size)
+        if size < self._hashed:
+            self._in_order = False
+        return size
+
+    def flush(self) -> None:
+        self._file.flush()
+
+    def seekable(self) -> bool:
+        return True
+
+    def writable(self) -> bool:
+        return True
+
+    def hexdigests(self) -> Dict[str, str]:
+        """Finishes the output file and returns {algorithm: hex digest} of its contents."""
+        self._file.flush()
+        end = self._file.seek(0, 2)
+        self._file.seek(self._position)
+        if self._in_order:
+            self._hash_zeros(end)
+            return self._hasher.hexdigests()
+        self._hasher.close()
+        return hash_file(self.file_path, self.algorithms)
+
+    def close(self) -> None:
+        self._hasher.close()
+        self._file.close()
+
+    def _hash_zeros(self, end: int) -> None:
+        """Hashes the unwritten gap between the hashed prefix and `end`."""
+        while self._hashed < end:
+            length = min(end - self._hashed, len(_ZEROS))
+            self._hasher.update(_ZEROS if length == len(_ZEROS) else bytes(length))
+            self._hashed += length
+
+
+_ZEROS = bytes(CHECKSUM_BUFFER_SIZE)
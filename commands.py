@@ -4,9 +4,15 @@ Command pattern implementation for undo/redo functionality.
 This module provides command classes for undoable operations in the ISO Editor.
 """
 
-from typing import Optional, Dict, Any, List
+from typing import Optional, Dict, Any, List, Deque, Iterator
 from abc import ABC, abstractmethod
+from collections import deque
+from contextlib import contextmanager
 import logging
+import os
+import tempfile
+
+from constants import UNDO_HISTORY_MEMORY_LIMIT
 
 logger = logging.getLogger(__name__)
 
@@ -49,6 +55,30 @@ class Command(ABC):
         """
         pass
 
+    def payload_nodes(self) -> List[Dict[str, Any]]:
+        """
+        Get the nodes with file data in memory that this command holds outside the tree.
+
+        CommandHistory counts their data against its memory limit.
+
+        Returns:
+            list: File nodes whose 'file_data' is set
+        """
+        return []
+
+
+def _nodes_with_data(nodes: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
+    """Returns the file nodes in the loaded subtrees of nodes whose data is held in memory."""
+    found = []
+    stack = list(nodes)
+    while stack:
+        node = stack.pop()
+        if node.get('is_directory'):
+            stack.extend(node.get('children', []))
+        elif node.get('file_data') is not None:
+            found.append(node)
+    return found
+
 
 class AddFileCommand(Command):
     """Command for adding a file to the ISO."""
@@ -66,18 +96,16 @@ class AddFileCommand(Command):
         self.file_path = file_path
         self.target_node = target_node
         self.added_node: Optional[Dict[str, Any]] = None
+        self.executed = False
 
     def execute(self) -> bool:
         """Add the file to the ISO."""
         try:
             self.core.add_file_to_directory(self.file_path, self.target_node)
-            # Find the newly added node (it's the last child with this filename)
-            import os
-            filename = os.path.basename(self.file_path)
-            for node in reversed(self.target_node['children']):
-                if node['name'] == filename:
-                    self.added_node = node
-                    break
+            # Find the newly added node; it replaced any other entry of that name
+            directory = self.target_node if self.target_node['is_directory'] else self.target_node['parent']
+            self.added_node = self.core.find_child(directory, os.path.basename(self.file_path), is_directory=False)
+            self.executed = True
             logger.info(f"Executed: Add file '{self.file_path}'")
             return True
         except Exception as e:
@@ -89,6 +117,7 @@ class AddFileCommand(Command):
         try:
             if self.added_node:
                 self.core.remove_node(self.added_node)
+                self.executed = False
                 logger.info(f"Undone: Add file '{self.file_path}'")
                 return True
             return False
@@ -98,9 +127,14 @@ class AddFileCommand(Command):
 
     def description(self) -> str:
         """Get description of this command."""
-        import os
         return f"Add file '{os.path.basename(self.file_path)}'"
 
+    def payload_nodes(self) -> List[Dict[str, Any]]:
+        """The added file once undone."""
+        if self.executed or not self.added_node:
+            return []
+        return _nodes_with_data([self.added_node])
+
 
 class RemoveNodeCommand(Command):
     """Command for removing a file or folder from the ISO."""
@@ -117,18 +151,17 @@ class RemoveNodeCommand(Command):
         self.node = node
         self.parent = node.get('parent')
         self.index: Optional[int] = None
+        self.executed = False
 
     def execute(self) -> bool:
         """Remove the node from the ISO."""
         try:
             # Remember the index so we can restore to the same position
             if self.parent and 'children' in self.parent:
-                try:
-                    self.index = self.parent['children'].index(self.node)
-                except ValueError:
-                    self.index = None
+                self.index = self.core.child_index(self.parent).position(self.node)
 
             self.core.remove_node(self.node)
+            self.executed = True
             logger.info(f"Executed: Remove '{self.node.get('name')}'")
             return True
         except Exception as e:
@@ -140,11 +173,8 @@ class RemoveNodeCommand(Command):
         try:
             if self.parent and 'children' in self.parent:
                 # Restore to the same position if we know the index
-                if self.index is not None and self.index <= len(self.parent['children']):
-                    self.parent['children'].insert(self.index, self.node)
-                else:
-                    self.parent['children'].append(self.node)
-                self.core.iso_modified = True
+                self.core.insert_node(self.parent, self.node, self.index)
+                self.executed = False
                 logger.info(f"Undone: Remove '{self.node.get('name')}'")
                 return True
             return False
@@ -157,6 +187,10 @@ class RemoveNodeCommand(Command):
         node_type = "folder" if self.node.get('is_directory') else "file"
         return f"Remove {node_type} '{self.node.get('name')}'"
 
+    def payload_nodes(self) -> List[Dict[str, Any]]:
+        """The removed subtree while it is out of the tree."""
+        return _nodes_with_data([self.node]) if self.executed else []
+
 
 class AddFolderCommand(Command):
     """Command for adding a folder to the ISO."""
@@ -180,10 +214,7 @@ class AddFolderCommand(Command):
         try:
             self.core.add_folder_to_directory(self.folder_name, self.target_node)
             # Find the newly added folder
-            for node in reversed(self.target_node['children']):
-                if node['name'] == self.folder_name and node.get('is_directory'):
-                    self.added_node = node
-                    break
+            self.added_node = self.core.find_child(self.target_node, self.folder_name, is_directory=True)
             logger.info(f"Executed: Add folder '{self.folder_name}'")
             return True
         except Exception as e:
@@ -210,7 +241,7 @@ class AddFolderCommand(Command):
 class RenameNodeCommand(Command):
     """Command for renaming a file or folder in the ISO."""
 
-    def __init__(self, node: Dict[str, Any], old_name: str, new_name: str):
+    def __init__(self, node: Dict[str, Any], old_name: str, new_name: str, core=None):
         """
         Initialize the RenameNodeCommand.
 
@@ -218,15 +249,17 @@ class RenameNodeCommand(Command):
             node: The node to rename
             old_name: The current name
             new_name: The new name
+            core: The ISOCore instance that performs the rename; without it only the name is set
         """
         self.node = node
         self.old_name = old_name
         self.new_name = new_name
+        self.core = core
 
     def execute(self) -> bool:
         """Rename the node."""
         try:
-            self.node['name'] = self.new_name
+            self._set_name(self.new_name)
             logger.info(f"Executed: Rename '{self.old_name}' to '{self.new_name}'")
             return True
         except Exception as e:
@@ -236,33 +269,240 @@ class RenameNodeCommand(Command):
     def undo(self) -> bool:
         """Restore the original name."""
         try:
-            self.node['name'] = self.old_name
+            self._set_name(self.old_name)
             logger.info(f"Undone: Rename '{self.new_name}' back to '{self.old_name}'")
             return True
         except Exception as e:
             logger.error(f"Failed to undo RenameNodeCommand: {e}")
             return False
 
+    def _set_name(self, name: str) -> None:
+        if self.core:
+            # Keeps the parent's ChildIndex in step and notifies the tree listeners
+            self.core.rename_node(self.node, name)
+        else:
+            self.node['name'] = name
+
     def description(self) -> str:
         """Get description of this command."""
         return f"Rename '{self.old_name}' to '{self.new_name}'"
 
 
+class CompositeCommand(Command):
+    """Several commands undone and redone as one, e.g. the files added from one dialog."""
+
+    def __init__(self, commands: List[Command], description: str):
+        """
+        Initialize the CompositeCommand.
+
+        Args:
+            commands: The commands, in the order they are executed
+            description: Description of the whole group
+        """
+        self.commands = commands
+        self._description = description
+
+    def execute(self) -> bool:
+        """Execute every command; if one fails, the ones before it are undone."""
+        for position, command in enumerate(self.commands):
+            if not command.execute():
+                for done in reversed(self.commands[:position]):
+                    done.undo()
+                return False
+        return True
+
+    def undo(self) -> bool:
+        """Undo every command in reverse; if one fails, the ones after it are redone."""
+        for position in range(len(self.commands) - 1, -1, -1):
+            if not self.commands[position].undo():
+                for done in self.commands[position + 1:]:
+                    done.execute()
+                return False
+        return True
+
+    def description(self) -> str:
+        """Get description of this command."""
+        return self._description
+
+    def payload_nodes(self) -> List[Dict[str, Any]]:
+        """The payload nodes of all commands."""
+        return [node for command in self.commands for node in command.payload_nodes()]
+
+
+class _ChangeRecorder:
+    """Tree listener that records the nodes inserted into and removed from the tree."""
+
+    def __init__(self):
+        self.changes: List[tuple] = []
+
+    def node_inserted(self, parent: Dict[str, Any], node: Dict[str, Any]) -> None:
+        self.changes.append(('inserted', parent, node))
+
+    def node_removed(self, parent: Dict[str, Any], node: Dict[str, Any]) -> None:
+        self.changes.append(('removed', parent, node))
+
+    def node_changed(self, node: Dict[str, Any]) -> None:
+        pass
+
+
+class ImportCommand(Command):
+    """
+    Command for adding what an ImportEngine scanned to the ISO, as one
+    history entry however many files the import contains.
+
+    The first execute() attaches the scanned nodes and records the nodes it
+    inserted and replaced; undo and redo replay those changes.
+    """
+
+    def __init__(self, core, engine, description: str):
+        """
+        Initialize the ImportCommand.
+
+        Args:
+            core: The ISOCore instance
+            engine: An ImportEngine whose scan has completed
+            description: Description of the import, e.g. "Import directory 'photos'"
+        """
+        self.core = core
+        self.engine = engine
+        self._description = description
+        self.changes: Optional[List[tuple]] = None
+        self.executed = False
+
+    def execute(self) -> bool:
+        """Add the imported nodes to the ISO."""
+        try:
+            if self.changes is None:
+                recorder = _ChangeRecorder()
+                self.core.tree_listeners.append(recorder)
+                try:
+                    self.engine.attach()
+                finally:
+                    self.core.tree_listeners.remove(recorder)
+                self.changes = recorder.changes
+            else:
+                for kind, parent, node in self.changes:
+                    if kind == 'inserted':
+                        self.core.insert_node(parent, node)
+                    else:
+                        self.core.remove_node(node)
+            self.executed = True
+            logger.info(f"Executed: {self._description}")
+            return True
+        except Exception as e:
+            logger.error(f"Failed to execute ImportCommand: {e}")
+            return False
+
+    def undo(self) -> bool:
+        """Remove the imported nodes and put back the ones they replaced."""
+        try:
+            for kind, parent, node in reversed(self.changes or []):
+                if kind == 'inserted':
+                    self.core.remove_node(node)
+                else:
+                    self.core.insert_node(parent, node)
+            self.executed = False
+            logger.info(f"Undone: {self._description}")
+            return True
+        except Exception as e:
+            logger.error(f"Failed to undo ImportCommand: {e}")
+            return False
+
+    def description(self) -> str:
+        """Get description of this command."""
+        return self._description
+
+    def payload_nodes(self) -> List[Dict[str, Any]]:
+        """The replaced nodes while the import is applied, the imported ones once undone."""
+        kind = 'removed' if self.executed else 'inserted'
+        return _nodes_with_data([node for change, _, node in self.changes or [] if change == kind])
+
+
+class PayloadStore:
+    """
+    Moves the file data of nodes out of memory for CommandHistory.
+
+    Data whose source file is unchanged is dropped and read from that file
+    again; anything else is written to a temporary file that the node then
+    refers to by path. The temporary files are deleted by close(), or when
+    the store is garbage collected.
+    """
+
+    def __init__(self):
+        self._directory: Optional[tempfile.TemporaryDirectory] = None
+        self._count = 0
+
+    def spill(self, node: Dict[str, Any]) -> None:
+        """
+        Replaces a node's 'file_data' with a reference to a file holding the same bytes.
+
+        Raises:
+            OSError: If the data could not be written.
+        """
+        data = node['file_data']
+        path = node.get('file_path')
+        if path and self._matches(node, path, len(data)):
+            node['file_data'] = None
+            return
+        if self._directory is None:
+            self._directory = tempfile.TemporaryDirectory(prefix="iso-editor-undo-")
+        self._count += 1
+        spill_path = os.path.join(self._directory.name, f"{self._count}.bin")
+        with open(spill_path, 'wb') as f:
+            f.write(data)
+        node['file_path'] = spill_path
+        node['source_mtime_ns'] = os.stat(spill_path).st_mtime_ns
+        node['size'] = len(data)
+        node['file_data'] = None
+
+    @staticmethod
+    def _matches(node: Dict[str, Any], path: str, size: int) -> bool:
+        try:
+            stats = os.stat(path)
+        except OSError:
+            return False
+        mtime_ns = node.get('source_mtime_ns')
+        return stats.st_size == size and mtime_ns is not None and stats.st_mtime_ns == mtime_ns
+
+    def close(self) -> None:
+        """Deletes the temporary files."""
+        if self._directory is not None:
+            self._directory.cleanup()
+            self._directory = None
+
+
 class CommandHistory:
     """
     Manages the undo/redo history using command pattern.
+
+    The history is bounded by the number of commands and by the file data
+    its commands keep alive outside the tree (see Command.payload_nodes()).
+    Each payload is counted once however many commands hold it. Beyond
+    max_memory the oldest payloads are moved out of memory by a
+    PayloadStore; if that fails, the oldest commands are dropped.
     """
 
-    def __init__(self, max_history: int = 50):
+    def __init__(self, max_history: int = 50, max_memory: int = UNDO_HISTORY_MEMORY_LIMIT):
         """
         Initialize the command history.
 
         Args:
             max_history: Maximum number of commands to keep in history
+            max_memory: Maximum bytes of file data the history keeps in memory
         """
         self.max_history = max_history
-        self.undo_stack: List[Command] = []
-        self.redo_stack: List[Command] = []
+        self.max_memory = max_memory
+        self.undo_stack: Deque[Command] = deque()
+        self.redo_stack: Deque[Command] = deque()
+        self.payload_store = PayloadStore()
+        # Bytes of payload data in memory
+        self.memory_usage = 0
+        # Payload nodes by id(): [node, number of commands holding it, bytes in memory]
+        self._payloads: Dict[int, List[Any]] = {}
+        # The payload nodes each command was counted with, by id(command)
+        self._held: Dict[int, List[Dict[str, Any]]] = {}
+        # Commands executed inside group(), or None outside of it
+        self._group: Optional[List[Command]] = None
 
     def execute(self, command: Command) -> bool:
         """
@@ -275,16 +515,97 @@ class CommandHistory:
             bool: True if successful, False otherwise
         """
         if command.execute():
-            self.undo_stack.append(command)
             # Clear redo stack when a new command is executed
-            self.redo_stack.clear()
-            # Limit history size
-            if len(self.undo_stack) > self.max_history:
-                self.undo_stack.pop(0)
+            self._clear_redo()
+            if self._group is not None:
+                self._group.append(command)
+            else:
+                self._push(command)
             logger.debug(f"Command executed: {command.description()}")
             return True
         return False
 
+    @contextmanager
+    def group(self, description: str) -> Iterator[None]:
+        """
+        Coalesce the commands executed inside the block into one history entry.
+
+        Groups may be nested; the outermost one makes the entry.
+
+        Args:
+            description: Description of the entry if it holds several commands
+        """
+        if self._group is not None:
+            yield
+            return
+        self._group = []
+        try:
+            yield
+        finally:
+            commands, self._group = self._group, None
+            if len(commands) == 1:
+                self._push(commands[0])
+            elif commands:
+                self._push(CompositeCommand(commands, description))
+
+    def _push(self, command: Command) -> None:
+        self.undo_stack.append(command)
+        self._track(command)
+        self._enforce_limits()
+
+    def _clear_redo(self) -> None:
+        for command in self.redo_stack:
+            self._untrack(command)
+        self.redo_stack.clear()
+
+    def _track(self, command: Command) -> None:
+        """(Re)counts the payloads of a command, e.g. after it moved between the stacks."""
+        self._untrack(command)
+        nodes = command.payload_nodes()
+        self._held[id(command)] = nodes
+        for node in nodes:
+            entry = self._payloads.get(id(node))
+            if entry is None:
+                size = len(node.get('file_data') or b'')
+                entry = self._payloads[id(node)] = [node, 0, size]
+                self.memory_usage += size
+            entry[1] += 1
+
+    def _untrack(self, command: Command) -> None:
+        for node in self._held.pop(id(command), ()):
+            entry = self._payloads[id(node)]
+            entry[1] -= 1
+            if not entry[1]:
+                self.memory_usage -= entry[2]
+                del self._payloads[id(node)]
+
+    def _enforce_limits(self) -> None:
+        # Limit history size
+        while len(self.undo_stack) > self.max_history:
+            self._untrack(self.undo_stack.popleft())
+        if self.memory_usage > self.max_memory:
+            self._spill()
+        # What could not be spilled is dropped, oldest first, except the newest command
+        while self.memory_usage > self.max_memory and len(self.undo_stack) > 1:
+            self._untrack(self.undo_stack.popleft())
+
+    def _spill(self) -> None:
+        """Moves payloads out of memory, oldest command first, until the history is within max_memory."""
+        for command in list(self.undo_stack) + list(self.redo_stack):
+            for node in self._held.get(id(command), ()):
+                entry = self._payloads[id(node)]
+                if not entry[2]:
+                    continue
+                try:
+                    self.payload_store.spill(node)
+                except OSError as e:
+                    logger.warning(f"Could not move undo data out of memory: {e}")
+                    return
+                self.memory_usage -= entry[2]
+                entry[2] = 0
+                if self.memory_usage <= self.max_memory:
+                    return
+
     def undo(self) -> Optional[str]:
         """
         Undo the last command.
@@ -298,6 +619,8 @@ class CommandHistory:
         command = self.undo_stack.pop()
         if command.undo():
             self.redo_stack.append(command)
+            self._track(command)
+            self._enforce_limits()
             desc = command.description()
             logger.debug(f"Command undone: {desc}")
             return desc
@@ -319,6 +642,8 @@ class CommandHistory:
         command = self.redo_stack.pop()
         if command.execute():
             self.undo_stack.append(command)
+            self._track(command)
+            self._enforce_limits()
             desc = command.description()
             logger.debug(f"Command redone: {desc}")
             return desc
@@ -336,9 +661,18 @@ class CommandHistory:
         return len(self.redo_stack) > 0
 
     def clear(self) -> None:
-        """Clear all command history."""
+        """
+        Clear all command history.
+
+        This also deletes the data spilled to temporary files, which nodes may
+        still refer to; call it when the tree the commands edited is discarded.
+        """
         self.undo_stack.clear()
         self.redo_stack.clear()
+        self._payloads.clear()
+        self._held.clear()
+        self.memory_usage = 0
+        self.payload_store.close()
         logger.debug("Command history cleared")
 
     def get_undo_description(self) -> Optional[str]:
@@ -30,7 +30,27 @@ ISO9660_L1_MAX_EXT_LENGTH = 3     # Extension length
 
 # Buffer Sizes
 FILE_READ_BUFFER_SIZE = 8192      # Buffer for file reading (8 KB)
-CHECKSUM_BUFFER_SIZE = 8192       # Buffer for checksum calculation
+CHECKSUM_BUFFER_SIZE = 4 * 1024 * 1024  # Read size for checksum calculation (4 MB, sector aligned)
+
+# Files added to an image are kept by path and read while saving. Files up to
+# INLINE_FILE_MAX_SIZE are read into memory when added, while the bytes held
+# that way stay within INLINE_FILE_CACHE_BUDGET.
+INLINE_FILE_MAX_SIZE = 64 * 1024
+INLINE_FILE_CACHE_BUDGET = 64 * 1024 * 1024
+
+# Background jobs (loads, saves, checksums, ...) of all open images that run at once (see scheduler.py)
+SCHEDULER_WORKERS = 4
+
+# Blocks of opened images kept in memory, shared by all of them (see block_cache.py)
+IMAGE_BLOCK_CACHE_SIZE = 64 * 1024 * 1024
+
+# File data the undo history may keep in memory for nodes it has taken out of
+# the tree; beyond it the data is referenced by path or spilled to temporary files.
+UNDO_HISTORY_MEMORY_LIMIT = 64 * 1024 * 1024
+
+# Checksums shown after saving; BLAKE3 and XXH3 are added when their packages are installed
+CHECKSUM_ALGORITHMS = ('md5', 'sha1', 'sha256')
+OPTIONAL_CHECKSUM_ALGORITHMS = ('blake3', 'xxh3_128')
 
 # Disc Sizes (in bytes)
 CD_SIZE_BYTES = 700 * 1024 * 1024           # 700 MB CD
@@ -38,6 +58,14 @@ DVD_SIZE_BYTES = int(4.7 * 1024 * 1024 * 1024)  # 4.7 GB DVD
 DVD_DL_SIZE_BYTES = int(8.5 * 1024 * 1024 * 1024)  # 8.5 GB Dual Layer DVD
 BD_SIZE_BYTES = 25 * 1024 * 1024 * 1024    # 25 GB Blu-ray
 
+# Media a planned image is checked against (see layout_planner.py), smallest first
+MEDIA_CAPACITIES = {
+    'CD': CD_SIZE_BYTES,
+    'DVD': DVD_SIZE_BYTES,
+    'DVD-DL': DVD_DL_SIZE_BYTES,
+    'BD': BD_SIZE_BYTES,
+}
+
 # UI Constants
 DEFAULT_WINDOW_WIDTH = 800
 DEFAULT_WINDOW_HEIGHT = 600
@@ -84,6 +112,9 @@ CONFIG_SUBDIR_NAME = "iso-editor"
 RECENT_FILES_FILENAME = "recent_files.json"
 SETTINGS_FILENAME = "settings.json"
 LOG_FILENAME = "iso_editor.log"
+CACHE_DIR_NAME = ".cache"
+INDEX_CACHE_SUBDIR_NAME = "index"
+INDEX_CACHE_MAX_ENTRIES = 64     # Cached image indexes kept before the least recently used are removed
 
 # Logging
 DEFAULT_LOG_LEVEL = "INFO"
@@ -92,11 +123,14 @@ DEFAULT_LOG_FORMAT = "%(asctime)s - %(name)s - %(levelname)s - %(message)s"
 # File Filters for Dialogs
 ISO_FILE_FILTER = "Disc Images (*.iso *.cue);;ISO Files (*.iso);;CUE Files (*.cue);;All Files (*)"
 ISO_SAVE_FILTER = "ISO Files (*.iso)"
+CUE_FILE_FILTER = "CUE Files (*.cue);;All Files (*)"
 BOOT_IMAGE_FILTER = "Boot Images (*.img *.bin);;All Files (*)"
 
 # Progress Dialog Settings
 PROGRESS_MIN_VALUE = 0
 PROGRESS_MAX_VALUE = 100
+# Minimum time between progress signals of a background operation, so fast disks don't flood the event loop
+PROGRESS_INTERVAL_SEC = 0.05
 
 # Status Messages
 STATUS_READY = "Ready"
@@ -115,6 +149,9 @@ DEFAULT_USE_ROCK_RIDGE = True
 DEFAULT_USE_UDF = True
 DEFAULT_MAKE_HYBRID = False
 DEFAULT_CALCULATE_CHECKSUMS = True
+DEFAULT_INCREMENTAL_SAVE = True  # Patch changed files into the loaded image when possible
+DEFAULT_COMPACT_TREE = False  # Keep the directory tree in a columnar NodeStore (less memory per entry)
+DEFAULT_DEDUPLICATE = False  # Store identical files once, with every name pointing at the same data
 
 # UDF Version
 UDF_VERSION_2_60 = "2.60"
@@ -168,6 +205,9 @@ ACTION_REMOVE = "Remove"
 # Tree Widget Item Types
 ITEM_TYPE_FILE = "File"
 ITEM_TYPE_DIRECTORY = "Directory"
+TREE_FETCH_BATCH_SIZE = 1000  # Rows the tree model creates per fetch when a directory is expanded or scrolled
+SEARCH_DEBOUNCE_MS = 150  # Delay after the last keystroke in the filter box before searching
+SEARCH_INDEX_CHUNK_SIZE = 10000  # Names the search index handles between lock releases and cancellation checks
 
 # Node Flags
 NODE_FLAG_NEW = "is_new"
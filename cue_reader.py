@@ -0,0 +1,342 @@
+"""
+Streaming access to the tracks of a CUE/BIN image.
+
+A BIN file holds whole raw CD sectors. How much of each sector is user data
+depends on the track mode given in the CUE sheet:
+
+  AUDIO        2352 bytes of samples
+  MODE1/2048   2048 bytes of data, already without headers
+  MODE1/2352   12 sync + 4 header + 2048 data + 288 EDC/ECC
+  MODE2/2336   8 subheader + 2048 data (Form 1) + 280 EDC/ECC
+  MODE2/2352   12 sync + 4 header + 8 subheader + 2048 data (Form 1) + 280 EDC/ECC
+
+TrackReader maps the BIN file and exposes one track as a read-only file. For
+data tracks it presents the cooked 2048-byte sectors, i.e. the track as an ISO
+image, by skipping the sync, headers and error correction of every sector
+while reading. Nothing is read ahead or buffered, so memory use does not
+depend on the size of the track; iter_views() hands out slices of the mapping
+without copying them.
+
+TrackConverter writes a data track out as an ISO file. Each batch of sector
+slices goes to the output with a single gathering write, so converting a CD
+costs about as much as copying it.
+"""
+
+import io
+import logging
+import mmap
+import os
+import re
+import threading
+from typing import Any, Callable, Iterator, List, NamedTuple, Optional, Sequence
+
+from constants import CD_FRAME_SIZE
+
+logger = logging.getLogger(__name__)
+
+
+class SectorLayout(NamedTuple):
+    """Where the user data is in a raw sector of one track mode."""
+    raw_size: int
+    data_offset: int
+    data_size: int
+
+
+SECTOR_LAYOUTS = {
+    'AUDIO': SectorLayout(CD_FRAME_SIZE, 0, CD_FRAME_SIZE),
+    'MODE1/2048': SectorLayout(2048, 0, 2048),
+    'MODE1/2352': SectorLayout(CD_FRAME_SIZE, 16, 2048),
+    'MODE2/2336': SectorLayout(2336, 8, 2048),
+    'MODE2/2352': SectorLayout(CD_FRAME_SIZE, 24, 2048),
+}
+
+_TRACK_LINE = re.compile(r'^\s*TRACK\s+\d+\s+(\S+)', re.IGNORECASE | re.MULTILINE)
+
+# Bytes per slice handed out by iter_views() for tracks stored without headers
+VIEW_CHUNK_SIZE = 1024 * 1024
+# Bytes of output a TrackConverter writes at a time
+CONVERT_CHUNK_SIZE = 1024 * 1024
+
+
+def sector_layout(mode: str) -> SectorLayout:
+    """Returns the layout of a track mode; unknown modes are treated as raw 2352-byte sectors."""
+    layout = SECTOR_LAYOUTS.get(mode.upper())
+    if layout is None:
+        logger.warning(f"Unsupported CUE track mode '{mode}', reading it as raw sectors")
+        return SECTOR_LAYOUTS['AUDIO']
+    return layout
+
+
+def track_modes(cue_text: str) -> List[str]:
+    """Returns the mode of every TRACK line of a CUE sheet, in order."""
+    return [mode.upper() for mode in _TRACK_LINE.findall(cue_text)]
+
+
+def is_data_mode(mode: str) -> bool:
+    return mode.upper() != 'AUDIO'
+
+
+def track_length(mode: str, raw_length: int, cooked: bool = True) -> int:
+    """Returns the number of bytes a TrackReader presents for raw_length bytes of BIN data."""
+    layout = sector_layout(mode)
+    if not cooked or layout.data_size == layout.raw_size:
+        return raw_length
+    return (raw_length // layout.raw_size) * layout.data_size
+
+
+class TrackReader(io.RawIOBase):
+    """
+    A read-only, seekable file over one track of a BIN file.
+
+    With cooked=True (the default), data tracks read as their 2048-byte user
+    data sectors; with cooked=False, or for audio tracks, the raw sectors
+    are read as stored.
+    """
+
+    def __init__(self, bin_path: str, offset: int, raw_length: int, mode: str = 'AUDIO',
+                 cooked: bool = True) -> None:
+        """
+        Args:
+            bin_path (str): The BIN file.
+            offset (int): Byte position of the track in the BIN file.
+            raw_length (int): Bytes the track occupies in the BIN file.
+            mode (str): The CUE track mode, e.g. 'MODE1/2352'.
+            cooked (bool): Whether to strip everything but the user data of data sectors.
+
+        Raises:
+            OSError: If the BIN file cannot be opened.
+        """
+        super().__init__()
+        layout = sector_layout(mode)
+        if not cooked:
+            layout = SectorLayout(layout.raw_size, 0, layout.raw_size)
+        self.mode = mode.upper()
+        self.layout = layout
+        self.length = track_length(mode, raw_length, cooked)
+        self._contiguous = layout.data_size == layout.raw_size
+        self._base = offset
+        self._pos = 0
+        self._file = open(bin_path, 'rb')
+        self._map = None
+        self._view = memoryview(b'')
+        try:
+            file_size = self._file.seek(0, io.SEEK_END)
+            # Never present bytes the BIN file does not have
+            end = min(offset + raw_length, file_size)
+            if self._contiguous:
+                self.length = max(0, min(self.length, end - offset))
+            else:
+                self.length = min(self.length, max(0, (end - offset) // layout.raw_size) * layout.data_size)
+            if self.length:
+                self._map = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+                if hasattr(self._map, 'madvise') and hasattr(mmap, 'MADV_SEQUENTIAL'):
+                    self._map.madvise(mmap.MADV_SEQUENTIAL)
+                self._view = memoryview(self._map)
+        except Exception:
+            self._file.close()
+            raise
+
+    def readable(self) -> bool:
+        return True
+
+    def seekable(self) -> bool:
+        return True
+
+    def tell(self) -> int:
+        return self._pos
+
+    def seek(self, offset: int, whence: int = io.SEEK_SET) -> int:
+        if whence == io.SEEK_SET:
+            position = offset
+        elif whence == io.SEEK_CUR:
+            position = self._pos + offset
+        elif whence == io.SEEK_END:
+            position = self.length + offset
+        else:
+            raise ValueError(f"Invalid whence: {whence}")
+        if position < 0:
+            raise ValueError("Negative seek position")
+        self._pos = position
+        return position
+
+    def readinto(self, buffer: Any) -> int:
+        if self.closed:
+            raise ValueError("I/O operation on closed file")
+        target = memoryview(buffer).cast('B')
+        done = 0
+        for view in self._views(self._pos, len(target)):
+            target[done:done + len(view)] = view
+            done += len(view)
+        self._pos += done
+        return done
+
+    def iter_views(self, chunk_size: int = VIEW_CHUNK_SIZE) -> Iterator[memoryview]:
+        """
+        Yields the rest of the track as slices of the mapped BIN file, advancing the position.
+
+        The slices must be released (e.g. dropped) before the reader is closed.
+        For cooked data tracks every slice is one sector's user data.
+        """
+        while self._pos < self.length:
+            for view in self._views(self._pos, chunk_size):
+                self._pos += len(view)
+                yield view
+
+    def _views(self, position: int, count: int) -> Iterator[memoryview]:
+        """Yields the slices of the mapping that hold the track bytes [position, position + count)."""
+        count = min(count, self.length - position)
+        if count <= 0:
+            return
+        if self._contiguous:
+            start = self._base + position
+            yield self._view[start:start + count]
+            return
+        raw_size, data_offset, data_size = self.layout
+        sector, within = divmod(position, data_size)
+        start = self._base + sector * raw_size + data_offset + within
+        while count > 0:
+            take = min(data_size - within, count)
+            yield self._view[start:start + take]
+            count -= take
+            # The user data of the next sector
+            start += raw_size - within
+            within = 0
+
+    def close(self) -> None:
+        if self.closed:
+            return
+        try:
+            self._view.release()
+            if self._map is not None:
+                self._map.close()
+        except BufferError:
+            # A slice from iter_views() is still alive; the mapping goes with it.
+            logger.debug("TrackReader closed while views of it were in use")
+        self._file.close()
+        super().close()
+
+
+def _iov_max() -> int:
+    try:
+        return max(16, os.sysconf('SC_IOV_MAX'))
+    except (AttributeError, ValueError, OSError):
+        return 1024
+
+
+class TrackConverter:
+    """
+    Writes one track of a BIN file to a file of its own, e.g. a data track as an ISO image.
+
+    run() blocks until the track is written; progress_callback and cancel()
+    may be used from other threads.
+    """
+
+    def __init__(self, track: TrackReader, destination: str,
+                 progress_callback: Optional[Callable[[int, int], None]] = None,
+                 chunk_size: int = CONVERT_CHUNK_SIZE) -> None:
+        """
+        Args:
+            track (TrackReader): The track to write; run() closes it.
+            destination (str): The file to write.
+            progress_callback: Called as (bytes_done, bytes_total).
+            chunk_size (int): Bytes written per call.
+        """
+        self.track = track
+        self.destination = destination
+        self.progress_callback = progress_callback
+        self.chunk_size = max(track.layout.data_size, chunk_size)
+        self.bytes_done = 0
+        self._cancelled = threading.Event()
+
+    @property
+    def bytes_total(self) -> int:
+        return self.track.length
+
+    def cancel(self) -> None:
+        """Requests cancellation; run() raises InterruptedError and removes the partial file."""
+        self._cancelled.set()
+
+    def run(self) -> None:
+        """
+        Writes the rest of the track to the destination.
+
+        Raises:
+            InterruptedError: If cancel() was called.
+            IOError: If the destination cannot be written.
+        """
+        self.bytes_done = 0
+        self._report_progress()
+        try:
+            with open(self.destination, 'wb', buffering=0) as out:
+                if self.track._contiguous or not hasattr(os, 'writev'):
+                    self._copy(out)
+                else:
+                    self._gather(out.fileno())
+        except InterruptedError:
+            self._remove_partial()
+            raise
+        except OSError as e:
+            self._remove_partial()
+            raise IOError(f"Could not write {self.destination}: {e}") from e
+        finally:
+            self.track.close()
+        logger.info(f"Wrote {self.bytes_done} bytes of {self.track.mode} track to {self.destination}")
+
+    def _copy(self, out: Any) -> None:
+        """Writes through one reusable buffer; contiguous tracks are written straight from the mapping."""
+        if self.track._contiguous:
+            for view in self.track.iter_views(self.chunk_size):
+                out.write(view)
+                self._advance(len(view))
+            return
+        buffer = bytearray(self.chunk_size - self.chunk_size % self.track.layout.data_size)
+        while (length := self.track.readinto(buffer)):
+            out.write(memoryview(buffer)[:length])
+            self._advance(length)
+
+    def _gather(self, fd: int) -> None:
+        """Writes the user data of a batch of sectors per writev() call, without copying it."""
+        per_call = min(_iov_max(), self.chunk_size // self.track.layout.data_size)
+        batch: List[memoryview] = []
+        for view in self.track.iter_views():
+            batch.append(view)
+            if len(batch) == per_call:
+                self._advance(_write_all(fd, batch))
+                batch = []
+        if batch:
+            self._advance(_write_all(fd, batch))
+
+    def _advance(self, length: int) -> None:
+        self.bytes_done += length
+        self._report_progress()
+        if self._cancelled.is_set():
+            raise InterruptedError("Conversion cancelled by user")
+
+    def _remove_partial(self) -> None:
+        if os.path.exists(self.destination):
+            try:
+                os.remove(self.destination)
+                logger.info(f"Removed partial output file: {self.destination}")
+            except OSError as e:
+                logger.error(f"Failed to remove partial output file: {e}")
+
+    def _report_progress(self) -> None:
+        if self.progress_callback:
+            self.progress_callback(self.bytes_done, self.bytes_total)
+
+
+def _write_all(fd: int, views: Sequence[memoryview]) -> int:
+    """writev() that carries on after short writes; returns the bytes written."""
+    total = sum(len(view) for view in views)
+    written = os.writev(fd, views)
+    if written < total:
+        # Rare for regular files; finish the batch one slice at a time.
+        for view in views:
+            if written >= len(view):
+                written -= len(view)
+                continue
+            view = view[written:]
+            written = 0
+            while view:
+                view = view[os.write(fd, view):]
+    return total
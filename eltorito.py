@@ -0,0 +1,188 @@
+"""
+El Torito boot catalogs and isohybrid MBRs of an existing image.
+
+The functions here read and patch an image file in place, one sector at a
+time, so a bootable image can be changed without rebuilding it:
+
+  boot record        the volume descriptor after sector 16 whose system
+                     identifier is EL TORITO SPECIFICATION; it points at the
+                     boot catalog
+  boot catalog       a validation entry followed by 32-byte entries: the
+                     initial entry, then section headers (0x90, 0x91 for the
+                     last) each followed by their section entries
+  isohybrid MBR      the partition table in sector 0 of the system area; the
+                     boot code before it is kept as it is
+
+Sector counts of catalog entries are in 512-byte units, extents in
+ISO_BLOCK_SIZE units.
+"""
+
+import struct
+import zlib
+from typing import BinaryIO, List, NamedTuple, Optional, Tuple
+
+from constants import ISO_BLOCK_SIZE
+
+PLATFORM_X86 = 0x00
+PLATFORM_EFI = 0xEF
+
+# El Torito media types, mapped the same way as ISOCore._extract_boot_info()
+MEDIA_TYPES = {0: 'noemul', 1: 'floppy', 2: 'floppy', 3: 'floppy', 4: 'hdemul'}
+
+_EL_TORITO_ID = b'EL TORITO SPECIFICATION'
+_FIRST_DESCRIPTOR = 16
+_ENTRY_SIZE = 32
+_SECTION_HEADER = 0x90
+_FINAL_SECTION_HEADER = 0x91
+
+# The partition table pycdlib's add_isohybrid() writes: one bootable partition
+# of type 0x17 over the whole image, on a disk of 64 heads and 32 sectors.
+_MBR_PARTITION_TABLE = 446
+_MBR_DISK_SIGNATURE = 440
+_HYBRID_PARTITION_TYPE = 0x17
+_EFI_PARTITION_TYPE = 0xEF
+_GPT_PROTECTIVE_TYPE = 0xEE
+_HEADS = 64
+_SECTORS_PER_TRACK = 32
+
+
+class BootEntry(NamedTuple):
+    """One boot entry of a catalog, as found in the image."""
+    offset: int         # byte offset of the entry in the image
+    platform_id: int
+    media_type: int
+    load_segment: int
+    sector_count: int   # 512-byte sectors loaded by the BIOS or firmware
+    load_rba: int       # extent of the boot image
+    system_type: int    # partition type of a hard disk image, reported as platform_id by ISOCore
+
+    @property
+    def emulation_type(self) -> str:
+        return MEDIA_TYPES.get(self.media_type & 0x0F, 'unknown')
+
+
+def _read_sector(fp: BinaryIO, sector: int) -> bytes:
+    fp.seek(sector * ISO_BLOCK_SIZE)
+    return fp.read(ISO_BLOCK_SIZE)
+
+
+def find_boot_catalog(fp: BinaryIO) -> Optional[int]:
+    """Returns the sector of the image's boot catalog, or None if it has no El Torito boot record."""
+    sector = _FIRST_DESCRIPTOR
+    while True:
+        descriptor = _read_sector(fp, sector)
+        if len(descriptor) < ISO_BLOCK_SIZE or descriptor[1:6] != b'CD001' or descriptor[0] == 255:
+            return None
+        if descriptor[0] == 0 and descriptor[7:39].rstrip(b'\x00') == _EL_TORITO_ID:
+            return struct.unpack_from('<I', descriptor, 71)[0]
+        sector += 1
+
+
+def _entry(data: bytes, position: int, offset: int, platform_id: int) -> BootEntry:
+    media_type, load_segment, system_type, _, sector_count, load_rba = struct.unpack_from('<BHBBHI', data, position + 1)
+    return BootEntry(offset, platform_id, media_type, load_segment, sector_count, load_rba, system_type)
+
+
+def read_boot_entries(fp: BinaryIO, catalog_sector: int) -> List[BootEntry]:
+    """
+    Returns the initial entry and the section entries of a boot catalog.
+
+    Raises:
+        ValueError: If the catalog has no valid validation entry.
+    """
+    catalog = _read_sector(fp, catalog_sector)
+    if len(catalog) < 2 * _ENTRY_SIZE or catalog[0] != 1 or catalog[30:32] != b'\x55\xaa':
+        raise ValueError("El Torito boot catalog has no valid validation entry")
+    # The words of the validation entry add up to zero
+    if sum(struct.unpack_from('<16H', catalog)) & 0xFFFF:
+        raise ValueError("El Torito validation entry has a bad checksum")
+
+    base = catalog_sector * ISO_BLOCK_SIZE
+    entries = [_entry(catalog, _ENTRY_SIZE, base + _ENTRY_SIZE, catalog[1])]
+    position = 2 * _ENTRY_SIZE
+    while position + _ENTRY_SIZE <= len(catalog) and catalog[position] in (_SECTION_HEADER, _FINAL_SECTION_HEADER):
+        header, platform_id, count = struct.unpack_from('<BBH', catalog, position)
+        position += _ENTRY_SIZE
+        for _ in range(count):
+            if position + _ENTRY_SIZE > len(catalog):
+                break
+            entries.append(_entry(catalog, position, base + position, platform_id))
+            position += _ENTRY_SIZE
+        if header == _FINAL_SECTION_HEADER:
+            break
+    return entries
+
+
+def find_entry(entries: List[BootEntry], platform_id: int) -> Optional[BootEntry]:
+    """Returns the first entry for the platform, or None."""
+    return next((entry for entry in entries if entry.platform_id == platform_id), None)
+
+
+def patch_boot_entry(fp: BinaryIO, entry: BootEntry, sector_count: Optional[int] = None,
+                     load_rba: Optional[int] = None) -> BootEntry:
+    """Rewrites the sector count and extent of an entry; returns the entry as written."""
+    entry = entry._replace(sector_count=entry.sector_count if sector_count is None else sector_count,
+                           load_rba=entry.load_rba if load_rba is None else load_rba)
+    fp.seek(entry.offset + 6)
+    fp.write(struct.pack('<HI', entry.sector_count, entry.load_rba))
+    return entry
+
+
+def _chs(lba: int) -> bytes:
+    cylinder = lba // (_HEADS * _SECTORS_PER_TRACK)
+    if cylinder > 1023:
+        cylinder, head, sector = 1023, _HEADS - 1, _SECTORS_PER_TRACK
+    else:
+        head = lba // _SECTORS_PER_TRACK % _HEADS
+        sector = lba % _SECTORS_PER_TRACK + 1
+    return bytes([head, sector | (cylinder >> 2) & 0xC0, cylinder & 0xFF])
+
+
+def _partition(bootable: bool, partition_type: int, start: int, count: int) -> bytes:
+    return (bytes([0x80 if bootable else 0]) + _chs(start) + bytes([partition_type]) +
+            _chs(start + count - 1) + struct.pack('<II', start, count))
+
+
+def has_boot_code(fp: BinaryIO) -> bool:
+    """Returns True if sector 0 of the image holds MBR boot code, e.g. from an earlier isohybrid."""
+    fp.seek(0)
+    return any(fp.read(_MBR_DISK_SIGNATURE))
+
+
+def has_gpt(fp: BinaryIO) -> bool:
+    """Returns True if the image's MBR is the protective MBR of a GPT."""
+    fp.seek(_MBR_PARTITION_TABLE)
+    table = fp.read(66)
+    return table[64:66] == b'\x55\xaa' and any(table[i + 4] == _GPT_PROTECTIVE_TYPE for i in range(0, 64, 16))
+
+
+def write_hybrid_mbr(fp: BinaryIO, alignment: int,
+                     efi_partition: Optional[Tuple[int, int]] = None) -> int:
+    """
+    Writes an isohybrid partition table and pads the image to a multiple of alignment bytes.
+
+    Args:
+        fp: The image, opened for reading and writing.
+        alignment (int): The size the image is padded to a multiple of.
+        efi_partition (tuple): (first 512-byte sector, sector count) of the EFI
+            boot image, which gets a partition of its own for UEFI firmware.
+
+    Returns:
+        int: The size of the image after padding.
+    """
+    size = fp.seek(0, 2)
+    size += -size % alignment
+    fp.truncate(size)
+
+    fp.seek(_MBR_DISK_SIGNATURE)
+    signature = fp.read(4)
+    if not any(signature):
+        # Derived from the primary volume descriptor, so a re-save gives the same disk
+        signature = struct.pack('<I', zlib.crc32(_read_sector(fp, _FIRST_DESCRIPTOR)) or 1)
+
+    table = _partition(True, _HYBRID_PARTITION_TYPE, 0, size // 512)
+    if efi_partition is not None:
+        table += _partition(False, _EFI_PARTITION_TYPE, *efi_partition)
+    fp.seek(_MBR_DISK_SIGNATURE)
+    fp.write(signature + b'\x00\x00' + table.ljust(64, b'\x00') + b'\x55\xaa')
+    return size
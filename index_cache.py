@@ -0,0 +1,199 @@
+"""
+Persistent index of previously opened images.
+
+Reopening an unchanged image reads its directory tree, volume information
+and El Torito entries from a cache file instead of parsing the image again.
+Entries hold an iso_scanner.ImageScan, i.e. the tree as flat columns. Loading
+one is a memory map plus a few array copies, and ISOCore then builds its
+nodes exactly as it does after a native scan.
+
+An entry is used only when the image's path, size, modification time and
+volume descriptors still match the ones it was written for.
+"""
+
+import hashlib
+import json
+import logging
+import mmap
+import os
+import struct
+import sys
+import tempfile
+from typing import Any, Callable, Dict, Iterable, Optional
+
+from iso_scanner import ImageScan
+
+logger = logging.getLogger(__name__)
+
+_MAGIC = b'ISOIDX01'
+# Magic, then the length of the JSON header that follows it
+_PREFIX = struct.Struct('<8sI')
+# Packed columns, stored after the header in this order
+_COLUMNS = ('flags', 'parent', 'first_child', 'child_count', 'size', 'extent', 'date')
+
+# Volume descriptors start at sector 16; read at most this many of them
+_MAX_DESCRIPTORS = 32
+_SECTOR_SIZE = 2048
+
+
+def _descriptor_hash(file_path: str) -> str:
+    """Hashes the volume descriptor set (PVD, Joliet SVD, boot record, UDF VRS) of an image."""
+    digest = hashlib.blake2b(digest_size=16)
+    with open(file_path, 'rb') as f:
+        f.seek(16 * _SECTOR_SIZE)
+        for _ in range(_MAX_DESCRIPTORS):
+            sector = f.read(_SECTOR_SIZE)
+            if not sector:
+                break
+            digest.update(sector)
+            # The ISO 9660 set terminator; UDF descriptors follow it, so keep going
+            # only while sectors still look like volume structure descriptors.
+            if sector[1:6] not in (b'CD001', b'BEA01', b'NSR02', b'NSR03', b'TEA01', b'BOOT2'):
+                break
+    return digest.hexdigest()
+
+
+class IndexCache:
+    """
+    A directory of cached image indexes, one file per image path.
+
+    Args:
+        directory (str): Where the cache files live; created on first store.
+        max_entries (int): How many entries to keep; the least recently used go first.
+    """
+
+    def __init__(self, directory: str, max_entries: int = 64) -> None:
+        self.directory = directory
+        self.max_entries = max_entries
+
+    def _entry_path(self, file_path: str) -> str:
+        key = hashlib.sha1(os.path.abspath(file_path).encode('utf-8', 'surrogateescape')).hexdigest()
+        return os.path.join(self.directory, f"{key}.idx")
+
+    def _fingerprint(self, file_path: str) -> Dict[str, Any]:
+        """Identifies the current state of an image; raises OSError if it cannot be read."""
+        stat = os.stat(file_path)
+        return {
+            'path': os.path.abspath(file_path),
+            'size': stat.st_size,
+            'mtime_ns': stat.st_mtime_ns,
+            'descriptors': _descriptor_hash(file_path),
+        }
+
+    def load(self, file_path: str) -> Optional[ImageScan]:
+        """
+        Returns the cached index of an image if it is still valid.
+
+        Returns:
+            ImageScan, or None on a cache miss.
+        """
+        entry_path = self._entry_path(file_path)
+        if not os.path.exists(entry_path):
+            return None
+        try:
+            fingerprint = self._fingerprint(file_path)
+            with open(entry_path, 'rb') as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as data:
+                magic, header_length = _PREFIX.unpack_from(data, 0)
+                if magic != _MAGIC:
+                    return None
+                offset = _PREFIX.size
+                header = json.loads(bytes(data[offset:offset + header_length]))
+                offset += header_length
+                if header['fingerprint'] != fingerprint or header['byteorder'] != sys.byteorder:
+                    logger.debug(f"Index cache entry for {file_path} is stale")
+                    return None
+
+                columns: Dict[str, Any] = {}
+                names_length = header['names_length']
+                columns['names'] = bytes(data[offset:offset + names_length]).decode(
+                    'utf-8', 'surrogateescape').split('\0')
+                offset += names_length
+                for key in _COLUMNS:
+                    length = header['lengths'][key]
+                    columns[key] = bytes(data[offset:offset + length])
+                    offset += length
+            # Touch the entry so pruning keeps recently used images.
+            os.utime(entry_path)
+        except (OSError, ValueError, KeyError, struct.error) as e:
+            logger.warning(f"Ignoring unreadable index cache entry {entry_path}: {e}")
+            return None
+
+        scan = ImageScan(header['walk_key'], header['info'], columns, header['boot_entries'])
+        logger.info(f"Loaded index of {file_path} from cache ({len(scan)} entries)")
+        return scan
+
+    def store(self, file_path: str, scan: ImageScan) -> None:
+        """Writes the index of an image. Failures are logged, never raised."""
+        try:
+            fingerprint = self._fingerprint(file_path)
+            columns = scan.columns()
+            names = '\0'.join(columns['names']).encode('utf-8', 'surrogateescape')
+            header = json.dumps({
+                'fingerprint': fingerprint,
+                'byteorder': sys.byteorder,
+                'walk_key': scan.walk_key,
+                'info': scan.info(),
+                'boot_entries': scan.boot_entries,
+                'names_length': len(names),
+                'lengths': {key: len(columns[key]) for key in _COLUMNS},
+            }).encode('utf-8')
+
+            os.makedirs(self.directory, exist_ok=True)
+            fd, temp_path = tempfile.mkstemp(prefix='.idx_', dir=self.directory)
+            try:
+                with os.fdopen(fd, 'wb') as f:
+                    f.write(_PREFIX.pack(_MAGIC, len(header)))
+                    f.write(header)
+                    f.write(names)
+                    for key in _COLUMNS:
+                        f.write(columns[key])
+                os.replace(temp_path, self._entry_path(file_path))
+            except BaseException:
+                os.remove(temp_path)
+                raise
+        except (OSError, TypeError, ValueError) as e:
+            logger.warning(f"Could not write index cache entry for {file_path}: {e}")
+            return
+        logger.debug(f"Stored index of {file_path} ({len(scan)} entries)")
+        self._prune()
+
+    def contains(self, file_path: str) -> bool:
+        """Returns True if a valid entry exists for the image."""
+        return self.load(file_path) is not None
+
+    def warm(self, paths: Iterable[str], is_cancelled: Optional[Callable[[], bool]] = None) -> None:
+        """
+        Indexes the given images that have no valid entry yet.
+
+        Args:
+            paths: Image paths, e.g. the recent files list.
+            is_cancelled: Polled between images.
+        """
+        from iso_logic import ISOCore  # imported here because iso_logic imports this module
+
+        for path in paths:
+            if is_cancelled and is_cancelled():
+                return
+            if path.lower().endswith('.cue') or not os.path.isfile(path) or self.contains(path):
+                continue
+            logger.info(f"Warming index cache for {path}")
+            core = ISOCore(index_cache=self)
+            try:
+                core.load_iso(path)
+            except Exception as e:
+                logger.warning(f"Could not index {path}: {e}")
+            finally:
+                core.close_iso()
+
+    def _prune(self) -> None:
+        """Removes the least recently used entries beyond max_entries."""
+        try:
+            entries = [os.path.join(self.directory, name) for name in os.listdir(self.directory)
+                       if name.endswith('.idx')]
+            if len(entries) <= self.max_entries:
+                return
+            entries.sort(key=os.path.getmtime, reverse=True)
+            for stale in entries[self.max_entries:]:
+                os.remove(stale)
+        except OSError as e:
+            logger.debug(f"Could not prune index cache: {e}")
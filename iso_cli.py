@@ -0,0 +1,444 @@
+"""
+Headless command line interface.
+
+Builds, edits, extracts and verifies images without the GUI; PySide6 is
+never imported, so it starts quickly on build machines:
+
+  iso-editor-cli build SOURCE... -o OUTPUT     make an image of directories and files
+  iso-editor-cli build --manifest FILE         make every image listed in a JSON manifest
+  iso-editor-cli add IMAGE SOURCE... [--to DIR] [-o OUTPUT]
+  iso-editor-cli remove IMAGE PATH... [-o OUTPUT]
+  iso-editor-cli extract IMAGE [PATH] -d DESTINATION
+  iso-editor-cli verify IMAGE [--expect ALGORITHM=DIGEST]...
+
+The jobs of a manifest run in a process pool, --jobs at a time. Small files
+that several jobs include are read once, by the parent, before the pool
+starts; where processes are forked the workers inherit that cache instead
+of reading the files again.
+
+A manifest is a JSON list of jobs, or an object with a "jobs" list:
+
+  [{"output": "out/base.iso", "sources": ["base/"], "volume_id": "BASE"},
+   {"output": "out/full.iso", "sources": ["base/", "extras/"], "checksums": ["sha256"]}]
+
+Relative paths are resolved against the manifest's directory. The optional
+keys of a job are volume_id, boot_image, efi_boot_image, joliet, rock_ridge,
+udf, hybrid, deduplicate, checksums and media (CD, DVD, DVD-DL or BD: fail
+before writing if the image would not fit). build --dry-run prints the
+planned size of each image instead of writing it.
+
+--profile REPORT (before the command) writes the phase times, byte counts,
+peak memory and throughput of the run as JSON; --trace adds a Chrome trace.
+"""
+
+import argparse
+import json
+import logging
+import multiprocessing
+import os
+import sys
+import time
+from concurrent.futures import ProcessPoolExecutor, as_completed
+from typing import Any, Dict, Iterator, List, Optional, Tuple
+
+from checksums import ALGORITHM_NAMES, hash_file
+from constants import (APP_NAME, VERSION, DEFAULT_LOG_FORMAT, INLINE_FILE_MAX_SIZE, INLINE_FILE_CACHE_BUDGET,
+                       MEDIA_CAPACITIES)
+from iso_logic import ISOCore, ImportEngine, ExtractionEngine, TreeNode
+from layout_planner import fitting_media
+import profiler
+
+logger = logging.getLogger(__name__)
+
+# Bytes read per step when verifying the files of an image
+VERIFY_CHUNK_SIZE = 1024 * 1024
+
+
+class SourceCache:
+    """
+    Contents of small source files, with the size and mtime they were read at.
+
+    A cached copy is only used for a node whose size and mtime still match.
+    """
+
+    def __init__(self, budget: int = INLINE_FILE_CACHE_BUDGET) -> None:
+        self.budget = budget
+        self.size = 0
+        self._files: Dict[str, Tuple[int, int, bytes]] = {}
+
+    def __len__(self) -> int:
+        return len(self._files)
+
+    def preload(self, paths: List[str]) -> None:
+        """Reads files up to INLINE_FILE_MAX_SIZE while the budget allows."""
+        for path in paths:
+            try:
+                stats = os.stat(path)
+                if stats.st_size > INLINE_FILE_MAX_SIZE or self.size + stats.st_size > self.budget:
+                    continue
+                with open(path, 'rb') as f:
+                    data = f.read()
+            except OSError as e:
+                logger.debug(f"Not caching {path}: {e}")
+                continue
+            if len(data) == stats.st_size:
+                self._files[path] = (stats.st_size, stats.st_mtime_ns, data)
+                self.size += len(data)
+
+    def fill(self, node: TreeNode) -> int:
+        """Gives the cached contents to every matching file node below node; returns how many."""
+        filled = 0
+        for file_node in _iter_files(node):
+            entry = self._files.get(file_node.get('file_path'))
+            if (entry and file_node.get('file_data') is None
+                    and entry[0] == file_node['size'] and entry[1] == file_node.get('source_mtime_ns')):
+                file_node['file_data'] = entry[2]
+                filled += 1
+        return filled
+
+
+# The cache a forked worker inherits from the parent process
+_shared_cache: Optional[SourceCache] = None
+
+
+def _iter_files(node: TreeNode) -> Iterator[TreeNode]:
+    stack = [node]
+    while stack:
+        current = stack.pop()
+        if current['is_directory']:
+            stack.extend(current['children'])
+        else:
+            yield current
+
+
+def _source_entries(sources: List[str]) -> List[str]:
+    """The paths that go to the image root: the contents of each directory, and each file."""
+    entries = []
+    for source in sources:
+        if os.path.isdir(source):
+            entries.extend(os.path.join(source, name) for name in sorted(os.listdir(source)))
+        else:
+            entries.append(source)
+    return entries
+
+
+def _walk_files(sources: List[str]) -> Iterator[str]:
+    for source in sources:
+        if os.path.isfile(source):
+            yield os.path.abspath(source)
+            continue
+        for root, _, files in os.walk(source):
+            for name in files:
+                yield os.path.abspath(os.path.join(root, name))
+
+
+def shared_files(jobs: List[Dict[str, Any]]) -> List[str]:
+    """Returns the source files that more than one job includes."""
+    seen: Dict[str, int] = {}
+    for job in jobs:
+        for path in set(_walk_files(job['sources'])):
+            seen[path] = seen.get(path, 0) + 1
+    return [path for path, count in seen.items() if count > 1]
+
+
+def load_manifest(path: str) -> List[Dict[str, Any]]:
+    """
+    Reads a build manifest; see the module docstring.
+
+    Raises:
+        ValueError: If the manifest is not valid.
+    """
+    with open(path, 'r', encoding='utf-8') as f:
+        try:
+            manifest = json.load(f)
+        except json.JSONDecodeError as e:
+            raise ValueError(f"Invalid manifest {path}: {e}") from e
+    jobs = manifest.get('jobs') if isinstance(manifest, dict) else manifest
+    if not isinstance(jobs, list):
+        raise ValueError(f"Manifest {path} has no list of jobs")
+    base = os.path.dirname(os.path.abspath(path))
+
+    def resolve(value: Optional[str]) -> Optional[str]:
+        return os.path.join(base, value) if value else value
+
+    for number, job in enumerate(jobs, 1):
+        if not isinstance(job, dict) or not job.get('output') or not job.get('sources'):
+            raise ValueError(f"Job {number} of {path} needs an output and sources")
+        job['output'] = resolve(job['output'])
+        job['sources'] = [resolve(source) for source in job['sources']]
+        for key in ('boot_image', 'efi_boot_image'):
+            job[key] = resolve(job.get(key))
+        if job.get('media') is not None and job['media'] not in MEDIA_CAPACITIES:
+            raise ValueError(f"Job {number} of {path} has unknown media {job['media']!r}")
+    return jobs
+
+
+def build_image(job: Dict[str, Any], cache: Optional[SourceCache] = None) -> Dict[str, Any]:
+    """
+    Builds one image; runs in a pool worker for manifests.
+
+    Returns:
+        dict: The output path, the checksums, the seconds taken, the files added
+            and the paths that could not be read.
+    """
+    cache = cache if cache is not None else _shared_cache
+    start = time.monotonic()
+    core = ISOCore()
+    core.init_new_iso()
+    if job.get('volume_id'):
+        core.volume_descriptor['volume_id'] = job['volume_id']
+    core.boot_image_path = job.get('boot_image')
+    core.efi_boot_image_path = job.get('efi_boot_image')
+
+    engine = ImportEngine(core, _source_entries(job['sources']), core.directory_tree)
+    files = engine.run()
+    result = {'output': job['output'], 'files': files, 'errors': engine.errors, 'checksums': {}}
+    if job.get('dry_run'):
+        result['plan'] = core.plan_layout(use_joliet=job.get('joliet', True), use_rock_ridge=job.get('rock_ridge', True),
+                                          use_udf=job.get('udf', True), make_hybrid=job.get('hybrid', False))
+        result['seconds'] = time.monotonic() - start
+        return result
+    if cache:
+        cache.fill(core.directory_tree)
+    media = job.get('media')
+    checksums = core.save_iso(job['output'], use_joliet=job.get('joliet', True),
+                              use_rock_ridge=job.get('rock_ridge', True), use_udf=job.get('udf', True),
+                              make_hybrid=job.get('hybrid', False), checksum_algorithms=job.get('checksums'),
+                              deduplicate=job.get('deduplicate', False),
+                              max_size=MEDIA_CAPACITIES[media] if media else None)
+    result['checksums'] = checksums or {}
+    result['seconds'] = time.monotonic() - start
+    return result
+
+
+def run_builds(jobs: List[Dict[str, Any]], workers: int) -> int:
+    """Builds every job, workers at a time; returns the number that failed."""
+    global _shared_cache
+    cache = SourceCache()
+    if len(jobs) > 1:
+        cache.preload(shared_files(jobs))
+        logger.info(f"Cached {len(cache)} file(s) shared between jobs ({cache.size} bytes)")
+
+    failures = 0
+    if workers <= 1 or len(jobs) == 1:
+        for job in jobs:
+            failures += not _report_build(job, lambda job=job: build_image(job, cache))
+        return failures
+
+    # Forked workers see the cache without it being copied to them.
+    methods = multiprocessing.get_all_start_methods()
+    context = multiprocessing.get_context('fork' if 'fork' in methods else None)
+    _shared_cache = cache if 'fork' in methods else None
+    try:
+        with ProcessPoolExecutor(max_workers=workers, mp_context=context) as pool:
+            futures = {pool.submit(build_image, job): job for job in jobs}
+            for future in as_completed(futures):
+                failures += not _report_build(futures[future], future.result)
+    finally:
+        _shared_cache = None
+    return failures
+
+
+def _report_build(job: Dict[str, Any], result_of) -> bool:
+    try:
+        result = result_of()
+    except Exception as e:
+        logger.error(f"Failed to build {job['output']}: {e}")
+        print(f"FAILED {job['output']}: {e}", file=sys.stderr)
+        return False
+    for path, error in result['errors']:
+        print(f"warning: skipped {path}: {error}", file=sys.stderr)
+    plan = result.get('plan')
+    if plan is not None:
+        media = job.get('media')
+        fits = fitting_media(plan.total_size)
+        print(f"planned {result['output']}: {result['files']} file(s), {plan.total_size:,} bytes "
+              f"({plan.total_sectors:,} sectors), fits on {', '.join(fits) or 'none of ' + ', '.join(MEDIA_CAPACITIES)}")
+        return not media or media in fits
+    print(f"built {result['output']}: {result['files']} file(s) in {result['seconds']:.1f}s")
+    for algorithm, digest in result['checksums'].items():
+        print(f"  {ALGORITHM_NAMES.get(algorithm, algorithm)}: {digest}")
+    return True
+
+
+def _open(image: str) -> ISOCore:
+    core = ISOCore()
+    core.load_iso(image)
+    return core
+
+
+def _save(core: ISOCore, output: str) -> None:
+    core.save_iso(output, use_joliet=True, use_rock_ridge=True)
+    print(f"saved {output}")
+
+
+def _lookup(core: ISOCore, path: str) -> TreeNode:
+    node = core.find_node_by_path(path)
+    if node is None:
+        raise FileNotFoundError(f"No such path in the image: {path}")
+    return node
+
+
+def cmd_build(args: argparse.Namespace) -> int:
+    if args.manifest:
+        jobs = load_manifest(args.manifest)
+    elif args.sources and args.output:
+        jobs = [{'output': args.output, 'sources': args.sources, 'volume_id': args.volume_id,
+                 'boot_image': args.boot_image, 'checksums': args.checksum or None,
+                 'deduplicate': args.dedup}]
+    else:
+        raise ValueError("build needs SOURCE... -o OUTPUT, or --manifest")
+    for job in jobs:
+        if args.media:
+            job['media'] = args.media
+        job['dry_run'] = args.dry_run
+    # Worker processes are not profiled
+    workers = 1 if profiler.active() else args.jobs
+    return 1 if run_builds(jobs, workers) else 0
+
+
+def cmd_add(args: argparse.Namespace) -> int:
+    core = _open(args.image)
+    target = _lookup(core, args.to)
+    if not target['is_directory']:
+        raise NotADirectoryError(f"Not a directory in the image: {args.to}")
+    engine = ImportEngine(core, args.sources, target)
+    engine.run()
+    for path, error in engine.errors:
+        print(f"warning: skipped {path}: {error}", file=sys.stderr)
+    _save(core, args.output or args.image)
+    return 0
+
+
+def cmd_remove(args: argparse.Namespace) -> int:
+    core = _open(args.image)
+    for path in args.paths:
+        node = _lookup(core, path)
+        if node is core.directory_tree:
+            raise ValueError("The root directory cannot be removed")
+        core.remove_node(node)
+    _save(core, args.output or args.image)
+    return 0
+
+
+def cmd_extract(args: argparse.Namespace) -> int:
+    core = _open(args.image)
+    node = _lookup(core, args.path)
+    destination = args.destination
+    if node is not core.directory_tree and os.path.isdir(destination):
+        destination = os.path.join(destination, node['name'])
+    engine = ExtractionEngine(core, node, destination)
+    engine.run()
+    print(f"extracted {engine.bytes_done} bytes to {destination}")
+    return 0
+
+
+def cmd_verify(args: argparse.Namespace) -> int:
+    """Reads every file of the image back and compares the image's checksums."""
+    core = _open(args.image)
+    core.load_all_children()
+    unreadable = 0
+    for node in _iter_files(core.directory_tree):
+        try:
+            stream, length = core.open_file_stream(node)
+            with stream:
+                remaining = length
+                while remaining > 0:
+                    chunk = stream.read(min(VERIFY_CHUNK_SIZE, remaining))
+                    if not chunk:
+                        raise IOError(f"ends {remaining} bytes early")
+                    remaining -= len(chunk)
+        except Exception as e:
+            unreadable += 1
+            print(f"unreadable {core.get_node_path(node)}: {e}", file=sys.stderr)
+
+    expected = {}
+    for item in args.expect:
+        algorithm, _, digest = item.partition('=')
+        expected[algorithm.lower()] = digest.lower()
+    mismatched = 0
+    if expected:
+        digests = hash_file(args.image, list(expected))
+        for algorithm, digest in expected.items():
+            ok = digests[algorithm] == digest
+            mismatched += not ok
+            print(f"{ALGORITHM_NAMES.get(algorithm, algorithm)}: {digests[algorithm]} {'OK' if ok else 'MISMATCH'}")
+    print(f"{args.image}: {'OK' if not unreadable and not mismatched else 'FAILED'}")
+    return 1 if unreadable or mismatched else 0
+
+
+def parse_arguments(argv: Optional[List[str]] = None) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(prog='iso-editor-cli', description=f'{APP_NAME} - headless mode',
+                                     epilog=f'Version {VERSION}')
+    parser.add_argument('--version', action='version', version=f'{APP_NAME} {VERSION}')
+    parser.add_argument('--log-level', choices=['DEBUG', 'INFO', 'WARNING', 'ERROR', 'CRITICAL'],
+                        default='WARNING', help='Set the logging level (default: WARNING)')
+    parser.add_argument('--profile', metavar='REPORT',
+                        help='Write a JSON report of phase times, bytes read and written, peak memory and '
+                             'throughput here ("-" for standard output); a manifest is then built one image at a time')
+    parser.add_argument('--trace', metavar='TRACE', help='Also write the timed phases here as a Chrome trace')
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    build = commands.add_parser('build', help='Make images from directories and files')
+    build.add_argument('sources', nargs='*', help='Directories whose contents, and files, form the image root')
+    build.add_argument('-o', '--output', help='The image to write')
+    build.add_argument('--manifest', help='A JSON list of images to build')
+    build.add_argument('--jobs', type=int, default=os.cpu_count() or 1,
+                       help='Images built at the same time (default: number of CPUs)')
+    build.add_argument('--volume-id', help='The volume identifier')
+    build.add_argument('--boot-image', help='A BIOS boot image')
+    build.add_argument('--checksum', action='append', default=[], metavar='ALGORITHM',
+                       help='Hash the image while writing it, e.g. sha256; may be repeated')
+    build.add_argument('--dedup', action='store_true', help='Store files with identical contents once')
+    build.add_argument('--media', type=str.upper, choices=list(MEDIA_CAPACITIES),
+                       help='Fail before writing if an image would not fit on this medium')
+    build.add_argument('--dry-run', action='store_true',
+                       help='Print the planned size of each image instead of writing it')
+    build.set_defaults(handler=cmd_build)
+
+    add = commands.add_parser('add', help='Add files and directories to an image')
+    add.add_argument('image')
+    add.add_argument('sources', nargs='+')
+    add.add_argument('--to', default='/', help='The directory in the image to add to (default: /)')
+    add.add_argument('-o', '--output', help='Write the result here instead of replacing the image')
+    add.set_defaults(handler=cmd_add)
+
+    remove = commands.add_parser('remove', help='Remove files and directories from an image')
+    remove.add_argument('image')
+    remove.add_argument('paths', nargs='+')
+    remove.add_argument('-o', '--output', help='Write the result here instead of replacing the image')
+    remove.set_defaults(handler=cmd_remove)
+
+    extract = commands.add_parser('extract', help='Extract a file or directory from an image')
+    extract.add_argument('image')
+    extract.add_argument('path', nargs='?', default='/')
+    extract.add_argument('-d', '--destination', required=True)
+    extract.set_defaults(handler=cmd_extract)
+
+    verify = commands.add_parser('verify', help='Read every file of an image and check its checksums')
+    verify.add_argument('image')
+    verify.add_argument('--expect', action='append', default=[], metavar='ALGORITHM=DIGEST')
+    verify.set_defaults(handler=cmd_verify)
+
+    return parser.parse_args(argv)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    args = parse_arguments(argv)
+    logging.basicConfig(level=getattr(logging, args.log_level), format=DEFAULT_LOG_FORMAT)
+    if args.profile or args.trace:
+        profiler.enable()
+    try:
+        return args.handler(args)
+    except Exception as e:
+        logger.debug(f"{args.command} failed", exc_info=True)
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+    finally:
+        active = profiler.disable()
+        if active is not None:
+            active.write(args.profile, args.trace)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,22 +1,375 @@
+import io
 import os
-import re
 import struct
 from datetime import datetime
 import tempfile
 import shutil
 import math
 import logging
+import threading
+from concurrent.futures import ThreadPoolExecutor, wait, FIRST_COMPLETED, FIRST_EXCEPTION
 import pycdlib
 from io import BytesIO
 import posixpath
 from cueparser import CueSheet
-from typing import Dict, List, Optional, Callable, Any, Tuple
+import cue_reader
+import eltorito
+import iso_names
+import layout_planner
+import profiler
+import iso_scanner
+from block_cache import BlockCache, CachedImageFile, shared_cache
+from index_cache import IndexCache
+from checksums import HashingWriter, content_hash
+from constants import INLINE_FILE_MAX_SIZE, INLINE_FILE_CACHE_BUDGET, ISO_BLOCK_SIZE
+from node_store import (NodeStore, NodeHandle, FLAG_DIRECTORY, FLAG_CHILDREN_LOADED,
+                        FLAG_HAS_CHILDREN_LOADED)
+from typing import Dict, List, Optional, Callable, Any, Set, Tuple, BinaryIO, Iterator, NamedTuple, Union
+
+try:
+    import fcntl
+except ImportError:  # Not available on Windows
+    fcntl = None
 
 logger = logging.getLogger(__name__)
 
+# Linux ioctl that makes dst a copy-on-write clone of src (btrfs, XFS, ...)
+FICLONE = 0x40049409
+
+# Chunk size and number of parallel file copies used by ExtractionEngine
+EXTRACT_CHUNK_SIZE = 1024 * 1024
+EXTRACT_WORKERS = 4
+
+# Number of directories ImportEngine lists at the same time
+IMPORT_WORKERS = 8
+
+# Files DuplicateFinder hashes at the same time, and the bytes hashed first to rule out most candidates
+DEDUP_WORKERS = 4
+DEDUP_HEAD_SIZE = 64 * 1024
+
 # Type alias for directory tree nodes
 TreeNode = Dict[str, Any]
 
+# Key of the TreeStats kept on directory nodes (see ISOCore.tree_stats())
+_STATS_KEY = 'subtree_stats'
+
+
+class LazyFileStream(io.RawIOBase):
+    """
+    A read-only, seekable view of `length` bytes of another file-like object.
+
+    The underlying object is only created by `opener` on the first read and is
+    released again once the last byte has been returned, so thousands of these
+    streams can be queued with pycdlib without holding open handles or buffers.
+    """
+    def __init__(self, opener: Callable[[], Any], length: int, base_offset: int = 0) -> None:
+        """
+        Args:
+            opener (callable): Returns the underlying file-like object.
+            length (int): The number of bytes exposed by this stream.
+            base_offset (int): Offset in the underlying object of byte 0 of this stream.
+        """
+        super().__init__()
+        self._opener = opener
+        self._length = length
+        self._base_offset = base_offset
+        self._pos = 0
+        self._fp: Any = None
+
+    def readable(self) -> bool:
+        return True
+
+    def seekable(self) -> bool:
+        return True
+
+    def tell(self) -> int:
+        return self._pos
+
+    def seek(self, offset: int, whence: int = io.SEEK_SET) -> int:
+        if whence == io.SEEK_SET:
+            new_pos = offset
+        elif whence == io.SEEK_CUR:
+            new_pos = self._pos + offset
+        elif whence == io.SEEK_END:
+            new_pos = self._length + offset
+        else:
+            raise ValueError(f"Invalid whence value: {whence}")
+        if new_pos < 0:
+            raise ValueError("Negative seek position")
+        if self._fp is not None and new_pos != self._pos:
+            self._fp.seek(self._base_offset + new_pos)
+        self._pos = new_pos
+        return self._pos
+
+    def read(self, size: int = -1) -> bytes:
+        """Reads up to `size` bytes, only returning short reads at the end of the stream."""
+        remaining = self._length - self._pos
+        if size is None or size < 0 or size > remaining:
+            size = remaining
+        if size <= 0:
+            self._release()
+            return b''
+
+        fp = self._acquire()
+        chunks = []
+        wanted = size
+        while wanted > 0:
+            chunk = fp.read(wanted)
+            if not chunk:
+                break
+            chunks.append(chunk)
+            wanted -= len(chunk)
+
+        data = chunks[0] if len(chunks) == 1 else b''.join(chunks)
+        self._pos += len(data)
+        profiler.count('bytes_read', len(data))
+        if self._pos >= self._length or not data:
+            self._release()
+        return data
+
+    def readinto(self, buffer: Any) -> int:
+        data = self.read(len(buffer))
+        buffer[:len(data)] = data
+        return len(data)
+
+    def close(self) -> None:
+        self._release()
+        super().close()
+
+    def _acquire(self) -> Any:
+        if self._fp is None:
+            self._fp = self._opener()
+            self._fp.seek(self._base_offset + self._pos)
+        return self._fp
+
+    def _release(self) -> None:
+        if self._fp is not None:
+            try:
+                self._fp.close()
+            except Exception as e:
+                logger.debug(f"Error closing lazy stream source: {e}")
+            self._fp = None
+
+def clone_file(src_path: str, dst_path: str) -> None:
+    """
+    Copies a file using the cheapest mechanism the platform offers.
+
+    A copy-on-write reflink is tried first, then a kernel-side copy_file_range()
+    loop, and finally a plain buffered copy.
+
+    Args:
+        src_path (str): The file to copy.
+        dst_path (str): The destination path; created or truncated.
+    """
+    with open(src_path, 'rb') as fsrc, open(dst_path, 'wb') as fdst:
+        if fcntl is not None:
+            try:
+                fcntl.ioctl(fdst.fileno(), FICLONE, fsrc.fileno())
+                logger.debug(f"Reflinked {src_path} to {dst_path}")
+                return
+            except OSError:
+                pass
+
+        if hasattr(os, 'copy_file_range'):
+            remaining = os.fstat(fsrc.fileno()).st_size
+            try:
+                while remaining > 0:
+                    copied = os.copy_file_range(fsrc.fileno(), fdst.fileno(), min(remaining, 1 << 30))
+                    if copied == 0:
+                        break
+                    remaining -= copied
+                if remaining == 0:
+                    logger.debug(f"Copied {src_path} to {dst_path} with copy_file_range")
+                    return
+            except OSError as e:
+                logger.debug(f"copy_file_range unavailable, using a buffered copy: {e}")
+            fsrc.seek(0)
+            fdst.seek(0)
+            fdst.truncate()
+
+        shutil.copyfileobj(fsrc, fdst, 16 * 1024 * 1024)
+
+class SourceFileChangedError(IOError):
+    """Raised when files added by path were changed or removed on disk before they were saved."""
+    def __init__(self, paths: List[str]) -> None:
+        self.paths = paths
+        listed = ", ".join(paths[:5]) + (" ..." if len(paths) > 5 else "")
+        super().__init__(f"{len(paths)} file(s) changed on disk since they were added: {listed}")
+
+
+def _boot_images(*paths: Optional[str]) -> List[Tuple[str, int]]:
+    """Returns (file name, size) of the boot images ISOBuilder would add from these paths."""
+    return [(os.path.basename(path), os.path.getsize(path)) for path in paths if path and os.path.exists(path)]
+
+
+class ImageTooLargeError(IOError):
+    """Raised before anything is written when the laid out image exceeds ISOBuilder.max_size."""
+    def __init__(self, size: int, max_size: int) -> None:
+        self.size = size
+        self.max_size = max_size
+        super().__init__(f"The image would take {size:,} bytes, more than the {max_size:,} bytes allowed")
+
+
+class TreeListener:
+    """
+    Receives notifications about edits to ISOCore.directory_tree, e.g. to update a view.
+
+    Each method is called after the change, with the nodes as stored in the tree.
+    Loading or resetting the tree is not notified; callers that replace the whole
+    tree refresh their views themselves.
+    """
+    def node_inserted(self, parent: TreeNode, node: TreeNode) -> None:
+        """A node was added to parent['children']."""
+
+    def node_removed(self, parent: TreeNode, node: TreeNode) -> None:
+        """A node was taken out of parent['children']."""
+
+    def node_changed(self, node: TreeNode) -> None:
+        """A node's own fields, such as its name, changed."""
+
+
+class ChildIndex:
+    """
+    Finds the children of one directory by case-insensitive name or by identity.
+
+    ISOCore keeps one for every directory it edits (see ISOCore.child_index())
+    and updates it with each edit it makes. If the children list changed length
+    some other way, e.g. when a lazily loaded directory is listed, the index is
+    rebuilt on next use. Renames must go through ISOCore.rename_node().
+    """
+    __slots__ = ('directory', '_by_name', '_keys', '_positions', '_valid_below', '_count')
+
+    def __init__(self, directory: TreeNode) -> None:
+        self.directory = directory
+        self.rebuild()
+
+    def rebuild(self) -> None:
+        """Re-reads the directory's children list."""
+        children = self.directory['children']
+        # Children by lower-case name; holding them also keeps their id() valid
+        self._by_name: Dict[str, List[TreeNode]] = {}
+        # Lower-case name each child is filed under, by id()
+        self._keys: Dict[int, str] = {}
+        for child in children:
+            key = child['name'].lower()
+            self._by_name.setdefault(key, []).append(child)
+            self._keys[id(child)] = key
+        # Positions by id(), correct for the positions below _valid_below
+        self._positions: Dict[int, int] = {}
+        self._valid_below = 0
+        self._count = len(children)
+
+    def _check(self) -> None:
+        if len(self.directory['children']) != self._count:
+            self.rebuild()
+
+    def named(self, name: str) -> List[TreeNode]:
+        """Returns the children whose name equals name, ignoring case."""
+        self._check()
+        return list(self._by_name.get(name.lower(), ()))
+
+    def find(self, name: str, is_directory: Optional[bool] = None) -> Optional[TreeNode]:
+        """Returns a child of that name, and of that kind unless is_directory is None."""
+        self._check()
+        for child in self._by_name.get(name.lower(), ()):
+            if is_directory is None or bool(child['is_directory']) == is_directory:
+                return child
+        return None
+
+    def position(self, node: TreeNode) -> Optional[int]:
+        """Returns a child's position in the children list, or None if it is not a child."""
+        self._check()
+        if id(node) not in self._keys:
+            return None
+        position = self._positions.get(id(node))
+        if position is None or position >= self._valid_below:
+            start = self._valid_below
+            for offset, child in enumerate(self.directory['children'][start:]):
+                self._positions[id(child)] = start + offset
+            self._valid_below = self._count
+            position = self._positions[id(node)]
+        return position
+
+    def __contains__(self, node: object) -> bool:
+        self._check()
+        return id(node) in self._keys
+
+    def added(self, node: TreeNode, position: Optional[int] = None) -> None:
+        """Records a node just inserted at position, or appended if position is None."""
+        key = node['name'].lower()
+        self._by_name.setdefault(key, []).append(node)
+        self._keys[id(node)] = key
+        self._count += 1
+        if position is None or position >= self._count - 1:
+            if self._valid_below == self._count - 1:
+                self._positions[id(node)] = self._count - 1
+                self._valid_below = self._count
+        else:
+            self._valid_below = min(self._valid_below, position)
+
+    def removed(self, node: TreeNode, position: int) -> None:
+        """Records a node just deleted from position."""
+        self._unfile(node)
+        self._positions.pop(id(node), None)
+        self._count -= 1
+        self._valid_below = min(self._valid_below, position)
+
+    def renamed(self, node: TreeNode) -> None:
+        """Files a child under its current name."""
+        if id(node) in self._keys:
+            self._unfile(node)
+            key = node['name'].lower()
+            self._by_name.setdefault(key, []).append(node)
+            self._keys[id(node)] = key
+
+    def _unfile(self, node: TreeNode) -> None:
+        key = self._keys.pop(id(node))
+        same = [child for child in self._by_name[key] if child is not node]
+        if same:
+            self._by_name[key] = same
+        else:
+            del self._by_name[key]
+
+
+class TreeStats(NamedTuple):
+    """Totals of the nodes below a directory."""
+    files: int = 0
+    directories: int = 0
+    size: int = 0
+    # ISO_BLOCK_SIZE sectors the file data takes up
+    sectors: int = 0
+
+    @classmethod
+    def of_file(cls, size: int) -> 'TreeStats':
+        return cls(1, 0, size, -(-size // ISO_BLOCK_SIZE))
+
+    @property
+    def allocated_size(self) -> int:
+        """The file data rounded up to whole sectors, in bytes."""
+        return self.sectors * ISO_BLOCK_SIZE
+
+    def plus(self, other: 'TreeStats', sign: int = 1) -> 'TreeStats':
+        """Returns these totals with other's added, or subtracted if sign is -1."""
+        return TreeStats(self.files + sign * other.files, self.directories + sign * other.directories,
+                         self.size + sign * other.size, self.sectors + sign * other.sectors)
+
+
+def _inline_bytes_below(nodes: List[TreeNode]) -> int:
+    """Returns the bytes of file data held in memory by nodes and the loaded nodes below them."""
+    total = 0
+    stack = list(nodes)
+    while stack:
+        node = stack.pop()
+        if node['is_directory']:
+            if node.get('children_loaded', True):
+                stack.extend(node['children'])
+        elif node.get('is_new'):
+            file_data = node.get('file_data')
+            if file_data is not None:
+                total += len(file_data)
+    return total
+
+
 class ISOCore:
     """
     Core logic for handling ISO file structures.
@@ -25,8 +378,32 @@ class ISOCore:
     including loading from an existing ISO, parsing its structure,
     modifying the file tree, and saving it back to a new ISO file.
     """
-    def __init__(self) -> None:
-        """Initializes the ISOCore instance with a new, empty ISO structure."""
+    def __init__(self, compact_tree: bool = False, index_cache: Optional[IndexCache] = None,
+                 inline_budget: int = INLINE_FILE_CACHE_BUDGET, block_cache: Optional[BlockCache] = None) -> None:
+        """
+        Initializes the ISOCore instance with a new, empty ISO structure.
+
+        Args:
+            compact_tree (bool): Whether to keep the directory tree in a NodeStore
+                (see node_store.py) instead of one dict per node.
+            index_cache (IndexCache): Where to look up and store the indexes of
+                opened images (see index_cache.py); None disables caching.
+            inline_budget (int): Bytes of small added files that may be held in
+                memory; 0 keeps every added file by path only.
+            block_cache (BlockCache): Where reads of opened images are cached
+                (see block_cache.py); by default the cache shared by every core.
+        """
+        self.compact_tree = compact_tree
+        self.index_cache: Optional[IndexCache] = index_cache
+        self.inline_budget: int = inline_budget
+        self.block_cache: BlockCache = block_cache if block_cache is not None else shared_cache()
+        # Bytes of added files held in memory by the nodes in the tree; nodes
+        # taken out of it, e.g. into the undo history, no longer count
+        self.inline_bytes: int = 0
+        # Objects notified of edits to directory_tree (see TreeListener)
+        self.tree_listeners: List['TreeListener'] = []
+        # ChildIndex of each edited directory, by id() of the directory node
+        self._child_indexes: Dict[int, ChildIndex] = {}
         self.current_iso_path: Optional[str] = None
         self.volume_descriptor: Optional[Dict[str, Any]] = None
         self.directory_tree: Optional[TreeNode] = None
@@ -34,11 +411,116 @@ class ISOCore:
         self.boot_image_path: Optional[str] = None
         self.efi_boot_image_path: Optional[str] = None
         self.boot_emulation_type: str = 'noemul'
-        self._pycdlib_instance: Optional[pycdlib.PyCdlib] = None
+        self._pycdlib: Optional[pycdlib.PyCdlib] = None
+        # The handle pycdlib reads the loaded image through
+        self._image_file: Optional[CachedImageFile] = None
+        # Image that _pycdlib_instance opens on first use (see _open_image())
+        self._deferred_open_path: Optional[str] = None
+        # Native directory scan of the loaded image, used instead of pycdlib to build the tree
+        self._image_scan: Optional[iso_scanner.ImageScan] = None
         self.is_joliet: bool = False
+        # The pycdlib path namespace that node 'iso_path' values belong to
+        self._walk_key: str = 'iso_path'
         self.extracted_boot_info: List[Dict[str, Any]] = []
+        # ISO 9660 paths of the loaded image's files by data extent and by pycdlib inode;
+        # None until built (see find_path_by_extent())
+        self._extent_index: Optional[Dict[int, str]] = None
+        self._inode_index: Dict[int, str] = {}
+        # Snapshot of the loaded image that incremental saves are checked against.
+        self._incremental_base: Optional[Dict[str, Any]] = None
         self.init_new_iso()
 
+    @property
+    def _pycdlib_instance(self) -> Optional[pycdlib.PyCdlib]:
+        """
+        The pycdlib handle of the loaded image.
+
+        When the tree came from the native scanner, pycdlib is only opened once
+        something actually needs it, e.g. to read file data or to save.
+        """
+        if self._pycdlib is None and self._deferred_open_path:
+            path = self._deferred_open_path
+            self._deferred_open_path = None
+            logger.debug(f"Opening {path} with pycdlib on first use.")
+            self._pycdlib = self._open_pycdlib(path)
+        return self._pycdlib
+
+    @_pycdlib_instance.setter
+    def _pycdlib_instance(self, value: Optional[pycdlib.PyCdlib]) -> None:
+        self._pycdlib = value
+        self._deferred_open_path = None
+
+    def reads_from(self, path: str) -> bool:
+        """
+        Returns True if path is the file the loaded image's data is read from.
+
+        That is the image that was loaded, even after saves under other names
+        changed current_iso_path, so it is compared with the open handle itself.
+        """
+        try:
+            target = os.stat(path)
+            if self._image_file is not None and not self._image_file.closed:
+                source = os.fstat(self._image_file.fileno())
+            elif self._deferred_open_path:
+                source = os.stat(self._deferred_open_path)
+            else:
+                return False
+        except OSError:
+            return False
+        return (source.st_dev, source.st_ino) == (target.st_dev, target.st_ino)
+
+    def is_source_image(self, path: str) -> bool:
+        """
+        Returns True if writing to path would overwrite the image being edited:
+        the file its data is read from (see reads_from()) or current_iso_path.
+        """
+        if self.reads_from(path):
+            return True
+        source_path = self.current_iso_path
+        if not source_path or not os.path.exists(source_path) or not os.path.exists(path):
+            return False
+        try:
+            return os.path.samefile(source_path, path)
+        except OSError:
+            return False
+
+    def _reopen_image(self, path: str) -> None:
+        """
+        Reads the loaded image from path from now on, e.g. after an incremental
+        save patched it or wrote a patched copy of it there.
+
+        The tree is kept, as the layout did not change; pycdlib opens the image
+        again on first use, and the blocks cached of the old file are dropped.
+        """
+        old_path = self._image_file.name if self._image_file is not None else None
+        if self._pycdlib:
+            try:
+                self._pycdlib.close()
+            except Exception as e:
+                logger.error(f"Error closing pycdlib instance: {e}")
+        if self._image_file is not None:
+            self._image_file.close()
+            self._image_file = None
+        self._pycdlib_instance = None
+        self._deferred_open_path = path
+        # Indexed by the inodes of the old handle
+        self._extent_index = None
+        self._inode_index = {}
+        for cached_path in {old_path, path} - {None}:
+            self.block_cache.forget(cached_path)
+
+    def _open_pycdlib(self, path: str) -> pycdlib.PyCdlib:
+        """Opens an image with pycdlib, reading it through the block cache."""
+        image_file = self.block_cache.open(path)
+        iso = pycdlib.PyCdlib()
+        try:
+            iso.open_fp(image_file)
+        except Exception:
+            image_file.close()
+            raise
+        self._image_file = image_file
+        return iso
+
     def init_new_iso(self) -> None:
         """Initializes or resets the core to a new, empty ISO structure."""
         logger.info("Initializing new ISO structure.")
@@ -50,35 +532,54 @@ class ISOCore:
         self.iso_modified = False
         self._pycdlib_instance = None
         self.is_joliet = False
+        self._walk_key = 'iso_path'
         self.volume_descriptor = {
             'system_id': 'TK_ISO_EDITOR', 'volume_id': 'NEW_ISO',
             'volume_size': 0, 'logical_block_size': 2048
         }
         now_str = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
-        self.directory_tree = {
+        self.directory_tree = self._new_root({
             'name': '/', 'is_directory': True, 'is_hidden': False,
             'size': 0, 'date': now_str, 'extent_location': 0,
             'children': [], 'parent': None
-        }
-        self.directory_tree['parent'] = self.directory_tree
+        })
         self.extracted_boot_info = []
+        self._incremental_base = None
+        self.inline_bytes = 0
+
+    def _new_root(self, root_node: TreeNode) -> TreeNode:
+        """Turns a root node dict into the root of a new tree, in a NodeStore if compact_tree is set."""
+        self._child_indexes = {}
+        if self.compact_tree:
+            return NodeStore().create_root(root_node)
+        root_node['parent'] = root_node
+        return root_node
 
     def close_iso(self) -> None:
         """Closes the currently open ISO file handle, if one exists."""
-        if self._pycdlib_instance:
+        if self._pycdlib:
             logger.info(f"Closing ISO file: {self.current_iso_path}")
             try:
-                self._pycdlib_instance.close()
+                self._pycdlib.close()
             except Exception as e:
                 logger.error(f"Error closing pycdlib instance: {e}")
-            self._pycdlib_instance = None
+        if self._image_file is not None:
+            self._image_file.close()
+            self._image_file = None
+        self._pycdlib_instance = None
+        self._image_scan = None
+        self._extent_index = None
+        self._inode_index = {}
 
-    def load_iso(self, file_path: str) -> None:
+    @profiler.timed('load')
+    def load_iso(self, file_path: str, lazy: bool = False) -> None:
         """
         Loads an ISO file from the given path and parses its structure using pycdlib.
 
         Args:
             file_path (str): The path to the ISO file to load.
+            lazy (bool): Whether to read only the root directory now and fill in
+                every other directory on first access (see load_children()).
 
         Raises:
             IOError: If the file is not found or another I/O error occurs.
@@ -94,21 +595,8 @@ class ISOCore:
             self.iso_modified = False
         else:
             try:
-                iso = pycdlib.PyCdlib()
-                iso.open(file_path)
-
-                self._pycdlib_instance = iso
-                self.current_iso_path = file_path
-                self.is_joliet = iso.has_joliet()
-
-                if self.is_joliet and iso.joliet_vd:
-                    self.volume_descriptor['volume_id'] = iso.joliet_vd.volume_identifier.decode('utf-16-be', 'ignore').strip()
-                    self.volume_descriptor['system_id'] = iso.joliet_vd.system_identifier.decode('utf-16-be', 'ignore').strip()
-                elif iso.pvd:
-                    self.volume_descriptor['volume_id'] = iso.pvd.volume_identifier.decode('ascii', 'ignore').strip()
-                    self.volume_descriptor['system_id'] = iso.pvd.system_identifier.decode('ascii', 'ignore').strip()
-
-                self.directory_tree = self._build_tree_from_pycdlib()
+                self._open_image(file_path)
+                self.directory_tree = self._build_tree_from_pycdlib(lazy=lazy)
                 self._extract_boot_info() # New method call
                 self.iso_modified = False
             except FileNotFoundError:
@@ -120,6 +608,61 @@ class ISOCore:
                 logger.exception(f"An unexpected error occurred while loading the ISO with pycdlib: {e}")
                 raise ValueError(f"Failed to parse ISO with pycdlib: {e}") from e
 
+    @profiler.timed('load.open')
+    def _open_image(self, file_path: str) -> None:
+        """
+        Opens an image and reads its volume information.
+
+        A valid index cache entry is used first, then the native scanner; if
+        either provides the tree, opening the image with pycdlib is deferred
+        until the handle is needed.
+        """
+        scan = self.index_cache.load(file_path) if self.index_cache else None
+        if scan is None:
+            scan = iso_scanner.scan_image(file_path)
+            if scan is not None and self.index_cache:
+                self.index_cache.store(file_path, scan)
+        if scan is not None:
+            self._image_scan = scan
+            self._deferred_open_path = file_path
+            self.current_iso_path = file_path
+            self.is_joliet = scan.has_joliet
+            self._walk_key = scan.walk_key
+            self.volume_descriptor['volume_id'] = scan.volume_id
+            self.volume_descriptor['system_id'] = scan.system_id
+            self._incremental_base = {
+                'volume_id': scan.volume_id,
+                'features': (scan.has_joliet, scan.has_rock_ridge, scan.has_udf),
+            }
+            return
+
+        iso = self._open_pycdlib(file_path)
+
+        self._pycdlib_instance = iso
+        self.current_iso_path = file_path
+        self.is_joliet = iso.has_joliet()
+
+        if iso.has_udf():
+            self._walk_key = 'udf_path'
+        elif self.is_joliet:
+            self._walk_key = 'joliet_path'
+        elif iso.has_rock_ridge():
+            self._walk_key = 'rr_path'
+        else:
+            self._walk_key = 'iso_path'
+
+        if self.is_joliet and iso.joliet_vd:
+            self.volume_descriptor['volume_id'] = iso.joliet_vd.volume_identifier.decode('utf-16-be', 'ignore').strip()
+            self.volume_descriptor['system_id'] = iso.joliet_vd.system_identifier.decode('utf-16-be', 'ignore').strip()
+        elif iso.pvd:
+            self.volume_descriptor['volume_id'] = iso.pvd.volume_identifier.decode('ascii', 'ignore').strip()
+            self.volume_descriptor['system_id'] = iso.pvd.system_identifier.decode('ascii', 'ignore').strip()
+
+        self._incremental_base = {
+            'volume_id': self.volume_descriptor.get('volume_id'),
+            'features': (bool(self.is_joliet), bool(iso.has_rock_ridge()), bool(iso.has_udf())),
+        }
+
     def _load_cue_sheet(self, file_path: str) -> None:
         """Builds the internal directory_tree from a CUE sheet."""
         try:
@@ -151,9 +694,23 @@ class ISOCore:
         if not bin_filename:
             raise ValueError("CUE sheet does not specify a BIN file.")
 
+        # CueParser does not report track modes, so they are read from the sheet directly.
+        modes = cue_reader.track_modes(cue_data)
+        bin_path = os.path.join(os.path.dirname(file_path), bin_filename)
+        track_nodes = []
+        offset, previous_frames, previous_raw_size = 0, 0, None
         for i, track in enumerate(cue_sheet.tracks):
+            mode = modes[i] if i < len(modes) else 'AUDIO'
+            # INDEX times count sectors from the start of the file, whose sizes depend on the mode
+            frames = self._parse_cue_frames(track.offset)
+            if previous_raw_size is not None:
+                offset += (frames - previous_frames) * previous_raw_size
+            else:
+                offset = frames * cue_reader.sector_layout(mode).raw_size
+            previous_frames, previous_raw_size = frames, cue_reader.sector_layout(mode).raw_size
+            extension = 'iso' if cue_reader.is_data_mode(mode) else 'wav'
             track_node = {
-                'name': track.title or f'TRACK_{i+1:02d}.wav',
+                'name': track.title or f'TRACK_{i+1:02d}.{extension}',
                 'is_directory': False,
                 'is_hidden': False,
                 'size': 0, # Will be calculated later
@@ -163,27 +720,28 @@ class ISOCore:
                 'is_new': False,
                 'is_cue_track': True,
                 'cue_track_number': i,
-                'cue_bin_file': os.path.join(os.path.dirname(file_path), bin_filename),
-                'cue_offset': self._parse_cue_offset(track.offset),
+                'cue_bin_file': bin_path,
+                'cue_offset': offset,
+                'cue_mode': mode,
             }
-            self.directory_tree['children'].append(track_node)
-
-        # Now, calculate the size of each track
-        for i, track_node in enumerate(self.directory_tree['children']):
-            if i + 1 < len(self.directory_tree['children']):
-                next_track_node = self.directory_tree['children'][i+1]
-                track_node['size'] = next_track_node['cue_offset'] - track_node['cue_offset']
+            track_nodes.append(track_node)
+
+        # Each track runs up to the next one; the last one to the end of the BIN file.
+        bin_size = os.path.getsize(bin_path) if os.path.exists(bin_path) else None
+        for i, track_node in enumerate(track_nodes):
+            if i + 1 < len(track_nodes):
+                raw_length = track_nodes[i + 1]['cue_offset'] - track_node['cue_offset']
+            elif bin_size is not None:
+                raw_length = bin_size - track_node['cue_offset']
             else:
-                # For the last track, the size is the rest of the BIN file.
-                bin_path = track_node['cue_bin_file']
-                if os.path.exists(bin_path):
-                    total_size = os.path.getsize(bin_path)
-                    track_node['size'] = total_size - track_node['cue_offset']
-                else:
-                    track_node['size'] = 0
+                raw_length = 0
+            track_node['cue_raw_size'] = max(0, raw_length)
+            # Data tracks are presented as their 2048-byte user data sectors
+            track_node['size'] = cue_reader.track_length(track_node['cue_mode'], track_node['cue_raw_size'])
+            self.directory_tree['children'].append(track_node)
 
-    def _parse_cue_offset(self, offset_str: str) -> int:
-        """Converts a CUE sheet offset string (MM:SS:FF) to bytes."""
+    def _parse_cue_frames(self, offset_str: str) -> int:
+        """Converts a CUE sheet offset string (MM:SS:FF) to a number of sectors."""
         try:
             parts = offset_str.split(':')
             if len(parts) != 3:
@@ -194,36 +752,41 @@ class ISOCore:
             if not (0 <= seconds < 60 and 0 <= frames < 75):
                 raise ValueError(f"Invalid time component in offset: seconds={seconds}, frames={frames}")
 
-            total_frames = (minutes * 60 * 75) + (seconds * 75) + frames
-            return total_frames * 2352 # 2352 bytes per frame for CD-DA
+            return (minutes * 60 * 75) + (seconds * 75) + frames
         except (ValueError, IndexError) as e:
             logger.error(f"Could not parse CUE offset string: '{offset_str}'. Error: {e}")
             raise ValueError(f"Invalid CUE offset format: '{offset_str}'") from e
 
-    def _build_tree_from_pycdlib(self) -> Optional[TreeNode]:
-        """Builds the internal directory_tree structure from the loaded pycdlib instance."""
+    @profiler.timed('load.tree')
+    def _build_tree_from_pycdlib(self, lazy: bool = False) -> Optional[TreeNode]:
+        """
+        Builds the internal directory_tree structure from the loaded pycdlib instance.
+
+        Args:
+            lazy (bool): If True, only the root directory is read. Every other
+                directory node is created with 'children_loaded' set to False and
+                is filled in by load_children() when it is first needed.
+        """
+        if self._image_scan is not None:
+            return self._build_tree_from_scan(lazy)
         if not self._pycdlib_instance:
             return None
 
-        root_node = {
+        root_node = self._new_root({
             'name': '/', 'is_directory': True, 'is_hidden': False, 'size': 0,
-            'date': '', 'children': [], 'parent': None, 'iso_path': '/'
-        }
-        root_node['parent'] = root_node
-        node_map = {'/': root_node}
+            'date': '', 'children': [], 'parent': None, 'iso_path': '/',
+            'children_loaded': not lazy
+        })
 
-        if self._pycdlib_instance.has_udf():
-            walk_key = 'udf_path'
-            walker = self._pycdlib_instance.walk(udf_path='/')
-        elif self.is_joliet:
-            walk_key = 'joliet_path'
-            walker = self._pycdlib_instance.walk(joliet_path='/')
-        elif self._pycdlib_instance.has_rock_ridge():
-            walk_key = 'rr_path'
-            walker = self._pycdlib_instance.walk(rr_path='/')
-        else:
-            walk_key = 'iso_path'
-            walker = self._pycdlib_instance.walk(iso_path='/')
+        if lazy:
+            self.load_children(root_node)
+            return root_node
+
+        node_map = {'/': root_node}
+        walker = self._pycdlib_instance.walk(**{self._walk_key: '/'})
+        if self._walk_key == 'iso_path':
+            # Every ISO 9660 record is visited anyway, so the extent index comes for free.
+            self._extent_index, self._inode_index = {}, {}
 
         for root, dirs, files in walker:
             parent_node = node_map.get(root)
@@ -231,63 +794,279 @@ class ISOCore:
                 logger.warning(f"Could not find parent node for path: {root}")
                 continue
 
-            for item_name in dirs + files:
-                is_directory = item_name in dirs
-                item_path = posixpath.join(root, item_name)
+            for new_node in self._make_child_nodes(parent_node, root, dirs, files, lazy=False):
+                if new_node['is_directory']:
+                    node_map[new_node['iso_path']] = new_node
 
-                try:
-                    record = self._pycdlib_instance.get_record(**{walk_key: item_path})
-                    if not record:
-                        logger.warning(f"Could not retrieve record for path: {item_path}")
-                        continue
-                except Exception as e:
-                    logger.error(f"Error retrieving record for {item_path}: {e}")
+        if self.index_cache and self.current_iso_path:
+            self._store_index(root_node)
+        return root_node
+
+    def _store_index(self, root_node: TreeNode) -> None:
+        """Writes a fully read pycdlib tree to the index cache, so the next load can skip pycdlib."""
+        has_rock_ridge, has_udf = self._incremental_base['features'][1:] if self._incremental_base else (False, False)
+        info = {
+            'joliet': bool(self.is_joliet), 'rock_ridge': has_rock_ridge, 'udf': has_udf,
+            'volume_id_text': self.volume_descriptor.get('volume_id', ''),
+            'system_id_text': self.volume_descriptor.get('system_id', ''),
+        }
+        # Boot information is read after the tree, so extract it now for the entry.
+        self._extract_boot_info()
+        scan = iso_scanner.ImageScan.from_tree(self._walk_key, info, root_node, self.get_extent_location,
+                                               list(self.extracted_boot_info))
+        self.index_cache.store(self.current_iso_path, scan)
+
+    def _build_tree_from_scan(self, lazy: bool) -> TreeNode:
+        """Builds the directory_tree from the native scan, like _build_tree_from_pycdlib()."""
+        scan = self._image_scan
+        root_node = self._new_root({
+            'name': '/', 'is_directory': True, 'is_hidden': False, 'size': 0,
+            'date': scan.date_string(0), 'extent_location': scan.extent[0],
+            'children': [], 'parent': None, 'iso_path': '/',
+            'children_loaded': False, 'scan_index': 0
+        })
+
+        if lazy:
+            self.load_children(root_node)
+        else:
+            self.load_all_children(root_node)
+        return root_node
+
+    def _make_scan_nodes(self, parent_node: TreeNode) -> List[TreeNode]:
+        """Creates and attaches the nodes for one directory of the native scan."""
+        scan = self._image_scan
+        new_nodes = []
+        for index in scan.children(parent_node['scan_index']):
+            name = scan.names[index]
+            new_node = {
+                'name': name,
+                'is_directory': scan.is_directory(index),
+                'is_hidden': scan.is_hidden(index),
+                'size': scan.size[index],
+                'date': scan.date_string(index),
+                'extent_location': scan.extent[index],
+                'children': [],
+                'parent': parent_node,
+                'iso_path': posixpath.join(parent_node['iso_path'], name),
+                'is_new': False
+            }
+            if new_node['is_directory']:
+                new_node['children_loaded'] = False
+                new_node['scan_index'] = index
+            new_nodes.append(new_node)
+
+        parent_node['children'][:0] = new_nodes
+        parent_node['original_child_count'] = len(new_nodes)
+        return parent_node['children'][:len(new_nodes)]
+
+    def _make_child_nodes(self, parent_node: TreeNode, root: str, dirs: List[str],
+                          files: List[str], lazy: bool) -> List[TreeNode]:
+        """
+        Creates and attaches the nodes for one directory listing from pycdlib.
+
+        Returns:
+            list: The nodes that were added to parent_node['children'].
+        """
+        walk_key = self._walk_key
+        new_nodes = []
+        for item_name in dirs + files:
+            is_directory = item_name in dirs
+            item_path = posixpath.join(root, item_name)
+
+            try:
+                record = self._pycdlib_instance.get_record(**{walk_key: item_path})
+                if not record:
+                    logger.warning(f"Could not retrieve record for path: {item_path}")
                     continue
+            except Exception as e:
+                logger.error(f"Error retrieving record for {item_path}: {e}")
+                continue
 
-                is_hidden = False
-                if walk_key != 'udf_path':
-                    is_hidden = (record.file_flags & 1) != 0
+            is_hidden = False
+            if walk_key != 'udf_path':
+                is_hidden = (record.file_flags & 1) != 0
 
-                data_length = 0
-                if walk_key == 'udf_path':
-                    data_length = record.get_data_length()
-                else:
-                    data_length = record.data_length
+            try:
+                extent = record.extent_location()
+            except Exception:
+                extent = None
+            if not is_directory and walk_key == 'iso_path' and self._extent_index is not None:
+                self._index_record(item_path, record, extent)
+
+            data_length = 0
+            if walk_key == 'udf_path':
+                data_length = record.get_data_length()
+            else:
+                data_length = record.data_length
 
-                date_obj = None
-                if walk_key == 'udf_path':
-                    date_obj = record.mod_time
-                else:
-                    date_obj = record.date
-
-                new_node = {
-                    'name': item_name,
-                    'is_directory': is_directory,
-                    'is_hidden': is_hidden,
-                    'size': data_length,
-                    'date': self._format_pycdlib_date(date_obj),
-                    'children': [],
-                    'parent': parent_node,
-                    'iso_path': item_path,
-                    'is_new': False
-                }
-                parent_node['children'].append(new_node)
+            date_obj = None
+            if walk_key == 'udf_path':
+                date_obj = record.mod_time
+            else:
+                date_obj = record.date
+
+            new_node = {
+                'name': item_name,
+                'is_directory': is_directory,
+                'is_hidden': is_hidden,
+                'size': data_length,
+                'date': self._format_pycdlib_date(date_obj),
+                'children': [],
+                'parent': parent_node,
+                'iso_path': item_path,
+                'is_new': False
+            }
+            if extent is not None:
+                new_node['extent_location'] = extent
+            if is_directory:
+                new_node['children_loaded'] = not lazy
+            new_nodes.append(new_node)
+
+        # Insert ahead of anything added before the listing was read
+        parent_node['children'][:0] = new_nodes
+        parent_node['original_child_count'] = len(new_nodes)
+        # Compact trees copy the dicts into their store; return the nodes as stored.
+        return parent_node['children'][:len(new_nodes)]
+
+    @profiler.timed('load.children')
+    def load_children(self, node: TreeNode) -> List[TreeNode]:
+        """
+        Returns a node's children, reading them from the image on first access
+        if the tree was loaded lazily.
 
-                if is_directory:
-                    node_map[item_path] = new_node
-        return root_node
+        Args:
+            node (dict): The node whose children are needed.
+
+        Returns:
+            list: The node's 'children' list.
+        """
+        if node.get('children_loaded', True):
+            return node.get('children', [])
+
+        node['children_loaded'] = True
+        if self._image_scan is not None and 'scan_index' in node:
+            self._make_scan_nodes(node)
+            return node['children']
+        if not self._pycdlib_instance:
+            return node['children']
+
+        try:
+            root, dirs, files = next(self._pycdlib_instance.walk(**{self._walk_key: node['iso_path']}))
+        except Exception as e:
+            logger.error(f"Error listing directory {node.get('iso_path')}: {e}")
+            return node['children']
+
+        self._make_child_nodes(node, root, dirs, files, lazy=True)
+        return node['children']
+
+    def has_image_listing(self) -> bool:
+        """Returns True if iter_image_listing() can list the loaded image."""
+        return self._image_scan is not None or self._pycdlib is not None
+
+    def iter_image_listing(self) -> Iterator[Tuple[str, List[str], List[str]]]:
+        """
+        Yields (path, directory names, file names) for every directory of the
+        loaded image, parents first, like pycdlib's walk().
 
-    def _format_pycdlib_date(self, pycdlib_date: Dict[str, int]) -> str:
-        """Formats a pycdlib date dictionary into a string."""
+        The listing comes from the native scan or pycdlib, not from
+        directory_tree, so it does not show edits and does not load any nodes.
+        Paths are in the namespace of node 'iso_path' values.
+        """
+        scan = self._image_scan
+        if scan is not None:
+            # Entries are in breadth-first order, so a directory's path is known before it is reached.
+            paths = {0: '/'}
+            for index in range(len(scan)):
+                if not scan.is_directory(index):
+                    continue
+                path = paths.pop(index)
+                dirs, files = [], []
+                for child in scan.children(index):
+                    name = scan.names[child]
+                    if scan.is_directory(child):
+                        dirs.append(name)
+                        paths[child] = posixpath.join(path, name)
+                    else:
+                        files.append(name)
+                yield path, dirs, files
+            return
+        if self._pycdlib is not None:
+            yield from self._pycdlib.walk(**{self._walk_key: '/'})
+
+    def load_all_children(self, node: Optional[TreeNode] = None) -> None:
+        """
+        Reads every not-yet-loaded directory below the given node (the root by default).
+
+        Args:
+            node (dict): The directory node to start from.
+        """
+        node = node or self.directory_tree
+        if isinstance(node, NodeHandle):
+            # Walk the store's columns and only create handles for directories still to be read.
+            store = node.store
+            stack = [node.index]
+            while stack:
+                index = stack.pop()
+                flags = store.flags[index]
+                if flags & FLAG_HAS_CHILDREN_LOADED and not flags & FLAG_CHILDREN_LOADED:
+                    self.load_children(store.handle(index))
+                stack.extend(i for i in store.children.get(index, ()) if store.flags[i] & FLAG_DIRECTORY)
+            return
+
+        stack = [node]
+        while stack:
+            for child in self.load_children(stack.pop()):
+                if child['is_directory']:
+                    stack.append(child)
+
+    def iter_entries(self, node: Optional[TreeNode] = None) -> Iterator[Tuple[str, bool, int]]:
+        """
+        Yields (name, is_directory, size) for every node below the given node
+        (the root by default), reading unloaded directories first.
+
+        Compact trees are walked over the NodeStore columns without creating handles.
+        """
+        node = node or self.directory_tree
+        if node is None:
+            return
+        self.load_all_children(node)
+
+        if isinstance(node, NodeHandle):
+            store = node.store
+            sizes, flags = store.sizes, store.flags
+            for index in store.subtree(node.index)[1:]:
+                yield store.name(index), bool(flags[index] & FLAG_DIRECTORY), sizes[index]
+            return
+
+        stack = list(reversed(node.get('children', [])))
+        while stack:
+            current = stack.pop()
+            yield current['name'], current['is_directory'], current.get('size', 0)
+            stack.extend(reversed(current.get('children', [])))
+
+    def _format_pycdlib_date(self, pycdlib_date: Any) -> str:
+        """Formats a pycdlib directory record date or UDF timestamp into a string."""
         try:
-            return (f"{pycdlib_date['year']:04d}-{pycdlib_date['month']:02d}-{pycdlib_date['day']:02d} "
-                    f"{pycdlib_date['hour']:02d}:{pycdlib_date['minute']:02d}:{pycdlib_date['second']:02d}")
-        except (TypeError, KeyError):
+            if hasattr(pycdlib_date, 'years_since_1900'):
+                year = pycdlib_date.years_since_1900 + 1900
+                day = pycdlib_date.day_of_month
+            else:
+                year = pycdlib_date.year
+                day = pycdlib_date.day
+            if not year or not pycdlib_date.month:
+                return "Unknown"
+            return (f"{year:04d}-{pycdlib_date.month:02d}-{day:02d} "
+                    f"{pycdlib_date.hour:02d}:{pycdlib_date.minute:02d}:{pycdlib_date.second:02d}")
+        except (TypeError, AttributeError):
             return "Unknown"
 
+    @profiler.timed('save')
     def save_iso(self, output_path: str, use_joliet: bool, use_rock_ridge: bool,
                  progress_callback: Optional[Callable[[int, int], None]] = None,
-                 make_hybrid: bool = False, use_udf: bool = True) -> None:
+                 make_hybrid: bool = False, use_udf: bool = True,
+                 incremental: bool = False,
+                 checksum_algorithms: Optional[List[str]] = None,
+                 deduplicate: bool = False, max_size: Optional[int] = None) -> Optional[Dict[str, str]]:
         """
         Saves the current in-memory ISO structure to a new file.
 
@@ -298,8 +1077,39 @@ class ISOCore:
             progress_callback (function): A callback for progress updates.
             make_hybrid (bool): Whether to make the ISO a hybrid ISO.
             use_udf (bool): Whether to use UDF.
+            incremental (bool): Whether to patch only the changed files into a copy
+                of the loaded image when the edit allows it. New boot images that fit
+                the extents of the ones they replace and isohybrid are patched in too.
+                Falls back to a full rebuild otherwise.
+            checksum_algorithms (list): Algorithms to hash the image with while it is
+                written, e.g. ['md5', 'sha256'].
+            deduplicate (bool): Whether to store files with identical contents once
+                in a rebuilt image, with all their names linked to the same data.
+            max_size (int): Fail with ImageTooLargeError, before writing, if a
+                rebuilt image would be larger than this many bytes.
+
+        Returns:
+            dict: {algorithm: hex digest} of the written image when checksum_algorithms
+                was given and the image was rebuilt; None otherwise (incremental saves
+                are not hashed inline).
         """
         logger.info(f"Saving ISO to path: {output_path}")
+        if incremental:
+            changes = self._collect_incremental_changes(use_joliet, use_rock_ridge, use_udf, make_hybrid)
+            if changes is not None:
+                try:
+                    IncrementalISOWriter(self, changes[0], output_path, progress_callback, changes[1]).write()
+                    self.current_iso_path = output_path
+                    self.iso_modified = False
+                    # The written image holds the changed files now, so they are read from it like the rest
+                    self._reopen_image(output_path)
+                    for node in changes[0]:
+                        self._adopt_patched_node(node)
+                    return None
+                except Exception as e:
+                    logger.exception(f"Failed to save ISO incrementally to {output_path}: {e}")
+                    raise
+
         try:
             builder = ISOBuilder(
                 root_node=self.directory_tree,
@@ -313,15 +1123,38 @@ class ISOCore:
                 core=self,
                 progress_callback=progress_callback,
                 make_hybrid=make_hybrid,
-                use_udf=use_udf
+                use_udf=use_udf,
+                checksum_algorithms=checksum_algorithms,
+                deduplicate=deduplicate,
+                max_size=max_size
             )
             builder.build()
             self.current_iso_path = output_path
             self.iso_modified = False
+            # The new layout no longer matches the loaded image's records.
+            self._incremental_base = None
+            return builder.checksums
         except Exception as e:
             logger.exception(f"Failed to save ISO to {output_path}: {e}")
             raise
 
+    @profiler.timed('plan')
+    def plan_layout(self, use_joliet: bool = True, use_rock_ridge: bool = True, use_udf: bool = True,
+                    make_hybrid: bool = False) -> layout_planner.LayoutPlan:
+        """
+        Plans the image save_iso() would write with these options, without writing it.
+
+        Unloaded directories are read first. See layout_planner.py.
+
+        Returns:
+            LayoutPlan: The sectors of the image, by what they hold.
+        """
+        self.load_all_children(self.directory_tree)
+        boot_images = _boot_images(self.boot_image_path, self.efi_boot_image_path)
+        return layout_planner.plan_layout(self.directory_tree, use_joliet=use_joliet, use_rock_ridge=use_rock_ridge,
+                                          use_udf=use_udf, boot_images=boot_images, make_hybrid=make_hybrid)
+
+    @profiler.timed('get_file_data')
     def get_file_data(self, node: TreeNode) -> bytes:
         """
         Retrieves the data for a given file node.
@@ -332,18 +1165,25 @@ class ISOCore:
         Returns:
             bytes: The file data.
         """
+        data = self._read_file_data(node)
+        profiler.count('bytes_read', len(data))
+        return data
+
+    def _read_file_data(self, node: TreeNode) -> bytes:
         if node.get('is_new'):
-            return node.get('file_data', b'')
+            file_data = node.get('file_data')
+            if file_data is None and node.get('file_path'):
+                # Imported and large files are only read from disk when needed
+                with open(node['file_path'], 'rb') as f:
+                    return f.read()
+            return file_data or b''
 
         if node.get('is_cue_track'):
             bin_path = node['cue_bin_file']
-            offset = node['cue_offset']
-            size = node['size']
             if os.path.exists(bin_path):
                 try:
-                    with open(bin_path, 'rb') as f:
-                        f.seek(offset)
-                        return f.read(size)
+                    with self._open_cue_track(node) as track:
+                        return track.read()
                 except (IOError, OSError) as e:
                     logger.error(f"Error reading BIN file '{bin_path}': {e}")
                     return b''
@@ -355,15 +1195,7 @@ class ISOCore:
             logger.warning("get_file_data called for ISO node but no pycdlib instance is available.")
             return b''
 
-        if self._pycdlib_instance.has_udf():
-            iso_path_key = 'udf_path'
-        elif self.is_joliet:
-            iso_path_key = 'joliet_path'
-        elif self._pycdlib_instance.has_rock_ridge():
-            iso_path_key = 'rr_path'
-        else:
-            iso_path_key = 'iso_path'
-
+        iso_path_key = self._walk_key
         try:
             with self._pycdlib_instance.open_file_from_iso(**{iso_path_key: node['iso_path']}) as f:
                 return f.read()
@@ -371,10 +1203,332 @@ class ISOCore:
             logger.error(f"Error getting file data for {node.get('name')} using pycdlib: {e}")
             return b''
 
+    def source_file_changed(self, node: TreeNode) -> bool:
+        """
+        Returns True if a new file node kept by path no longer matches its file
+        on disk, i.e. the file is gone or its size or modification time changed.
+        Nodes whose data is held in memory never count as changed.
+        """
+        if not node.get('is_new') or node.get('file_data') is not None or not node.get('file_path'):
+            return False
+        try:
+            stats = os.stat(node['file_path'])
+        except OSError:
+            return True
+        return self._stats_differ(node, stats)
+
+    @staticmethod
+    def _stats_differ(node: TreeNode, stats: os.stat_result) -> bool:
+        mtime_ns = node.get('source_mtime_ns')
+        return stats.st_size != node.get('size', 0) or (mtime_ns is not None and stats.st_mtime_ns != mtime_ns)
+
+    def _open_source_file(self, node: TreeNode) -> BinaryIO:
+        """Opens the file behind a node kept by path, failing if it changed since it was added."""
+        f = open(node['file_path'], 'rb')
+        if self._stats_differ(node, os.fstat(f.fileno())):
+            f.close()
+            raise SourceFileChangedError([node['file_path']])
+        return f
+
+    @staticmethod
+    def _open_cue_track(node: TreeNode) -> cue_reader.TrackReader:
+        """Opens a CUE track as its cooked bytes; data tracks read as ISO images."""
+        return cue_reader.TrackReader(node['cue_bin_file'], node['cue_offset'],
+                                      node.get('cue_raw_size', node['size']), node.get('cue_mode', 'AUDIO'))
+
+    def cue_track_converter(self, destination: str, node: Optional[TreeNode] = None,
+                            progress_callback: Optional[Callable[[int, int], None]] = None) -> cue_reader.TrackConverter:
+        """
+        Prepares writing a track of the loaded CUE sheet to a file of its own.
+
+        Writing a data track produces an ISO image without going through pycdlib.
+
+        Args:
+            destination (str): The file to write.
+            node (dict, optional): The track; by default the first data track.
+            progress_callback: Called as (bytes_done, bytes_total).
+
+        Returns:
+            TrackConverter: The converter; its run() does the writing.
+
+        Raises:
+            ValueError: If no CUE sheet with a data track is loaded.
+            IOError: If the BIN file is not available.
+        """
+        if node is None:
+            node = next((child for child in self.directory_tree['children'] if child.get('is_cue_track')
+                         and cue_reader.is_data_mode(child.get('cue_mode', 'AUDIO'))), None)
+            if node is None:
+                raise ValueError("The loaded image has no CUE data track to convert")
+        elif not node.get('is_cue_track'):
+            raise ValueError(f"'{node['name']}' is not a CUE track")
+        if not os.path.exists(node['cue_bin_file']):
+            raise IOError(f"BIN file not found: {node['cue_bin_file']}")
+        return cue_reader.TrackConverter(self._open_cue_track(node), destination, progress_callback)
+
+    def open_file_stream(self, node: TreeNode) -> Tuple[BinaryIO, int]:
+        """
+        Opens a lazy, read-only stream over the data of a file node.
+
+        Unlike get_file_data(), nothing is read until the stream is consumed, and
+        reads are served in caller-sized chunks, so the stream can be handed to
+        pycdlib and copied during the write phase with bounded memory.
+
+        Args:
+            node (dict): The file node to open.
+
+        Returns:
+            tuple: The stream and the number of bytes it will produce.
+
+        Raises:
+            IOError: If the node's data source is not available.
+        """
+        if node.get('is_new'):
+            file_data = node.get('file_data')
+            if file_data is not None:
+                return BytesIO(file_data), len(file_data)
+            file_path = node.get('file_path')
+            if not file_path or not os.path.exists(file_path):
+                raise IOError(f"File not found: {file_path}")
+            size = node.get('size', 0)
+            return LazyFileStream(lambda: self._open_source_file(node), size), size
+
+        if node.get('is_cue_track'):
+            bin_path = node['cue_bin_file']
+            if not os.path.exists(bin_path):
+                raise IOError(f"BIN file not found: {bin_path}")
+            size = node['size']
+            return LazyFileStream(lambda: self._open_cue_track(node), size), size
+
+        iso = self._pycdlib_instance
+        if not iso:
+            raise IOError(f"No source image is open to read '{node.get('name')}' from.")
+
+        iso_path_key = self._walk_key
+        iso_path = node['iso_path']
+        size = node.get('size', 0)
+        return LazyFileStream(lambda: iso.open_file_from_iso(**{iso_path_key: iso_path}), size), size
+
+    def find_path_by_extent(self, extent: Optional[int], inode: Any = None) -> Optional[str]:
+        """
+        Returns the ISO 9660 path of the file whose data starts at the given extent,
+        or that uses the given pycdlib inode.
+
+        The index is filled while a full ISO 9660 tree is read, or otherwise built
+        with a single walk on first use, so every lookup after that is O(1).
+        Trees read from the Joliet or UDF namespace cannot fill it: their records
+        do not tell the ISO 9660 path of their file, which is what the boot
+        catalog code reads with. The extra walk only happens for images with
+        boot entries, when their boot images are looked up.
+        """
+        if self._extent_index is None:
+            self._build_extent_index()
+        if inode is not None and id(inode) in self._inode_index:
+            return self._inode_index[id(inode)]
+        return self._extent_index.get(extent) if extent is not None else None
+
+    def _index_record(self, iso_path: str, record: Any, extent: Optional[int]) -> None:
+        """Adds one ISO 9660 file record to the extent and inode index."""
+        if extent is not None:
+            self._extent_index.setdefault(extent, iso_path)
+        inode = getattr(record, 'inode', None)
+        if inode is not None:
+            self._inode_index.setdefault(id(inode), iso_path)
+
+    def _build_extent_index(self) -> None:
+        """Builds the extent index with one pass over the ISO 9660 namespace."""
+        self._extent_index, self._inode_index = {}, {}
+        scan = self._image_scan
+        if scan is not None and scan.walk_key == 'iso_path':
+            # Breadth-first order puts every directory's path before its children's.
+            paths = ['/'] * len(scan)
+            for index in range(1, len(scan)):
+                paths[index] = posixpath.join(paths[scan.parent[index]], scan.names[index])
+                if not scan.is_directory(index):
+                    self._extent_index.setdefault(scan.extent[index], paths[index])
+            return
+
+        iso = self._pycdlib_instance
+        if not iso:
+            return
+        for root, _, files in iso.walk(iso_path='/'):
+            for name in files:
+                path = posixpath.join(root, name)
+                try:
+                    record = iso.get_record(iso_path=path)
+                    extent = record.extent_location()
+                except (pycdlib.pycdlibexception.PyCdlibException, AttributeError, KeyError) as e:
+                    logger.debug(f"Could not retrieve record for {path}: {e}")
+                    continue
+                self._index_record(path, record, extent)
+        logger.debug(f"Indexed {len(self._extent_index)} file extents of the loaded image.")
+
+    def get_extent_location(self, node: TreeNode) -> int:
+        """
+        Returns the block where a file's data starts in its source, used to read
+        many files in on-disk order. Files that do not come from the loaded
+        image sort first with 0; CUE tracks use their sector in the BIN file.
+        """
+        if node.get('is_new'):
+            return 0
+        if node.get('is_cue_track'):
+            return node.get('cue_offset', 0) // cue_reader.sector_layout(node.get('cue_mode', 'AUDIO')).raw_size
+        if 'extent_location' in node:
+            return node['extent_location']
+
+        extent = 0
+        iso = self._pycdlib_instance
+        if iso and node.get('iso_path'):
+            try:
+                record = iso.get_record(**{self._walk_key: node['iso_path']})
+                extent = record.extent_location()
+            except Exception as e:
+                logger.debug(f"No extent location for {node.get('iso_path')}: {e}")
+        node['extent_location'] = extent
+        return extent
+
+    def _adopt_patched_node(self, node: TreeNode) -> None:
+        """Turns a replacement file that an incremental save wrote into the image into a file of the image."""
+        self.inline_bytes -= _inline_bytes_below([node])
+        node['iso_path'] = node['replaces_iso_path']
+        node['is_new'] = False
+        for key in ('replaces_iso_path', 'replaces_size', 'file_path', 'source_mtime_ns', 'file_data',
+                    'extent_location'):
+            if key in node:
+                del node[key]
+        self._notify('node_changed', node)
+
+    def _collect_incremental_changes(self, use_joliet: bool, use_rock_ridge: bool,
+                                     use_udf: bool, make_hybrid: bool) -> Optional[Tuple[List[TreeNode], 'BootChanges']]:
+        """
+        Checks whether the pending edits can be saved by patching the loaded image.
+
+        That is the case when every edit overwrites an original file with data
+        that occupies the same number of extents, and nothing was added,
+        removed, renamed or moved, so the existing layout stays valid. Boot
+        settings are checked by _collect_boot_changes().
+
+        Returns:
+            tuple: The file nodes whose data must be written and the BootChanges,
+            or None if a full rebuild is required.
+        """
+        def fall_back(reason: str) -> None:
+            logger.info(f"Incremental save not possible ({reason}); rebuilding the whole image.")
+            return None
+
+        base = self._incremental_base
+        if not base or not self._pycdlib_instance or not self.current_iso_path:
+            return fall_back("no unmodified source image is loaded")
+        if (bool(use_joliet), bool(use_rock_ridge), bool(use_udf)) != base['features']:
+            return fall_back("requested extensions differ from the source image")
+        if self.volume_descriptor.get('volume_id') != base['volume_id']:
+            return fall_back("volume ID changed")
+
+        block_size = self.volume_descriptor.get('logical_block_size', 2048)
+        changed_nodes = []
+        stack = [self.directory_tree]
+        while stack:
+            parent = stack.pop()
+            # Directories that were never loaded cannot have been edited.
+            if not parent.get('children_loaded', True):
+                continue
+            original_count = 0
+            for child in parent['children']:
+                expected_path = posixpath.join(parent['iso_path'], child['name'])
+                if child.get('is_new'):
+                    if child['is_directory'] or child.get('replaces_iso_path') != expected_path:
+                        return fall_back(f"'{child['name']}' needs a new directory record")
+                    if math.ceil(child['size'] / block_size) != math.ceil(child['replaces_size'] / block_size):
+                        return fall_back(f"'{child['name']}' no longer fits its original extents")
+                    if child['size'] > 0:
+                        changed_nodes.append(child)
+                elif child.get('iso_path') != expected_path:
+                    return fall_back(f"'{child['name']}' was renamed or moved")
+                elif child['is_directory']:
+                    stack.append(child)
+                original_count += 1
+
+            if original_count != parent.get('original_child_count'):
+                return fall_back(f"entries were removed from '{parent['iso_path']}'")
+
+        boot_changes = self._collect_boot_changes(make_hybrid)
+        if isinstance(boot_changes, str):
+            return fall_back(boot_changes)
+        return changed_nodes, boot_changes
+
+    def _collect_boot_changes(self, make_hybrid: bool) -> Union['BootChanges', str]:
+        """
+        Checks whether the boot settings can be saved by patching the loaded image.
+
+        A new BIOS or EFI boot image is written over the file the catalog's entry
+        for that platform loads, if it takes as many extents and the emulation
+        type is unchanged; the entry's sector count follows the new size when it
+        covered the whole old image. isohybrid is written as a partition table
+        behind the boot code already in the system area. Anything else, e.g. a
+        platform without an entry, needs the catalog rebuilt.
+
+        Returns:
+            BootChanges, or a string with the reason a full rebuild is required.
+        """
+        requested = [(platform_id, path) for platform_id, path in
+                     ((eltorito.PLATFORM_X86, self.boot_image_path), (eltorito.PLATFORM_EFI, self.efi_boot_image_path))
+                     if path]
+        if not requested and not make_hybrid:
+            return BootChanges([], False, None)
+
+        try:
+            with open(self.current_iso_path, 'rb') as fp:
+                catalog_sector = eltorito.find_boot_catalog(fp)
+                entries = eltorito.read_boot_entries(fp, catalog_sector) if catalog_sector is not None else []
+                boot_code, gpt = eltorito.has_boot_code(fp), eltorito.has_gpt(fp)
+        except (OSError, ValueError) as e:
+            return f"the boot catalog cannot be read: {e}"
+        if not entries:
+            return "the source image has no boot catalog to patch"
+
+        iso = self._pycdlib_instance
+        block_size = self.volume_descriptor.get('logical_block_size', ISO_BLOCK_SIZE)
+        patches = []
+        for platform_id, source_path in requested:
+            platform = 'EFI' if platform_id == eltorito.PLATFORM_EFI else 'BIOS'
+            entry = eltorito.find_entry(entries, platform_id)
+            if entry is None:
+                return f"the source image has no {platform} boot entry"
+            if platform_id == eltorito.PLATFORM_X86 and entry.emulation_type != self.boot_emulation_type:
+                return "the boot emulation type changed"
+            iso_path = self.find_path_by_extent(entry.load_rba)
+            if iso_path is None or not os.path.exists(source_path):
+                return f"the {platform} boot image cannot be replaced"
+            old_size = iso.get_record(iso_path=iso_path).get_data_length()
+            size = os.path.getsize(source_path)
+            if math.ceil(size / block_size) != math.ceil(old_size / block_size):
+                return f"'{os.path.basename(source_path)}' does not fit the extents of {iso_path}"
+            sector_count = entry.sector_count
+            if sector_count == math.ceil(old_size / 512):
+                sector_count = min(math.ceil(size / 512), 0xFFFF)
+            patches.append(BootPatch(entry, source_path, iso_path, size, sector_count))
+
+        efi_partition = None
+        if make_hybrid:
+            if gpt:
+                return "the source image has a GPT"
+            if eltorito.find_entry(entries, eltorito.PLATFORM_X86) is not None and not boot_code:
+                return "the source image has no MBR boot code to keep"
+            efi_entry = eltorito.find_entry(entries, eltorito.PLATFORM_EFI)
+            efi_path = self.find_path_by_extent(efi_entry.load_rba) if efi_entry else None
+            if efi_path is not None:
+                efi_size = next((patch.size for patch in patches if patch.entry == efi_entry),
+                                None) or iso.get_record(iso_path=efi_path).get_data_length()
+                efi_partition = (efi_entry.load_rba * (ISO_BLOCK_SIZE // 512), math.ceil(efi_size / 512))
+        return BootChanges(patches, make_hybrid, efi_partition)
+
     def add_file_to_directory(self, file_path: str, target_node: TreeNode) -> None:
         """
         Adds a file from the local filesystem to a directory in the ISO structure.
-        For large files (>100MB), stores only the path to stream during save.
+
+        The file is kept by path and read while saving; a save fails with
+        SourceFileChangedError if it changed in the meantime. Files up to
+        INLINE_FILE_MAX_SIZE are read right away while inline_budget allows.
 
         Args:
             file_path (str): The path to the local file to add.
@@ -386,47 +1540,108 @@ class ISOCore:
         logger.info(f"Adding file '{file_path}' to '{self.get_node_path(target_node)}'")
         filename = os.path.basename(file_path)
 
-        # Memory optimization threshold: 100 MB
-        LARGE_FILE_THRESHOLD = 100 * 1024 * 1024
-
         try:
             file_stats = os.stat(file_path)
-            file_size = file_stats.st_size
-
-            # For large files, store only the path to stream later
-            if file_size > LARGE_FILE_THRESHOLD:
-                logger.info(f"Large file detected ({file_size} bytes), will stream from disk during save")
-                new_node = {
-                    'name': filename, 'is_directory': False, 'is_hidden': False,
-                    'size': file_size,
-                    'date': datetime.fromtimestamp(file_stats.st_mtime).strftime("%Y-%m-%d %H:%M:%S"),
-                    'extent_location': 0, 'children': [], 'parent': target_node,
-                    'file_path': file_path,  # Store path instead of data
-                    'file_data': None,  # No data in memory
-                    'is_new': True,
-                    'is_large_file': True  # Flag for streaming
-                }
-            else:
-                # For small files, read into memory as before
+            new_node = {
+                'name': filename, 'is_directory': False, 'is_hidden': False,
+                'size': file_stats.st_size,
+                'date': datetime.fromtimestamp(file_stats.st_mtime).strftime("%Y-%m-%d %H:%M:%S"),
+                'extent_location': 0, 'children': [], 'parent': target_node,
+                # The data is read from here while saving; size and mtime tell if it changed.
+                'file_path': file_path, 'source_mtime_ns': file_stats.st_mtime_ns,
+                'file_data': None,
+                'is_new': True
+            }
+            if (file_stats.st_size <= INLINE_FILE_MAX_SIZE
+                    and self.inline_bytes + file_stats.st_size <= self.inline_budget):
+                # Small files are kept in memory, as long as the budget allows it
                 with open(file_path, 'rb') as f:
                     file_data = f.read()
-
-                new_node = {
-                    'name': filename, 'is_directory': False, 'is_hidden': False,
-                    'size': len(file_data),
-                    'date': datetime.fromtimestamp(file_stats.st_mtime).strftime("%Y-%m-%d %H:%M:%S"),
-                    'extent_location': 0, 'children': [], 'parent': target_node,
-                    'file_data': file_data,
-                    'is_new': True,
-                    'is_large_file': False
-                }
+                new_node['file_data'] = file_data
+                new_node['size'] = len(file_data)
         except (FileNotFoundError, IOError) as e:
             logger.error(f"Error adding file {file_path}: {e}")
             raise IOError(f"File not found or unreadable: {file_path}") from e
 
-        target_node['children'] = [c for c in target_node['children'] if c['name'].lower() != filename.lower()]
-        target_node['children'].append(new_node)
+        self.merge_nodes(target_node, [new_node])
+
+    def merge_nodes(self, target_node: TreeNode, new_nodes: List[TreeNode]) -> None:
+        """
+        Adds new nodes, e.g. from ImportEngine, to a directory in one pass.
+
+        A file replaces every entry of the same name, like add_file_to_directory()
+        always did; a folder is merged into an existing folder of the same name.
+        Names are looked up in the directory's ChildIndex, so adding n nodes
+        costs O(n) however many children the directory already has.
+
+        Args:
+            target_node (dict): The directory node to add to.
+            new_nodes (list): Node dicts not yet in the tree; folders carry their children.
+        """
+        index = self.child_index(target_node)
+        # Entries by lower-case name, read from the index when first needed: the
+        # existing children that remain, then the nodes added so far
+        by_name: Dict[str, List[TreeNode]] = {}
+        removed: List[TreeNode] = []
+        added: List[TreeNode] = []
+        added_ids: Set[int] = set()
+
+        for node in new_nodes:
+            key = node['name'].lower()
+            same = by_name.get(key)
+            if same is None:
+                same = by_name[key] = index.named(key)
+            if node['is_directory']:
+                folder = next((c for c in same if c['is_directory']), None)
+                if folder is None:
+                    same.append(node)
+                    added.append(node)
+                    added_ids.add(id(node))
+                elif id(folder) in added_ids:
+                    for child in node['children']:
+                        child['parent'] = folder
+                    folder['children'].extend(node['children'])
+                else:
+                    self.merge_nodes(folder, node['children'])
+                continue
+
+            for existing in same:
+                if existing['is_directory']:
+                    continue
+                # Remember which original record is being overwritten so that an
+                # incremental save can patch its extent instead of rebuilding.
+                if existing.get('replaces_iso_path'):
+                    node['replaces_iso_path'] = existing['replaces_iso_path']
+                    node['replaces_size'] = existing['replaces_size']
+                elif not existing.get('is_new') and existing.get('iso_path'):
+                    node['replaces_iso_path'] = existing['iso_path']
+                    node['replaces_size'] = existing['size']
+            for existing in same:
+                if id(existing) in added_ids:
+                    added_ids.discard(id(existing))
+                else:
+                    removed.append(existing)
+            same[:] = [node]
+            added.append(node)
+            added_ids.add(id(node))
+
+        if removed:
+            self._take_out_children(target_node, removed)
+            self._update_tree_stats(target_node, removed, -1)
+            for old_node in removed:
+                self._notify('node_removed', target_node, old_node)
+        added = [node for node in added if id(node) in added_ids]
+        if not added:
+            return
         self.iso_modified = True
+        children = target_node['children']
+        for node in added:
+            node['parent'] = target_node
+            children.append(node)
+            stored = children[-1]
+            index.added(stored)
+            self._update_tree_stats(target_node, [stored], 1)
+            self._notify('node_inserted', target_node, stored)
 
     def add_folder_to_directory(self, folder_name: str, target_node: TreeNode) -> None:
         """
@@ -437,8 +1652,9 @@ class ISOCore:
             target_node (dict): The target directory node in the ISO tree.
         """
         logger.info(f"Adding folder '{folder_name}' to '{self.get_node_path(target_node)}'")
+        index = self.child_index(target_node)
 
-        if any(c['name'].lower() == folder_name.lower() and c['is_directory'] for c in target_node['children']):
+        if index.find(folder_name, is_directory=True) is not None:
             logger.warning(f"Folder '{folder_name}' already exists in '{self.get_node_path(target_node)}'")
             return
 
@@ -448,7 +1664,11 @@ class ISOCore:
             'children': [], 'parent': target_node, 'is_new': True
         }
         target_node['children'].append(new_node)
+        stored = target_node['children'][-1]
+        index.added(stored)
+        self._update_tree_stats(target_node, [stored], 1)
         self.iso_modified = True
+        self._notify('node_inserted', target_node, stored)
 
     def remove_node(self, node_to_remove: TreeNode) -> None:
         """
@@ -463,12 +1683,12 @@ class ISOCore:
                 node_name = node_to_remove.get('name', 'Unnamed')
                 parent_path = self.get_node_path(parent)
                 logger.info(f"Removing node '{node_name}' from '{parent_path}'")
-                original_len = len(parent['children'])
-                parent['children'] = [c for c in parent['children'] if id(c) != id(node_to_remove)]
 
-                if len(parent['children']) < original_len:
+                if self._take_out_children(parent, [node_to_remove]):
+                    self._update_tree_stats(parent, [node_to_remove], -1)
                     self.iso_modified = True
                     logger.info(f"Successfully removed node '{node_name}'.")
+                    self._notify('node_removed', parent, node_to_remove)
                 else:
                     logger.warning(f"Node '{node_name}' not found in parent '{parent_path}' for removal.")
             elif not parent:
@@ -480,6 +1700,219 @@ class ISOCore:
             # Depending on desired robustness, you might want to re-raise or handle differently
             raise
 
+    def _take_out_children(self, parent: TreeNode, nodes: List[TreeNode]) -> bool:
+        """
+        Deletes nodes from a directory's children list without notifying.
+
+        Returns:
+            bool: False if none of the nodes was a child of parent.
+        """
+        index = self.child_index(parent)
+        if len(nodes) == 1:
+            position = index.position(nodes[0])
+            if position is None:
+                return False
+            del parent['children'][position]
+            index.removed(nodes[0], position)
+            return True
+
+        # Rebuilding the list once beats deleting many entries by position.
+        removed_ids = {id(node) for node in nodes if node in index}
+        if not removed_ids:
+            return False
+        parent['children'] = [c for c in parent['children'] if id(c) not in removed_ids]
+        index.rebuild()
+        return True
+
+    def insert_node(self, parent: TreeNode, node: TreeNode, index: Optional[int] = None) -> TreeNode:
+        """
+        Puts a node back into a directory, e.g. one taken out by remove_node().
+
+        Args:
+            parent (dict): The directory node.
+            node (dict): The node to insert.
+            index (int): Position in the parent's children; appended if None or out of range.
+
+        Returns:
+            dict: The node as stored in the tree.
+        """
+        child_index = self.child_index(parent)
+        children = parent['children']
+        if index is None or index > len(children):
+            index = len(children)
+        children.insert(index, node)
+        self.iso_modified = True
+        stored = children[index]
+        child_index.added(stored, index)
+        self._update_tree_stats(parent, [stored], 1)
+        self._notify('node_inserted', parent, stored)
+        return stored
+
+    def rename_node(self, node: TreeNode, new_name: str) -> None:
+        """
+        Renames a node in place and tells the tree listeners.
+
+        Args:
+            node (dict): The node to rename.
+            new_name (str): Its new name.
+        """
+        node['name'] = new_name
+        parent = node.get('parent')
+        if parent is not None and parent is not node:
+            self.child_index(parent).renamed(node)
+        self.iso_modified = True
+        self.node_changed(node)
+
+    def tree_stats(self, node: Optional[TreeNode] = None, compute: bool = True) -> Optional[TreeStats]:
+        """
+        Returns the TreeStats of everything below a directory (the root by default).
+
+        The totals are computed on first use, for every directory below node
+        in the same pass, and the edits made through ISOCore update them along
+        the parent chain, so later calls take constant time. A file gives its
+        own totals.
+
+        Args:
+            node (dict): The directory node.
+            compute (bool): If False, None is returned rather than computing
+                totals that are not known yet, e.g. to avoid reading the
+                directories of a lazily loaded image.
+        """
+        node = node or self.directory_tree
+        if node is None:
+            return None
+        if not node['is_directory']:
+            return TreeStats.of_file(node.get('size', 0))
+        stats = node.get(_STATS_KEY)
+        if stats is None and compute:
+            stats = self._compute_tree_stats(node)
+        return stats
+
+    def _compute_tree_stats(self, node: TreeNode) -> TreeStats:
+        """Computes and stores the TreeStats of node and of every directory below it."""
+        self.load_all_children(node)
+
+        if isinstance(node, NodeHandle):
+            # Bottom-up over the store's columns; only the results are stored per directory.
+            store = node.store
+            flags, sizes, children, extras = store.flags, store.sizes, store.children, store.extras
+            totals: Dict[int, TreeStats] = {}
+            for index in reversed(store.subtree(node.index)):
+                if not flags[index] & FLAG_DIRECTORY:
+                    continue
+                files = directories = size = sectors = 0
+                for child in children.get(index, ()):
+                    if flags[child] & FLAG_DIRECTORY:
+                        below = totals.pop(child)
+                        files += below.files
+                        directories += below.directories + 1
+                        size += below.size
+                        sectors += below.sectors
+                    else:
+                        files += 1
+                        size += sizes[child]
+                        sectors += -(-sizes[child] // ISO_BLOCK_SIZE)
+                totals[index] = stats = TreeStats(files, directories, size, sectors)
+                extras.setdefault(index, {})[_STATS_KEY] = stats
+            return totals[node.index]
+
+        # Post-order; directories whose totals are known are not walked again.
+        stack = [(node, False)]
+        while stack:
+            current, walked = stack.pop()
+            if not walked:
+                stack.append((current, True))
+                stack.extend((child, False) for child in current['children']
+                             if child['is_directory'] and child.get(_STATS_KEY) is None)
+                continue
+            stats = TreeStats()
+            for child in current['children']:
+                stats = stats.plus(self._stats_below_parent(child))
+            current[_STATS_KEY] = stats
+        return node[_STATS_KEY]
+
+    def _stats_below_parent(self, node: TreeNode) -> TreeStats:
+        """Returns what a node adds to its parent's TreeStats: itself and, for a directory, its contents."""
+        if not node['is_directory']:
+            return TreeStats.of_file(node.get('size', 0))
+        return self.tree_stats(node).plus(TreeStats(directories=1))
+
+    def _update_tree_stats(self, parent: TreeNode, nodes: List[TreeNode], sign: int) -> None:
+        """
+        Adds the totals of nodes just put into parent (sign 1), or just taken
+        out of it (sign -1), to every ancestor whose TreeStats are known, and
+        their file data held in memory to inline_bytes.
+        """
+        self.inline_bytes += sign * _inline_bytes_below(nodes)
+        known = []
+        current = parent
+        while current is not None:
+            if current.get(_STATS_KEY) is not None:
+                known.append(current)
+            up = current.get('parent')
+            current = None if up is None or up is current else up
+        if not known:
+            return
+        change = TreeStats()
+        for node in nodes:
+            change = change.plus(self._stats_below_parent(node))
+        for directory in known:
+            directory[_STATS_KEY] = directory[_STATS_KEY].plus(change, sign)
+
+    def child_index(self, directory: TreeNode) -> ChildIndex:
+        """
+        Returns the ChildIndex of a directory, loading its children first if needed.
+
+        Args:
+            directory (dict): A directory node of the current tree.
+        """
+        index = self._child_indexes.get(id(directory))
+        if index is None or index.directory is not directory:
+            self.load_children(directory)
+            index = self._child_indexes[id(directory)] = ChildIndex(directory)
+        return index
+
+    def find_child(self, directory: TreeNode, name: str,
+                   is_directory: Optional[bool] = None) -> Optional[TreeNode]:
+        """
+        Looks up a directory's child by name, ignoring case.
+
+        Args:
+            directory (dict): The directory node.
+            name (str): The name to look for.
+            is_directory (bool): Only return a folder if True, or a file if False.
+
+        Returns:
+            dict: The child, or None if there is none.
+        """
+        return self.child_index(directory).find(name, is_directory)
+
+    def find_node_by_path(self, path: str) -> Optional[TreeNode]:
+        """
+        Looks up a node by its path in the image, e.g. '/BOOT/grub.cfg', ignoring case.
+
+        Returns:
+            dict: The node, or None if there is none.
+        """
+        node = self.directory_tree
+        for part in (part for part in path.split('/') if part):
+            if node is None or not node['is_directory']:
+                return None
+            node = self.find_child(node, part)
+        return node
+
+    def node_changed(self, node: TreeNode) -> None:
+        """Tells the tree listeners that a node's fields (e.g. its name) were edited in place."""
+        self._notify('node_changed', node)
+
+    def _notify(self, event: str, *args: Any) -> None:
+        """Calls one TreeListener method on every listener; a failing listener does not stop the edit."""
+        for listener in list(self.tree_listeners):
+            try:
+                getattr(listener, event)(*args)
+            except Exception as e:
+                logger.exception(f"Tree listener {listener!r} failed in {event}: {e}")
+
     def get_node_path(self, node: TreeNode) -> str:
         """
         Gets the full path string for a given node in the directory tree.
@@ -501,35 +1934,18 @@ class ISOCore:
 
     def find_non_compliant_filenames(self) -> List[str]:
         """
-        Scans the directory tree for filenames that do not comply with the
-        strict ISO9660 Level 1 standard.
+        Scans the directory tree for filenames that have to be changed to fit
+        ISO9660 (see iso_names.non_compliant_names()).
 
         Returns:
             list: A list of non-compliant filenames.
         """
-        non_compliant_files = []
-        iso9660_pattern = re.compile(r'^[A-Z0-9_]+$')
-
-        def check_node(node):
-            if node['name'] != '/':
-                if node['name'].count('.') > 1:
-                    non_compliant_files.append(node['name'])
-
-                base, ext = os.path.splitext(node['name'])
-                if ext: ext = ext[1:]
-
-                if not iso9660_pattern.match(base.upper()) or \
-                   (ext and not iso9660_pattern.match(ext.upper())):
-                    non_compliant_files.append(node['name'])
-
-            for child in node.get('children', []):
-                check_node(child)
-
-        if self.directory_tree:
-            check_node(self.directory_tree)
-
-        return list(set(non_compliant_files))
+        # Many entries share a name (e.g. README), so each name is checked once.
+        names = {name for name, _, _ in self.iter_entries()}
+        names.discard('/')
+        return iso_names.non_compliant_names(names)
 
+    @profiler.timed('load.boot')
     def _extract_boot_info(self) -> None:
         """
         Extracts boot information from the loaded ISO and populates
@@ -538,6 +1954,10 @@ class ISOCore:
         self.extracted_boot_info = []
         logger.debug("Attempting to extract boot info from loaded ISO.")
 
+        if self._image_scan is not None:
+            self.extracted_boot_info = list(self._image_scan.boot_entries)
+            return
+
         if not hasattr(self._pycdlib_instance, 'eltorito_boot_catalog'):
             logger.debug("No El Torito boot catalog found in the ISO.")
             return
@@ -573,21 +1993,11 @@ class ISOCore:
                 media_map = {0: 'noemul', 1: 'floppy', 2: 'floppy', 3: 'floppy', 4: 'hdemul'}
                 emulation_type = media_map.get(media_type, 'unknown')
 
-                boot_inode_num = getattr(entry, 'inode', -1)
+                boot_inode = getattr(entry, 'inode', None)
                 boot_image_path = "Unknown"
-                if boot_inode_num != -1:
-                    for root, _, files in self._pycdlib_instance.walk(iso_path='/'):
-                        for f in files:
-                            try:
-                                record = self._pycdlib_instance.get_record(iso_path=posixpath.join(root, f))
-                                if record.inode == boot_inode_num:
-                                    boot_image_path = posixpath.join(root, f)
-                                    break
-                            except (pycdlib.pycdlibexception.PyCdlibException, AttributeError, KeyError) as e:
-                                logger.debug(f"Could not retrieve record for {posixpath.join(root, f)}: {e}")
-                                continue
-                        if boot_image_path != "Unknown":
-                            break
+                if boot_inode is not None:
+                    boot_image_path = self.find_path_by_extent(getattr(entry, 'load_rba', None),
+                                                               inode=boot_inode) or "Unknown"
 
                 info = {
                     'platform_id': getattr(entry, 'system_type', -1),
@@ -601,6 +2011,143 @@ class ISOCore:
         except Exception as e:
             logger.error(f"An unexpected error occurred during boot info extraction: {e}")
 
+class DuplicateFinder:
+    """
+    Finds file nodes with identical contents, so an image can store them once.
+
+    Candidates are grouped by size first. Files that read from the same
+    place (the same extent of the loaded image, or the same source path)
+    are identical without being read. The others are told apart by a hash
+    of their first DEDUP_HEAD_SIZE bytes and then, if they still match, of
+    all their data; the hashing runs on a thread pool.
+    """
+    def __init__(self, core: ISOCore, nodes: List[TreeNode], workers: int = DEDUP_WORKERS,
+                 chunk_size: int = EXTRACT_CHUNK_SIZE) -> None:
+        """
+        Args:
+            core (ISOCore): The core the nodes belong to.
+            nodes (list): File nodes, in the order they will be written.
+            workers (int): Number of files hashed at the same time.
+            chunk_size (int): Bytes read per step.
+        """
+        self.core: ISOCore = core
+        self.nodes: List[TreeNode] = nodes
+        self.workers: int = max(1, workers)
+        self.chunk_size: int = chunk_size
+        self.bytes_hashed: int = 0
+        self._source_lock = threading.Lock()
+        self._count_lock = threading.Lock()
+
+    @profiler.timed('build.dedup')
+    def find(self) -> List[List[TreeNode]]:
+        """
+        Returns:
+            list: Groups of two or more identical nodes, each in the order of self.nodes.
+                Files that cannot be read are left out.
+        """
+        by_size: Dict[int, List[TreeNode]] = {}
+        for node in self.nodes:
+            if node.get('size', 0) > 0:
+                by_size.setdefault(node['size'], []).append(node)
+
+        # Nodes reading from the same place form one 'copy'; only its first node is hashed.
+        copies_by_size: List[List[List[TreeNode]]] = []
+        for nodes in by_size.values():
+            if len(nodes) < 2:
+                continue
+            same_source: Dict[Any, List[TreeNode]] = {}
+            copies: List[List[TreeNode]] = []
+            for node in nodes:
+                key = self._source_key(node)
+                if key is None:
+                    copies.append([node])
+                elif key in same_source:
+                    same_source[key].append(node)
+                else:
+                    same_source[key] = [node]
+                    copies.append(same_source[key])
+            copies_by_size.append(copies)
+
+        # Same-size copies are compared by the hash of their head, then of all their data.
+        final = [bucket for bucket in copies_by_size if len(bucket) == 1]
+        full = []
+        for bucket in self._split([b for b in copies_by_size if len(b) > 1], DEDUP_HEAD_SIZE):
+            if len(bucket) == 1 or bucket[0][0]['size'] <= DEDUP_HEAD_SIZE:
+                final.append(bucket)
+            else:
+                full.append(bucket)
+        final.extend(self._split(full, None))
+
+        order = {id(node): position for position, node in enumerate(self.nodes)}
+        groups = [sorted((node for copy in bucket for node in copy), key=lambda node: order[id(node)])
+                  for bucket in final]
+        return [group for group in groups if len(group) > 1]
+
+    def _source_key(self, node: TreeNode) -> Any:
+        """Where a node's data is read from, or None if that does not identify it."""
+        if node.get('is_new'):
+            if node.get('file_data') is None and node.get('file_path'):
+                return ('path', node['file_path'])
+            return None
+        if node.get('is_cue_track'):
+            return ('cue', node['cue_bin_file'], node['cue_offset'], node.get('cue_mode'))
+        extent = self.core.get_extent_location(node)
+        return ('extent', extent) if extent else None
+
+    def _split(self, buckets: List[List[List[TreeNode]]], limit: Optional[int]) -> List[List[List[TreeNode]]]:
+        """Splits buckets of copies by the hash of their first limit bytes (all of them if None)."""
+        copies = [copy for bucket in buckets for copy in bucket]
+        with ThreadPoolExecutor(max_workers=min(self.workers, len(copies) or 1)) as pool:
+            digests = dict(zip(map(id, copies), pool.map(lambda copy: self._digest(copy[0], limit), copies)))
+        result = []
+        for bucket in buckets:
+            by_digest: Dict[Any, List[List[TreeNode]]] = {}
+            for copy in bucket:
+                # An unreadable copy only matches itself.
+                digest = digests[id(copy)] or id(copy)
+                by_digest.setdefault(digest, []).append(copy)
+            result.extend(by_digest.values())
+        return result
+
+    def _digest(self, node: TreeNode, limit: Optional[int]) -> Optional[bytes]:
+        """Hashes the first limit bytes of a node's data; returns None if it cannot be read."""
+        # Everything except new files and CUE tracks is read through the shared image handle.
+        lock = self._source_lock if not node.get('is_new') and not node.get('is_cue_track') else None
+        length = node['size'] if limit is None else min(limit, node['size'])
+        hasher = content_hash()
+        try:
+            if lock:
+                with lock:
+                    stream, _ = self.core.open_file_stream(node)
+            else:
+                stream, _ = self.core.open_file_stream(node)
+            try:
+                remaining = length
+                while remaining > 0:
+                    size = min(self.chunk_size, remaining)
+                    if lock:
+                        with lock:
+                            chunk = stream.read(size)
+                    else:
+                        chunk = stream.read(size)
+                    if not chunk:
+                        return None
+                    hasher.update(chunk)
+                    remaining -= len(chunk)
+            finally:
+                if lock:
+                    with lock:
+                        stream.close()
+                else:
+                    stream.close()
+        except Exception as e:
+            logger.debug(f"Not deduplicating {node.get('name')}: {e}")
+            return None
+        with self._count_lock:
+            self.bytes_hashed += length
+        return hasher.digest()
+
+
 class ISOBuilder:
     """
     Builds an ISO 9660 file from an in-memory directory tree using pycdlib.
@@ -610,7 +2157,9 @@ class ISOBuilder:
                  boot_image_path: Optional[str] = None, efi_boot_image_path: Optional[str] = None,
                  boot_emulation_type: str = 'noemul', core: Optional[ISOCore] = None,
                  progress_callback: Optional[Callable[[int, int], None]] = None,
-                 make_hybrid: bool = False, use_udf: bool = True) -> None:
+                 make_hybrid: bool = False, use_udf: bool = True,
+                 checksum_algorithms: Optional[List[str]] = None, deduplicate: bool = False,
+                 iso9660_level: int = 1, max_size: Optional[int] = None) -> None:
         self.root_node: TreeNode = root_node
         self.output_path: str = output_path
         self.volume_id: str = volume_id
@@ -623,8 +2172,24 @@ class ISOBuilder:
         self.progress_callback: Optional[Callable[[int, int], None]] = progress_callback
         self.make_hybrid: bool = make_hybrid
         self.use_udf: bool = use_udf
+        self.checksum_algorithms: Optional[List[str]] = checksum_algorithms
+        # Digests of the written image, filled in by build() when checksum_algorithms is set
+        self.checksums: Optional[Dict[str, str]] = None
+        # Whether identical files are stored once, with every name linked to that copy
+        self.deduplicate: bool = deduplicate
+        self.deduplicated_files: int = 0
+        self.deduplicated_bytes: int = 0
+        # Interchange level whose limits the ISO9660 names keep to (see iso_names.py)
+        self.iso9660_level: int = iso9660_level
+        # Largest image, in bytes, that build() may write; checked once the layout is known
+        self.max_size: Optional[int] = max_size
+        # Size of the image as laid out, filled in by build() before writing
+        self.planned_size: Optional[int] = None
         self.iso: pycdlib.PyCdlib = pycdlib.PyCdlib()
+        # ISO9660 and Joliet names of the directories, shared by the walks of one build
+        self._directory_names: iso_names.NamesCache = {}
 
+    @profiler.timed('build')
     def build(self) -> None:
         """
         Builds the ISO file and writes it to the output path.
@@ -644,87 +2209,176 @@ class ISOBuilder:
             logger.exception(f"Failed to initialize new ISO with pycdlib: {e}")
             raise
 
-        all_nodes = self._get_all_nodes_flat(self.root_node, '/', '/', '/')
-        all_nodes.sort(key=lambda x: x[0].count('/'))
-
-        for joliet_path, iso9660_path, udf_path, node in all_nodes:
-            rr_name = node['name']
-
-            # Don't use Joliet path if the name is too long.
-            # UDF and Rock Ridge can handle it.
-            current_joliet_path = joliet_path
-            if len(node['name']) > 64:
-                current_joliet_path = None
-
-            if node['is_directory']:
-                try:
-                    self.iso.add_directory(iso9660_path, rr_name=rr_name, joliet_path=current_joliet_path, udf_path=udf_path)
-                except Exception as e:
-                    if 'File already exists' not in str(e):
-                        logger.error(f"Failed to add directory {joliet_path} to ISO: {e}")
-                        raise
-            else:
-                # Check if this is a large file that should be streamed from disk
-                if node.get('is_new') and node.get('is_large_file'):
-                    # Large file - stream directly from disk without loading into memory
-                    file_path = node.get('file_path')
-                    if file_path and os.path.exists(file_path):
-                        try:
-                            logger.debug(f"Streaming large file from {file_path}")
-                            self.iso.add_file(file_path, iso9660_path, rr_name=rr_name, joliet_path=current_joliet_path, udf_path=udf_path)
-                        except Exception as e:
-                            logger.error(f"Failed to add large file {joliet_path} to ISO: {e}")
+        # Directories of a lazily loaded image that were never opened still
+        # have to be read so their contents end up in the new image.
+        if self.core:
+            self.core.load_all_children(self.root_node)
+
+        # Added files that were modified on disk; they fail the build before anything is written
+        changed_sources: List[str] = []
+        # Duplicates map to the node whose data they share; it is added first and they are linked to it.
+        # The map is keyed by id(), so the files it was built from are kept for the whole build: the
+        # handles of a compact tree are only cached while referenced, and new ones could reuse the ids.
+        primaries, dedup_files = self._find_duplicates() if self.deduplicate and self.core else ({}, [])
+        primary_ids = {id(primary) for primary in primaries.values()}
+        primary_paths: Dict[int, str] = {}
+        links: List[Tuple[TreeNode, Optional[str], str, str, str]] = []
+
+        # Pre-order, so every directory is added before its contents
+        with profiler.phase('build.tree'):
+            for joliet_path, iso9660_path, udf_path, node in self._iter_nodes(self.root_node):
+                rr_name = node['name']
+                current_joliet_path = joliet_path
+
+                if node['is_directory']:
+                    try:
+                        self.iso.add_directory(iso9660_path, rr_name=rr_name, joliet_path=current_joliet_path, udf_path=udf_path)
+                    except Exception as e:
+                        if 'File already exists' not in str(e):
+                            logger.error(f"Failed to add directory {joliet_path} to ISO: {e}")
                             raise
-                    else:
-                        logger.error(f"Large file path not found for {joliet_path}: {file_path}")
-                        raise FileNotFoundError(f"File not found: {file_path}")
                 else:
-                    # Small file or existing file - use existing approach
+                    if self.core and self.core.source_file_changed(node):
+                        changed_sources.append(node['file_path'])
+                        continue
+                    primary = primaries.get(id(node))
+                    if primary is not None:
+                        links.append((primary, current_joliet_path, iso9660_path, udf_path, rr_name))
+                        continue
+                    if id(node) in primary_ids:
+                        primary_paths[id(node)] = iso9660_path
+                    profiler.count('files')
+                    # Stream the file so that no data is read until pycdlib copies
+                    # it during the write phase.
                     try:
-                        file_data = self.core.get_file_data(node)
-                        self.iso.add_fp(BytesIO(file_data), len(file_data), iso9660_path, rr_name=rr_name, joliet_path=current_joliet_path, udf_path=udf_path)
+                        stream, length = self.core.open_file_stream(node)
+                        self.iso.add_fp(stream, length, iso9660_path, rr_name=rr_name, joliet_path=current_joliet_path, udf_path=udf_path)
                     except Exception as e:
                         logger.error(f"Failed to add file {joliet_path} to ISO: {e}")
                         raise
 
-        if self.boot_image_path or self.efi_boot_image_path:
-            self._add_boot_images()
-            if self.make_hybrid:
-                self.iso.add_isohybrid()
+        if changed_sources:
+            raise SourceFileChangedError(changed_sources)
+        for primary, joliet_path, iso9660_path, udf_path, rr_name in links:
+            self._add_links(primary_paths[id(primary)], joliet_path, iso9660_path, udf_path, rr_name)
+            self.deduplicated_files += 1
+            self.deduplicated_bytes += primary['size']
+        if links:
+            logger.info(f"Stored {self.deduplicated_files} duplicate file(s) as links, "
+                        f"saving {self.deduplicated_bytes} bytes")
+
+        with profiler.phase('build.layout'):
+            if self.boot_image_path or self.efi_boot_image_path:
+                self._add_boot_images()
+                if self.make_hybrid:
+                    self.iso.add_isohybrid()
+            self.planned_size = self._laid_out_size()
+        if self.max_size is not None and self.planned_size > self.max_size:
+            raise ImageTooLargeError(self.planned_size, self.max_size)
+
+        # Original file data is streamed from the source image while writing, so the
+        # source must not be truncated underneath us when saving over it.
+        write_path = self.output_path
+        if self._output_is_source():
+            fd, write_path = tempfile.mkstemp(prefix='.iso_editor_', suffix='.tmp',
+                                              dir=os.path.dirname(os.path.abspath(self.output_path)))
+            os.close(fd)
+            logger.info(f"Output is the source image; writing to temporary file {write_path} first.")
 
-        self.iso.write(self.output_path, progress_cb=self.progress_callback)
-        self.iso.close()
+        try:
+            with profiler.phase('build.write'):
+                if self.checksum_algorithms:
+                    # Hash sectors as pycdlib emits them instead of reading the image back.
+                    with HashingWriter(write_path, self.checksum_algorithms) as out:
+                        self.iso.write_fp(out, progress_cb=self.progress_callback)
+                        self.checksums = out.hexdigests()
+                else:
+                    self.iso.write(write_path, progress_cb=self.progress_callback)
+            profiler.count('bytes_written', os.path.getsize(write_path))
+            self.iso.close()
+            if write_path != self.output_path:
+                os.replace(write_path, self.output_path)
+        except BaseException:
+            if write_path != self.output_path and os.path.exists(write_path):
+                os.remove(write_path)
+            raise
         logger.info(f"ISO build process completed successfully. Output at: {self.output_path}")
 
+    def _find_duplicates(self) -> Tuple[Dict[int, TreeNode], List[TreeNode]]:
+        """
+        Returns {id(duplicate): the first node with the same contents, in build order}
+        over the files to write, and those files; the ids are only valid while they are held.
+        """
+        files = [node for _, _, _, node in self._iter_nodes(self.root_node) if not node['is_directory']]
+        finder = DuplicateFinder(self.core, files)
+        primaries = {}
+        for group in finder.find():
+            for duplicate in group[1:]:
+                primaries[id(duplicate)] = group[0]
+        logger.info(f"Deduplication hashed {finder.bytes_hashed} bytes and found {len(primaries)} duplicate file(s)")
+        return primaries, files
+
+    def _add_links(self, iso_old_path: str, joliet_path: Optional[str], iso9660_path: str,
+                   udf_path: str, rr_name: str) -> None:
+        """Adds the records of a duplicate, pointing at the data of the file at iso_old_path."""
+        rr = {'rr_name': rr_name} if self.use_rock_ridge else {}
+        self.iso.add_hard_link(iso_old_path=iso_old_path, iso_new_path=iso9660_path, **rr)
+        if self.use_joliet and joliet_path:
+            self.iso.add_hard_link(iso_old_path=iso_old_path, joliet_new_path=joliet_path)
+        if self.use_udf:
+            self.iso.add_hard_link(iso_old_path=iso_old_path, udf_new_path=udf_path)
+
+    def _laid_out_size(self) -> int:
+        """
+        Returns the size of the image pycdlib has laid out, or the planned size
+        if this pycdlib does not tell.
+        """
+        space_size = getattr(getattr(self.iso, 'pvd', None), 'space_size', None)
+        if not isinstance(space_size, int):
+            boot_images = _boot_images(self.boot_image_path, self.efi_boot_image_path)
+            return layout_planner.plan_layout(self.root_node, self.use_joliet, self.use_rock_ridge, self.use_udf,
+                                              boot_images, self.make_hybrid, self.iso9660_level,
+                                              self._directory_names).total_size
+        size = space_size * ISO_BLOCK_SIZE
+        if self.make_hybrid and (self.boot_image_path or self.efi_boot_image_path):
+            size += -size % layout_planner.HYBRID_ALIGNMENT
+        return size
+
+    def _output_is_source(self) -> bool:
+        """Returns True if the output path is the image the tree is being read from."""
+        return bool(self.core) and self.core.is_source_image(self.output_path)
+
     def _sanitize_iso9660_name(self, name: str) -> str:
         """
         Sanitizes a filename to be compliant with the basic ISO9660 standard.
         """
-        base, ext = os.path.splitext(name)
-        sanitized_base = re.sub(r'[^A-Z0-9_]', '_', base.upper())
-        if not sanitized_base: sanitized_base = '_'
-        if ext:
-            sanitized_ext = re.sub(r'[^A-Z0-9_]', '_', ext[1:].upper())
-            return f"{sanitized_base[:8]}.{sanitized_ext[:3]}"
-        return sanitized_base[:8]
+        return iso_names.iso9660_name(name, level=self.iso9660_level)
 
-    def _get_all_nodes_flat(self, node: TreeNode, joliet_path: str, iso9660_path: str,
-                            udf_path: str) -> List[Tuple[str, str, str, TreeNode]]:
-        """
-        Walks the directory tree and returns a flat list of all nodes
-        with their full Joliet, ISO9660, and UDF paths.
+    def _iter_nodes(self, node: TreeNode) -> Iterator[Tuple[str, str, str, TreeNode]]:
         """
-        nodes = []
-        for child in node['children']:
-            child_joliet_path = posixpath.join(joliet_path, child['name'])
-            child_udf_path = posixpath.join(udf_path, child['name'])
-            sanitized_name = self._sanitize_iso9660_name(child['name'])
-            child_iso9660_path = posixpath.join(iso9660_path, sanitized_name)
+        Walks the tree below node in pre-order, yielding (Joliet path, ISO9660 path, UDF path, node).
 
-            nodes.append((child_joliet_path, child_iso9660_path, child_udf_path, child))
+        Only the paths of the directories being walked are kept, so memory use
+        depends on the depth of the tree rather than on its size. The ISO9660
+        and Joliet names of each directory are mapped together by iso_names.
+        """
+        level = self.iso9660_level
+        # (children left to visit, Joliet, ISO9660 and UDF path prefixes, ISO9660 and Joliet names)
+        names = self._directory_names
+        stack = [(enumerate(node['children']), '/', '/', '/', *iso_names.directory_names(node, level, names))]
+        while stack:
+            children, joliet_prefix, iso9660_prefix, udf_prefix, iso9660, joliet = stack[-1]
+            i, child = next(children, (None, None))
+            if child is None:
+                stack.pop()
+                continue
+            joliet_path = joliet_prefix + joliet[i]
+            iso9660_path = iso9660_prefix + iso9660[i]
+            udf_path = udf_prefix + child['name']
+            yield joliet_path, iso9660_path, udf_path, child
             if child['is_directory']:
-                nodes.extend(self._get_all_nodes_flat(child, child_joliet_path, child_iso9660_path, child_udf_path))
-        return nodes
+                stack.append((enumerate(child['children']), joliet_path + '/', iso9660_path + '/',
+                              udf_path + '/', *iso_names.directory_names(child, level, names)))
 
     def _add_boot_images(self) -> None:
         """Adds boot images to the ISO if they exist."""
@@ -747,3 +2401,486 @@ class ISOBuilder:
             joliet_efi_iso_path = f'/boot/{efi_boot_filename}'
             self.iso.add_file(self.efi_boot_image_path, efi_iso_path, rr_name=efi_boot_filename, joliet_path=joliet_efi_iso_path)
             self.iso.add_eltorito(efi_iso_path, efi=True)
+
+class BootPatch(NamedTuple):
+    """A boot image written over the file a catalog entry loads."""
+    entry: eltorito.BootEntry
+    source_path: str
+    iso_path: str
+    size: int
+    sector_count: int
+
+
+class BootChanges(NamedTuple):
+    """The boot edits IncrementalISOWriter patches in; see ISOCore._collect_boot_changes()."""
+    patches: List[BootPatch]
+    make_hybrid: bool
+    # (first 512-byte sector, sector count) of the EFI boot image, for its isohybrid partition
+    efi_partition: Optional[Tuple[int, int]]
+
+
+class IncrementalISOWriter:
+    """
+    Saves edits by patching changed file extents into a copy of the loaded image.
+
+    Only usable when ISOCore._collect_incremental_changes() found the edit to
+    preserve the existing layout. Unchanged extents are cloned from the source
+    image (reflink or kernel-side copy where available) or, when saving over the
+    source, left untouched; only the changed files' data and the records that
+    describe their lengths are written. Boot changes touch the swapped boot
+    files, their catalog entries and the MBR in sector 0.
+
+    A save over the source cannot be cancelled once patching started, as the
+    image is the only copy: an InterruptedError from the progress callback is
+    then logged and the patching completes.
+    """
+    def __init__(self, core: ISOCore, changed_nodes: List[TreeNode], output_path: str,
+                 progress_callback: Optional[Callable[[int, int, Any], None]] = None,
+                 boot_changes: Optional[BootChanges] = None) -> None:
+        self.core: ISOCore = core
+        self.changed_nodes: List[TreeNode] = changed_nodes
+        self.output_path: str = output_path
+        self.progress_callback = progress_callback
+        self.boot_changes: BootChanges = boot_changes or BootChanges([], False, None)
+        self.in_place: bool = False
+        self._cancel_ignored: bool = False
+
+    @profiler.timed('save.incremental')
+    def write(self) -> None:
+        """
+        Writes the patched image to the output path.
+
+        Raises:
+            SourceFileChangedError: If replacement files changed on disk since they
+                were added; checked before anything is written, as the output may
+                be the only copy of the image.
+        """
+        changed_sources = [node['file_path'] for node in self.changed_nodes if self.core.source_file_changed(node)]
+        if changed_sources:
+            raise SourceFileChangedError(changed_sources)
+
+        source_path = self.core.current_iso_path
+        in_place = self.in_place = self.core.is_source_image(self.output_path)
+        logger.info(f"Incrementally saving {len(self.changed_nodes)} changed file(s) to {self.output_path}"
+                    f"{' in place' if in_place else ''}.")
+
+        target_path = self.output_path
+        if not in_place:
+            fd, target_path = tempfile.mkstemp(prefix='.iso_editor_', suffix='.tmp',
+                                               dir=os.path.dirname(os.path.abspath(self.output_path)))
+            os.close(fd)
+
+        try:
+            if not in_place:
+                clone_file(source_path, target_path)
+            if self.changed_nodes or self.boot_changes.patches:
+                self._patch(target_path)
+            if self.boot_changes.patches or self.boot_changes.make_hybrid:
+                self._patch_boot(target_path)
+            if not in_place:
+                os.replace(target_path, self.output_path)
+        except BaseException:
+            if not in_place and os.path.exists(target_path):
+                os.remove(target_path)
+            raise
+        logger.info(f"Incremental save completed successfully. Output at: {self.output_path}")
+
+    def _patch(self, image_path: str) -> None:
+        """Rewrites the changed files and the swapped boot images inside the image at image_path."""
+        path_key = self.core._walk_key
+        patches = self.boot_changes.patches
+        total = sum(node['size'] for node in self.changed_nodes) + sum(patch.size for patch in patches)
+        done = 0
+
+        with open(image_path, 'r+b') as fp:
+            iso = pycdlib.PyCdlib()
+            iso.open_fp(fp)
+            try:
+                paths_by_inode = self._index_paths(iso)
+                for node in self.changed_nodes:
+                    stream, length = self.core.open_file_stream(node)
+                    self._replace_file(iso, paths_by_inode, {path_key: node['replaces_iso_path']}, stream, length)
+                    done += length
+                    profiler.count('files')
+                    profiler.count('bytes_written', length)
+                    self._report_progress(done, total)
+                for patch in patches:
+                    self._replace_file(iso, paths_by_inode, {'iso_path': patch.iso_path},
+                                       open(patch.source_path, 'rb'), patch.size)
+                    done += patch.size
+                    profiler.count('bytes_written', patch.size)
+                    self._report_progress(done, total)
+            finally:
+                iso.close()
+
+    def _replace_file(self, iso: pycdlib.PyCdlib, paths_by_inode: Dict[int, Dict[str, str]],
+                      path: Dict[str, str], stream: BinaryIO, length: int) -> None:
+        """Writes stream over the data of the file at path, in every namespace; closes stream."""
+        try:
+            record = iso.get_record(**path)
+            paths = paths_by_inode.get(id(record.inode))
+            if not paths or 'iso_path' not in paths:
+                raise ValueError(f"Could not locate the ISO9660 record for {next(iter(path.values()))}")
+            iso.modify_file_in_place(stream, length, paths['iso_path'],
+                                     joliet_path=paths.get('joliet_path'),
+                                     udf_path=paths.get('udf_path'))
+        finally:
+            stream.close()
+
+    def _patch_boot(self, image_path: str) -> None:
+        """Updates the catalog entries of the swapped boot images and writes the isohybrid MBR."""
+        with open(image_path, 'r+b') as fp:
+            for patch in self.boot_changes.patches:
+                eltorito.patch_boot_entry(fp, patch.entry, sector_count=patch.sector_count)
+            if self.boot_changes.make_hybrid:
+                eltorito.write_hybrid_mbr(fp, layout_planner.HYBRID_ALIGNMENT, self.boot_changes.efi_partition)
+
+    def _index_paths(self, iso: pycdlib.PyCdlib) -> Dict[int, Dict[str, str]]:
+        """Maps each file inode to its path in every namespace of the image."""
+        namespaces = ['iso_path']
+        if iso.has_joliet():
+            namespaces.append('joliet_path')
+        if iso.has_udf():
+            namespaces.append('udf_path')
+
+        paths_by_inode: Dict[int, Dict[str, str]] = {}
+        for key in namespaces:
+            for root, _, files in iso.walk(**{key: '/'}):
+                for name in files:
+                    path = posixpath.join(root, name)
+                    record = iso.get_record(**{key: path})
+                    if record.inode is not None:
+                        paths_by_inode.setdefault(id(record.inode), {})[key] = path
+        return paths_by_inode
+
+    def _report_progress(self, done: int, total: int) -> None:
+        """Reports progress using the same callback convention as pycdlib's write()."""
+        if not self.progress_callback or total <= 0:
+            return
+        try:
+            self.progress_callback(done, total, None)
+        except InterruptedError:
+            if not self.in_place:
+                raise
+            if not self._cancel_ignored:
+                self._cancel_ignored = True
+                logger.warning(f"Cannot cancel patching {self.output_path} in place; finishing the save.")
+
+
+class ExtractionEngine:
+    """
+    Extracts a node and everything below it to the local filesystem.
+
+    Files are copied in bounded chunks by a small thread pool, in the order
+    their data is laid out in the source image, so the image is read front to
+    back. Reads from the image are serialized because pycdlib shares one file
+    handle between streams; writes to the output files overlap with each
+    other and with the next read.
+    """
+    def __init__(self, core: ISOCore, node: TreeNode, destination: str,
+                 progress_callback: Optional[Callable[[int, int], None]] = None,
+                 workers: int = EXTRACT_WORKERS, chunk_size: int = EXTRACT_CHUNK_SIZE) -> None:
+        """
+        Args:
+            core (ISOCore): The core holding the loaded image.
+            node (dict): The file or directory node to extract.
+            destination (str): The path the node itself is extracted to.
+            progress_callback: Called from worker threads as (bytes_done, bytes_total).
+            workers (int): Number of files copied at the same time.
+            chunk_size (int): Maximum bytes read and written per step.
+        """
+        self.core: ISOCore = core
+        self.node: TreeNode = node
+        self.destination: str = destination
+        self.progress_callback = progress_callback
+        self.workers: int = max(1, workers)
+        self.chunk_size: int = chunk_size
+        self.bytes_total: int = 0
+        self.bytes_done: int = 0
+        self._cancelled = threading.Event()
+        self._source_lock = threading.Lock()
+        self._progress_lock = threading.Lock()
+
+    def cancel(self) -> None:
+        """Requests cancellation; run() raises InterruptedError once the copies stop."""
+        self._cancelled.set()
+
+    def plan(self) -> List[Tuple[TreeNode, str]]:
+        """
+        Creates the directory structure and lists the files to copy.
+
+        Returns:
+            list: (node, output path) pairs, sorted by the position of the data in the image.
+
+        Raises:
+            IOError: If a directory cannot be created or a name is not a safe path component.
+        """
+        self.core.load_all_children(self.node)
+        if not self.node.get('is_directory'):
+            os.makedirs(os.path.dirname(os.path.abspath(self.destination)), exist_ok=True)
+        files = []
+        stack = [(self.node, self.destination)]
+        while stack:
+            node, path = stack.pop()
+            if not node.get('is_directory'):
+                files.append((node, path))
+                continue
+            try:
+                os.makedirs(path, exist_ok=True)
+            except OSError as e:
+                raise IOError(f"A file system error occurred while creating '{path}': {e}") from e
+            for child in node.get('children', []):
+                name = child.get('name', '')
+                if not name or name in ('.', '..') or '/' in name or os.sep in name:
+                    raise IOError(f"Refusing to extract entry with unsafe name {name!r}")
+                stack.append((child, os.path.join(path, name)))
+
+        files.sort(key=lambda item: self.core.get_extent_location(item[0]))
+        return files
+
+    @profiler.timed('extract')
+    def run(self) -> None:
+        """
+        Extracts everything.
+
+        Raises:
+            InterruptedError: If cancel() was called.
+            IOError: If a file could not be read or written.
+        """
+        files = self.plan()
+        self.bytes_total = sum(node.get('size', 0) for node, _ in files)
+        self.bytes_done = 0
+        logger.info(f"Extracting {len(files)} file(s), {self.bytes_total} bytes, to {self.destination}")
+        self._report_progress()
+
+        # Streams are opened here, on one thread, since opening may touch the pycdlib handle.
+        jobs = [(node, path) + self.core.open_file_stream(node) for node, path in files]
+        with ThreadPoolExecutor(max_workers=min(self.workers, len(jobs) or 1)) as pool:
+            futures = [pool.submit(self._copy_file, *job) for job in jobs]
+            done, _ = wait(futures, return_when=FIRST_EXCEPTION)
+            failed = [f for f in done if f.exception() is not None]
+            if failed:
+                self._cancelled.set()
+                wait(futures)
+                raise failed[0].exception()
+
+        if self._cancelled.is_set():
+            raise InterruptedError("Extraction cancelled by user")
+        logger.info(f"Extraction to {self.destination} complete.")
+
+    def _copy_file(self, node: TreeNode, path: str, stream: BinaryIO, length: int) -> None:
+        """Copies one file's data to its output path in chunks."""
+        if self._cancelled.is_set():
+            return
+        # Everything except new files and CUE tracks is read through the shared image handle.
+        shared_source = not node.get('is_new') and not node.get('is_cue_track')
+        lock = self._source_lock if shared_source else None
+
+        try:
+            with open(path, 'wb') as out:
+                remaining = length
+                while remaining > 0 and not self._cancelled.is_set():
+                    size = min(self.chunk_size, remaining)
+                    if lock:
+                        with lock:
+                            chunk = stream.read(size)
+                    else:
+                        chunk = stream.read(size)
+                    if not chunk:
+                        raise IOError(f"Unexpected end of data after {length - remaining} of {length} bytes")
+                    out.write(chunk)
+                    remaining -= len(chunk)
+                    profiler.count('bytes_written', len(chunk))
+                    self._advance(len(chunk))
+            if self._cancelled.is_set():
+                os.remove(path)
+            else:
+                profiler.count('files')
+        except Exception as e:
+            if os.path.exists(path):
+                os.remove(path)
+            raise IOError(f"A file system error occurred while extracting '{node.get('name', 'Unnamed')}': {e}") from e
+        finally:
+            if lock:
+                with lock:
+                    stream.close()
+            else:
+                stream.close()
+
+    def _advance(self, count: int) -> None:
+        with self._progress_lock:
+            self.bytes_done += count
+            self._report_progress()
+
+    def _report_progress(self) -> None:
+        if self.progress_callback:
+            self.progress_callback(self.bytes_done, self.bytes_total)
+
+
+class ImportEngine:
+    """
+    Imports files and directories from the local filesystem into the tree.
+
+    scan() lists the sources with os.scandir on a thread pool and builds the
+    new nodes apart from the tree, without reading any file: imported files
+    keep only their path and are streamed from disk when the image is saved.
+    attach() then adds everything with ISOCore.merge_nodes(), one call per
+    target directory, so the tree and its listeners see one insertion per
+    imported item instead of one per file.
+
+    scan() may run on a worker thread; attach() must run where the tree is
+    edited, e.g. the GUI thread.
+    """
+    def __init__(self, core: ISOCore, sources: List[str], target_node: TreeNode,
+                 progress_callback: Optional[Callable[[int, int], None]] = None,
+                 workers: int = IMPORT_WORKERS) -> None:
+        """
+        Args:
+            core (ISOCore): The core to import into.
+            sources (list): Local files and directories; directories are imported as folders.
+            target_node (dict): The directory node to import into.
+            progress_callback: Called from the scanning thread as (files found, directories listed).
+            workers (int): Number of directories listed at the same time.
+        """
+        self.core: ISOCore = core
+        self.sources: List[str] = sources
+        self.target_node: TreeNode = target_node
+        self.progress_callback = progress_callback
+        self.workers: int = max(1, workers)
+        self.file_count: int = 0
+        self.directory_count: int = 0
+        # (path, error message) of entries that could not be read; they are skipped
+        self.errors: List[Tuple[str, str]] = []
+        self._nodes: List[TreeNode] = []
+        self._cancelled = threading.Event()
+
+    def cancel(self) -> None:
+        """Requests cancellation; scan() raises InterruptedError and nothing is attached."""
+        self._cancelled.set()
+
+    @profiler.timed('import')
+    def run(self) -> int:
+        """Scans and attaches on the calling thread; returns the number of files imported."""
+        self.scan()
+        return self.attach()
+
+    def scan(self) -> None:
+        """
+        Lists the sources and builds their nodes.
+
+        Raises:
+            InterruptedError: If cancel() was called.
+        """
+        self._nodes = []
+        directories = []
+        for source in self.sources:
+            source = os.path.abspath(source)
+            if os.path.islink(source):
+                logger.warning(f"Skipping symbolic link: {source}")
+            elif os.path.isdir(source):
+                node = self._new_folder(os.path.basename(source))
+                self._nodes.append(node)
+                directories.append((source, node))
+            elif os.path.isfile(source):
+                try:
+                    self._nodes.append(self._new_file(os.path.basename(source), source, os.stat(source)))
+                except OSError as e:
+                    self.errors.append((source, str(e)))
+
+        with ThreadPoolExecutor(max_workers=self.workers) as pool:
+            pending = {pool.submit(self._list_directory, path): node for path, node in directories}
+            while pending:
+                done, _ = wait(pending, return_when=FIRST_COMPLETED)
+                if self._cancelled.is_set():
+                    for future in pending:
+                        future.cancel()
+                    raise InterruptedError("Import cancelled by user")
+                for future in done:
+                    node = pending.pop(future)
+                    for entry_path, subfolder in self._attach_listing(node, future.result()):
+                        pending[pool.submit(self._list_directory, entry_path)] = subfolder
+                self._report_progress()
+
+        logger.info(f"Scanned {self.file_count} file(s) in {self.directory_count} folder(s) for import")
+
+    def _list_directory(self, path: str) -> List[Tuple[str, str, Optional[os.stat_result]]]:
+        """
+        Lists one directory on a pool thread.
+
+        Returns:
+            list: (name, path, stat) per entry; stat is None for subdirectories.
+        """
+        entries = []
+        try:
+            with os.scandir(path) as iterator:
+                for entry in iterator:
+                    if self._cancelled.is_set():
+                        break
+                    try:
+                        if entry.is_symlink():
+                            logger.warning(f"Skipping symbolic link: {entry.path}")
+                        elif entry.is_dir(follow_symlinks=False):
+                            entries.append((entry.name, entry.path, None))
+                        elif entry.is_file(follow_symlinks=False):
+                            entries.append((entry.name, entry.path, entry.stat(follow_symlinks=False)))
+                    except OSError as e:
+                        entries.append((entry.name, entry.path, e))
+        except OSError as e:
+            entries.append(('', path, e))
+        return entries
+
+    def _attach_listing(self, folder: TreeNode, entries: List[Tuple[str, str, Any]]) -> List[Tuple[str, TreeNode]]:
+        """Adds the nodes for one listing to its folder; returns the subdirectories still to list."""
+        self.directory_count += 1
+        subdirectories = []
+        children = folder['children']
+        for name, path, stat in entries:
+            if isinstance(stat, OSError):
+                logger.warning(f"Skipping unreadable entry {path}: {stat}")
+                self.errors.append((path, str(stat)))
+            elif stat is None:
+                subfolder = self._new_folder(name, folder)
+                children.append(subfolder)
+                subdirectories.append((path, subfolder))
+            else:
+                children.append(self._new_file(name, path, stat, folder))
+        return subdirectories
+
+    def _new_folder(self, name: str, parent: Optional[TreeNode] = None) -> TreeNode:
+        return {
+            'name': name, 'is_directory': True, 'is_hidden': False, 'size': 0,
+            'date': datetime.now().strftime("%Y-%m-%d %H:%M:%S"), 'extent_location': 0,
+            'children': [], 'parent': parent, 'is_new': True
+        }
+
+    def _new_file(self, name: str, path: str, stat: os.stat_result,
+                  parent: Optional[TreeNode] = None) -> TreeNode:
+        self.file_count += 1
+        return {
+            'name': name, 'is_directory': False, 'is_hidden': False,
+            'size': stat.st_size,
+            'date': datetime.fromtimestamp(stat.st_mtime).strftime("%Y-%m-%d %H:%M:%S"),
+            'extent_location': 0, 'children': [], 'parent': parent,
+            'file_path': path, 'source_mtime_ns': stat.st_mtime_ns,
+            'file_data': None, 'is_new': True
+        }
+
+    def attach(self) -> int:
+        """
+        Adds the scanned nodes to the target directory.
+
+        Returns:
+            int: The number of files imported.
+        """
+        target = self.target_node
+        if not target['is_directory']:
+            target = target['parent']
+        if self._nodes:
+            self.core.merge_nodes(target, self._nodes)
+        self._nodes = []
+        logger.info(f"Imported {self.file_count} file(s) into '{self.core.get_node_path(target)}'")
+        return self.file_count
+
+    def _report_progress(self) -> None:
+        if self.progress_callback:
+            self.progress_callback(self.file_count, self.directory_count)
@@ -0,0 +1,185 @@
+"""
+ISO 9660 and Joliet names.
+
+The names of one directory are mapped together: all of them are translated
+to d-characters (A-Z, 0-9, _) in a single str/bytes translate pass, cut to
+the limits of the interchange level, and names that end up equal are given
+numeric suffixes. Names that need no change keep them; the others are
+numbered in sorted order, so the result does not depend on the order the
+files were added in.
+
+  level 1      8.3 files, 8-character directories
+  level 2, 3   30 characters (name and extension) for files, 31 for directories
+
+Joliet names keep their case and most characters; they are cut to
+JOLIET_MAX_FILENAME_LENGTH UCS-2 characters and numbered with '~N' when
+that makes them equal.
+
+directory_names() maps the names of a directory on every call. Callers that
+walk the same tree more than once, like ISOBuilder, pass it a NamesCache to
+keep the results for the time they do not edit the tree; nothing is stored
+on the nodes, so a large tree does not hold every name several times over.
+"""
+
+from typing import Any, Dict, Iterable, List, Optional, Sequence, Tuple
+
+from constants import (ISO9660_MAX_FILENAME_LENGTH, JOLIET_MAX_FILENAME_LENGTH,
+                       ISO9660_L1_MAX_NAME_LENGTH, ISO9660_L1_MAX_EXT_LENGTH)
+
+D_CHARACTERS = 'ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_'
+
+# Applied to ASCII-encoded, upper-cased names: d-characters, '.' and the NUL separator stay.
+_D_TABLE = bytes(c if chr(c) in D_CHARACTERS or c in (0, ord('.')) else ord('_') for c in range(256))
+# Characters Joliet does not allow (NUL is the separator in joliet_names())
+_JOLIET_TABLE = {c: '_' for c in [*range(1, 0x20), *map(ord, '*/:;?\\')]}
+
+# Names mapped by directory_names(), by id() of the directory node and level; the
+# node is kept with them, so its id cannot be reused while the cache is alive
+NamesCache = Dict[Tuple[int, int], Tuple[Any, List[str], List[str]]]
+
+
+def _translate(names: Sequence[str]) -> List[str]:
+    """Upper-cases names and replaces everything but d-characters and dots, in one pass."""
+    if not names:
+        return []
+    joined = '\0'.join(names).upper().encode('ascii', 'replace')
+    return joined.translate(_D_TABLE).decode('ascii').split('\0')
+
+
+def _split(translated: str, is_directory: bool, level: int) -> Tuple[str, str, int]:
+    """Returns (base, extension, room for the base) of a translated name."""
+    dot = translated.rfind('.')
+    # Leading dots do not start an extension, as in os.path.splitext()
+    if is_directory or dot <= 0 or not translated[:dot].strip('.'):
+        base, ext = translated, ''
+    else:
+        base, ext = translated[:dot], translated[dot + 1:]
+    base = base.replace('.', '_') or '_'
+    if level == 1:
+        return base, ext[:ISO9660_L1_MAX_EXT_LENGTH], ISO9660_L1_MAX_NAME_LENGTH
+    if is_directory:
+        return base, '', ISO9660_MAX_FILENAME_LENGTH
+    ext = ext[:ISO9660_MAX_FILENAME_LENGTH - 2]
+    return base, ext, ISO9660_MAX_FILENAME_LENGTH - 1 - len(ext)
+
+
+def _join(base: str, ext: str) -> str:
+    return f"{base}.{ext}" if ext else base
+
+
+def _number(wanted: Sequence[str], originals: Sequence[str], make, key=lambda name: name) -> List[str]:
+    """
+    Gives every name its wanted form if it is free, else make(index, n) for the first free n.
+
+    Names whose wanted form is their original one win; the rest go in sorted order.
+    """
+    count = len(wanted)
+    result = [''] * count
+    taken = set()
+    order = sorted(range(count), key=lambda i: (wanted[i] != originals[i], originals[i]))
+    collided = []
+    for i in order:
+        k = key(wanted[i])
+        if k in taken:
+            collided.append(i)
+        else:
+            taken.add(k)
+            result[i] = wanted[i]
+    for i in collided:
+        n = 1
+        while key(candidate := make(i, n)) in taken:
+            n += 1
+        taken.add(key(candidate))
+        result[i] = candidate
+    return result
+
+
+def iso9660_name(name: str, is_directory: bool = False, level: int = 1) -> str:
+    """Maps one name on its own, without looking for collisions."""
+    base, ext, room = _split(_translate([name])[0], is_directory, level)
+    return _join(base[:room], ext)
+
+
+def iso9660_names(names: Sequence[str], directory_flags: Sequence[bool], level: int = 1) -> List[str]:
+    """Maps the names of one directory to unique ISO 9660 names of the given level."""
+    parts = [_split(t, is_directory, level) for t, is_directory in zip(_translate(names), directory_flags)]
+    wanted = [_join(base[:room], ext) for base, ext, room in parts]
+
+    def make(i: int, n: int) -> str:
+        base, ext, room = parts[i]
+        suffix = str(n)
+        return _join(base[:max(1, room - len(suffix))] + suffix, ext)
+
+    return _number(wanted, list(names), make)
+
+
+def _ucs2_length(name: str) -> int:
+    return len(name.encode('utf-16-be')) // 2
+
+
+def _cut_joliet(stem: str, tail: str, limit: int) -> str:
+    """Shortens the stem until stem + tail fits in limit UCS-2 characters."""
+    stem = stem[:max(1, limit - len(tail))]
+    while len(stem) > 1 and _ucs2_length(stem + tail) > limit:
+        stem = stem[:-1]
+    return stem + tail
+
+
+def joliet_names(names: Sequence[str]) -> List[str]:
+    """Maps the names of one directory to unique Joliet names."""
+    if not names:
+        return []
+    cleaned = '\0'.join(names).translate(_JOLIET_TABLE).split('\0')
+    parts = []
+    for name in cleaned:
+        dot = name.rfind('.')
+        # The extension is kept when a long name is shortened, unless it is most of the name.
+        if dot > 0 and len(name) - dot <= JOLIET_MAX_FILENAME_LENGTH // 2:
+            parts.append((name[:dot], name[dot:]))
+        else:
+            parts.append((name, ''))
+    wanted = [name if _ucs2_length(name) <= JOLIET_MAX_FILENAME_LENGTH
+              else _cut_joliet(stem, ext, JOLIET_MAX_FILENAME_LENGTH)
+              for name, (stem, ext) in zip(cleaned, parts)]
+
+    def make(i: int, n: int) -> str:
+        stem, ext = parts[i]
+        return _cut_joliet(stem, f"~{n}{ext}", JOLIET_MAX_FILENAME_LENGTH)
+
+    # Windows compares Joliet names without regard to case.
+    return _number(wanted, list(names), make, key=str.casefold)
+
+
+def directory_names(directory, level: int = 1,
+                    cache: Optional[NamesCache] = None) -> Tuple[List[str], List[str]]:
+    """
+    Returns the ISO 9660 and Joliet names of a directory node's children, in child order.
+
+    Args:
+        cache (dict): Where results are kept for later calls with the same cache;
+            only valid while the tree is not edited. See the module docstring.
+    """
+    key = (id(directory), level)
+    if cache is not None and key in cache:
+        return cache[key][1], cache[key][2]
+    children = directory['children']
+    names = [child['name'] for child in children]
+    iso9660 = iso9660_names(names, [bool(child['is_directory']) for child in children], level)
+    joliet = joliet_names(names)
+    if cache is not None:
+        cache[key] = (directory, iso9660, joliet)
+    return iso9660, joliet
+
+
+def non_compliant_names(names: Iterable[str]) -> List[str]:
+    """
+    Returns the names whose characters cannot be kept in an ISO 9660 name.
+
+    These are names with characters other than letters, digits and '_', with
+    more than one dot, or starting with a dot. Names that are only too long
+    are not listed: they are shortened, and Joliet, Rock Ridge and UDF keep
+    them whole.
+    """
+    names = list(names)
+    return [name for name, translated in zip(names, _translate(names))
+            if translated != name.upper() or translated.count('.') > 1 or translated.startswith('.')]
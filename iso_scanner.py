@@ -0,0 +1,244 @@
+"""
+Native fast path for reading the directory tree of an image.
+
+The optional _isoscan extension (native/isoscan.cpp) parses the volume
+descriptors and directory records of an image straight from a memory map and
+returns the whole tree of one namespace as flat columns. scan_image() wraps it
+for ISOCore; it returns None when the extension is not built or the image uses
+a layout the scanner does not handle, in which case pycdlib is used as before.
+"""
+
+import logging
+import mmap
+import posixpath
+from array import array
+from typing import Any, Callable, Dict, List, Optional
+
+import eltorito
+from node_store import format_packed_date, pack_date
+
+try:
+    import _isoscan
+except ImportError:
+    _isoscan = None
+
+logger = logging.getLogger(__name__)
+
+AVAILABLE = _isoscan is not None
+
+FLAG_DIRECTORY = 0x01
+FLAG_HIDDEN = 0x02
+
+# array typecodes of the numeric columns returned by _isoscan.scan()
+_COLUMN_TYPES = {
+    'parent': 'i', 'first_child': 'i', 'child_count': 'i',
+    'size': 'Q', 'extent': 'I', 'date': 'q',
+}
+
+
+class ImageScan:
+    """
+    The directory tree of one image namespace, as produced by the native scanner.
+
+    Entries are numbered in breadth-first order with the root at index 0, so the
+    children of a directory are the contiguous range returned by children().
+    """
+
+    def __init__(self, walk_key: str, info: Dict[str, Any], columns: Dict[str, Any],
+                 boot_entries: List[Dict[str, Any]]) -> None:
+        self.walk_key = walk_key
+        self.has_joliet: bool = info['joliet']
+        self.has_rock_ridge: bool = info['rock_ridge']
+        self.has_udf: bool = info['udf']
+        self.volume_id: str = info['volume_id_text']
+        self.system_id: str = info['system_id_text']
+        self.boot_entries = boot_entries
+
+        self.names: List[str] = columns['names']
+        self.flags: bytes = columns['flags']
+        for key, typecode in _COLUMN_TYPES.items():
+            column = array(typecode)
+            column.frombytes(columns[key])
+            setattr(self, key, column)
+
+    def __len__(self) -> int:
+        return len(self.names)
+
+    def children(self, index: int) -> range:
+        """Returns the indices of the entries inside directory `index`."""
+        first = self.first_child[index]
+        return range(first, first + self.child_count[index])
+
+    def is_directory(self, index: int) -> bool:
+        return bool(self.flags[index] & FLAG_DIRECTORY)
+
+    def is_hidden(self, index: int) -> bool:
+        return bool(self.flags[index] & FLAG_HIDDEN)
+
+    def date_string(self, index: int) -> str:
+        """Formats an entry's modification date like ISOCore._format_pycdlib_date()."""
+        return format_packed_date(self.date[index])
+
+    def info(self) -> Dict[str, Any]:
+        """Returns the volume information in the form the constructor takes."""
+        return {
+            'joliet': self.has_joliet, 'rock_ridge': self.has_rock_ridge, 'udf': self.has_udf,
+            'volume_id_text': self.volume_id, 'system_id_text': self.system_id,
+        }
+
+    def columns(self) -> Dict[str, Any]:
+        """Returns the tree in the form _isoscan.scan() produces, i.e. names plus packed columns."""
+        columns: Dict[str, Any] = {'names': self.names, 'flags': bytes(self.flags)}
+        for key in _COLUMN_TYPES:
+            columns[key] = getattr(self, key).tobytes()
+        return columns
+
+    @classmethod
+    def from_tree(cls, walk_key: str, info: Dict[str, Any], root: Dict[str, Any],
+                  extent_of: Callable[[Dict[str, Any]], int],
+                  boot_entries: List[Dict[str, Any]]) -> 'ImageScan':
+        """
+        Builds a scan from a fully loaded directory tree, e.g. one read with pycdlib.
+
+        Args:
+            walk_key: The pycdlib namespace the tree's names belong to.
+            info: Volume information, as returned by info().
+            root: The root node of the tree.
+            extent_of: Returns the extent of a node, e.g. ISOCore.get_extent_location.
+            boot_entries: The image's El Torito entries.
+        """
+        names, flags = [root['name']], bytearray()
+        parent, first_child, child_count = array('i', [0]), array('i'), array('i')
+        size, extent, date = array('Q', [0]), array('I'), array('q')
+        # Breadth-first, so the children of every directory are contiguous like in _isoscan
+        queue, position = [root], 0
+        while position < len(queue):
+            node = queue[position]
+            flags.append((FLAG_DIRECTORY if node['is_directory'] else 0) |
+                         (FLAG_HIDDEN if node.get('is_hidden') else 0))
+            extent.append(extent_of(node))
+            packed = pack_date(node.get('date') or '')
+            date.append(max(packed, 0))
+            first_child.append(len(queue))
+            children = node['children'] if node['is_directory'] else []
+            child_count.append(len(children))
+            for child in children:
+                names.append(child['name'])
+                parent.append(position)
+                size.append(child['size'])
+                queue.append(child)
+            position += 1
+
+        columns = {'names': names, 'flags': bytes(flags)}
+        for key, column in (('parent', parent), ('first_child', first_child), ('child_count', child_count),
+                            ('size', size), ('extent', extent), ('date', date)):
+            columns[key] = column.tobytes()
+        return cls(walk_key, info, columns, boot_entries)
+
+
+def scan_image(file_path: str) -> Optional[ImageScan]:
+    """
+    Scans an image with the native extension.
+
+    The namespace is chosen with the same priority as ISOCore (UDF, Joliet,
+    Rock Ridge, plain ISO 9660), so node paths work with pycdlib unchanged.
+
+    Returns:
+        ImageScan, or None if the native scanner is unavailable or declines the image.
+
+    Raises:
+        FileNotFoundError, PermissionError: If the image cannot be opened.
+    """
+    if _isoscan is None:
+        return None
+
+    with open(file_path, 'rb') as f:
+        try:
+            image = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (ValueError, OSError) as e:
+            logger.debug(f"Cannot map {file_path}, skipping native scan: {e}")
+            return None
+
+    with image:
+        try:
+            info = _isoscan.probe(image)
+            if info['udf']:
+                walk_key = 'udf_path'
+            elif info['joliet']:
+                walk_key = 'joliet_path'
+            elif info['rock_ridge']:
+                walk_key = 'rr_path'
+            else:
+                walk_key = 'iso_path'
+
+            if info['joliet']:
+                system_id, volume_id = _isoscan.joliet_ids(image)
+                info['system_id_text'] = system_id.decode('utf-16-be', 'ignore').strip(' \x00')
+                info['volume_id_text'] = volume_id.decode('utf-16-be', 'ignore').strip(' \x00')
+            else:
+                info['system_id_text'] = info['system_id'].decode('ascii', 'ignore').strip(' \x00')
+                info['volume_id_text'] = info['volume_id'].decode('ascii', 'ignore').strip(' \x00')
+
+            columns = _isoscan.scan(image, walk_key)
+            boot_entries = _read_boot_entries(image, info, columns if walk_key == 'iso_path' else None)
+        except _isoscan.UnsupportedImage as e:
+            logger.info(f"Native scanner does not support {file_path}: {e}")
+            return None
+        except ValueError as e:
+            # Let pycdlib report the problem with its more detailed messages.
+            logger.debug(f"Native scan of {file_path} failed: {e}")
+            return None
+
+    logger.debug(f"Native scan of {file_path} found {len(columns['names'])} entries in {walk_key}")
+    return ImageScan(walk_key, info, columns, boot_entries)
+
+
+def _read_boot_entries(image: mmap.mmap, info: Dict[str, Any],
+                       iso_columns: Optional[Dict[str, Any]]) -> List[Dict[str, Any]]:
+    """
+    Reads the initial El Torito entry, in the format of ISOCore.extracted_boot_info.
+
+    Args:
+        image: The mapped image.
+        info: The result of _isoscan.probe().
+        iso_columns: A plain ISO 9660 scan of the image, if one was already made.
+    """
+    catalog_sector = info.get('boot_catalog')
+    if catalog_sector is None:
+        return []
+
+    try:
+        entry = eltorito.read_boot_entries(image, catalog_sector)[0]
+    except ValueError as e:
+        logger.warning(f"Cannot read the El Torito boot catalog: {e}")
+        return []
+
+    if iso_columns is None:
+        iso_columns = _isoscan.scan(image, 'iso_path')
+    boot_image_path = _path_of_extent(iso_columns, entry.load_rba) or "Unknown"
+
+    return [{
+        'platform_id': entry.system_type,
+        'emulation_type': entry.emulation_type,
+        'boot_image_path': boot_image_path,
+        'load_segment': entry.load_segment,
+    }]
+
+
+def _path_of_extent(columns: Dict[str, Any], extent: int) -> Optional[str]:
+    """Returns the path of the first file that starts at the given extent."""
+    extents = array('I')
+    extents.frombytes(columns['extent'])
+    parents = array('i')
+    parents.frombytes(columns['parent'])
+    flags = columns['flags']
+    names = columns['names']
+
+    for index in range(1, len(names)):
+        if extents[index] == extent and not flags[index] & FLAG_DIRECTORY:
+            parts = []
+            while index:
+                parts.append(names[index])
+                index = parents[index]
+            return posixpath.join('/', *reversed(parts))
+    return None
@@ -0,0 +1,251 @@
+"""
+Size of an image before it is written.
+
+plan_layout() counts the sectors of the image ISOBuilder would write for a
+tree, placed the way pycdlib lays them out:
+
+  system area, volume descriptors  16 sectors, then one per descriptor (PVD,
+                                   El Torito boot record, Joliet SVD,
+                                   terminator, version descriptor, and the
+                                   three UDF recognition descriptors)
+  path tables                      an L and an M table per volume descriptor,
+                                   each two sectors per started 4 KiB
+  directories                      one extent per directory; records never
+                                   cross a sector boundary
+  Rock Ridge                       RR, PX, TF and NM entries on every record;
+                                   NM entries that do not fit in a record and
+                                   the root's ER go to continuation sectors
+  UDF 2.60                         everything up to the partition at sector
+                                   257, the file set descriptor and its
+                                   terminator, a file entry per node, the file
+                                   identifiers of each directory, an end anchor
+  El Torito                        the catalog, listed in the root, and the
+                                   boot images under /BOOT
+  file data                        each file from a sector boundary
+  isohybrid                        padding to a whole MiB (only with boot images,
+                                   like ISOBuilder)
+
+The plan is that of a build without deduplication, so a deduplicated image
+can come out smaller. ISOBuilder checks the size pycdlib lays out before it
+writes anything (see ISOBuilder.max_size).
+"""
+
+from typing import Iterable, List, NamedTuple, Optional, Sequence, Tuple
+
+import iso_names
+from constants import ISO_BLOCK_SIZE, MEDIA_CAPACITIES
+
+SYSTEM_AREA_SECTORS = 16
+# First sector of the UDF partition; the anchor descriptor is at 256
+UDF_PARTITION_START = 257
+# isohybrid images are padded to whole cylinders of 64 heads and 32 sectors
+HYBRID_ALIGNMENT = 64 * 32 * 512
+
+# Rock Ridge 1.09 entry sizes as pycdlib writes them
+_RR_ENTRIES = 5 + 36 + 26  # RR, PX, TF (modification, access, attributes)
+_RR_SP = 7
+_RR_CE = 28
+_RR_NM_HEADER = 5
+# ER entry of RRIP_1991A with pycdlib's descriptor and source strings
+_RR_ER = 237
+_MAX_RECORD_LENGTH = 255
+
+
+class LayoutPlan(NamedTuple):
+    """Sectors of a planned image, by what they hold."""
+    system_area: int = 0
+    descriptors: int = 0
+    path_tables: int = 0
+    directories: int = 0
+    joliet_directories: int = 0
+    udf: int = 0
+    boot: int = 0
+    file_data: int = 0
+    padding: int = 0
+
+    @property
+    def total_sectors(self) -> int:
+        return sum(self)
+
+    @property
+    def total_size(self) -> int:
+        """Size of the image in bytes."""
+        return self.total_sectors * ISO_BLOCK_SIZE
+
+
+def fitting_media(size: int) -> List[str]:
+    """Returns the names of the MEDIA_CAPACITIES an image of size bytes fits on, smallest first."""
+    return [name for name, capacity in MEDIA_CAPACITIES.items() if size <= capacity]
+
+
+def _sectors(size: int) -> int:
+    return -(-size // ISO_BLOCK_SIZE)
+
+
+def _extent_sectors(record_lengths: Iterable[int]) -> int:
+    """Sectors a directory extent takes; a record that does not fit starts the next sector."""
+    sectors, offset = 1, 0
+    for length in record_lengths:
+        if offset + length > ISO_BLOCK_SIZE:
+            sectors += 1
+            offset = 0
+        offset += length
+    return sectors
+
+
+def _record_length(identifier_length: int) -> int:
+    # The identifier is followed by a padding byte when its length is even
+    return 33 + identifier_length + (identifier_length % 2 == 0)
+
+
+def _path_table_record(identifier_length: int) -> int:
+    return 8 + identifier_length + identifier_length % 2
+
+
+def _path_table_sectors(size: int) -> int:
+    # An L and an M table, each given two sectors per started 4 KiB
+    return 2 * 2 * -(-size // (2 * ISO_BLOCK_SIZE))
+
+
+def _ucs2_length(name: str) -> int:
+    return len(name.encode('utf-16-be')) // 2
+
+
+# A child as the walk sees it: (ISO 9660 name, Joliet name, name, is a directory, is in UDF)
+_Entry = Tuple[str, str, str, bool, bool]
+
+
+def _udf_identifier(name: str) -> int:
+    """Size of a UDF file identifier descriptor for name, padded to 4 bytes."""
+    if all(ord(c) < 256 for c in name):
+        length = 1 + len(name)
+    else:
+        length = 1 + 2 * _ucs2_length(name)
+    return (38 + length + 3) & ~3
+
+
+class _Walk:
+    """Adds up the sectors of one tree; see plan_layout()."""
+
+    def __init__(self, use_joliet: bool, use_rock_ridge: bool, use_udf: bool) -> None:
+        self.use_joliet = use_joliet
+        self.use_rock_ridge = use_rock_ridge
+        self.use_udf = use_udf
+        self.directories = 0
+        self.joliet_directories = 0
+        self.udf = 0
+        # Both path tables start with the root, whose identifier is one byte
+        self.path_table = _path_table_record(1)
+        self.joliet_path_table = _path_table_record(1)
+        self._continuation = 0
+
+    def _rock_ridge(self, record: int, name: str) -> int:
+        """Returns the length of a record with its Rock Ridge entries for name."""
+        nm = _RR_NM_HEADER + len(name.encode('utf-8'))
+        length = record + _RR_ENTRIES + nm
+        if length > _MAX_RECORD_LENGTH:
+            # The NM entry moves to the directory's continuation area
+            self._continuation += nm
+            length = record + _RR_ENTRIES + _RR_CE
+        return length + length % 2
+
+    def directory(self, entries: Sequence[_Entry], is_root: bool = False, in_udf: bool = True) -> None:
+        """Adds the extents of one directory with the given children."""
+        if self.use_rock_ridge:
+            dot = _record_length(1) + _RR_ENTRIES + (_RR_SP + _RR_CE if is_root else 0)
+            dot_dot = _record_length(1) + _RR_ENTRIES
+            records = [dot + dot % 2, dot_dot + dot_dot % 2]
+            self._continuation = _RR_ER if is_root else 0
+            for iso9660, _, name, is_directory, _ in entries:
+                records.append(self._rock_ridge(_record_length(len(iso9660) + (0 if is_directory else 2)), name))
+            self.directories += _extent_sectors(records) + _sectors(self._continuation)
+        else:
+            records = [_record_length(1), _record_length(1)]
+            records.extend(_record_length(len(iso9660) + (0 if is_directory else 2))
+                           for iso9660, _, _, is_directory, _ in entries)
+            self.directories += _extent_sectors(records)
+
+        if self.use_joliet:
+            records = [_record_length(1), _record_length(1)]
+            records.extend(_record_length(2 * _ucs2_length(joliet) + (0 if is_directory else 4))
+                           for _, joliet, _, is_directory, _ in entries)
+            self.joliet_directories += _extent_sectors(records)
+
+        if self.use_udf and in_udf:
+            # The directory's file entry and its identifiers, after the parent's;
+            # each file in UDF has a file entry of its own.
+            identifiers = 40 + sum(_udf_identifier(name) for _, _, name, _, udf in entries if udf)
+            self.udf += 1 + _sectors(identifiers)
+            self.udf += sum(1 for _, _, _, is_directory, udf in entries if udf and not is_directory)
+
+    def subdirectory(self, iso9660: str, joliet: str) -> None:
+        self.path_table += _path_table_record(len(iso9660))
+        self.joliet_path_table += _path_table_record(2 * _ucs2_length(joliet))
+
+
+def plan_layout(root, use_joliet: bool = True, use_rock_ridge: bool = True, use_udf: bool = True,
+                boot_images: Sequence[Tuple[str, int]] = (), make_hybrid: bool = False,
+                iso9660_level: int = 1, names_cache: Optional[iso_names.NamesCache] = None) -> LayoutPlan:
+    """
+    Plans the image ISOBuilder would write for a tree whose directories are all loaded.
+
+    Args:
+        root (dict): The root directory node.
+        boot_images (list): (file name, size) of the El Torito boot images,
+            which ISOBuilder puts in /BOOT, outside UDF.
+        iso9660_level (int): The interchange level ISO 9660 names are mapped for.
+        names_cache (dict): Passed on to iso_names.directory_names().
+
+    Returns:
+        LayoutPlan: The sectors of the image.
+    """
+    walk = _Walk(use_joliet, use_rock_ridge, use_udf)
+    file_data = 0
+    boot_entries = [(iso_names.iso9660_name(name, level=iso9660_level), name, name, False, False)
+                    for name, _ in boot_images]
+    boot_directory = None
+
+    stack = [root]
+    while stack:
+        directory = stack.pop()
+        children = directory['children']
+        iso9660, joliet = iso_names.directory_names(directory, iso9660_level, names_cache)
+        entries = [(iso9660_name, joliet_name, child['name'], bool(child['is_directory']), True)
+                   for child, iso9660_name, joliet_name in zip(children, iso9660, joliet)]
+        for child, (iso9660_name, joliet_name, _, is_directory, _) in zip(children, entries):
+            if is_directory:
+                walk.subdirectory(iso9660_name, joliet_name)
+                stack.append(child)
+            elif child.get('size'):
+                file_data += _sectors(child['size'])
+        if directory is root and boot_entries:
+            # pycdlib lists the boot catalog in the root
+            entries.append(('BOOT.CAT', 'boot.cat', 'boot.cat', False, True))
+            boot_directory = next((child for child, entry in zip(children, entries)
+                                   if entry[3] and entry[0] == 'BOOT'), None)
+            if boot_directory is None:
+                entries.append(('BOOT', 'boot', 'BOOT', True, False))
+                walk.subdirectory('BOOT', 'boot')
+        if directory is boot_directory:
+            entries.extend(boot_entries)
+        walk.directory(entries, is_root=directory is root)
+    if boot_entries and boot_directory is None:
+        walk.directory(boot_entries, in_udf=False)
+
+    descriptors = 1 + bool(boot_images) + use_joliet + 1 + 1 + (3 if use_udf else 0)
+    path_tables = _path_table_sectors(walk.path_table)
+    if use_joliet:
+        path_tables += _path_table_sectors(walk.joliet_path_table)
+    udf = 0
+    if use_udf:
+        # Descriptor sequences and the anchor fill the space up to the partition,
+        # which starts with the file set descriptor and its terminator; a second
+        # anchor ends the image.
+        udf = UDF_PARTITION_START - SYSTEM_AREA_SECTORS - descriptors + 2 + walk.udf + 1
+    boot = 1 + sum(_sectors(size) for _, size in boot_images) if boot_images else 0
+
+    plan = LayoutPlan(SYSTEM_AREA_SECTORS, descriptors, path_tables, walk.directories,
+                      walk.joliet_directories, udf, boot, file_data)
+    if make_hybrid and boot_images:
+        plan = plan._replace(padding=-plan.total_sectors % (HYBRID_ALIGNMENT // ISO_BLOCK_SIZE))
+    return plan
@@ -0,0 +1,821 @@
+/*
+ * _isoscan - fast, read-only directory scanner for ISO 9660 images.
+ *
+ * Parses the volume descriptors and walks the directory extents of one
+ * namespace (plain ISO 9660, Rock Ridge, Joliet or UDF) in a single
+ * breadth-first pass over a buffer (normally an mmap of the image). The tree
+ * is returned as flat, parallel columns so that Python only has to create
+ * objects for the entries it actually looks at. The GIL is released while the
+ * image is parsed.
+ *
+ * Entries are stored in breadth-first order with the root at index 0, so the
+ * children of every directory occupy one contiguous range of indices.
+ *
+ * The scanner only supports layouts it can describe exactly; anything else
+ * (relocated Rock Ridge directories, UDF virtual/sparable/metadata partitions,
+ * ...) raises UnsupportedImage so the caller can fall back to pycdlib.
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kSectorSize = 2048;
+constexpr uint64_t kFirstVolumeDescriptor = 16;
+constexpr uint64_t kMaxVolumeDescriptors = 64;
+constexpr uint64_t kUdfAnchorSector = 256;
+constexpr int kMaxContinuationDepth = 16;
+
+enum EntryFlags : uint8_t {
+    kFlagDirectory = 1 << 0,
+    kFlagHidden = 1 << 1,
+};
+
+enum class Namespace { Iso9660, RockRidge, Joliet, Udf };
+
+struct UnsupportedImage : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct MalformedImage : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+inline uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+inline uint32_t le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t le64(const uint8_t* p) {
+    return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32);
+}
+
+// Dates are packed as the decimal number YYYYMMDDhhmmss; 0 means unknown.
+int64_t pack_date(int year, int month, int day, int hour, int minute, int second) {
+    if (year <= 0 || month < 1 || month > 12 || day < 1 || day > 31) {
+        return 0;
+    }
+    return ((((static_cast<int64_t>(year) * 100 + month) * 100 + day) * 100 + hour) * 100 + minute) * 100 + second;
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+std::string utf16be_to_utf8(const uint8_t* p, size_t length) {
+    std::string out;
+    out.reserve(length);
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        uint32_t unit = (static_cast<uint32_t>(p[i]) << 8) | p[i + 1];
+        if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < length) {
+            uint32_t low = (static_cast<uint32_t>(p[i + 2]) << 8) | p[i + 3];
+            if (low >= 0xDC00 && low < 0xE000) {
+                append_utf8(out, 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+                i += 2;
+                continue;
+            }
+        }
+        append_utf8(out, unit);
+    }
+    return out;
+}
+
+std::string latin1_to_utf8(const uint8_t* p, size_t length) {
+    std::string out;
+    out.reserve(length);
+    for (size_t i = 0; i < length; ++i) {
+        append_utf8(out, p[i]);
+    }
+    return out;
+}
+
+class Image {
+public:
+    Image(const uint8_t* data, uint64_t size) : data_(data), size_(size) {}
+
+    const uint8_t* at(uint64_t offset, uint64_t length) const {
+        if (offset > size_ || length > size_ - offset) {
+            throw MalformedImage("structure extends past the end of the image");
+        }
+        return data_ + offset;
+    }
+
+    uint64_t size() const { return size_; }
+
+private:
+    const uint8_t* data_;
+    uint64_t size_;
+};
+
+struct Entry {
+    std::string name;
+    int32_t parent = 0;
+    uint8_t flags = 0;
+    uint64_t size = 0;
+    uint32_t extent = 0;
+    int64_t date = 0;
+    int32_t first_child = 0;
+    int32_t child_count = 0;
+    // Where a directory's own contents live: an extent for ISO 9660, the
+    // logical block of its file entry for UDF.
+    uint64_t location = 0;
+};
+
+struct VolumeInfo {
+    uint32_t block_size = 2048;
+    uint32_t volume_space_size = 0;
+    const uint8_t* pvd = nullptr;
+    const uint8_t* joliet_svd = nullptr;
+    int64_t boot_catalog = -1;
+    bool has_rock_ridge = false;
+    bool has_udf = false;
+    uint8_t susp_skip = 0;
+};
+
+bool is_joliet_escape(const uint8_t* escapes) {
+    for (int i = 0; i + 2 < 32; ++i) {
+        if (escapes[i] == '%' && escapes[i + 1] == '/' &&
+            (escapes[i + 2] == '@' || escapes[i + 2] == 'C' || escapes[i + 2] == 'E')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool has_udf_anchor(const Image& image) {
+    if (image.size() < (kUdfAnchorSector + 1) * kSectorSize) {
+        return false;
+    }
+    const uint8_t* tag = image.at(kUdfAnchorSector * kSectorSize, 16);
+    return le16(tag) == 2 && le32(tag + 12) == kUdfAnchorSector;
+}
+
+VolumeInfo probe_volume(const Image& image) {
+    VolumeInfo info;
+    for (uint64_t sector = kFirstVolumeDescriptor; sector < kFirstVolumeDescriptor + kMaxVolumeDescriptors; ++sector) {
+        if ((sector + 1) * kSectorSize > image.size()) {
+            break;
+        }
+        const uint8_t* vd = image.at(sector * kSectorSize, kSectorSize);
+        if (std::memcmp(vd + 1, "CD001", 5) != 0 || vd[0] == 255) {
+            break;
+        }
+        if (vd[0] == 1 && info.pvd == nullptr) {
+            info.pvd = vd;
+        } else if (vd[0] == 2 && info.joliet_svd == nullptr && is_joliet_escape(vd + 88)) {
+            info.joliet_svd = vd;
+        } else if (vd[0] == 0 && std::memcmp(vd + 7, "EL TORITO SPECIFICATION", 23) == 0) {
+            info.boot_catalog = le32(vd + 71);
+        }
+    }
+    if (info.pvd == nullptr) {
+        throw MalformedImage("no primary volume descriptor found");
+    }
+
+    info.block_size = le16(info.pvd + 128);
+    if (info.block_size == 0 || info.block_size > kSectorSize || (info.block_size & (info.block_size - 1)) != 0) {
+        throw MalformedImage("invalid logical block size");
+    }
+    info.volume_space_size = le32(info.pvd + 80);
+
+    // Rock Ridge is announced by an SP entry in the root directory's "." record.
+    const uint8_t* root = info.pvd + 156;
+    const uint8_t* dot = image.at(static_cast<uint64_t>(le32(root + 2)) * info.block_size, 34);
+    uint8_t dot_length = dot[0];
+    if (dot_length >= 34 + 7) {
+        const uint8_t* susp = image.at(static_cast<uint64_t>(le32(root + 2)) * info.block_size + 34, 7);
+        if (susp[0] == 'S' && susp[1] == 'P' && susp[4] == 0xBE && susp[5] == 0xEF) {
+            info.has_rock_ridge = true;
+            info.susp_skip = susp[6];
+        }
+    }
+
+    info.has_udf = has_udf_anchor(image);
+    return info;
+}
+
+struct RockRidgeEntry {
+    std::string name;
+    bool has_name = false;
+    bool relocated = false;
+};
+
+void parse_susp(const Image& image, const VolumeInfo& info, const uint8_t* p, uint64_t length,
+                RockRidgeEntry& rr, int depth) {
+    uint64_t ce_block = 0, ce_offset = 0, ce_length = 0;
+    bool has_continuation = false;
+
+    while (length >= 4) {
+        uint8_t entry_length = p[2];
+        if (entry_length < 4 || entry_length > length) {
+            break;
+        }
+        if (p[0] == 'N' && p[1] == 'M') {
+            // Names with the CURRENT or PARENT flag are not real names.
+            if (entry_length > 5 && (p[4] & 0x06) == 0) {
+                rr.name.append(reinterpret_cast<const char*>(p + 5), entry_length - 5);
+            }
+            rr.has_name = true;
+        } else if (p[0] == 'C' && p[1] == 'E' && entry_length >= 28) {
+            ce_block = le32(p + 4);
+            ce_offset = le32(p + 12);
+            ce_length = le32(p + 20);
+            has_continuation = true;
+        } else if ((p[0] == 'C' && p[1] == 'L') || (p[0] == 'R' && p[1] == 'E')) {
+            rr.relocated = true;
+        } else if (p[0] == 'S' && p[1] == 'T') {
+            break;
+        }
+        p += entry_length;
+        length -= entry_length;
+    }
+
+    if (has_continuation) {
+        if (depth >= kMaxContinuationDepth) {
+            throw MalformedImage("too many Rock Ridge continuation areas");
+        }
+        const uint8_t* area = image.at(ce_block * info.block_size + ce_offset, ce_length);
+        parse_susp(image, info, area, ce_length, rr, depth + 1);
+    }
+}
+
+int64_t iso_date(const uint8_t* d) {
+    return pack_date(d[0] + 1900, d[1], d[2], d[3], d[4], d[5]);
+}
+
+void scan_iso9660(const Image& image, const VolumeInfo& info, Namespace ns, std::vector<Entry>& entries) {
+    const uint8_t* vd = (ns == Namespace::Joliet) ? info.joliet_svd : info.pvd;
+    if (vd == nullptr) {
+        throw MalformedImage("the requested namespace is not present in this image");
+    }
+    bool rock_ridge = (ns == Namespace::RockRidge);
+    if (rock_ridge && !info.has_rock_ridge) {
+        throw MalformedImage("the image has no Rock Ridge extensions");
+    }
+
+    const uint8_t* root_record = vd + 156;
+    Entry root;
+    root.flags = kFlagDirectory;
+    root.extent = le32(root_record + 2);
+    root.size = le32(root_record + 10);
+    root.date = iso_date(root_record + 18);
+    root.location = root.extent;
+    entries.push_back(root);
+
+    std::unordered_set<uint64_t> visited{root.location};
+    const uint64_t block_size = info.block_size;
+
+    for (size_t index = 0; index < entries.size(); ++index) {
+        if (!(entries[index].flags & kFlagDirectory)) {
+            continue;
+        }
+        entries[index].first_child = static_cast<int32_t>(entries.size());
+
+        uint64_t position = entries[index].location * block_size;
+        const uint64_t end = position + entries[index].size;
+        bool continues_previous = false;
+        std::string previous_identifier;
+
+        while (position < end) {
+            const uint8_t* record = image.at(position, 1);
+            uint8_t record_length = record[0];
+            if (record_length == 0) {
+                // Records never cross a block boundary; the rest of this block is padding.
+                position = (position / block_size + 1) * block_size;
+                continues_previous = false;
+                continue;
+            }
+            record = image.at(position, record_length);
+            uint8_t identifier_length = record[32];
+            if (record_length < 34 || 33u + identifier_length > record_length) {
+                throw MalformedImage("invalid directory record");
+            }
+            position += record_length;
+
+            const uint8_t* identifier = record + 33;
+            if (identifier_length == 1 && (identifier[0] == 0 || identifier[0] == 1)) {
+                continue;
+            }
+
+            uint8_t file_flags = record[25];
+            uint32_t data_length = le32(record + 10);
+            std::string raw_identifier(reinterpret_cast<const char*>(identifier), identifier_length);
+
+            // Files larger than one extent are split over several records with the same name.
+            if (continues_previous && raw_identifier == previous_identifier) {
+                entries.back().size += data_length;
+                continues_previous = (file_flags & 0x80) != 0;
+                continue;
+            }
+            continues_previous = (file_flags & 0x80) != 0;
+            previous_identifier = raw_identifier;
+
+            Entry entry;
+            entry.parent = static_cast<int32_t>(index);
+            entry.extent = le32(record + 2);
+            entry.size = data_length;
+            entry.date = iso_date(record + 18);
+            if (file_flags & 0x02) {
+                entry.flags |= kFlagDirectory;
+            }
+            if (file_flags & 0x01) {
+                entry.flags |= kFlagHidden;
+            }
+
+            if (ns == Namespace::Joliet) {
+                entry.name = utf16be_to_utf8(identifier, identifier_length);
+            } else if (rock_ridge) {
+                uint64_t su_offset = 33u + identifier_length + ((identifier_length % 2 == 0) ? 1 : 0) + info.susp_skip;
+                RockRidgeEntry rr;
+                if (su_offset < record_length) {
+                    parse_susp(image, info, record + su_offset, record_length - su_offset, rr, 0);
+                }
+                if (rr.relocated) {
+                    throw UnsupportedImage("relocated Rock Ridge directories are not supported");
+                }
+                if (rr.has_name) {
+                    entry.name = std::move(rr.name);
+                } else {
+                    size_t version = raw_identifier.find(';');
+                    entry.name = raw_identifier.substr(0, version);
+                }
+            } else {
+                entry.name = std::move(raw_identifier);
+            }
+
+            if (entry.flags & kFlagDirectory) {
+                entry.location = entry.extent;
+                if (!visited.insert(entry.location).second) {
+                    throw MalformedImage("directory hierarchy contains a cycle");
+                }
+            }
+            entries.push_back(std::move(entry));
+        }
+        entries[index].child_count = static_cast<int32_t>(entries.size()) - entries[index].first_child;
+    }
+}
+
+struct UdfVolume {
+    uint64_t partition_start = 0;
+    uint64_t block_size = kSectorSize;
+    uint32_t fsd_block = 0;
+};
+
+struct UdfFileEntry {
+    uint8_t file_type = 0;
+    uint64_t information_length = 0;
+    int64_t date = 0;
+    uint32_t data_sector = 0;
+    std::string embedded;
+    std::vector<std::pair<uint64_t, uint64_t>> extents;  // absolute byte offset, length
+};
+
+int64_t udf_date(const uint8_t* t) {
+    int16_t year = static_cast<int16_t>(le16(t + 2));
+    return pack_date(year, t[4], t[5], t[6], t[7], t[8]);
+}
+
+UdfVolume read_udf_volume(const Image& image) {
+    const uint8_t* anchor = image.at(kUdfAnchorSector * kSectorSize, 32);
+    uint32_t sequence_length = le32(anchor + 16);
+    uint32_t sequence_start = le32(anchor + 20);
+
+    UdfVolume volume;
+    bool have_partition = false, have_logical_volume = false;
+    uint64_t sectors = sequence_length / kSectorSize;
+    for (uint64_t i = 0; i < sectors; ++i) {
+        const uint8_t* d = image.at((sequence_start + i) * kSectorSize, kSectorSize);
+        uint16_t tag = le16(d);
+        if (tag == 5 && !have_partition) {
+            volume.partition_start = le32(d + 188);
+            have_partition = true;
+        } else if (tag == 6 && !have_logical_volume) {
+            volume.block_size = le32(d + 212);
+            volume.fsd_block = le32(d + 252);
+            uint32_t map_count = le32(d + 268);
+            const uint8_t* map = d + 440;
+            for (uint32_t m = 0; m < map_count; ++m) {
+                if (map + 2 > d + kSectorSize || map[1] == 0) {
+                    throw MalformedImage("invalid UDF partition map");
+                }
+                if (map[0] != 1) {
+                    throw UnsupportedImage("only type 1 UDF partition maps are supported");
+                }
+                map += map[1];
+            }
+            have_logical_volume = true;
+        } else if (tag == 8) {
+            break;
+        }
+    }
+    if (!have_partition || !have_logical_volume) {
+        throw MalformedImage("UDF volume descriptor sequence is incomplete");
+    }
+    if (volume.block_size != kSectorSize) {
+        throw UnsupportedImage("only 2048-byte UDF logical blocks are supported");
+    }
+    return volume;
+}
+
+UdfFileEntry read_udf_file_entry(const Image& image, const UdfVolume& volume, uint32_t block) {
+    uint64_t offset = (volume.partition_start + block) * volume.block_size;
+    const uint8_t* fe = image.at(offset, 176);
+    uint16_t tag = le16(fe);
+
+    uint64_t ea_offset, date_offset;
+    if (tag == 261) {
+        ea_offset = 168;
+        date_offset = 84;
+    } else if (tag == 266) {
+        fe = image.at(offset, 216);
+        ea_offset = 208;
+        date_offset = 92;
+    } else {
+        throw MalformedImage("expected a UDF file entry");
+    }
+
+    UdfFileEntry entry;
+    entry.file_type = fe[27];
+    entry.information_length = le64(fe + 56);
+    entry.date = udf_date(fe + date_offset);
+    entry.data_sector = static_cast<uint32_t>(volume.partition_start + block);
+
+    uint32_t ea_length = le32(fe + ea_offset);
+    uint32_t ad_length = le32(fe + ea_offset + 4);
+    const uint8_t* ads = image.at(offset + ea_offset + 8 + ea_length, ad_length);
+    uint16_t ad_type = le16(fe + 34) & 0x07;
+
+    if (ad_type == 3) {
+        entry.embedded.assign(reinterpret_cast<const char*>(ads), ad_length);
+        return entry;
+    }
+    if (ad_type != 0 && ad_type != 1) {
+        throw UnsupportedImage("extended UDF allocation descriptors are not supported");
+    }
+
+    const uint32_t ad_size = (ad_type == 0) ? 8 : 16;
+    for (uint32_t i = 0; i + ad_size <= ad_length; i += ad_size) {
+        uint32_t raw_length = le32(ads + i);
+        uint32_t extent_type = raw_length >> 30;
+        uint64_t length = raw_length & 0x3FFFFFFF;
+        if (length == 0) {
+            break;
+        }
+        if (extent_type == 3) {
+            throw UnsupportedImage("chained UDF allocation descriptors are not supported");
+        }
+        uint64_t position = le32(ads + i + 4);
+        if (entry.extents.empty()) {
+            entry.data_sector = static_cast<uint32_t>(volume.partition_start + position);
+        }
+        entry.extents.emplace_back((volume.partition_start + position) * volume.block_size, length);
+    }
+    return entry;
+}
+
+std::string read_udf_directory(const Image& image, const UdfFileEntry& directory) {
+    if (directory.extents.empty()) {
+        return directory.embedded.substr(0, directory.information_length);
+    }
+    std::string data;
+    data.reserve(directory.information_length);
+    for (const auto& extent : directory.extents) {
+        const uint8_t* p = image.at(extent.first, extent.second);
+        data.append(reinterpret_cast<const char*>(p), extent.second);
+    }
+    if (data.size() > directory.information_length) {
+        data.resize(directory.information_length);
+    }
+    return data;
+}
+
+std::string udf_name(const uint8_t* p, size_t length) {
+    if (length == 0) {
+        return std::string();
+    }
+    if (p[0] == 8) {
+        return latin1_to_utf8(p + 1, length - 1);
+    }
+    if (p[0] == 16) {
+        return utf16be_to_utf8(p + 1, length - 1);
+    }
+    throw MalformedImage("unknown UDF compression identifier");
+}
+
+void scan_udf(const Image& image, std::vector<Entry>& entries) {
+    UdfVolume volume = read_udf_volume(image);
+
+    const uint8_t* fsd = image.at((volume.partition_start + volume.fsd_block) * volume.block_size, 512);
+    if (le16(fsd) != 256) {
+        throw MalformedImage("expected a UDF file set descriptor");
+    }
+    uint32_t root_block = le32(fsd + 400 + 4);
+
+    UdfFileEntry root_fe = read_udf_file_entry(image, volume, root_block);
+    Entry root;
+    root.flags = kFlagDirectory;
+    root.size = root_fe.information_length;
+    root.date = root_fe.date;
+    root.extent = root_fe.data_sector;
+    root.location = root_block;
+    entries.push_back(root);
+
+    std::unordered_set<uint64_t> visited{root.location};
+
+    for (size_t index = 0; index < entries.size(); ++index) {
+        if (!(entries[index].flags & kFlagDirectory)) {
+            continue;
+        }
+        entries[index].first_child = static_cast<int32_t>(entries.size());
+
+        UdfFileEntry directory = read_udf_file_entry(image, volume, static_cast<uint32_t>(entries[index].location));
+        std::string data = read_udf_directory(image, directory);
+        const uint8_t* d = reinterpret_cast<const uint8_t*>(data.data());
+        const size_t length = data.size();
+
+        size_t offset = 0;
+        while (offset + 38 <= length) {
+            const uint8_t* fid = d + offset;
+            if (le16(fid) != 257) {
+                throw MalformedImage("expected a UDF file identifier descriptor");
+            }
+            uint8_t characteristics = fid[18];
+            uint8_t identifier_length = fid[19];
+            uint32_t icb_block = le32(fid + 24);
+            uint16_t implementation_length = le16(fid + 36);
+            size_t record_length = (38u + implementation_length + identifier_length + 3u) & ~static_cast<size_t>(3);
+            if (offset + 38u + implementation_length + identifier_length > length) {
+                throw MalformedImage("truncated UDF file identifier descriptor");
+            }
+            const uint8_t* identifier = fid + 38 + implementation_length;
+            offset += record_length;
+
+            // Skip the parent entry and deleted entries.
+            if ((characteristics & 0x08) || (characteristics & 0x04) || identifier_length == 0) {
+                continue;
+            }
+
+            UdfFileEntry fe = read_udf_file_entry(image, volume, icb_block);
+            Entry entry;
+            entry.parent = static_cast<int32_t>(index);
+            entry.name = udf_name(identifier, identifier_length);
+            entry.size = fe.information_length;
+            entry.extent = fe.data_sector;
+            entry.date = fe.date;
+            if (characteristics & 0x02) {
+                entry.flags |= kFlagDirectory;
+                entry.location = icb_block;
+                if (!visited.insert(entry.location).second) {
+                    throw MalformedImage("directory hierarchy contains a cycle");
+                }
+            }
+            if (characteristics & 0x01) {
+                entry.flags |= kFlagHidden;
+            }
+            entries.push_back(std::move(entry));
+        }
+        entries[index].child_count = static_cast<int32_t>(entries.size()) - entries[index].first_child;
+    }
+}
+
+PyObject* UnsupportedImageError = nullptr;
+
+// Holds a buffer view for the duration of a call.
+class BufferView {
+public:
+    explicit BufferView(PyObject* object) {
+        ok_ = PyObject_GetBuffer(object, &view_, PyBUF_SIMPLE) == 0;
+    }
+    ~BufferView() {
+        if (ok_) {
+            PyBuffer_Release(&view_);
+        }
+    }
+    bool ok() const { return ok_; }
+    Image image() const { return Image(static_cast<const uint8_t*>(view_.buf), static_cast<uint64_t>(view_.len)); }
+
+private:
+    Py_buffer view_{};
+    bool ok_ = false;
+};
+
+template <typename T, typename F>
+PyObject* column(const std::vector<Entry>& entries, F field) {
+    PyObject* bytes = PyBytes_FromStringAndSize(nullptr, static_cast<Py_ssize_t>(entries.size() * sizeof(T)));
+    if (bytes == nullptr) {
+        return nullptr;
+    }
+    T* out = reinterpret_cast<T*>(PyBytes_AS_STRING(bytes));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        out[i] = static_cast<T>(field(entries[i]));
+    }
+    return bytes;
+}
+
+PyObject* raise_scan_error(const std::string& message, bool unsupported) {
+    PyErr_SetString(unsupported ? UnsupportedImageError : PyExc_ValueError, message.c_str());
+    return nullptr;
+}
+
+PyObject* isoscan_probe(PyObject*, PyObject* args) {
+    PyObject* buffer;
+    if (!PyArg_ParseTuple(args, "O:probe", &buffer)) {
+        return nullptr;
+    }
+    BufferView view(buffer);
+    if (!view.ok()) {
+        return nullptr;
+    }
+
+    VolumeInfo info;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        info = probe_volume(view.image());
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+    if (!error.empty()) {
+        return raise_scan_error(error, false);
+    }
+
+    PyObject* boot_catalog;
+    if (info.boot_catalog >= 0) {
+        boot_catalog = PyLong_FromLongLong(info.boot_catalog);
+    } else {
+        Py_INCREF(Py_None);
+        boot_catalog = Py_None;
+    }
+    return Py_BuildValue(
+        "{s:I,s:I,s:y#,s:y#,s:O,s:O,s:O,s:N}",
+        "block_size", info.block_size,
+        "volume_space_size", info.volume_space_size,
+        "system_id", reinterpret_cast<const char*>(info.pvd + 8), static_cast<Py_ssize_t>(32),
+        "volume_id", reinterpret_cast<const char*>(info.pvd + 40), static_cast<Py_ssize_t>(32),
+        "joliet", info.joliet_svd ? Py_True : Py_False,
+        "rock_ridge", info.has_rock_ridge ? Py_True : Py_False,
+        "udf", info.has_udf ? Py_True : Py_False,
+        "boot_catalog", boot_catalog);
+}
+
+PyObject* isoscan_joliet_ids(PyObject*, PyObject* args) {
+    PyObject* buffer;
+    if (!PyArg_ParseTuple(args, "O:joliet_ids", &buffer)) {
+        return nullptr;
+    }
+    BufferView view(buffer);
+    if (!view.ok()) {
+        return nullptr;
+    }
+    VolumeInfo info;
+    try {
+        info = probe_volume(view.image());
+    } catch (const std::exception& e) {
+        return raise_scan_error(e.what(), false);
+    }
+    if (info.joliet_svd == nullptr) {
+        Py_RETURN_NONE;
+    }
+    return Py_BuildValue("(y#y#)",
+                         reinterpret_cast<const char*>(info.joliet_svd + 8), static_cast<Py_ssize_t>(32),
+                         reinterpret_cast<const char*>(info.joliet_svd + 40), static_cast<Py_ssize_t>(32));
+}
+
+PyObject* isoscan_scan(PyObject*, PyObject* args) {
+    PyObject* buffer;
+    const char* namespace_name;
+    if (!PyArg_ParseTuple(args, "Os:scan", &buffer, &namespace_name)) {
+        return nullptr;
+    }
+
+    Namespace ns;
+    if (std::strcmp(namespace_name, "iso_path") == 0) {
+        ns = Namespace::Iso9660;
+    } else if (std::strcmp(namespace_name, "rr_path") == 0) {
+        ns = Namespace::RockRidge;
+    } else if (std::strcmp(namespace_name, "joliet_path") == 0) {
+        ns = Namespace::Joliet;
+    } else if (std::strcmp(namespace_name, "udf_path") == 0) {
+        ns = Namespace::Udf;
+    } else {
+        PyErr_Format(PyExc_ValueError, "unknown namespace '%s'", namespace_name);
+        return nullptr;
+    }
+
+    BufferView view(buffer);
+    if (!view.ok()) {
+        return nullptr;
+    }
+
+    std::vector<Entry> entries;
+    std::string error;
+    bool unsupported = false;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        Image image = view.image();
+        if (ns == Namespace::Udf) {
+            if (!has_udf_anchor(image)) {
+                throw MalformedImage("the image has no UDF anchor");
+            }
+            scan_udf(image, entries);
+        } else {
+            scan_iso9660(image, probe_volume(image), ns, entries);
+        }
+    } catch (const UnsupportedImage& e) {
+        error = e.what();
+        unsupported = true;
+    } catch (const std::bad_alloc&) {
+        error = "out of memory while scanning the image";
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+    if (!error.empty()) {
+        return raise_scan_error(error, unsupported);
+    }
+
+    PyObject* names = PyList_New(static_cast<Py_ssize_t>(entries.size()));
+    if (names == nullptr) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        PyObject* name = PyUnicode_DecodeUTF8(entries[i].name.data(), static_cast<Py_ssize_t>(entries[i].name.size()),
+                                              "replace");
+        if (name == nullptr) {
+            Py_DECREF(names);
+            return nullptr;
+        }
+        PyList_SET_ITEM(names, static_cast<Py_ssize_t>(i), name);
+    }
+
+    return Py_BuildValue(
+        "{s:N,s:N,s:N,s:N,s:N,s:N,s:N,s:N}",
+        "names", names,
+        "parent", column<int32_t>(entries, [](const Entry& e) { return e.parent; }),
+        "flags", column<uint8_t>(entries, [](const Entry& e) { return e.flags; }),
+        "size", column<uint64_t>(entries, [](const Entry& e) { return e.size; }),
+        "extent", column<uint32_t>(entries, [](const Entry& e) { return e.extent; }),
+        "date", column<int64_t>(entries, [](const Entry& e) { return e.date; }),
+        "first_child", column<int32_t>(entries, [](const Entry& e) { return e.first_child; }),
+        "child_count", column<int32_t>(entries, [](const Entry& e) { return e.child_count; }));
+}
+
+PyMethodDef isoscan_methods[] = {
+    {"probe", isoscan_probe, METH_VARARGS,
+     "probe(buffer) -> dict\n\nReads the volume descriptors and reports which namespaces the image has."},
+    {"joliet_ids", isoscan_joliet_ids, METH_VARARGS,
+     "joliet_ids(buffer) -> (system_id, volume_id) or None\n\nRaw UCS-2 identifiers of the Joliet volume."},
+    {"scan", isoscan_scan, METH_VARARGS,
+     "scan(buffer, namespace) -> dict of columns\n\n"
+     "Walks the directory tree of one namespace ('iso_path', 'rr_path', 'joliet_path' or 'udf_path')."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyModuleDef isoscan_module = {
+    PyModuleDef_HEAD_INIT, "_isoscan", "Fast read-only directory scanner for ISO 9660 images.", -1,
+    isoscan_methods, nullptr, nullptr, nullptr, nullptr,
+};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit__isoscan(void) {
+    PyObject* module = PyModule_Create(&isoscan_module);
+    if (module == nullptr) {
+        return nullptr;
+    }
+    UnsupportedImageError = PyErr_NewExceptionWithDoc(
+        "_isoscan.UnsupportedImage",
+        "The image uses a layout the scanner does not handle; use the pure-Python reader instead.",
+        PyExc_ValueError, nullptr);
+    if (UnsupportedImageError == nullptr || PyModule_AddObject(module, "UnsupportedImage", UnsupportedImageError) < 0) {
+        Py_XDECREF(UnsupportedImageError);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    Py_INCREF(UnsupportedImageError);
+    return module;
+}
@@ -0,0 +1,412 @@
+"""
+Compact struct-of-arrays storage for the directory tree.
+
+By default every TreeNode is a dict of about ten keys. For images with hundreds
+of thousands of entries that costs several hundred bytes per entry before any
+file data is read. A NodeStore keeps the same information in typed columns:
+names in an interned string table, plus sizes, flags, parent indices and
+packed timestamps. NodeHandle objects stand in for the node dicts. A handle
+supports the mapping interface the rest of the editor uses on nodes, so code
+such as commands.py and the GUI's tree_item_map works unchanged.
+
+Handles are created on demand and cached weakly. While any reference to a
+handle exists, looking up the same node again returns the same object, so
+`is` and id() comparisons keep working.
+
+Dicts assigned into a handle's 'children' list become part of the store when
+they are assigned. Changes made to such a dict afterwards are not seen; use the
+handle returned by the list instead.
+"""
+
+import weakref
+from array import array
+from collections.abc import MutableMapping, MutableSequence
+from typing import Any, Dict, Iterator, List, Optional
+
+# Flag bits of NodeStore.flags
+FLAG_DIRECTORY = 0x01
+FLAG_HIDDEN = 0x02
+FLAG_NEW = 0x04
+FLAG_CHILDREN_LOADED = 0x08
+FLAG_HAS_CHILDREN_LOADED = 0x10
+FLAG_HAS_ISO_PATH = 0x20
+FLAG_HAS_EXTENT = 0x40
+
+# Keys that are stored in columns; everything else lives in the per-node extras dict.
+_BOOL_FLAGS = {'is_directory': FLAG_DIRECTORY, 'is_hidden': FLAG_HIDDEN, 'is_new': FLAG_NEW}
+_ALWAYS_PRESENT = ('name', 'is_directory', 'is_hidden', 'size', 'date', 'children', 'parent', 'is_new')
+_OPTIONAL_COLUMNS = ('iso_path', 'children_loaded', 'extent_location', 'scan_index', 'original_child_count')
+_COLUMN_KEYS = frozenset(_ALWAYS_PRESENT + _OPTIONAL_COLUMNS)
+
+# Value of the date column for dates that are not "YYYY-MM-DD HH:MM:SS" strings;
+# the original string is kept in the extras dict.
+_DATE_IN_EXTRAS = -1
+
+
+def pack_date(date: str) -> int:
+    """
+    Packs a "YYYY-MM-DD HH:MM:SS" string into the integer YYYYMMDDhhmmss.
+
+    Returns 0 for "Unknown" and _DATE_IN_EXTRAS for anything else that does not parse.
+    """
+    if date == "Unknown":
+        return 0
+    if len(date) == 19 and date[4] == '-' and date[7] == '-' and date[10] == ' ' \
+            and date[13] == ':' and date[16] == ':':
+        digits = date[0:4] + date[5:7] + date[8:10] + date[11:13] + date[14:16] + date[17:19]
+        if digits.isdigit():
+            return int(digits)
+    return _DATE_IN_EXTRAS
+
+
+def format_packed_date(packed: int) -> str:
+    """Formats a date packed as YYYYMMDDhhmmss; 0 means "Unknown"."""
+    if not packed:
+        return "Unknown"
+    digits = f"{packed:014d}"
+    return (f"{digits[0:4]}-{digits[4:6]}-{digits[6:8]} "
+            f"{digits[8:10]}:{digits[10:12]}:{digits[12:14]}")
+
+
+class NodeStore:
+    """
+    Columnar storage for all nodes of one directory tree.
+
+    Nodes are identified by their index. Index 0 is the root, which is its own
+    parent. Removed nodes keep their slots until the store is discarded,
+    because undo may put them back.
+    """
+
+    def __init__(self) -> None:
+        self._name_table: List[str] = []
+        self._name_ids: Dict[str, int] = {}
+        self.name_ids = array('i')
+        # Name the node had when it was read from the image; iso_path is derived from these.
+        self.original_name_ids = array('i')
+        self.parents = array('i')
+        self.sizes = array('Q')
+        self.dates = array('q')
+        self.extents = array('I')
+        self.flags = array('B')
+        self.scan_indices = array('i')
+        self.original_child_counts = array('i')
+        self.children: Dict[int, array] = {}
+        self.extras: Dict[int, Dict[str, Any]] = {}
+        self._handles: 'weakref.WeakValueDictionary[int, NodeHandle]' = weakref.WeakValueDictionary()
+
+    def __len__(self) -> int:
+        return len(self.parents)
+
+    def intern(self, name: str) -> int:
+        """Returns the id of a name in the string table, adding it if needed."""
+        name_id = self._name_ids.get(name)
+        if name_id is None:
+            name_id = len(self._name_table)
+            self._name_table.append(name)
+            self._name_ids[name] = name_id
+        return name_id
+
+    def name(self, index: int) -> str:
+        return self._name_table[self.name_ids[index]]
+
+    def is_directory(self, index: int) -> bool:
+        return bool(self.flags[index] & FLAG_DIRECTORY)
+
+    def handle(self, index: int) -> 'NodeHandle':
+        """Returns the handle for a node, reusing a live one if there is one."""
+        node = self._handles.get(index)
+        if node is None:
+            node = NodeHandle(self, index)
+            self._handles[index] = node
+        return node
+
+    def create_root(self, node: Dict[str, Any]) -> 'NodeHandle':
+        """Creates the root node from a node dict and returns its handle."""
+        if len(self):
+            raise ValueError("NodeStore already has a root")
+        self.adopt(node, 0)
+        return self.handle(0)
+
+    def adopt(self, node: Any, parent_index: int) -> int:
+        """
+        Makes a node part of this store under the given parent.
+
+        Args:
+            node: A handle from this store, or a node dict to copy into the store.
+            parent_index: Index of the new parent.
+
+        Returns:
+            int: The node's index.
+        """
+        if isinstance(node, NodeHandle):
+            if node.store is not self:
+                raise ValueError("Cannot move nodes between node stores")
+            self.parents[node.index] = parent_index
+            return node.index
+
+        index = len(self.parents)
+        self.parents.append(parent_index)
+        self.name_ids.append(0)
+        self.original_name_ids.append(0)
+        self.sizes.append(0)
+        self.dates.append(0)
+        self.extents.append(0)
+        self.flags.append(0)
+        self.scan_indices.append(-1)
+        self.original_child_counts.append(-1)
+
+        name_id = self.intern(node.get('name', ''))
+        self.name_ids[index] = name_id
+        self.original_name_ids[index] = name_id
+
+        handle = self.handle(index)
+        for key, value in node.items():
+            if key in ('parent', 'name'):
+                continue
+            handle[key] = value
+        return index
+
+    def iso_path(self, index: int) -> str:
+        """Derives a node's path in the source image from the original names of its ancestors."""
+        parts = []
+        parents = self.parents
+        while parents[index] != index:
+            parts.append(self._name_table[self.original_name_ids[index]])
+            index = parents[index]
+        return '/' + '/'.join(reversed(parts))
+
+    def subtree(self, index: int = 0) -> List[int]:
+        """Returns the indices of a node and all its descendants in pre-order."""
+        result = []
+        stack = [index]
+        children = self.children
+        while stack:
+            current = stack.pop()
+            result.append(current)
+            child_indices = children.get(current)
+            if child_indices:
+                stack.extend(reversed(child_indices))
+        return result
+
+
+class NodeHandle(MutableMapping):
+    """A node of a NodeStore, accessed like a TreeNode dict."""
+
+    __slots__ = ('store', 'index', '__weakref__')
+
+    def __init__(self, store: NodeStore, index: int) -> None:
+        self.store = store
+        self.index = index
+
+    def __getitem__(self, key: str) -> Any:
+        store, index = self.store, self.index
+        if key not in _COLUMN_KEYS:
+            extras = store.extras.get(index)
+            if extras is None or key not in extras:
+                raise KeyError(key)
+            return extras[key]
+
+        flags = store.flags[index]
+        if key == 'name':
+            return store.name(index)
+        if key in _BOOL_FLAGS:
+            return bool(flags & _BOOL_FLAGS[key])
+        if key == 'size':
+            return store.sizes[index]
+        if key == 'date':
+            packed = store.dates[index]
+            return store.extras[index]['date'] if packed == _DATE_IN_EXTRAS else format_packed_date(packed)
+        if key == 'children':
+            return ChildList(store, index)
+        if key == 'parent':
+            return store.handle(store.parents[index])
+        if key == 'iso_path':
+            extras = store.extras.get(index)
+            if extras and 'iso_path' in extras:
+                return extras['iso_path']
+            if flags & FLAG_HAS_ISO_PATH:
+                return store.iso_path(index)
+        elif key == 'children_loaded':
+            if flags & FLAG_HAS_CHILDREN_LOADED:
+                return bool(flags & FLAG_CHILDREN_LOADED)
+        elif key == 'extent_location':
+            if flags & FLAG_HAS_EXTENT:
+                return store.extents[index]
+        elif key == 'scan_index':
+            if store.scan_indices[index] >= 0:
+                return store.scan_indices[index]
+        elif key == 'original_child_count':
+            if store.original_child_counts[index] >= 0:
+                return store.original_child_counts[index]
+        raise KeyError(key)
+
+    def __setitem__(self, key: str, value: Any) -> None:
+        store, index = self.store, self.index
+        if key not in _COLUMN_KEYS:
+            store.extras.setdefault(index, {})[key] = value
+            return
+
+        if key == 'name':
+            store.name_ids[index] = store.intern(value)
+        elif key in _BOOL_FLAGS:
+            self._set_flag(_BOOL_FLAGS[key], bool(value))
+        elif key == 'size':
+            store.sizes[index] = value
+        elif key == 'date':
+            packed = pack_date(value) if isinstance(value, str) else _DATE_IN_EXTRAS
+            store.dates[index] = packed
+            if packed == _DATE_IN_EXTRAS:
+                store.extras.setdefault(index, {})['date'] = value
+            else:
+                self._discard_extra('date')
+        elif key == 'children':
+            if isinstance(value, ChildList) and value.store is store and value.owner == index:
+                return
+            indices = array('i', [store.adopt(child, index) for child in value])
+            if indices:
+                store.children[index] = indices
+            else:
+                store.children.pop(index, None)
+        elif key == 'parent':
+            store.parents[index] = value.index if isinstance(value, NodeHandle) else index
+        elif key == 'iso_path':
+            self._discard_extra('iso_path')
+            self._set_flag(FLAG_HAS_ISO_PATH, True)
+            if store.iso_path(index) != value:
+                store.extras.setdefault(index, {})['iso_path'] = value
+        elif key == 'children_loaded':
+            self._set_flag(FLAG_HAS_CHILDREN_LOADED, True)
+            self._set_flag(FLAG_CHILDREN_LOADED, bool(value))
+        elif key == 'extent_location':
+            store.extents[index] = value
+            self._set_flag(FLAG_HAS_EXTENT, True)
+        elif key == 'scan_index':
+            store.scan_indices[index] = value
+        elif key == 'original_child_count':
+            store.original_child_counts[index] = value
+
+    def __delitem__(self, key: str) -> None:
+        store, index = self.store, self.index
+        if key not in self:
+            raise KeyError(key)
+        if key not in _COLUMN_KEYS:
+            self._discard_extra(key)
+        elif key == 'iso_path':
+            self._discard_extra('iso_path')
+            self._set_flag(FLAG_HAS_ISO_PATH, False)
+        elif key == 'children_loaded':
+            self._set_flag(FLAG_HAS_CHILDREN_LOADED | FLAG_CHILDREN_LOADED, False)
+        elif key == 'extent_location':
+            self._set_flag(FLAG_HAS_EXTENT, False)
+        elif key == 'scan_index':
+            store.scan_indices[index] = -1
+        elif key == 'original_child_count':
+            store.original_child_counts[index] = -1
+        else:
+            raise KeyError(f"'{key}' cannot be removed from a node")
+
+    def __contains__(self, key: object) -> bool:
+        try:
+            self[key]
+        except KeyError:
+            return False
+        return True
+
+    def __iter__(self) -> Iterator[str]:
+        for key in _ALWAYS_PRESENT:
+            yield key
+        for key in _OPTIONAL_COLUMNS:
+            if key in self:
+                yield key
+        extras = self.store.extras.get(self.index)
+        if extras:
+            for key in list(extras):
+                if key not in _COLUMN_KEYS:
+                    yield key
+
+    def __len__(self) -> int:
+        return sum(1 for _ in self)
+
+    # Nodes compare by identity like dicts in the tree are used; comparing
+    # contents would recurse through the parent back-reference.
+    def __eq__(self, other: object) -> bool:
+        return isinstance(other, NodeHandle) and other.store is self.store and other.index == self.index
+
+    def __hash__(self) -> int:
+        return hash((id(self.store), self.index))
+
+    def __repr__(self) -> str:
+        return f"<NodeHandle {self.index} {self.store.name(self.index)!r}>"
+
+    def _set_flag(self, bit: int, enabled: bool) -> None:
+        if enabled:
+            self.store.flags[self.index] |= bit
+        else:
+            self.store.flags[self.index] &= ~bit & 0xFF
+
+    def _discard_extra(self, key: str) -> None:
+        extras = self.store.extras.get(self.index)
+        if extras and key in extras:
+            del extras[key]
+            if not extras:
+                del self.store.extras[self.index]
+
+
+class ChildList(MutableSequence):
+    """The 'children' list of a NodeHandle; a view onto the store's child index array."""
+
+    __slots__ = ('store', 'owner')
+
+    def __init__(self, store: NodeStore, owner: int) -> None:
+        self.store = store
+        # Index of the node whose children these are ('index' is the list method)
+        self.owner = owner
+
+    def _indices(self, create: bool = False) -> Optional[array]:
+        indices = self.store.children.get(self.owner)
+        if indices is None and create:
+            indices = self.store.children[self.owner] = array('i')
+        return indices
+
+    def __len__(self) -> int:
+        indices = self._indices()
+        return len(indices) if indices is not None else 0
+
+    def __getitem__(self, position: Any) -> Any:
+        indices = self._indices()
+        if isinstance(position, slice):
+            return [self.store.handle(i) for i in (indices[position] if indices is not None else [])]
+        if indices is None:
+            raise IndexError("list index out of range")
+        return self.store.handle(indices[position])
+
+    def __setitem__(self, position: Any, value: Any) -> None:
+        indices = self._indices(create=True)
+        if isinstance(position, slice):
+            indices[position] = array('i', [self.store.adopt(child, self.owner) for child in value])
+        else:
+            indices[position] = self.store.adopt(value, self.owner)
+
+    def __delitem__(self, position: Any) -> None:
+        indices = self._indices()
+        if indices is None:
+            raise IndexError("list assignment index out of range")
+        del indices[position]
+
+    def insert(self, position: int, value: Any) -> None:
+        self._indices(create=True).insert(position, self.store.adopt(value, self.owner))
+
+    def __iter__(self) -> Iterator[NodeHandle]:
+        indices = self._indices()
+        if indices is None:
+            return iter(())
+        handle = self.store.handle
+        return (handle(i) for i in list(indices))
+
+    def __eq__(self, other: object) -> bool:
+        if isinstance(other, (list, tuple, ChildList)):
+            return list(self) == list(other)
+        return NotImplemented
+
+    def __repr__(self) -> str:
+        return repr(list(self))
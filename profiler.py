@@ -0,0 +1,196 @@
+"""
+Timing and counters for the load, build, write and extract paths.
+
+Profiling is off unless enable() was called (the --profile option of both
+entry points). While it is off, phase(), timed() and count() only check a
+module global, so they can stay in hot paths.
+
+  phases     wall time and number of calls per named phase; phases nest, and
+             each one's time includes that of the phases inside it
+  counters   totals such as bytes_read, bytes_written and files
+  report()   the above, with the run's wall time, peak RSS and the read and
+             write throughput, as a JSON-serializable dict
+  trace()    every phase as a Chrome trace event ("X", microseconds), for
+             chrome://tracing or Perfetto
+
+ThroughputMeter gives the live rate of a running operation from its
+progress callbacks, e.g. for the GUI status bar.
+"""
+
+import functools
+import json
+import os
+import sys
+import threading
+import time
+from collections import deque
+from contextlib import nullcontext
+from typing import Any, Callable, Deque, Dict, List, Optional, Tuple
+
+try:
+    import resource
+except ImportError:  # Windows
+    resource = None
+
+# Spans kept for the trace; later ones are only counted (see Profiler.dropped_spans)
+TRACE_MAX_SPANS = 100000
+
+_NULL_PHASE = nullcontext()
+_active: Optional['Profiler'] = None
+
+
+def peak_rss() -> Optional[int]:
+    """Returns the peak resident set size of this process in bytes, or None where it is not known."""
+    if resource is None:
+        return None
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # Kilobytes everywhere except on macOS
+    return peak if sys.platform == 'darwin' else peak * 1024
+
+
+class _Phase:
+    __slots__ = ('profiler', 'name', 'start')
+
+    def __init__(self, profiler: 'Profiler', name: str) -> None:
+        self.profiler = profiler
+        self.name = name
+
+    def __enter__(self) -> None:
+        self.start = time.perf_counter()
+
+    def __exit__(self, *exc_info: Any) -> None:
+        self.profiler._record(self.name, self.start, time.perf_counter())
+
+
+class Profiler:
+    """Phase times and counters of one run; thread-safe."""
+
+    def __init__(self) -> None:
+        self.started: float = time.perf_counter()
+        self.phases: Dict[str, List[float]] = {}  # name: [seconds, calls]
+        self.counters: Dict[str, int] = {}
+        self.dropped_spans: int = 0
+        self._spans: List[Tuple[str, float, float, int]] = []
+        self._lock = threading.Lock()
+
+    def phase(self, name: str) -> _Phase:
+        """Returns a context manager that times one call of the phase."""
+        return _Phase(self, name)
+
+    def count(self, name: str, amount: int = 1) -> None:
+        with self._lock:
+            self.counters[name] = self.counters.get(name, 0) + amount
+
+    def _record(self, name: str, start: float, end: float) -> None:
+        with self._lock:
+            totals = self.phases.setdefault(name, [0.0, 0])
+            totals[0] += end - start
+            totals[1] += 1
+            if len(self._spans) < TRACE_MAX_SPANS:
+                self._spans.append((name, start, end, threading.get_ident()))
+            else:
+                self.dropped_spans += 1
+
+    def report(self) -> Dict[str, Any]:
+        """Returns the phases, counters, peak RSS and throughput so far."""
+        with self._lock:
+            wall = time.perf_counter() - self.started
+            counters = dict(self.counters)
+            phases = {name: {'seconds': round(seconds, 6), 'calls': calls}
+                      for name, (seconds, calls) in sorted(self.phases.items(), key=lambda item: -item[1][0])}
+        throughput = {f"{key}_per_second": round(counters[key] / wall) if wall > 0 else 0
+                      for key in ('bytes_read', 'bytes_written') if key in counters}
+        return {
+            'wall_seconds': round(wall, 6),
+            'peak_rss_bytes': peak_rss(),
+            'phases': phases,
+            'counters': counters,
+            'throughput': throughput,
+        }
+
+    def trace(self) -> Dict[str, Any]:
+        """Returns the recorded phases in the Chrome trace event format."""
+        pid = os.getpid()
+        with self._lock:
+            spans = list(self._spans)
+            counters = dict(self.counters)
+        events = [{'name': name, 'ph': 'X', 'pid': pid, 'tid': tid,
+                   'ts': round((start - self.started) * 1e6, 3), 'dur': round((end - start) * 1e6, 3)}
+                  for name, start, end, tid in spans]
+        return {'traceEvents': events, 'displayTimeUnit': 'ms', 'otherData': {'counters': counters}}
+
+    def write(self, report_path: Optional[str] = None, trace_path: Optional[str] = None) -> None:
+        """Writes the report and the trace as JSON; '-' writes the report to stdout."""
+        if report_path == '-':
+            json.dump(self.report(), sys.stdout, indent=2)
+            sys.stdout.write('\n')
+        elif report_path:
+            with open(report_path, 'w', encoding='utf-8') as f:
+                json.dump(self.report(), f, indent=2)
+        if trace_path:
+            with open(trace_path, 'w', encoding='utf-8') as f:
+                json.dump(self.trace(), f)
+
+
+def enable() -> Profiler:
+    """Starts profiling with a new Profiler and returns it."""
+    global _active
+    _active = Profiler()
+    return _active
+
+
+def disable() -> Optional[Profiler]:
+    """Stops profiling and returns the profiler that was active."""
+    global _active
+    profiler, _active = _active, None
+    return profiler
+
+
+def active() -> Optional[Profiler]:
+    return _active
+
+
+def phase(name: str):
+    """Times a block as one call of the phase, if profiling is on."""
+    profiler = _active
+    return _NULL_PHASE if profiler is None else _Phase(profiler, name)
+
+
+def timed(name: str) -> Callable:
+    """Decorator that times every call of a function as the phase."""
+    def decorate(function: Callable) -> Callable:
+        @functools.wraps(function)
+        def wrapper(*args: Any, **kwargs: Any) -> Any:
+            profiler = _active
+            if profiler is None:
+                return function(*args, **kwargs)
+            with _Phase(profiler, name):
+                return function(*args, **kwargs)
+        return wrapper
+    return decorate
+
+
+def count(name: str, amount: int = 1) -> None:
+    """Adds to a counter, if profiling is on."""
+    profiler = _active
+    if profiler is not None:
+        profiler.count(name, amount)
+
+
+class ThroughputMeter:
+    """Bytes per second of a running operation over its last few seconds."""
+
+    def __init__(self, window: float = 2.0) -> None:
+        self.window = window
+        self._samples: Deque[Tuple[float, int]] = deque()
+
+    def update(self, done: int) -> float:
+        """Adds a progress sample (bytes done so far) and returns the current rate."""
+        now = time.monotonic()
+        samples = self._samples
+        samples.append((now, done))
+        while len(samples) > 2 and now - samples[0][0] > self.window:
+            samples.popleft()
+        (first_time, first_done), (last_time, last_done) = samples[0], samples[-1]
+        elapsed = last_time - first_time
+        return (last_done - first_done) / elapsed if elapsed > 0 else 0.0
@@ -0,0 +1,295 @@
+"""
+Disc ripping.
+
+DiscRipper copies an optical drive (or any block device or file) to an image
+file. The size to copy is read from the device itself. A reader thread fills
+large sector-aligned buffers, with O_DIRECT where the device supports it,
+while the calling thread writes and hashes the buffer read before, so the
+drive is never left waiting for the disk.
+
+Reads that fail are retried one sector at a time. Sectors that still cannot
+be read are written as zeros and listed in DiscRipper.bad_sectors.
+"""
+
+import errno
+import logging
+import mmap
+import os
+import queue
+import threading
+import time
+from typing import Callable, Dict, Iterable, List, Optional
+
+from checksums import MultiHasher
+from constants import ISO_BLOCK_SIZE
+
+try:
+    import fcntl
+except ImportError:  # Windows
+    fcntl = None
+
+logger = logging.getLogger(__name__)
+
+# Bytes requested per read; a multiple of both the sector and the page size
+RIP_READ_SIZE = 2 * 1024 * 1024
+# Buffers in flight between the reader and the writer
+RIP_BUFFERS = 2
+# Attempts per sector once a read has failed
+RIP_RETRIES = 3
+
+# ioctl returning the size of a Linux block device in bytes
+_BLKGETSIZE64 = 0x80081272
+
+
+def disc_capacity(fd: int) -> int:
+    """
+    Returns the size in bytes of an open device or file, or 0 if it cannot be told.
+    """
+    try:
+        size = os.lseek(fd, 0, os.SEEK_END)
+        if size > 0:
+            return size
+    except OSError:
+        pass
+    if fcntl is not None:
+        try:
+            buffer = bytearray(8)
+            fcntl.ioctl(fd, _BLKGETSIZE64, buffer)
+            return int.from_bytes(buffer, 'little')
+        except OSError:
+            pass
+    return 0
+
+
+def _read_into(fd: int, view: memoryview, offset: int) -> int:
+    if hasattr(os, 'preadv'):
+        return os.preadv(fd, [view], offset)
+    data = os.pread(fd, len(view), offset)
+    view[:len(data)] = data
+    return len(data)
+
+
+class DiscRipper:
+    """
+    Copies a disc to an image file; see the module docstring.
+
+    run() blocks until the copy is complete; progress_callback and cancel()
+    may be used from other threads.
+    """
+
+    def __init__(self, source: str, destination: str, algorithms: Iterable[str] = (),
+                 progress_callback: Optional[Callable[[int, int], None]] = None,
+                 read_size: int = RIP_READ_SIZE, retries: int = RIP_RETRIES,
+                 sector_size: int = ISO_BLOCK_SIZE) -> None:
+        """
+        Args:
+            source (str): The device (e.g. /dev/sr0) or file to read.
+            destination (str): The image file to write.
+            algorithms (iterable): Checksums to compute of the image while it is written.
+            progress_callback: Called as (bytes_done, bytes_total); bytes_total is 0 if unknown.
+            read_size (int): Bytes per read; rounded down to whole sectors.
+            retries (int): Attempts per sector after a failed read.
+            sector_size (int): The device's sector size.
+        """
+        self.source = source
+        self.destination = destination
+        self.algorithms: List[str] = list(algorithms)
+        self.progress_callback = progress_callback
+        self.sector_size = sector_size
+        self.read_size = max(sector_size, read_size - read_size % sector_size)
+        self.retries = max(1, retries)
+        self.bytes_total = 0
+        self.bytes_done = 0
+        # Sector numbers that could not be read and were written as zeros
+        self.bad_sectors: List[int] = []
+        self.checksums: Dict[str, str] = {}
+        self.started_at: Optional[float] = None
+        self._cancelled = threading.Event()
+        self._direct = False
+
+    def cancel(self) -> None:
+        """Requests cancellation; run() raises InterruptedError once reading stops."""
+        self._cancelled.set()
+
+    @property
+    def bytes_per_second(self) -> float:
+        if not self.started_at:
+            return 0.0
+        elapsed = time.monotonic() - self.started_at
+        return self.bytes_done / elapsed if elapsed > 0 else 0.0
+
+    def seconds_remaining(self) -> Optional[float]:
+        """Estimated time left, or None until it can be told."""
+        rate = self.bytes_per_second
+        if not self.bytes_total or not rate:
+            return None
+        return max(0.0, (self.bytes_total - self.bytes_done) / rate)
+
+    def run(self) -> None:
+        """
+        Copies the whole source to the destination.
+
+        Raises:
+            InterruptedError: If cancel() was called; the partial image is removed.
+            IOError: If the source cannot be opened or the image cannot be written.
+        """
+        fd = self._open_source()
+        hasher = MultiHasher(self.algorithms) if self.algorithms else None
+        # Each buffer is an anonymous mapping, so it is page aligned as O_DIRECT requires.
+        buffers = [mmap.mmap(-1, self.read_size) for _ in range(RIP_BUFFERS)]
+        free: queue.Queue = queue.Queue()
+        filled: queue.Queue = queue.Queue()
+        for buffer in buffers:
+            free.put(buffer)
+        errors: List[BaseException] = []
+
+        self.bytes_total = disc_capacity(fd)
+        self.bytes_done = 0
+        self.bad_sectors = []
+        self.started_at = time.monotonic()
+        logger.info(f"Ripping {self.source} ({self.bytes_total} bytes) to {self.destination}"
+                    f"{' with O_DIRECT' if self._direct else ''}")
+        self._report_progress()
+
+        reader = threading.Thread(target=self._read_loop, args=(fd, free, filled, errors),
+                                  name="DiscRipperReader", daemon=True)
+        reader.start()
+        finished = False
+        try:
+            with open(self.destination, 'wb') as out:
+                while True:
+                    item = filled.get()
+                    if item is None:
+                        break
+                    buffer, length = item
+                    # The hashing threads keep the chunk, so it must not be the reusable buffer.
+                    chunk = buffer[:length]
+                    free.put(buffer)
+                    out.write(chunk)
+                    if hasher:
+                        hasher.update(chunk)
+                    self.bytes_done += length
+                    self._report_progress()
+            finished = True
+        except OSError as e:
+            raise IOError(f"Could not write {self.destination}: {e}") from e
+        finally:
+            if not finished:
+                # Hand the buffers back until the reader has seen the cancellation.
+                self._cancelled.set()
+                while (item := filled.get()) is not None:
+                    free.put(item[0])
+            reader.join()
+            os.close(fd)
+            if errors or self._cancelled.is_set():
+                if hasher:
+                    hasher.close()
+                self._remove_partial()
+
+        if errors:
+            raise IOError(f"Could not read {self.source}: {errors[0]}") from errors[0]
+        if self._cancelled.is_set():
+            raise InterruptedError("Ripping cancelled by user")
+        if hasher:
+            self.checksums = hasher.hexdigests()
+        if self.bad_sectors:
+            logger.warning(f"{len(self.bad_sectors)} unreadable sector(s) were written as zeros")
+        logger.info(f"Ripped {self.bytes_done} bytes at {self.bytes_per_second / 1e6:.1f} MB/s")
+
+    def write_bad_sector_map(self, path: str) -> None:
+        """Writes the unreadable sectors to a text file, one sector number per line."""
+        with open(path, 'w', encoding='utf-8') as f:
+            f.write(f"# Unreadable {self.sector_size}-byte sectors of {self.source}\n")
+            f.writelines(f"{sector}\n" for sector in self.bad_sectors)
+
+    def _open_source(self) -> int:
+        flags = os.O_RDONLY | getattr(os, 'O_BINARY', 0)
+        direct = getattr(os, 'O_DIRECT', 0)
+        if direct:
+            try:
+                fd = os.open(self.source, flags | direct)
+                self._direct = True
+                return fd
+            except OSError as e:
+                if e.errno != errno.EINVAL:
+                    raise IOError(f"Could not open {self.source}: {e}") from e
+        try:
+            return os.open(self.source, flags)
+        except OSError as e:
+            raise IOError(f"Could not open {self.source}: {e}") from e
+
+    def _reopen_buffered(self, fd: int) -> int:
+        """Replaces an O_DIRECT descriptor that the device refuses to read from."""
+        logger.debug(f"O_DIRECT reads failed on {self.source}; using buffered reads")
+        new_fd = os.open(self.source, os.O_RDONLY | getattr(os, 'O_BINARY', 0))
+        os.dup2(new_fd, fd)
+        os.close(new_fd)
+        self._direct = False
+        return fd
+
+    def _read_loop(self, fd: int, free: queue.Queue, filled: queue.Queue,
+                   errors: List[BaseException]) -> None:
+        """Reader thread: fills free buffers in order and hands them to the writer."""
+        try:
+            offset = 0
+            total = self.bytes_total
+            while not self._cancelled.is_set() and (not total or offset < total):
+                buffer = free.get()
+                want = min(self.read_size, total - offset) if total else self.read_size
+                length = self._read_chunk(fd, memoryview(buffer)[:want], offset)
+                if not length:
+                    break
+                filled.put((buffer, length))
+                offset += length
+                if length < want:
+                    break
+        except BaseException as e:
+            errors.append(e)
+            self._cancelled.set()
+        finally:
+            filled.put(None)
+
+    def _read_chunk(self, fd: int, view: memoryview, offset: int) -> int:
+        """Reads one chunk, or as much of it as the device has; falls back to sectors on errors."""
+        try:
+            return _read_into(fd, view, offset)
+        except OSError as e:
+            if e.errno == errno.EINVAL and self._direct:
+                self._reopen_buffered(fd)
+                return self._read_chunk(fd, view, offset)
+            logger.warning(f"Read of {len(view)} bytes at {offset} failed ({e}); retrying by sector")
+
+        size = self.sector_size
+        done = 0
+        while done < len(view) and not self._cancelled.is_set():
+            sector = view[done:done + size]
+            length = self._read_sector(fd, sector, offset + done)
+            if length is None:
+                sector[:] = bytes(len(sector))
+                self.bad_sectors.append((offset + done) // size)
+                length = len(sector)
+            elif length < len(sector):
+                return done + length
+            done += length
+        return done
+
+    def _read_sector(self, fd: int, view: memoryview, offset: int) -> Optional[int]:
+        """Reads one sector with retries; returns None if it stays unreadable."""
+        for attempt in range(self.retries):
+            try:
+                return _read_into(fd, view, offset)
+            except OSError as e:
+                logger.debug(f"Sector {offset // self.sector_size}, attempt {attempt + 1}: {e}")
+        return None
+
+    def _remove_partial(self) -> None:
+        if os.path.exists(self.destination):
+            try:
+                os.remove(self.destination)
+                logger.info(f"Removed partial output file: {self.destination}")
+            except OSError as e:
+                logger.error(f"Failed to remove partial output file: {e}")
+
+    def _report_progress(self) -> None:
+        if self.progress_callback:
+            self.progress_callback(self.bytes_done, self.bytes_total)
@@ -0,0 +1,307 @@
+"""
+Shared scheduler for the background jobs of every open image.
+
+Loads, saves, extractions, conversions, checksums and rips all run as Jobs on
+one JobScheduler: a bounded pool of worker threads, fed in priority order.
+
+  devices      a job names the paths it reads and writes; each job holds the
+               devices those are on while it runs. Jobs that share a device run
+               one after another, while jobs on different devices run side by
+               side, so a checksum and a save on the same disk no longer fight
+               over its heads.
+  priorities   among the jobs that could run, the highest priority goes first
+               (PRIORITY_INTERACTIVE before PRIORITY_NORMAL before
+               PRIORITY_BACKGROUND), then the longest waiting. A queued job
+               skips ahead of a higher-priority one only if that one's devices
+               are busy.
+  progress     a job reports (done, total) through Job.report(); listeners
+               added with on_progress() are called with the job.
+  cancelling   Job.cancel() drops a queued job, or asks a running one to stop:
+               callbacks added with on_cancel() are called (e.g. an engine's
+               cancel()), and the job's function can poll is_cancelled().
+
+A job's function is called with the Job itself as its only argument. The
+windows of the GUI share shared_scheduler(), so the jobs of every open image
+are weighed against each other.
+"""
+
+import itertools
+import logging
+import os
+import stat
+import threading
+from typing import Any, Callable, Dict, FrozenSet, Iterable, List, Optional, Set, Tuple
+
+from constants import SCHEDULER_WORKERS
+
+logger = logging.getLogger(__name__)
+
+PRIORITY_INTERACTIVE = 0
+PRIORITY_NORMAL = 1
+PRIORITY_BACKGROUND = 2
+
+QUEUED = 'queued'
+RUNNING = 'running'
+FINISHED = 'finished'
+FAILED = 'failed'
+CANCELLED = 'cancelled'
+
+Listener = Callable[['Job'], None]
+
+_shared: Optional['JobScheduler'] = None
+_shared_lock = threading.Lock()
+
+
+def shared_scheduler() -> 'JobScheduler':
+    """Returns the process-wide scheduler, created with SCHEDULER_WORKERS on first use."""
+    global _shared
+    with _shared_lock:
+        if _shared is None:
+            _shared = JobScheduler(SCHEDULER_WORKERS)
+        return _shared
+
+
+def device_of(path: str) -> Any:
+    """
+    Returns an identifier of the device a path is on.
+
+    Paths that do not exist yet (e.g. an output file) count as being on the
+    device of their closest existing parent; block devices such as disc drives
+    are devices of their own.
+    """
+    path = os.path.abspath(path)
+    while True:
+        try:
+            stats = os.stat(path)
+        except OSError:
+            parent = os.path.dirname(path)
+            if parent == path:
+                return path
+            path = parent
+            continue
+        if stat.S_ISBLK(stats.st_mode) or stat.S_ISCHR(stats.st_mode):
+            return ('rdev', stats.st_rdev)
+        return stats.st_dev
+
+
+class Job:
+    """One unit of work on a JobScheduler, with its state, progress and cancellation."""
+
+    def __init__(self, function: Callable[['Job'], Any], name: str, priority: int,
+                 devices: FrozenSet[Any]) -> None:
+        self.function = function
+        self.name = name
+        self.priority = priority
+        self.devices = devices
+        self.state: str = QUEUED
+        self.done_bytes: int = 0
+        self.total_bytes: int = 0
+        self.result: Any = None
+        self.exception: Optional[BaseException] = None
+        self._cancelled = threading.Event()
+        self._finished = threading.Event()
+        self._lock = threading.Lock()
+        self._cancel_callbacks: List[Callable[[], None]] = []
+        self._progress_listeners: List[Listener] = []
+        self._done_listeners: List[Listener] = []
+        # Whether the function was called; a job cancelled while queued never is
+        self.started: bool = False
+        # Set by the scheduler; a cancelled queued job is taken off it
+        self._scheduler: Optional['JobScheduler'] = None
+
+    def __repr__(self) -> str:
+        return f"<Job {self.name!r} {self.state}>"
+
+    def is_cancelled(self) -> bool:
+        return self._cancelled.is_set()
+
+    def done(self) -> bool:
+        return self._finished.is_set()
+
+    def wait(self, timeout: Optional[float] = None) -> bool:
+        """Waits until the job finished, failed or was cancelled; returns False on timeout."""
+        return self._finished.wait(timeout)
+
+    def cancel(self) -> None:
+        """Drops the job if it is still queued, otherwise asks it to stop."""
+        with self._lock:
+            if self._cancelled.is_set() or self._finished.is_set():
+                return
+            self._cancelled.set()
+            callbacks = list(self._cancel_callbacks)
+        for callback in callbacks:
+            try:
+                callback()
+            except Exception as e:
+                logger.error(f"Cancelling job {self.name} failed: {e}")
+        if self._scheduler is not None:
+            self._scheduler._dequeue(self)
+
+    def on_cancel(self, callback: Callable[[], None]) -> None:
+        """Calls callback when the job is cancelled, right away if it already was."""
+        with self._lock:
+            if not self._cancelled.is_set():
+                self._cancel_callbacks.append(callback)
+                return
+        callback()
+
+    def on_progress(self, listener: Listener) -> None:
+        self._progress_listeners.append(listener)
+
+    def on_done(self, listener: Listener) -> None:
+        """Calls listener with the job once it is done, right away if it already is."""
+        with self._lock:
+            if not self._finished.is_set():
+                self._done_listeners.append(listener)
+                return
+        listener(self)
+
+    def report(self, done: int, total: int) -> None:
+        """Records the job's progress and tells its progress listeners."""
+        self.done_bytes, self.total_bytes = done, total
+        for listener in self._progress_listeners:
+            listener(self)
+
+    def _finish(self, state: str) -> None:
+        with self._lock:
+            self.state = state
+            self._finished.set()
+            listeners = list(self._done_listeners)
+        for listener in listeners:
+            try:
+                listener(self)
+            except Exception as e:
+                logger.error(f"Done listener of job {self.name} failed: {e}")
+
+
+class JobScheduler:
+    """Runs Jobs on a bounded pool of threads, one job per device at a time; thread-safe."""
+
+    def __init__(self, max_workers: int = SCHEDULER_WORKERS) -> None:
+        """
+        Args:
+            max_workers (int): The most jobs that run at once.
+        """
+        self.max_workers = max(1, max_workers)
+        self._queue: List[Tuple[int, int, Job]] = []  # (priority, sequence, job)
+        self._sequence = itertools.count()
+        self._running: Set[Job] = set()
+        self._busy_devices: Dict[Any, Job] = {}
+        self._threads: List[threading.Thread] = []
+        self._idle = 0
+        self._shutdown = False
+        self._condition = threading.Condition()
+
+    def submit(self, function: Callable[[Job], Any], name: str = 'job', paths: Iterable[Optional[str]] = (),
+               priority: int = PRIORITY_NORMAL) -> Job:
+        """
+        Queues function(job) to run once a worker and the devices of paths are free.
+
+        Args:
+            function (callable): The work; called with the Job.
+            name (str): Shown in logs and job lists.
+            paths (iterable): Files and directories the job reads or writes; None entries are ignored.
+            priority (int): One of the PRIORITY_ constants.
+
+        Returns:
+            Job: The queued job.
+
+        Raises:
+            RuntimeError: If the scheduler was shut down.
+        """
+        devices = frozenset(device_of(path) for path in paths if path)
+        job = Job(function, name, priority, devices)
+        job._scheduler = self
+        with self._condition:
+            if self._shutdown:
+                raise RuntimeError("The scheduler has been shut down")
+            self._queue.append((priority, next(self._sequence), job))
+            # Idle workers take one queued job each; a job beyond those would wait
+            # for a worker even when its devices are free
+            if len(self._queue) > self._idle and len(self._threads) < self.max_workers:
+                thread = threading.Thread(target=self._work, name=f"scheduler-{len(self._threads)}", daemon=True)
+                self._threads.append(thread)
+                thread.start()
+            self._condition.notify_all()
+        logger.debug(f"Queued job {name} (priority {priority}) on {len(devices)} device(s)")
+        return job
+
+    def jobs(self) -> List[Job]:
+        """The running jobs, then the queued ones in the order they are considered."""
+        with self._condition:
+            return list(self._running) + [job for _, _, job in sorted(self._queue)]
+
+    def cancel_all(self) -> None:
+        for job in self.jobs():
+            job.cancel()
+
+    def shutdown(self, wait: bool = True, cancel: bool = False) -> None:
+        """Stops accepting jobs; the workers exit once the queue is empty."""
+        if cancel:
+            self.cancel_all()
+        with self._condition:
+            self._shutdown = True
+            self._condition.notify_all()
+            threads = list(self._threads)
+        if wait:
+            for thread in threads:
+                if thread is not threading.current_thread():
+                    thread.join()
+
+    def _dequeue(self, job: Job) -> None:
+        """Takes a cancelled job off the queue, if it has not started."""
+        with self._condition:
+            for entry in self._queue:
+                if entry[2] is job:
+                    self._queue.remove(entry)
+                    break
+            else:
+                return
+            self._condition.notify_all()
+        job._finish(CANCELLED)
+
+    def _next_runnable(self) -> Optional[Job]:
+        """Takes the first queued job whose devices are all free off the queue; holds the lock."""
+        for entry in sorted(self._queue):
+            job = entry[2]
+            if not any(device in self._busy_devices for device in job.devices):
+                self._queue.remove(entry)
+                return job
+        return None
+
+    def _work(self) -> None:
+        while True:
+            with self._condition:
+                job = self._next_runnable()
+                while job is None:
+                    if self._shutdown and not self._queue:
+                        return
+                    self._idle += 1
+                    self._condition.wait()
+                    self._idle -= 1
+                    job = self._next_runnable()
+                self._running.add(job)
+                for device in job.devices:
+                    self._busy_devices[device] = job
+                job.state = RUNNING
+                job.started = True
+
+            state = FINISHED
+            try:
+                job.result = job.function(job)
+                if job.is_cancelled():
+                    state = CANCELLED
+            except InterruptedError as e:
+                job.exception = e
+                state = CANCELLED
+            except Exception as e:
+                logger.exception(f"Job {job.name} failed: {e}")
+                job.exception = e
+                state = FAILED
+            finally:
+                with self._condition:
+                    self._running.discard(job)
+                    for device in job.devices:
+                        self._busy_devices.pop(device, None)
+                    self._condition.notify_all()
+            job._finish(state)
@@ -0,0 +1,349 @@
+"""
+Name search over the directory tree.
+
+SearchIndex keeps a trigram index of every file and folder name, so a
+search only visits the names that share the rarest trigram of the query
+instead of walking the whole tree. It is built from the image as it was
+read (ISOCore.iter_image_listing()), which needs no tree nodes and can run
+on a worker thread even when the tree is loaded lazily. Edits reach it as
+tree listener events (see iso_logic.TreeListener).
+
+Entries come in two kinds:
+  - image entries, one per record of the opened image, stored as a name
+    and a parent entry; they are turned into nodes only when they match.
+  - live entries, for nodes whose name differs from what the image holds,
+    i.e. added and renamed nodes, or every node when there is no image.
+
+Stale image entries (removed or renamed nodes) are not deleted; resolve()
+drops them when their node cannot be found under its current name.
+"""
+
+import logging
+import posixpath
+import re
+import threading
+from array import array
+from typing import Any, Callable, Dict, Iterator, List, Optional, Tuple
+
+from constants import SEARCH_INDEX_CHUNK_SIZE
+
+logger = logging.getLogger(__name__)
+
+TreeNode = Any
+
+_GRAM = 3
+# Candidate count above which search() intersects the two rarest posting lists
+_INTERSECT_THRESHOLD = 1024
+# Parent values of entries that are not image entries
+_ROOT = -1
+_LIVE = -2
+
+
+def _trigrams(text: str) -> set:
+    return {text[i:i + _GRAM] for i in range(len(text) - _GRAM + 1)}
+
+
+class SearchQuery:
+    """
+    A compiled search: a substring, or a regular expression with use_regex.
+
+    Raises:
+        re.error: If use_regex is set and the pattern is invalid.
+    """
+
+    def __init__(self, text: str, case_sensitive: bool = False, use_regex: bool = False) -> None:
+        self.text = text
+        self.case_sensitive = case_sensitive
+        self.use_regex = use_regex
+        self._pattern = re.compile(text, 0 if case_sensitive else re.IGNORECASE) if use_regex else None
+        self._needle = text if case_sensitive else text.lower()
+
+    def trigrams(self) -> set:
+        """Trigrams every matching name contains; empty if the query cannot use the index."""
+        if self.use_regex:
+            return set()
+        return _trigrams(self.text.lower())
+
+    def matches(self, name: str) -> bool:
+        if self._pattern is not None:
+            return bool(self._pattern.search(name))
+        return self._needle in (name if self.case_sensitive else name.lower())
+
+
+class SearchIndex:
+    """
+    Trigram index over the names in one ISOCore's directory tree.
+
+    reset() must be called whenever the core's tree is replaced; the index
+    is usable once build() has run. search() may be called from any thread,
+    resolve() and the listener methods only where the tree is edited.
+    """
+
+    def __init__(self, core: Any) -> None:
+        self.core = core
+        self._lock = threading.Lock()
+        self._ready = threading.Event()
+        # Whether image entries cover the records of the opened image
+        self._image_backed = False
+        self._clear()
+        core.tree_listeners.append(self)
+
+    def _clear(self) -> None:
+        self._names: List[Optional[str]] = []
+        self._parents = array('i')
+        self._grams: Dict[str, array] = {}
+        self._live: Dict[int, TreeNode] = {}
+        self._live_entries: Dict[int, int] = {}
+        # Removed entries in total, and those still listed in the posting lists
+        self._removed = 0
+        self._dead = 0
+
+    # --- Building -----------------------------------------------------------
+
+    def reset(self) -> None:
+        """
+        Empties the index for the core's current tree.
+
+        If the tree does not come from an image, its nodes are indexed right
+        away and the index is ready; otherwise build() must run next.
+        """
+        with self._lock:
+            self._clear()
+            self._image_backed = self.core.has_image_listing()
+        if self._image_backed:
+            self._ready.clear()
+            return
+        root = self.core.directory_tree
+        if root is not None:
+            with self._lock:
+                self._add_live_subtree(root, include_root=False)
+        self._ready.set()
+
+    def build(self, is_cancelled: Optional[Callable[[], bool]] = None) -> bool:
+        """
+        Indexes the opened image's records. Safe to run on a worker thread.
+
+        Returns:
+            bool: True if the index was completed, False if cancelled or failed.
+        """
+        if self._ready.is_set():
+            return True
+        try:
+            batch: List[Tuple[str, int]] = []
+            # Entry of each directory path; only directories are kept here
+            dir_entries: Dict[str, int] = {'/': _ROOT}
+            for path, dirs, files in self.core.iter_image_listing():
+                if is_cancelled and is_cancelled():
+                    return False
+                parent = dir_entries.pop(path, None)
+                if parent is None:
+                    continue
+                with self._lock:
+                    for name in dirs:
+                        dir_entries[posixpath.join(path, name)] = self._add(name, parent)
+                if files:
+                    batch.extend((name, parent) for name in files)
+                if len(batch) >= SEARCH_INDEX_CHUNK_SIZE:
+                    self._add_batch(batch)
+                    batch = []
+            self._add_batch(batch)
+        except Exception as e:
+            logger.error(f"Could not build the search index: {e}")
+            return False
+        self._ready.set()
+        logger.info(f"Search index built ({len(self._names)} entries)")
+        return True
+
+    def wait_ready(self, timeout: Optional[float] = None) -> bool:
+        """Blocks until the index is usable; returns False on timeout."""
+        return self._ready.wait(timeout)
+
+    def _add_batch(self, batch: List[Tuple[str, int]]) -> None:
+        """Adds image entries; the same as calling _add() for each, with the lookups hoisted."""
+        with self._lock:
+            names, parents, grams = self._names, self._parents, self._grams
+            entry = len(names)
+            for name, parent in batch:
+                names.append(name)
+                parents.append(parent)
+                folded = name.lower()
+                for gram in {folded[i:i + _GRAM] for i in range(len(folded) - _GRAM + 1)}:
+                    posting = grams.get(gram)
+                    if posting is None:
+                        grams[gram] = array('i', (entry,))
+                    else:
+                        posting.append(entry)
+                entry += 1
+
+    def _add(self, name: str, parent: int) -> int:
+        entry = len(self._names)
+        self._names.append(name)
+        self._parents.append(parent)
+        grams = self._grams
+        for gram in _trigrams(name.lower()):
+            posting = grams.get(gram)
+            if posting is None:
+                grams[gram] = array('i', (entry,))
+            else:
+                posting.append(entry)
+        return entry
+
+    def _compact(self) -> None:
+        """Rebuilds the posting lists without the entries of removed live nodes."""
+        grams: Dict[str, array] = {}
+        names = self._names
+        for gram, posting in self._grams.items():
+            kept = array('i', (entry for entry in posting if names[entry] is not None))
+            if kept:
+                grams[gram] = kept
+        self._grams = grams
+        self._dead = 0
+
+    # --- Live entries -------------------------------------------------------
+
+    def _needs_live_entry(self, node: TreeNode) -> bool:
+        if not self._image_backed:
+            return True
+        iso_path = node.get('iso_path')
+        return not iso_path or posixpath.basename(iso_path) != node.get('name')
+
+    def _add_live(self, node: TreeNode) -> None:
+        entry = self._add(node.get('name', ''), _LIVE)
+        self._live[entry] = node
+        self._live_entries[id(node)] = entry
+
+    def _remove_live(self, node: TreeNode) -> None:
+        entry = self._live_entries.pop(id(node), None)
+        if entry is not None:
+            del self._live[entry]
+            self._names[entry] = None
+            self._removed += 1
+            self._dead += 1
+
+    def _loaded_subtree(self, node: TreeNode, include_root: bool = True) -> Iterator[TreeNode]:
+        """Yields a node and its descendants without reading unloaded directories."""
+        if include_root:
+            yield node
+        stack = [node]
+        while stack:
+            for child in stack.pop().get('children', []):
+                yield child
+                if child.get('is_directory'):
+                    stack.append(child)
+
+    def _add_live_subtree(self, node: TreeNode, include_root: bool = True) -> None:
+        for current in self._loaded_subtree(node, include_root):
+            if id(current) not in self._live_entries and self._needs_live_entry(current):
+                self._add_live(current)
+
+    def node_inserted(self, parent: TreeNode, node: TreeNode) -> None:
+        with self._lock:
+            self._add_live_subtree(node)
+
+    def node_removed(self, parent: TreeNode, node: TreeNode) -> None:
+        with self._lock:
+            for current in self._loaded_subtree(node):
+                self._remove_live(current)
+            if self._dead > SEARCH_INDEX_CHUNK_SIZE and self._dead > len(self):
+                self._compact()
+
+    def node_changed(self, node: TreeNode) -> None:
+        with self._lock:
+            self._remove_live(node)
+            if self._needs_live_entry(node):
+                self._add_live(node)
+
+    # --- Queries ------------------------------------------------------------
+
+    def search(self, query: SearchQuery, is_cancelled: Optional[Callable[[], bool]] = None) -> Optional[List[int]]:
+        """
+        Finds the entries whose indexed name matches a query.
+
+        Queries with a trigram look only at the rarest trigram's entries;
+        shorter substrings and regular expressions check every name.
+
+        Returns:
+            list: Entry numbers to pass to resolve(), or None if cancelled.
+        """
+        # Entries are only ever appended, so the scan itself runs without the lock.
+        with self._lock:
+            names = self._names
+            grams = query.trigrams()
+            if grams:
+                postings = [self._grams.get(gram) for gram in grams]
+                if not all(postings):
+                    return []
+                postings.sort(key=len)
+                candidates = postings[0][:]
+                if len(postings) > 1 and len(candidates) > _INTERSECT_THRESHOLD:
+                    # Only worth the set when the rarest trigram is still common.
+                    common = set(candidates).intersection(postings[1])
+                    candidates = array('i', sorted(common))
+            else:
+                candidates = range(len(names))
+
+        matches: List[int] = []
+        for start in range(0, len(candidates), SEARCH_INDEX_CHUNK_SIZE):
+            if is_cancelled and is_cancelled():
+                return None
+            chunk = candidates[start:start + SEARCH_INDEX_CHUNK_SIZE]
+            if query.use_regex:
+                matches.extend(e for e in chunk if names[e] is not None and query.matches(names[e]))
+            elif query.case_sensitive:
+                needle = query.text
+                matches.extend(e for e in chunk if names[e] is not None and needle in names[e])
+            else:
+                # The common case, kept free of per-name method calls
+                needle = query.text.lower()
+                matches.extend(e for e in chunk if names[e] is not None and needle in names[e].lower())
+        return matches
+
+    def resolve(self, entries: List[int], query: SearchQuery) -> List[TreeNode]:
+        """
+        Turns search results into the matching nodes of the current tree,
+        reading directories that were not loaded yet.
+
+        Results whose node was removed, or renamed so that it no longer
+        matches, are dropped.
+        """
+        root = self.core.directory_tree
+        if root is None:
+            return []
+        nodes: List[TreeNode] = []
+        seen = set()
+        # Node of each resolved image directory entry, and children of visited directories by iso_path
+        entry_nodes: Dict[int, Optional[TreeNode]] = {_ROOT: root}
+        children_by_path: Dict[int, Dict[str, TreeNode]] = {}
+
+        def image_node(entry: int) -> Optional[TreeNode]:
+            chain = []
+            while entry not in entry_nodes:
+                chain.append(entry)
+                entry = self._parents[entry]
+            node = entry_nodes[entry]
+            for current in reversed(chain):
+                if node is not None:
+                    listing = children_by_path.get(id(node))
+                    if listing is None:
+                        listing = {child.get('iso_path'): child for child in self.core.load_children(node)
+                                   if child.get('iso_path')}
+                        children_by_path[id(node)] = listing
+                    node = listing.get(posixpath.join(node.get('iso_path', '/'), self._names[current]))
+                entry_nodes[current] = node
+            return node
+
+        with self._lock:
+            for entry in entries:
+                name = self._names[entry]
+                if name is None:
+                    continue
+                parent = self._parents[entry]
+                node = self._live.get(entry) if parent == _LIVE else image_node(entry)
+                if node is None or id(node) in seen or not query.matches(node.get('name', '')):
+                    continue
+                seen.add(id(node))
+                nodes.append(node)
+        return nodes
+
+    def __len__(self) -> int:
+        return len(self._names) - self._removed
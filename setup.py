@@ -3,7 +3,7 @@
 Setup script for ISO Editor
 """
 
-from setuptools import setup, find_packages
+from setuptools import setup, find_packages, Extension
 import os
 
 # Read the long description from README
@@ -26,6 +26,15 @@ def read_requirements():
             return [line.strip() for line in f if line.strip() and not line.startswith('#')]
     return []
 
+# Optional native directory scanner; iso_scanner falls back to pycdlib without it
+isoscan_extension = Extension(
+    '_isoscan',
+    sources=['native/isoscan.cpp'],
+    language='c++',
+    extra_compile_args=['/std:c++17'] if os.name == 'nt' else ['-std=c++17', '-O2'],
+    optional=True,
+)
+
 setup(
     name='iso-editor',
     version='1.0.0',
@@ -40,7 +49,8 @@ setup(
         'Documentation': 'https://github.com/ivenhartford/ISO_editor#readme',
         'Source Code': 'https://github.com/ivenhartford/ISO_editor',
     },
-    py_modules=['ISO_edit', 'iso_logic', 'create_test_iso'],
+    py_modules=['ISO_edit', 'iso_logic', 'iso_scanner', 'node_store', 'checksums', 'index_cache', 'tree_model', 'search_index', 'ripper', 'cue_reader', 'iso_cli', 'iso_names', 'layout_planner', 'eltorito', 'profiler', 'block_cache', 'scheduler', 'create_test_iso'],
+    ext_modules=[isoscan_extension],
     python_requires='>=3.8',
     install_requires=read_requirements(),
     extras_require={
@@ -51,10 +61,15 @@ setup(
             'pylint>=2.0',
             'mypy>=0.9',
         ],
+        'fast-hash': [
+            'blake3>=0.3',
+            'xxhash>=3.0',
+        ],
     },
     entry_points={
         'console_scripts': [
             'iso-editor=ISO_edit:main',
+            'iso-editor-cli=iso_cli:main',
         ],
         'gui_scripts': [
             'iso-editor-gui=ISO_edit:main',
@@ -0,0 +1,84 @@
+import os
+from block_cache import BlockCache, CachedImageFile
+from iso_logic import ISOCore
+
+BLOCK = 4096
+
+
+def _image(tmp_path, blocks=10):
+    path = tmp_path / "image.bin"
+    data = b''.join(bytes([n]) * BLOCK for n in range(blocks)) + b'tail'
+    path.write_bytes(data)
+    return str(path), data
+
+
+def _count_reads(monkeypatch):
+    reads = []
+    original = CachedImageFile.pread
+
+    def pread(self, offset, size):
+        reads.append((offset // BLOCK, size // BLOCK))
+        return original(self, offset, size)
+    monkeypatch.setattr(CachedImageFile, 'pread', pread)
+    return reads
+
+
+def test_scattered_reads_are_coalesced_and_bounded(tmp_path, monkeypatch):
+    path, data = _image(tmp_path)
+    reads = _count_reads(monkeypatch)
+    cache = BlockCache(capacity=4 * BLOCK, block_size=BLOCK)
+    with cache.open(path) as f:
+        f.seek(BLOCK + 100)
+        assert f.read(2 * BLOCK) == data[BLOCK + 100:3 * BLOCK + 100]
+        # Blocks 1 to 3 in a single read
+        assert reads == [(1, 3)]
+        f.seek(2 * BLOCK)
+        assert f.read(10) == data[2 * BLOCK:2 * BLOCK + 10]
+        assert len(reads) == 1 and cache.hits == 1
+
+        f.seek(9 * BLOCK)
+        assert f.read() == data[9 * BLOCK:]
+        f.seek(-2, os.SEEK_END)
+        assert f.read(10) == b'il'
+        assert cache.size <= cache.capacity
+    assert f.closed
+    cache.forget(path)
+    assert cache.size == 0
+
+
+def test_sequential_reads_are_read_ahead(tmp_path, monkeypatch):
+    path, data = _image(tmp_path, blocks=64)
+    reads = _count_reads(monkeypatch)
+    cache = BlockCache(capacity=64 * BLOCK, block_size=BLOCK)
+    f = cache.open(path)
+    chunks = []
+    for offset in range(0, 16 * BLOCK, BLOCK):
+        f.seek(offset)
+        chunks.append(f.read(BLOCK))
+        for future in list(f.read_aheads):
+            future.result()
+    assert b''.join(chunks) == data[:16 * BLOCK]
+    # Only the first two reads missed; the rest was read ahead of them
+    assert cache.misses == 2 and cache.hits == 14
+    assert any(count > 1 for _, count in reads[2:])
+    f.close()
+    assert not f.read_aheads
+
+
+def test_core_reads_files_through_the_cache(tmp_path):
+    source = tmp_path / "a.bin"
+    source.write_bytes(b"a" * 100000)
+    core = ISOCore()
+    core.add_file_to_directory(str(source), core.directory_tree)
+    output = tmp_path / "out.iso"
+    core.save_iso(str(output), use_joliet=True, use_rock_ridge=True)
+
+    cache = BlockCache(capacity=1024 * 1024)
+    loaded = ISOCore(block_cache=cache)
+    loaded.load_iso(str(output))
+    assert cache.misses > 0 and cache.size > 0
+    node = next(child for child in loaded.directory_tree['children'] if not child['is_directory'])
+    assert loaded.get_file_data(node) == b"a" * 100000
+    image_file = loaded._image_file
+    loaded.close_iso()
+    assert image_file.closed and loaded._image_file is None
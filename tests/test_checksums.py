@@ -0,0 +1,88 @@
+import hashlib
+import pytest
+import checksums
+from checksums import HashingWriter, MultiHasher, available_algorithms, hash_file
+from iso_logic import ISOCore
+
+
+@pytest.mark.parametrize("mapped", [True, False])
+def test_hash_file_matches_hashlib(tmp_path, monkeypatch, mapped):
+    """Digests from the threaded single pass must match hashlib run sequentially."""
+    data = bytes(range(256)) * 40000 + b"tail"
+    path = tmp_path / "image.iso"
+    path.write_bytes(data)
+    if not mapped:
+        monkeypatch.setattr(checksums, '_map_file', lambda f, size: None)
+
+    progress = []
+    results = hash_file(str(path), ['md5', 'sha1', 'sha256'], chunk_size=1024 * 1024,
+                        progress_callback=lambda done, total: progress.append((done, total)))
+
+    assert results == {
+        'md5': hashlib.md5(data).hexdigest(),
+        'sha1': hashlib.sha1(data).hexdigest(),
+        'sha256': hashlib.sha256(data).hexdigest(),
+    }
+    assert progress[-1] == (len(data), len(data))
+
+
+def test_hash_file_empty_and_cancelled(tmp_path):
+    path = tmp_path / "empty.iso"
+    path.write_bytes(b"")
+    assert hash_file(str(path), ['md5', 'sha256']) == {
+        'md5': hashlib.md5(b"").hexdigest(),
+        'sha256': hashlib.sha256(b"").hexdigest(),
+    }
+    assert hash_file(str(path), ['md5', 'sha256'], is_cancelled=lambda: True) is None
+
+
+def test_multi_hasher_unthreaded_and_optional_algorithms():
+    available = available_algorithms()
+    assert {'md5', 'sha1', 'sha256', 'blake2b'} <= set(available)
+
+    single = MultiHasher(['sha1'], threaded=False)
+    single.update(b"abc")
+    assert single.hexdigests() == {'sha1': hashlib.sha1(b"abc").hexdigest()}
+
+    with pytest.raises(ValueError):
+        MultiHasher([])
+
+
+def test_hashing_writer_handles_gaps_and_rewrites(tmp_path):
+    """Seeked-over gaps hash as zeros; rewriting hashed data falls back to re-reading."""
+    in_order = tmp_path / "in_order.bin"
+    with HashingWriter(str(in_order), ['md5', 'sha256']) as out:
+        out.write(b"head")
+        out.seek(5000)
+        out.write(bytearray(b"body"))
+        digests = out.hexdigests()
+    data = in_order.read_bytes()
+    assert data == b"head" + bytes(4996) + b"body"
+    assert digests == {'md5': hashlib.md5(data).hexdigest(), 'sha256': hashlib.sha256(data).hexdigest()}
+
+    rewritten = tmp_path / "rewritten.bin"
+    with HashingWriter(str(rewritten), ['sha1']) as out:
+        out.write(b"x" * 4096)
+        out.seek(0)
+        out.write(b"MBR!")
+        digests = out.hexdigests()
+    assert digests == {'sha1': hashlib.sha1(b"MBR!" + b"x" * 4092).hexdigest()}
+
+
+def test_save_iso_hashes_inline(tmp_path):
+    core = ISOCore()
+    source = tmp_path / "payload.bin"
+    source.write_bytes(b"payload" * 1000)
+    core.add_file_to_directory(str(source), core.directory_tree)
+    output = tmp_path / "out.iso"
+
+    digests = core.save_iso(str(output), use_joliet=True, use_rock_ridge=True,
+                            checksum_algorithms=['md5', 'sha1', 'sha256'])
+
+    data = output.read_bytes()
+    assert digests == {
+        'md5': hashlib.md5(data).hexdigest(),
+        'sha1': hashlib.sha1(data).hexdigest(),
+        'sha256': hashlib.sha256(data).hexdigest(),
+    }
+    assert core.save_iso(str(tmp_path / "plain.iso"), use_joliet=True, use_rock_ridge=True) is None
@@ -0,0 +1,106 @@
+import os
+import pytest
+from iso_logic import ISOCore, ImportEngine
+from commands import CommandHistory, AddFileCommand, RemoveNodeCommand, ImportCommand
+
+
+def _add_files(core, tmp_path, names, size=100):
+    for name in names:
+        (tmp_path / name).write_bytes(name.encode().ljust(size, b"."))
+        core.add_file_to_directory(str(tmp_path / name), core.directory_tree)
+
+
+def test_history_spills_removed_data_beyond_memory_limit(tmp_path):
+    core = ISOCore()
+    _add_files(core, tmp_path, ["a.bin", "b.bin", "c.bin"])
+    history = CommandHistory(max_memory=150)
+    a, b, c = list(core.directory_tree['children'])
+
+    assert history.execute(RemoveNodeCommand(core, a))
+    assert history.memory_usage == 100 and a['file_data'] is not None
+    # b's source changes after it was added, so its data has to go to a temporary file.
+    (tmp_path / "b.bin").write_bytes(b"changed")
+    assert history.execute(RemoveNodeCommand(core, b))
+    assert history.memory_usage == 100
+    assert a['file_data'] is None and a['file_path'] == str(tmp_path / "a.bin")
+    assert history.execute(RemoveNodeCommand(core, c))
+    assert b['file_data'] is None and b['file_path'] != str(tmp_path / "b.bin")
+    assert len(history.undo_stack) == 3
+
+    while history.undo():
+        pass
+    assert history.memory_usage == 0
+    for node in (a, b, c):
+        assert core.get_file_data(node) == node['name'].encode().ljust(100, b".")
+        assert not core.source_file_changed(node)
+
+    history.clear()
+    assert not os.path.exists(b['file_path'])
+
+
+def test_history_count_limit_and_shared_payloads(tmp_path):
+    core = ISOCore()
+    _add_files(core, tmp_path, ["a.bin"])
+    history = CommandHistory(max_history=2)
+    node = core.directory_tree['children'][0]
+
+    # The same removed file held by two commands is counted once.
+    history.execute(RemoveNodeCommand(core, node))
+    history.undo()
+    redone = history.redo_stack[-1]
+    history.redo()
+    assert history.undo_stack[-1] is redone and history.memory_usage == 100
+
+    _add_files(core, tmp_path, ["b.bin", "c.bin"])
+    for name in ("b.bin", "c.bin"):
+        history.execute(RemoveNodeCommand(core, core.find_child(core.directory_tree, name)))
+    assert len(history.undo_stack) == 2 and history.memory_usage == 200
+
+
+def test_group_coalesces_commands(tmp_path):
+    core = ISOCore()
+    history = CommandHistory()
+    for name in ("a.txt", "b.txt", "c.txt"):
+        (tmp_path / name).write_bytes(name.encode())
+    with history.group("Add 3 files"):
+        for name in ("a.txt", "b.txt", "c.txt"):
+            assert history.execute(AddFileCommand(core, str(tmp_path / name), core.directory_tree))
+    with history.group("Add nothing"):
+        pass
+
+    assert len(history.undo_stack) == 1
+    assert history.undo() == "Add 3 files"
+    assert core.directory_tree['children'] == []
+    assert history.redo() == "Add 3 files"
+    assert sorted(c['name'] for c in core.directory_tree['children']) == ["a.txt", "b.txt", "c.txt"]
+
+
+def test_import_is_one_undoable_entry(tmp_path):
+    core = ISOCore()
+    source = tmp_path / "src"
+    (source / "sub").mkdir(parents=True)
+    for i in range(20):
+        (source / "sub" / f"{i}.bin").write_bytes(b"x")
+    (source / "top.txt").write_bytes(b"new")
+    (tmp_path / "top.txt").write_bytes(b"old")
+    core.add_folder_to_directory("src", core.directory_tree)
+    src = core.directory_tree['children'][0]
+    core.add_file_to_directory(str(tmp_path / "top.txt"), src)
+    old_top = src['children'][0]
+
+    engine = ImportEngine(core, [str(source)], core.directory_tree)
+    engine.scan()
+    history = CommandHistory()
+    assert history.execute(ImportCommand(core, engine, "Import directory 'src'"))
+    assert len(history.undo_stack) == 1
+    assert core.get_file_data(core.find_child(src, "top.txt")) == b"new"
+    assert len(core.find_child(src, "sub")['children']) == 20
+    # The replaced file is held by the history.
+    assert history.memory_usage == 3
+
+    assert history.undo() == "Import directory 'src'"
+    assert list(src['children']) == [old_top]
+    assert history.memory_usage == 0
+    history.redo()
+    assert core.find_child(src, "top.txt") is not old_top
+    assert core.find_child(src, "sub") is not None
@@ -0,0 +1,96 @@
+import io
+import pytest
+from iso_logic import ISOCore
+from cue_reader import TrackReader, track_modes
+
+
+def _mode1_sector(number):
+    """A raw MODE1/2352 sector whose user data starts with its sector number."""
+    data = number.to_bytes(4, 'little').ljust(2048, bytes([number % 251]))
+    return b"\x00" + b"\xff" * 10 + b"\x00" + b"\x01\x02\x03\x01" + data + b"\xee" * 288, data
+
+
+@pytest.fixture
+def mixed_image(tmp_path):
+    """A BIN with 20 MODE1/2352 sectors followed by 10 audio sectors, and its CUE sheet."""
+    raw, cooked = zip(*(_mode1_sector(i) for i in range(20)))
+    audio = b"\x22" * (10 * 2352)
+    (tmp_path / "GAME.BIN").write_bytes(b"".join(raw) + audio)
+    cue_path = tmp_path / "GAME.CUE"
+    cue_path.write_text('FILE "GAME.BIN" BINARY\n'
+                        '  TRACK 01 MODE1/2352\n    INDEX 01 00:00:00\n'
+                        '  TRACK 02 AUDIO\n    INDEX 01 00:00:20\n')
+    return str(tmp_path / "GAME.BIN"), str(cue_path), b"".join(cooked), audio
+
+
+def test_track_modes():
+    assert track_modes('FILE "A.BIN" BINARY\n  TRACK 01 mode2/2352\n  TRACK 2 AUDIO\n') == ['MODE2/2352', 'AUDIO']
+
+
+def test_reader_cooks_data_sectors(mixed_image):
+    bin_path, _, cooked, _ = mixed_image
+    with TrackReader(bin_path, 0, 20 * 2352, 'MODE1/2352') as track:
+        assert track.length == len(cooked)
+        assert track.read() == cooked
+        # Reads that straddle sector boundaries
+        track.seek(2040)
+        assert track.read(2064) == cooked[2040:4104]
+        buffer = bytearray(5000)
+        track.seek(-100, io.SEEK_END)
+        assert track.readinto(buffer) == 100 and bytes(buffer[:100]) == cooked[-100:]
+
+    with TrackReader(bin_path, 0, 20 * 2352, 'MODE1/2352', cooked=False) as track:
+        assert track.length == 20 * 2352 and track.read(16) == b"\x00" + b"\xff" * 10 + b"\x00\x01\x02\x03\x01"
+
+
+def test_iter_views_does_not_copy(mixed_image):
+    bin_path, _, cooked, _ = mixed_image
+    track = TrackReader(bin_path, 0, 20 * 2352, 'MODE1/2352')
+    track.seek(1000)
+    views = list(track.iter_views())
+    assert all(isinstance(view, memoryview) for view in views)
+    assert b"".join(views) == cooked[1000:] and track.tell() == track.length
+    del views
+    track.close()
+
+
+def test_mixed_mode_cue_sheet(mixed_image):
+    _, cue_path, cooked, audio = mixed_image
+    core = ISOCore()
+    core.load_iso(cue_path)
+    data, music = core.directory_tree['children']
+
+    assert (data['name'], data['cue_mode'], data['size']) == ('TRACK_01.iso', 'MODE1/2352', len(cooked))
+    assert (music['name'], music['cue_offset'], music['size']) == ('TRACK_02.wav', 20 * 2352, len(audio))
+    assert core.get_file_data(data) == cooked
+    assert core.get_extent_location(music) == 20
+
+    stream, size = core.open_file_stream(data)
+    assert size == len(cooked) and stream.read() == cooked
+    stream.close()
+    stream, size = core.open_file_stream(music)
+    assert stream.read() == audio
+    stream.close()
+
+
+def test_convert_data_track_to_iso(mixed_image, tmp_path):
+    _, cue_path, cooked, _ = mixed_image
+    core = ISOCore()
+    core.load_iso(cue_path)
+    progress = []
+    # Small chunks so the batches end mid-track
+    converter = core.cue_track_converter(str(tmp_path / "game.iso"),
+                                         progress_callback=lambda done, total: progress.append(done))
+    converter.chunk_size = 3 * 2048
+    converter.run()
+
+    assert (tmp_path / "game.iso").read_bytes() == cooked
+    assert progress[0] == 0 and progress[-1] == len(cooked)
+
+    converter = core.cue_track_converter(str(tmp_path / "cancelled.iso"),
+                                         progress_callback=lambda done, total: done and converter.cancel())
+    with pytest.raises(InterruptedError):
+        converter.run()
+    assert not (tmp_path / "cancelled.iso").exists()
+    with pytest.raises(ValueError):
+        core.cue_track_converter(str(tmp_path / "x.iso"), node=core.directory_tree)
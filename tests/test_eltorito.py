@@ -0,0 +1,113 @@
+import struct
+from unittest.mock import MagicMock
+import eltorito
+from iso_logic import ISOCore, IncrementalISOWriter, BootChanges
+from layout_planner import HYBRID_ALIGNMENT
+
+CATALOG, BIOS_RBA, EFI_RBA = 20, 21, 22
+
+
+def _entry(sector_count, load_rba):
+    return struct.pack('<BBHBBHI', 0x88, 0, 0, 0, 0, sector_count, load_rba).ljust(32, b'\x00')
+
+
+def _make_image(path, boot_code=b''):
+    """Writes a bare image with a boot record and a catalog with a BIOS and an EFI entry."""
+    image = bytearray(24 * 2048)
+    image[:len(boot_code)] = boot_code
+    record = 16 * 2048
+    image[record:record + 7] = b'\x00CD001\x01'
+    image[record + 7:record + 30] = b'EL TORITO SPECIFICATION'
+    struct.pack_into('<I', image, record + 71, CATALOG)
+    image[17 * 2048:17 * 2048 + 7] = b'\xffCD001\x01'
+
+    validation = bytearray(32)
+    validation[0] = 1
+    validation[30:32] = b'\x55\xaa'
+    struct.pack_into('<H', validation, 28, -sum(struct.unpack('<16H', validation)) & 0xFFFF)
+    catalog = bytes(validation) + _entry(4, BIOS_RBA) + struct.pack('<BBH', 0x91, 0xEF, 1).ljust(32, b'\x00')
+    catalog += _entry(6, EFI_RBA)
+    image[CATALOG * 2048:CATALOG * 2048 + len(catalog)] = catalog
+    path.write_bytes(bytes(image))
+
+
+def _core(image, sizes):
+    """A core for the image whose boot files have the given {extent: size}."""
+    core = ISOCore()
+    core.current_iso_path = str(image)
+    paths = {BIOS_RBA: '/BOOT/ISOLINUX.BIN', EFI_RBA: '/BOOT/EFI.IMG'}
+    core.find_path_by_extent = lambda extent, inode=None: paths.get(extent)
+    iso = MagicMock()
+    iso.get_record.side_effect = lambda iso_path: MagicMock(
+        get_data_length=lambda: sizes[next(k for k, v in paths.items() if v == iso_path)])
+    core._pycdlib_instance = iso
+    return core
+
+
+def test_read_and_patch_catalog(tmp_path):
+    image = tmp_path / "boot.iso"
+    _make_image(image)
+    with open(image, 'r+b') as fp:
+        assert eltorito.find_boot_catalog(fp) == CATALOG
+        entries = eltorito.read_boot_entries(fp, CATALOG)
+        assert [(e.platform_id, e.sector_count, e.load_rba) for e in entries] == [(0, 4, BIOS_RBA), (0xEF, 6, EFI_RBA)]
+        assert entries[0].emulation_type == 'noemul'
+        eltorito.patch_boot_entry(fp, entries[1], sector_count=8)
+        assert eltorito.read_boot_entries(fp, CATALOG)[1].sector_count == 8
+
+
+def test_hybrid_mbr_keeps_boot_code(tmp_path):
+    image = tmp_path / "boot.iso"
+    _make_image(image, boot_code=b'\xfa' * 400)
+    with open(image, 'r+b') as fp:
+        assert eltorito.has_boot_code(fp) and not eltorito.has_gpt(fp)
+        size = eltorito.write_hybrid_mbr(fp, HYBRID_ALIGNMENT, efi_partition=(EFI_RBA * 4, 6))
+    data = image.read_bytes()
+    assert size == len(data) == HYBRID_ALIGNMENT
+    assert data[:400] == b'\xfa' * 400 and data[510:512] == b'\x55\xaa'
+    first, second = data[446:462], data[462:478]
+    assert first[0] == 0x80 and first[4] == 0x17 and struct.unpack('<II', first[8:]) == (0, size // 512)
+    assert second[4] == 0xEF and struct.unpack('<II', second[8:]) == (EFI_RBA * 4, 6)
+
+    # Writing it again gives the same sector
+    with open(image, 'r+b') as fp:
+        eltorito.write_hybrid_mbr(fp, HYBRID_ALIGNMENT, efi_partition=(EFI_RBA * 4, 6))
+    assert image.read_bytes()[:512] == data[:512]
+
+
+def test_boot_changes_fall_back_when_they_need_a_new_catalog(tmp_path):
+    image = tmp_path / "boot.iso"
+    _make_image(image)
+    core = _core(image, {BIOS_RBA: 2048, EFI_RBA: 3000})
+    new_efi = tmp_path / "efi.img"
+
+    new_efi.write_bytes(b'e' * 3500)
+    core.efi_boot_image_path = str(new_efi)
+    changes = core._collect_boot_changes(make_hybrid=False)
+    # The old entry loaded the whole image, so the new one does too
+    assert [(p.iso_path, p.size, p.sector_count) for p in changes.patches] == [('/BOOT/EFI.IMG', 3500, 7)]
+
+    new_efi.write_bytes(b'e' * 5000)
+    assert "does not fit" in core._collect_boot_changes(make_hybrid=False)
+    core.efi_boot_image_path = None
+    # pycdlib's own boot code would be needed for the BIOS entry
+    assert "no MBR boot code" in core._collect_boot_changes(make_hybrid=True)
+    core.boot_emulation_type = 'floppy'
+    core.boot_image_path = str(new_efi)
+    assert "emulation" in core._collect_boot_changes(make_hybrid=False)
+
+
+def test_isohybrid_is_added_to_a_copy(tmp_path):
+    image = tmp_path / "boot.iso"
+    _make_image(image, boot_code=b'\xfa' * 400)
+    original = image.read_bytes()
+    core = _core(image, {BIOS_RBA: 2048, EFI_RBA: 3000})
+    changes = core._collect_boot_changes(make_hybrid=True)
+    assert changes.efi_partition == (EFI_RBA * 4, 6)
+
+    output = tmp_path / "hybrid.iso"
+    IncrementalISOWriter(core, [], str(output), boot_changes=changes).write()
+    data = output.read_bytes()
+    assert image.read_bytes() == original
+    assert len(data) == HYBRID_ALIGNMENT and data[16 * 2048:] == original[16 * 2048:] + bytes(len(data) - len(original))
+    assert data[446 + 4] == 0x17 and data[462 + 4] == 0xEF
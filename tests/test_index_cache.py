@@ -0,0 +1,68 @@
+import os
+import pytest
+from iso_logic import ISOCore
+from index_cache import IndexCache
+import iso_scanner
+
+
+def _tree_rows(node, prefix=''):
+    """Flattens a loaded tree into (path, is_directory, size, date) tuples."""
+    rows = []
+    for child in sorted(node['children'], key=lambda n: n['name']):
+        path = f"{prefix}/{child['name']}"
+        rows.append((path, child['is_directory'], 0 if child['is_directory'] else child['size'], child['date']))
+        if child['is_directory']:
+            rows.extend(_tree_rows(child, path))
+    return rows
+
+
+@pytest.fixture
+def saved_image(tmp_path):
+    """Saves a small image with a nested directory and returns its path."""
+    core = ISOCore()
+    (tmp_path / "readme.txt").write_bytes(b"hello")
+    core.add_file_to_directory(str(tmp_path / "readme.txt"), core.directory_tree)
+    core.add_folder_to_directory("docs", core.directory_tree)
+    (tmp_path / "guide.txt").write_bytes(b"guide")
+    core.add_file_to_directory(str(tmp_path / "guide.txt"), core.directory_tree['children'][-1])
+    output = tmp_path / "cached.iso"
+    core.save_iso(str(output), use_joliet=True, use_rock_ridge=True)
+    return str(output)
+
+
+def test_reopen_uses_cached_index(saved_image, tmp_path, monkeypatch):
+    cache = IndexCache(str(tmp_path / "cache"))
+    first = ISOCore(index_cache=cache)
+    first.load_iso(saved_image)
+    assert cache.contains(saved_image)
+
+    # A cache hit must not need the native scanner or pycdlib to build the tree.
+    monkeypatch.setattr(iso_scanner, 'scan_image', lambda path: pytest.fail("image was rescanned"))
+    second = ISOCore(index_cache=cache)
+    second.load_iso(saved_image, lazy=True)
+    assert second._pycdlib is None
+    second.load_all_children()
+    assert _tree_rows(second.directory_tree) == _tree_rows(first.directory_tree)
+    assert second.volume_descriptor['volume_id'] == first.volume_descriptor['volume_id']
+    assert second.extracted_boot_info == first.extracted_boot_info
+
+    guide = second.directory_tree
+    for name in ('docs', 'guide.txt'):
+        guide = next(c for c in second.load_children(guide) if c['name'].lower().startswith(name.split('.')[0]))
+    assert second.get_file_data(guide) == b"guide"
+
+
+def test_changed_image_misses_cache(saved_image, tmp_path):
+    cache = IndexCache(str(tmp_path / "cache"))
+    ISOCore(index_cache=cache).load_iso(saved_image)
+    assert cache.contains(saved_image)
+
+    stat = os.stat(saved_image)
+    os.utime(saved_image, ns=(stat.st_atime_ns, stat.st_mtime_ns + 1_000_000_000))
+    assert not cache.contains(saved_image)
+
+    # Warming re-indexes it; unreadable files are skipped without raising.
+    (tmp_path / "broken.iso").write_bytes(b"not an image")
+    cache.warm([saved_image, str(tmp_path / "broken.iso"), str(tmp_path / "missing.iso")])
+    assert cache.contains(saved_image)
+    assert not cache.contains(str(tmp_path / "broken.iso"))
@@ -0,0 +1,83 @@
+import json
+import os
+import subprocess
+import sys
+import pytest
+import iso_cli
+from iso_cli import SourceCache, load_manifest, run_builds, shared_files
+from iso_logic import ISOCore
+
+
+@pytest.fixture
+def sources(tmp_path):
+    """Two source trees that share common/."""
+    for tree in ("base", "extras"):
+        (tmp_path / tree / "docs").mkdir(parents=True)
+        (tmp_path / tree / "docs" / f"{tree}.txt").write_bytes(tree.encode() * 10)
+    (tmp_path / "common").mkdir()
+    (tmp_path / "common" / "license.txt").write_bytes(b"MIT" * 100)
+    return tmp_path
+
+
+def _names(node):
+    return sorted(child['name'] for child in node['children'])
+
+
+def test_cli_does_not_import_qt():
+    code = "import sys, iso_cli; print('PySide6' in sys.modules)"
+    result = subprocess.run([sys.executable, "-c", code], capture_output=True, text=True,
+                            cwd=os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+    assert result.stdout.strip() == "False", result.stderr
+
+
+def test_manifest_builds_in_parallel(sources):
+    manifest = sources / "builds.json"
+    manifest.write_text(json.dumps({"jobs": [
+        {"output": "base.iso", "sources": ["base", "common"], "volume_id": "BASE"},
+        {"output": "full.iso", "sources": ["base", "extras", "common"]},
+    ]}))
+    jobs = load_manifest(str(manifest))
+    assert jobs[0]['output'] == str(sources / "base.iso")
+    assert sorted(os.path.basename(path) for path in shared_files(jobs)) == ["base.txt", "license.txt"]
+
+    assert run_builds(jobs, workers=2) == 0
+    core = ISOCore()
+    core.load_iso(str(sources / "full.iso"))
+    assert _names(core.directory_tree) == ["docs", "license.txt"]
+    assert _names(core.find_node_by_path("/docs")) == ["base.txt", "extras.txt"]
+    assert core.get_file_data(core.find_node_by_path("/license.txt")) == b"MIT" * 100
+
+
+def test_source_cache_needs_matching_files(sources):
+    core = ISOCore()
+    path = str(sources / "common" / "license.txt")
+    cache = SourceCache()
+    cache.preload([path, str(sources / "missing.txt")])
+    assert len(cache) == 1
+
+    engine = iso_cli.ImportEngine(core, [str(sources / "common")], core.directory_tree)
+    engine.run()
+    assert cache.fill(core.directory_tree) == 1
+    assert core.find_node_by_path("/common/license.txt")['file_data'] == b"MIT" * 100
+
+    # A file edited after it was cached is read from disk instead.
+    os.utime(path, ns=(0, 0))
+    core = ISOCore()
+    iso_cli.ImportEngine(core, [path], core.directory_tree).run()
+    assert cache.fill(core.directory_tree) == 0
+
+
+def test_edit_extract_and_verify(sources, tmp_path, capsys):
+    image = str(tmp_path / "base.iso")
+    assert iso_cli.main(["build", str(sources / "base"), "-o", image]) == 0
+    assert iso_cli.main(["add", image, str(sources / "common"), "--to", "/docs"]) == 0
+    assert iso_cli.main(["remove", image, "/docs/base.txt"]) == 0
+    assert iso_cli.main(["remove", image, "/nothing"]) == 1
+
+    assert iso_cli.main(["extract", image, "/docs", "-d", str(tmp_path / "out")]) == 0
+    assert sorted(os.listdir(tmp_path / "out")) == ["common"]
+    assert (tmp_path / "out" / "common" / "license.txt").read_bytes() == b"MIT" * 100
+
+    assert iso_cli.main(["verify", image]) == 0
+    assert iso_cli.main(["verify", image, "--expect", "md5=0"]) == 1
+    assert "MISMATCH" in capsys.readouterr().out
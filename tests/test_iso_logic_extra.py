@@ -356,3 +356,649 @@ def test_find_non_compliant_filenames(iso_core, tmp_path):
     # Sort lists for consistent comparison
     expected = sorted(["bad-name", "another bad name", "file.with.dots"])
     assert sorted(non_compliant) == expected
+
+def test_resave_streams_original_files(iso_core, tmp_path, monkeypatch):
+    """Test that re-saving a loaded ISO streams original files instead of reading them into memory."""
+    original_content = b"original file content" * 100
+    original_path = tmp_path / "original.txt"
+    original_path.write_bytes(original_content)
+    iso_core.add_file_to_directory(str(original_path), iso_core.directory_tree)
+    first_iso_path = tmp_path / "first.iso"
+    iso_core.save_iso(str(first_iso_path), use_joliet=True, use_rock_ridge=True)
+
+    loaded_core = ISOCore()
+    loaded_core.load_iso(str(first_iso_path))
+
+    added_path = tmp_path / "added.txt"
+    added_path.write_bytes(b"added")
+    loaded_core.add_file_to_directory(str(added_path), loaded_core.directory_tree)
+
+    def fail_get_file_data(node):
+        raise AssertionError(f"get_file_data() should not be used while saving ({node['name']})")
+    monkeypatch.setattr(loaded_core, 'get_file_data', fail_get_file_data)
+
+    second_iso_path = tmp_path / "second.iso"
+    loaded_core.save_iso(str(second_iso_path), use_joliet=True, use_rock_ridge=True)
+
+    verify_core = ISOCore()
+    verify_core.load_iso(str(second_iso_path))
+    nodes = {c['name']: c for c in verify_core.directory_tree['children']}
+    assert verify_core.get_file_data(nodes['original.txt']) == original_content
+    assert verify_core.get_file_data(nodes['added.txt']) == b"added"
+
+def test_resave_over_source_image(iso_core, tmp_path):
+    """Test that saving over the image being edited keeps the original file data intact."""
+    original_content = b"keep me" * 1000
+    original_path = tmp_path / "keep.txt"
+    original_path.write_bytes(original_content)
+    iso_core.add_file_to_directory(str(original_path), iso_core.directory_tree)
+    iso_path = tmp_path / "inplace.iso"
+    iso_core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True)
+
+    loaded_core = ISOCore()
+    loaded_core.load_iso(str(iso_path))
+    loaded_core.add_folder_to_directory("NEW_DIR", loaded_core.directory_tree)
+    loaded_core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True)
+
+    assert not [p for p in os.listdir(tmp_path) if p.endswith('.tmp')]
+
+    verify_core = ISOCore()
+    verify_core.load_iso(str(iso_path))
+    nodes = {c['name']: c for c in verify_core.directory_tree['children']}
+    assert 'NEW_DIR' in nodes
+    assert verify_core.get_file_data(nodes['keep.txt']) == original_content
+
+def test_save_as_back_over_the_loaded_image(iso_core, tmp_path, monkeypatch):
+    """Test that A -> Save As B -> Save As A is detected as saving over the image being read."""
+    original_content = b"keep me" * 1000
+    original_path = tmp_path / "keep.txt"
+    original_path.write_bytes(original_content)
+    iso_core.add_file_to_directory(str(original_path), iso_core.directory_tree)
+    a_path, b_path = tmp_path / "a.iso", tmp_path / "b.iso"
+    iso_core.save_iso(str(a_path), use_joliet=True, use_rock_ridge=True)
+
+    loaded_core = ISOCore()
+    loaded_core.load_iso(str(a_path))
+    loaded_core.add_folder_to_directory("NEW_DIR", loaded_core.directory_tree)
+    loaded_core.save_iso(str(b_path), use_joliet=True, use_rock_ridge=True)
+    assert loaded_core.current_iso_path == str(b_path)
+    assert loaded_core.reads_from(str(a_path)) and not loaded_core.reads_from(str(b_path))
+
+    replaced = []
+    real_replace = os.replace
+    monkeypatch.setattr(os, 'replace', lambda src, dst: replaced.append(dst) or real_replace(src, dst))
+    loaded_core.save_iso(str(a_path), use_joliet=True, use_rock_ridge=True)
+    # Written to a temporary file first, then moved over the source
+    assert replaced == [str(a_path)]
+
+    verify_core = ISOCore()
+    verify_core.load_iso(str(a_path))
+    nodes = {c['name']: c for c in verify_core.directory_tree['children']}
+    assert 'NEW_DIR' in nodes
+    assert verify_core.get_file_data(nodes['keep.txt']) == original_content
+
+def _make_saved_iso(tmp_path, files):
+    """Saves an ISO with the given {name: bytes} files and returns its loaded core."""
+    core = ISOCore()
+    for name, content in files.items():
+        path = tmp_path / name
+        path.write_bytes(content)
+        core.add_file_to_directory(str(path), core.directory_tree)
+    iso_path = tmp_path / "base.iso"
+    core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True)
+
+    loaded_core = ISOCore()
+    loaded_core.load_iso(str(iso_path))
+    return loaded_core, iso_path
+
+def test_incremental_save_patches_overwritten_file(tmp_path, monkeypatch):
+    """Test that overwriting a file with same-sized data is saved without a rebuild."""
+    import iso_logic
+    loaded_core, _ = _make_saved_iso(tmp_path, {"a.txt": b"a" * 3000, "b.txt": b"b" * 100})
+
+    replacement_dir = tmp_path / "replacement"
+    replacement_dir.mkdir()
+    replacement = replacement_dir / "a.txt"
+    replacement.write_bytes(b"z" * 2500)
+    loaded_core.add_file_to_directory(str(replacement), loaded_core.directory_tree)
+
+    def fail_build(self):
+        raise AssertionError("ISOBuilder.build() should not run for an incremental save")
+    monkeypatch.setattr(iso_logic.ISOBuilder, 'build', fail_build)
+
+    output_path = tmp_path / "patched.iso"
+    loaded_core.save_iso(str(output_path), use_joliet=True, use_rock_ridge=True, incremental=True)
+
+    verify_core = ISOCore()
+    verify_core.load_iso(str(output_path))
+    nodes = {c['name']: c for c in verify_core.directory_tree['children']}
+    assert nodes['a.txt']['size'] == 2500
+    assert verify_core.get_file_data(nodes['a.txt']) == b"z" * 2500
+    assert verify_core.get_file_data(nodes['b.txt']) == b"b" * 100
+
+def test_incremental_save_checks_sources_before_patching(tmp_path):
+    """Test that an in-place incremental save leaves the image untouched if a replacement changed on disk."""
+    from iso_logic import SourceFileChangedError
+    loaded_core, iso_path = _make_saved_iso(tmp_path, {"a.bin": b"a" * 100000, "b.bin": b"b" * 100000})
+    original = iso_path.read_bytes()
+
+    replacement_dir = tmp_path / "replacement"
+    replacement_dir.mkdir()
+    for name in ("a.bin", "b.bin"):
+        (replacement_dir / name).write_bytes(b"z" * 99000)
+        loaded_core.add_file_to_directory(str(replacement_dir / name), loaded_core.directory_tree)
+    assert loaded_core._collect_incremental_changes(True, True, True, False) is not None
+    (replacement_dir / "b.bin").write_bytes(b"y" * 98000)
+
+    with pytest.raises(SourceFileChangedError) as raised:
+        loaded_core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True, incremental=True)
+    assert raised.value.paths == [str(replacement_dir / "b.bin")]
+    assert iso_path.read_bytes() == original
+
+def test_incremental_saves_read_back_what_they_patched(tmp_path, monkeypatch):
+    """Test that patched files are read from the saved image afterwards and not patched again."""
+    import iso_logic
+    loaded_core, iso_path = _make_saved_iso(tmp_path, {"a.bin": b"a" * 100000, "b.bin": b"b" * 100000})
+    replacement_dir = tmp_path / "replacement"
+    replacement_dir.mkdir()
+
+    def replace(name, content):
+        (replacement_dir / name).write_bytes(content)
+        loaded_core.add_file_to_directory(str(replacement_dir / name), loaded_core.directory_tree)
+        return next(c for c in loaded_core.directory_tree['children'] if c['name'] == name)
+
+    patched = []
+    original_replace = iso_logic.IncrementalISOWriter._replace_file
+    def record_replace(self, iso, paths_by_inode, path, stream, length):
+        patched.append(length)
+        return original_replace(self, iso, paths_by_inode, path, stream, length)
+    monkeypatch.setattr(iso_logic.IncrementalISOWriter, '_replace_file', record_replace)
+
+    # Save As a copy, then back over the loaded image
+    a_node = replace("a.bin", b"z" * 99000)
+    copy_path = tmp_path / "copy.iso"
+    loaded_core.save_iso(str(copy_path), use_joliet=True, use_rock_ridge=True, incremental=True)
+    (replacement_dir / "a.bin").unlink()
+    assert not a_node['is_new'] and loaded_core.reads_from(str(copy_path))
+    assert loaded_core.get_file_data(a_node) == b"z" * 99000
+
+    b_node = replace("b.bin", b"y" * 99000)
+    loaded_core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True, incremental=True)
+    assert patched == [99000, 99000]
+    assert loaded_core.reads_from(str(iso_path))
+
+    # In place, with a cancel that comes too late to stop it
+    a_node = replace("a.bin", b"w" * 99000)
+    assert loaded_core.get_file_data(b_node) == b"y" * 99000
+
+    def cancel(done, total, opaque):
+        raise InterruptedError("cancelled")
+    loaded_core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True, incremental=True,
+                         progress_callback=cancel)
+    assert patched == [99000, 99000, 99000] and not loaded_core.iso_modified
+    assert loaded_core.get_file_data(a_node) == b"w" * 99000
+
+    verify_core = ISOCore()
+    verify_core.load_iso(str(iso_path))
+    nodes = {c['name']: c for c in verify_core.directory_tree['children']}
+    assert verify_core.get_file_data(nodes['a.bin']) == b"w" * 99000
+    assert verify_core.get_file_data(nodes['b.bin']) == b"y" * 99000
+
+def test_incremental_save_falls_back_for_new_files(tmp_path):
+    """Test that an incremental save rebuilds the image when entries are added."""
+    loaded_core, iso_path = _make_saved_iso(tmp_path, {"a.txt": b"a" * 10})
+
+    new_file = tmp_path / "new.txt"
+    new_file.write_bytes(b"new")
+    loaded_core.add_file_to_directory(str(new_file), loaded_core.directory_tree)
+    assert loaded_core._collect_incremental_changes(True, True, True, False) is None
+
+    loaded_core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True, incremental=True)
+
+    verify_core = ISOCore()
+    verify_core.load_iso(str(iso_path))
+    names = sorted(c['name'] for c in verify_core.directory_tree['children'])
+    assert names == ['a.txt', 'new.txt']
+
+def test_clone_file(tmp_path):
+    """Test that clone_file produces an identical copy."""
+    from iso_logic import clone_file
+    src = tmp_path / "src.bin"
+    src.write_bytes(os.urandom(3 * 1024 * 1024 + 17))
+    dst = tmp_path / "dst.bin"
+    dst.write_bytes(b"stale contents that must be replaced")
+    clone_file(str(src), str(dst))
+    assert dst.read_bytes() == src.read_bytes()
+
+def test_lazy_load_reads_directories_on_demand(iso_core, tmp_path):
+    """Test that a lazily loaded tree only lists a directory when it is first accessed."""
+    iso_core.add_folder_to_directory("OUTER", iso_core.directory_tree)
+    outer = iso_core.directory_tree['children'][0]
+    iso_core.add_folder_to_directory("INNER", outer)
+    inner = outer['children'][0]
+    nested_path = tmp_path / "deep.txt"
+    nested_path.write_bytes(b"deep content")
+    iso_core.add_file_to_directory(str(nested_path), inner)
+    iso_path = tmp_path / "lazy.iso"
+    iso_core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True)
+
+    lazy_core = ISOCore()
+    lazy_core.load_iso(str(iso_path), lazy=True)
+    root = lazy_core.directory_tree
+    assert [c['name'] for c in root['children']] == ['OUTER']
+    lazy_outer = root['children'][0]
+    assert lazy_outer['children_loaded'] is False
+    assert lazy_outer['children'] == []
+
+    lazy_inner = lazy_core.load_children(lazy_outer)[0]
+    assert lazy_inner['name'] == 'INNER'
+    assert lazy_inner['children_loaded'] is False
+
+    deep_node = lazy_core.load_children(lazy_inner)[0]
+    assert deep_node['name'] == 'deep.txt'
+    assert lazy_core.get_file_data(deep_node) == b"deep content"
+
+def test_save_lazy_tree_includes_unvisited_directories(iso_core, tmp_path):
+    """Test that saving a lazily loaded tree keeps the contents of directories never opened."""
+    iso_core.add_folder_to_directory("DIR", iso_core.directory_tree)
+    dir_node = iso_core.directory_tree['children'][0]
+    inner_path = tmp_path / "inner.txt"
+    inner_path.write_bytes(b"inner")
+    iso_core.add_file_to_directory(str(inner_path), dir_node)
+    iso_path = tmp_path / "source.iso"
+    iso_core.save_iso(str(iso_path), use_joliet=True, use_rock_ridge=True)
+
+    lazy_core = ISOCore()
+    lazy_core.load_iso(str(iso_path), lazy=True)
+    lazy_core.add_folder_to_directory("NEW_DIR", lazy_core.directory_tree)
+    output_path = tmp_path / "output.iso"
+    lazy_core.save_iso(str(output_path), use_joliet=True, use_rock_ridge=True)
+
+    verify_core = ISOCore()
+    verify_core.load_iso(str(output_path))
+    nodes = {c['name']: c for c in verify_core.directory_tree['children']}
+    assert set(nodes) == {'DIR', 'NEW_DIR'}
+    assert [c['name'] for c in nodes['DIR']['children']] == ['inner.txt']
+    assert verify_core.get_file_data(nodes['DIR']['children'][0]) == b"inner"
+
+def test_extraction_engine_extracts_tree(tmp_path):
+    """Test that the extraction engine writes a whole tree with byte-accurate progress."""
+    from iso_logic import ExtractionEngine
+    loaded_core, _ = _make_saved_iso(tmp_path, {"big.bin": os.urandom(300000), "small.txt": b"small"})
+    loaded_core.add_folder_to_directory("new_dir", loaded_core.directory_tree)
+    new_file = tmp_path / "inner.txt"
+    new_file.write_bytes(b"inner")
+    new_dir = next(c for c in loaded_core.directory_tree['children'] if c['name'] == 'new_dir')
+    loaded_core.add_file_to_directory(str(new_file), new_dir)
+
+    progress = []
+    out_dir = tmp_path / "out"
+    engine = ExtractionEngine(loaded_core, loaded_core.directory_tree, str(out_dir),
+                              progress_callback=lambda done, total: progress.append((done, total)),
+                              workers=3, chunk_size=4096)
+    engine.run()
+
+    assert (out_dir / "big.bin").read_bytes() == (tmp_path / "big.bin").read_bytes()
+    assert (out_dir / "small.txt").read_bytes() == b"small"
+    assert (out_dir / "new_dir" / "inner.txt").read_bytes() == b"inner"
+    total = 300000 + len(b"small") + len(b"inner")
+    assert progress[0] == (0, total)
+    assert progress[-1] == (total, total)
+
+def test_extraction_engine_cancel_removes_partial_files(tmp_path):
+    """Test that a cancelled extraction stops and leaves no partial files."""
+    from iso_logic import ExtractionEngine
+    loaded_core, _ = _make_saved_iso(tmp_path, {"big.bin": b"x" * 200000})
+    out_dir = tmp_path / "out"
+
+    def cancel_after_first_chunk(done, total):
+        if done:
+            engine.cancel()
+
+    engine = ExtractionEngine(loaded_core, loaded_core.directory_tree, str(out_dir),
+                              progress_callback=cancel_after_first_chunk, chunk_size=4096)
+    with pytest.raises(InterruptedError):
+        engine.run()
+    assert not (out_dir / "big.bin").exists()
+
+
+def test_find_path_by_extent(iso_core, tmp_path, monkeypatch):
+    """The extent index is filled during a full ISO 9660 load and built on demand otherwise."""
+    for name in ("a.txt", "b.txt"):
+        (tmp_path / name).write_bytes(name.encode() * 100)
+        iso_core.add_file_to_directory(str(tmp_path / name), iso_core.directory_tree)
+    output = tmp_path / "plain.iso"
+    iso_core.save_iso(str(output), use_joliet=False, use_rock_ridge=False, use_udf=False)
+
+    import iso_scanner
+    monkeypatch.setattr(iso_scanner, 'scan_image', lambda file_path: None)
+    full = ISOCore()
+    full.load_iso(str(output))
+    assert full._walk_key == 'iso_path'
+    assert full._extent_index is not None
+    for node in full.directory_tree['children']:
+        assert full.find_path_by_extent(full.get_extent_location(node)) == node['iso_path']
+
+    lazy = ISOCore()
+    lazy.load_iso(str(output), lazy=True)
+    assert lazy._extent_index is None
+    node = lazy.directory_tree['children'][1]
+    assert lazy.find_path_by_extent(lazy.get_extent_location(node)) == node['iso_path']
+    assert lazy.find_path_by_extent(10 ** 9) is None
+
+def test_tree_listeners_follow_edits(iso_core, tmp_path):
+    """Edits made through the core and the commands are reported to tree listeners."""
+    from commands import RemoveNodeCommand, RenameNodeCommand
+
+    class Recorder:
+        def __init__(self):
+            self.events = []
+        def node_inserted(self, parent, node):
+            self.events.append(('inserted', parent['name'], node['name']))
+        def node_removed(self, parent, node):
+            self.events.append(('removed', parent['name'], node['name']))
+        def node_changed(self, node):
+            self.events.append(('changed', node['name']))
+
+    recorder = Recorder()
+    iso_core.tree_listeners.append(recorder)
+    root = iso_core.directory_tree
+    file_path = tmp_path / "a.txt"
+    file_path.write_bytes(b"a")
+
+    iso_core.add_folder_to_directory("docs", root)
+    iso_core.add_file_to_directory(str(file_path), root)
+    iso_core.add_file_to_directory(str(file_path), root)  # replaces the first copy
+    node = root['children'][-1]
+    rename = RenameNodeCommand(node, "a.txt", "b.txt", core=iso_core)
+    rename.execute()
+    remove = RemoveNodeCommand(iso_core, node)
+    remove.execute()
+    remove.undo()
+
+    assert recorder.events == [
+        ('inserted', '/', 'docs'),
+        ('inserted', '/', 'a.txt'),
+        ('removed', '/', 'a.txt'),
+        ('inserted', '/', 'a.txt'),
+        ('changed', 'b.txt'),
+        ('removed', '/', 'b.txt'),
+        ('inserted', '/', 'b.txt'),
+    ]
+    assert root['children'][-1] is node
+
+    # A failing listener must not break the edit.
+    class Broken:
+        def node_inserted(self, parent, node):
+            raise RuntimeError("boom")
+    iso_core.tree_listeners.append(Broken())
+    iso_core.add_folder_to_directory("more", root)
+    assert root['children'][-1]['name'] == "more"
+
+def test_import_engine_imports_tree_without_reading_files(iso_core, tmp_path):
+    """The import engine builds the whole tree in one insertion and reads file data only on save."""
+    from iso_logic import ImportEngine
+    source = tmp_path / "build"
+    (source / "bin" / "deep").mkdir(parents=True)
+    (source / "readme.txt").write_bytes(b"readme")
+    (source / "bin" / "tool").write_bytes(b"tool")
+    (source / "bin" / "deep" / "data.bin").write_bytes(b"data" * 100)
+    os.symlink(source / "readme.txt", source / "link.txt")
+    loose = tmp_path / "loose.txt"
+    loose.write_bytes(b"loose")
+
+    events = []
+    class Recorder:
+        def node_inserted(self, parent, node):
+            events.append(node['name'])
+        def node_removed(self, parent, node):
+            events.append('-' + node['name'])
+    iso_core.tree_listeners.append(Recorder())
+
+    progress = []
+    engine = ImportEngine(iso_core, [str(source), str(loose)], iso_core.directory_tree,
+                          progress_callback=lambda files, folders: progress.append((files, folders)), workers=2)
+    assert engine.run() == 4
+    assert sorted(events) == ['build', 'loose.txt']
+    assert progress[-1] == (4, 3)
+
+    build = next(c for c in iso_core.directory_tree['children'] if c['name'] == 'build')
+    assert sorted(c['name'] for c in build['children']) == ['bin', 'readme.txt']
+    tool = next(c for c in next(c for c in build['children'] if c['name'] == 'bin')['children'] if c['name'] == 'tool')
+    assert tool['file_data'] is None and tool['size'] == 4
+    assert iso_core.get_file_data(tool) == b"tool"
+
+    # Importing again merges into the existing folder and replaces the files in it.
+    (source / "bin" / "tool").write_bytes(b"tool v2")
+    events.clear()
+    ImportEngine(iso_core, [str(source)], iso_core.directory_tree).run()
+    assert len([c for c in iso_core.directory_tree['children'] if c['name'] == 'build']) == 1
+    assert sorted(events) == ['-data.bin', '-readme.txt', '-tool', 'data.bin', 'readme.txt', 'tool']
+
+    output = tmp_path / "imported.iso"
+    iso_core.save_iso(str(output), use_joliet=True, use_rock_ridge=True)
+    verify = ISOCore()
+    verify.load_iso(str(output))
+    build = next(c for c in verify.directory_tree['children'] if c['name'].lower() == 'build')
+    bin_dir = next(c for c in build['children'] if c['name'].lower() == 'bin')
+    tool = next(c for c in bin_dir['children'] if c['name'].lower().startswith('tool'))
+    assert verify.get_file_data(tool) == b"tool v2"
+
+def test_import_engine_cancel_attaches_nothing(iso_core, tmp_path):
+    from iso_logic import ImportEngine
+    source = tmp_path / "src"
+    source.mkdir()
+    (source / "a.txt").write_bytes(b"a")
+    engine = ImportEngine(iso_core, [str(source)], iso_core.directory_tree)
+    engine.cancel()
+    with pytest.raises(InterruptedError):
+        engine.scan()
+    assert iso_core.directory_tree['children'] == []
+
+def test_added_files_are_kept_by_path_within_budget(tmp_path):
+    """Small files are inlined until the budget is used up; later changes to by-path files fail the save."""
+    from iso_logic import SourceFileChangedError
+    core = ISOCore(inline_budget=10)
+    for name, data in (("a.txt", b"aaaaaa"), ("b.txt", b"bbbbbb")):
+        (tmp_path / name).write_bytes(data)
+        core.add_file_to_directory(str(tmp_path / name), core.directory_tree)
+    a, b = core.directory_tree['children']
+    assert a['file_data'] == b"aaaaaa" and core.inline_bytes == 6
+    assert b['file_data'] is None and b['file_path'] == str(tmp_path / "b.txt")
+    assert core.get_file_data(b) == b"bbbbbb"
+    assert not core.source_file_changed(b)
+
+    core.save_iso(str(tmp_path / "ok.iso"), use_joliet=True, use_rock_ridge=True)
+    verify = ISOCore()
+    verify.load_iso(str(tmp_path / "ok.iso"))
+    saved = next(c for c in verify.directory_tree['children'] if c['name'].lower().startswith('b'))
+    assert verify.get_file_data(saved) == b"bbbbbb"
+
+    # Inline data is a snapshot; files kept by path must still match their size and mtime.
+    (tmp_path / "a.txt").write_bytes(b"changed")
+    (tmp_path / "b.txt").write_bytes(b"changed")
+    assert not core.source_file_changed(a)
+    assert core.source_file_changed(b)
+    with pytest.raises(SourceFileChangedError) as info:
+        core.save_iso(str(tmp_path / "stale.iso"), use_joliet=True, use_rock_ridge=True)
+    assert info.value.paths == [str(tmp_path / "b.txt")]
+
+
+@pytest.mark.parametrize("compact_tree", [False, True])
+def test_inline_budget_is_given_back(tmp_path, compact_tree):
+    """Inlined files that leave the tree by removal, replacement or undo no longer use the budget."""
+    from commands import AddFileCommand
+    core = ISOCore(compact_tree=compact_tree, inline_budget=10)
+    replacement_dir = tmp_path / "replacement"
+    replacement_dir.mkdir()
+    for path, data in ((tmp_path / "a.txt", b"aaaaaa"), (replacement_dir / "a.txt", b"zzzz"),
+                       (tmp_path / "b.txt", b"bbbbbb")):
+        path.write_bytes(data)
+
+    core.add_file_to_directory(str(tmp_path / "a.txt"), core.directory_tree)
+    core.add_file_to_directory(str(replacement_dir / "a.txt"), core.directory_tree)
+    assert core.inline_bytes == 4
+    core.remove_node(core.directory_tree['children'][0])
+    assert core.inline_bytes == 0
+
+    command = AddFileCommand(core, str(tmp_path / "b.txt"), core.directory_tree)
+    assert command.execute() and core.inline_bytes == 6
+    assert command.undo() and core.inline_bytes == 0
+    assert command.execute() and core.inline_bytes == 6
+    # Still inlined after enough churn to exceed the budget several times over
+    assert core.directory_tree['children'][0]['file_data'] == b"bbbbbb"
+
+
+@pytest.mark.parametrize("compact_tree", [False, True])
+def test_child_index_follows_edits(tmp_path, compact_tree):
+    """Name and position lookups stay in step with a directory's children through edits and undo."""
+    from commands import AddFileCommand, RemoveNodeCommand, RenameNodeCommand
+    core = ISOCore(compact_tree=compact_tree)
+    root = core.directory_tree
+    for i in range(50):
+        path = tmp_path / f"file{i:02d}.txt"
+        path.write_bytes(b"x")
+        assert AddFileCommand(core, str(path), root).execute()
+    core.add_folder_to_directory("Sub", root)
+    core.add_folder_to_directory("SUB", root)  # same name in another case: ignored
+    assert len(root['children']) == 51
+
+    def check():
+        index = core.child_index(root)
+        for position, child in enumerate(root['children']):
+            assert index.position(child) == position
+            assert any(c is child for c in index.named(child['name'].upper()))
+
+    first = core.find_child(root, "FILE00.TXT")
+    remove = RemoveNodeCommand(core, first)
+    remove.execute()
+    assert core.find_child(root, "file00.txt") is None
+    check()
+    remove.undo()
+    assert root['children'][0] is first and core.find_child(root, "file00.txt") is first
+    check()
+
+    node = core.find_child(root, "file10.txt", is_directory=False)
+    RenameNodeCommand(node, "file10.txt", "renamed.txt", core=core).execute()
+    assert core.find_child(root, "file10.txt") is None
+    assert core.find_child(root, "Renamed.TXT") is node
+    assert core.find_child(root, "sub", is_directory=False) is None
+
+    # Adding a file of an existing name replaces the entry in place of a second one.
+    core.add_file_to_directory(str(tmp_path / "file20.txt"), root)
+    assert len(core.child_index(root).named("file20.txt")) == 1
+    assert len(root['children']) == 51
+    check()
+
+
+
+@pytest.mark.parametrize("compact_tree", [False, True])
+def test_tree_stats_follow_edits(tmp_path, compact_tree):
+    """Directory totals are updated along the parent chain instead of recomputed."""
+    from iso_logic import TreeStats
+    from commands import RemoveNodeCommand, RenameNodeCommand
+    core = ISOCore(compact_tree=compact_tree)
+    root = core.directory_tree
+    core.add_folder_to_directory("sub", root)
+    sub = core.find_child(root, "sub")
+    core.add_folder_to_directory("deep", sub)
+    deep = core.find_child(sub, "deep")
+    for name, size, target in (("a.bin", 10, root), ("b.bin", 2049, sub), ("c.bin", 0, deep)):
+        (tmp_path / name).write_bytes(b"x" * size)
+        core.add_file_to_directory(str(tmp_path / name), target)
+
+    assert core.tree_stats(compute=False) is None
+    assert core.tree_stats() == TreeStats(files=3, directories=2, size=2059, sectors=3)
+    assert core.tree_stats(sub, compute=False) == TreeStats(2, 1, 2049, 2)
+
+    def fresh():
+        files = [size for _, is_directory, size in core.iter_entries() if not is_directory]
+        return TreeStats(len(files), sum(1 for _, d, _ in core.iter_entries() if d),
+                         sum(files), sum(-(-size // 2048) for size in files))
+
+    (tmp_path / "d.bin").write_bytes(b"y" * 5000)
+    core.add_file_to_directory(str(tmp_path / "d.bin"), deep)
+    core.add_file_to_directory(str(tmp_path / "b.bin"), sub)  # replaces b.bin
+    assert core.tree_stats() == fresh() == TreeStats(4, 2, 7059, 6)
+
+    remove = RemoveNodeCommand(core, sub)
+    remove.execute()
+    assert core.tree_stats() == fresh() == TreeStats(1, 0, 10, 1)
+    remove.undo()
+    assert core.tree_stats() == fresh()
+    RenameNodeCommand(deep, "deep", "renamed", core=core).execute()
+    assert core.tree_stats(sub) == TreeStats(3, 1, 7049, 5)
+
+def test_deduplicated_save_links_identical_files(tmp_path):
+    """Identical files are written once and every name reads the same data back."""
+    from iso_logic import ISOBuilder, DEDUP_HEAD_SIZE
+    big = b"B" * (DEDUP_HEAD_SIZE + 10)
+    contents = {"a.bin": b"same" * 100, "b.bin": b"same" * 100, "c.bin": b"SAME" * 100,
+                "big1.bin": big + b"1", "big2.bin": big + b"2", "big3.bin": big + b"1"}
+    for name, data in contents.items():
+        (tmp_path / name).write_bytes(data)
+    core = ISOCore()
+    core.add_folder_to_directory("sub", core.directory_tree)
+    sub = core.find_child(core.directory_tree, "sub")
+    for name in contents:
+        core.add_file_to_directory(str(tmp_path / name), sub if name.startswith("b") else core.directory_tree)
+    # The same source file added twice is identical without being read.
+    core.add_file_to_directory(str(tmp_path / "big1.bin"), core.directory_tree)
+
+    output = tmp_path / "dedup.iso"
+    builder = ISOBuilder(core.directory_tree, str(output), core=core, deduplicate=True)
+    builder.build()
+    assert builder.deduplicated_files == 3
+    assert builder.deduplicated_bytes == 400 + 2 * len(big + b"1")
+
+    loaded = ISOCore()
+    loaded.load_iso(str(output))
+    for name, data in contents.items():
+        path = f"/sub/{name}" if name.startswith("b") else f"/{name}"
+        assert loaded.get_file_data(loaded.find_node_by_path(path)) == data
+    assert loaded.get_file_data(loaded.find_node_by_path("/big1.bin")) == big + b"1"
+
+
+def test_deduplicated_save_of_a_compact_tree(tmp_path):
+    """Duplicates are matched to their own primaries when the tree's node handles come and go."""
+    import gc
+    contents = {f"f{n:03d}.bin": bytes([65 + n % 3]) * (300 + n % 3) for n in range(200)}
+    source = ISOCore()
+    for name, data in contents.items():
+        (tmp_path / name).write_bytes(data)
+        source.add_file_to_directory(str(tmp_path / name), source.directory_tree)
+    source.save_iso(str(tmp_path / "source.iso"), use_joliet=True, use_rock_ridge=True)
+
+    core = ISOCore(compact_tree=True)
+    core.load_iso(str(tmp_path / "source.iso"))
+    gc.collect()
+    output = tmp_path / "dedup.iso"
+    core.save_iso(str(output), use_joliet=True, use_rock_ridge=True, deduplicate=True)
+
+    loaded = ISOCore()
+    loaded.load_iso(str(output))
+    for name, data in contents.items():
+        assert loaded.get_file_data(loaded.find_node_by_path(f"/{name}")) == data
+
+
+def test_builder_walks_deep_trees_in_pre_order(tmp_path):
+    """The build walk visits directories before their contents without recursing."""
+    import sys
+    from iso_logic import ISOBuilder
+    core = ISOCore()
+    folder = core.directory_tree
+    for depth in range(sys.getrecursionlimit() + 100):
+        core.add_folder_to_directory(f"level {depth}", folder)
+        folder = folder['children'][-1]
+    (tmp_path / "leaf.txt").write_bytes(b"leaf")
+    core.add_file_to_directory(str(tmp_path / "leaf.txt"), folder)
+
+    builder = ISOBuilder(core.directory_tree, str(tmp_path / "deep.iso"), core=core)
+    seen = set()
+    for joliet_path, iso9660_path, udf_path, node in builder._iter_nodes(core.directory_tree):
+        assert node['parent'] is core.directory_tree or id(node['parent']) in seen
+        seen.add(id(node))
+    assert joliet_path.startswith("/level 0/level 1/") and joliet_path.endswith("/leaf.txt")
+    assert iso9660_path.startswith("/LEVEL_0/LEVEL_1/") and iso9660_path.endswith("/LEAF.TXT")
+    assert udf_path == joliet_path
+    builder.build()
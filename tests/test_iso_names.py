@@ -0,0 +1,84 @@
+import pytest
+import iso_names
+from iso_logic import ISOCore, ISOBuilder
+
+
+def test_level_limits():
+    assert iso_names.iso9660_name("readme.txt") == "README.TXT"
+    assert iso_names.iso9660_name("long file name.html") == "LONG_FIL.HTM"
+    assert iso_names.iso9660_name("archive.tar.gz") == "ARCHIVE_.GZ"
+    assert iso_names.iso9660_name(".bashrc") == "_BASHRC"
+    assert iso_names.iso9660_name("my.folder", is_directory=True) == "MY_FOLDE"
+    assert iso_names.iso9660_name("long file name.html", level=3) == "LONG_FILE_NAME.HTML"
+    assert len(iso_names.iso9660_name("a" * 100 + ".txt", level=3)) == 31
+    assert len(iso_names.iso9660_name("d" * 100, is_directory=True, level=3)) == 31
+
+
+@pytest.mark.parametrize("order", [1, -1])
+def test_collisions_are_numbered_in_sorted_order(order):
+    names = ["longfilename2.txt", "README.TXT", "readme.txt", "longfilename1.txt"][::order]
+    mapped = dict(zip(names, iso_names.iso9660_names(names, [False] * 4)))
+    # The name that needs no change keeps it whatever the order
+    assert mapped == {"README.TXT": "README.TXT", "readme.txt": "README1.TXT",
+                      "longfilename1.txt": "LONGFILE.TXT", "longfilename2.txt": "LONGFIL1.TXT"}
+    assert iso_names.iso9660_names(["longfilename1.txt", "longfilename2.txt"], [False] * 2, level=3) == \
+        ["LONGFILENAME1.TXT", "LONGFILENAME2.TXT"]
+
+
+def test_joliet_names():
+    long_name = "x" * 70
+    mapped = iso_names.joliet_names([long_name + ".txt", long_name + ".TXT", "a:b", "A:B", "Short.txt"])
+    assert mapped == [long_name[:58] + "~1.txt", long_name[:60] + ".TXT", "a_b~1", "A_B", "Short.txt"]
+    assert all(len(name) <= 64 for name in mapped)
+
+
+def test_directory_cache_follows_renames(tmp_path):
+    core = ISOCore()
+    for name in ("first document.txt", "first draft.txt"):
+        (tmp_path / name).write_bytes(name.encode())
+        core.add_file_to_directory(str(tmp_path / name), core.directory_tree)
+    root = core.directory_tree
+    assert iso_names.directory_names(root)[0] == ["FIRST_DO.TXT", "FIRST_DR.TXT"]
+
+    core.rename_node(root['children'][1], "first donut.txt")
+    iso9660, joliet = iso_names.directory_names(root)
+    names = [child['name'] for child in root['children']]
+    assert dict(zip(names, iso9660)) == {"first document.txt": "FIRST_DO.TXT", "first donut.txt": "FIRST_D1.TXT"}
+    assert joliet == names
+
+
+def test_directory_names_are_cached_outside_the_tree(tmp_path):
+    core = ISOCore()
+    (tmp_path / "read me.txt").write_bytes(b"x")
+    core.add_file_to_directory(str(tmp_path / "read me.txt"), core.directory_tree)
+    root = core.directory_tree
+    keys = set(root)
+    cache = {}
+    first = iso_names.directory_names(root, cache=cache)
+    assert iso_names.directory_names(root, cache=cache)[0] is first[0]
+    assert first == (["READ_ME.TXT"], ["read me.txt"])
+    assert set(root) == keys
+
+
+def test_builder_keeps_colliding_names_apart(tmp_path):
+    core = ISOCore()
+    for name in ("report-2023.pdf", "report-2024.pdf"):
+        (tmp_path / name).write_bytes(name.encode())
+        core.add_file_to_directory(str(tmp_path / name), core.directory_tree)
+    output = tmp_path / "reports.iso"
+    core.save_iso(str(output), use_joliet=True, use_rock_ridge=True)
+
+    loaded = ISOCore()
+    loaded.load_iso(str(output))
+    files = {child['name']: loaded.get_file_data(child) for child in loaded.directory_tree['children']}
+    assert files == {"report-2023.pdf": b"report-2023.pdf", "report-2024.pdf": b"report-2024.pdf"}
+
+    builder = ISOBuilder(core.directory_tree, str(output), iso9660_level=3)
+    assert [path for _, path, _, _ in builder._iter_nodes(core.directory_tree)] == \
+        ["/REPORT_2023.PDF", "/REPORT_2024.PDF"]
+
+
+def test_non_compliant_names():
+    names = ["GOOD_NAME", "README.TXT", "bad-name", "archive.tar.gz", ".hidden", "café.txt",
+             "a_very_long_but_plain_name.txt"]
+    assert iso_names.non_compliant_names(names) == ["bad-name", "archive.tar.gz", ".hidden", "café.txt"]
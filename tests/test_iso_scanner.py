@@ -0,0 +1,99 @@
+import pytest
+from iso_logic import ISOCore
+import iso_scanner
+
+pytest.importorskip('_isoscan')
+
+
+def _node_summary(node, prefix=''):
+    """Flattens a loaded tree into (path, is_directory, is_hidden, size, date) tuples."""
+    rows = []
+    for child in sorted(node['children'], key=lambda n: n['name']):
+        path = f"{prefix}/{child['name']}"
+        size = 0 if child['is_directory'] else child['size']
+        rows.append((path, child['is_directory'], child['is_hidden'], size, child['date']))
+        if child['is_directory']:
+            rows.extend(_node_summary(child, path))
+    return rows
+
+
+def _build_image(tmp_path, **save_options):
+    """Creates an image with nested directories, an empty file and a boot image."""
+    core = ISOCore()
+    root = core.directory_tree
+    (tmp_path / "readme.txt").write_bytes(b"hello")
+    (tmp_path / "empty.dat").write_bytes(b"")
+    (tmp_path / "boot.img").write_bytes(b"\xeb" * 2048)
+    core.add_file_to_directory(str(tmp_path / "readme.txt"), root)
+    core.add_file_to_directory(str(tmp_path / "boot.img"), root)
+    core.add_folder_to_directory("docs", root)
+    docs = root['children'][-1]
+    core.add_folder_to_directory("nested", docs)
+    core.add_file_to_directory(str(tmp_path / "empty.dat"), docs['children'][-1])
+    core.boot_image_path = str(tmp_path / "boot.img")
+
+    output = tmp_path / "scan.iso"
+    core.save_iso(str(output), **save_options)
+    return str(output)
+
+
+def _load(path, monkeypatch, native):
+    core = ISOCore()
+    if not native:
+        monkeypatch.setattr(iso_scanner, 'scan_image', lambda file_path: None)
+    core.load_iso(path)
+    monkeypatch.undo()
+    return core
+
+
+@pytest.mark.parametrize("options", [
+    {'use_joliet': True, 'use_rock_ridge': True, 'use_udf': True},
+    {'use_joliet': True, 'use_rock_ridge': True, 'use_udf': False},
+    {'use_joliet': False, 'use_rock_ridge': True, 'use_udf': False},
+    {'use_joliet': False, 'use_rock_ridge': False, 'use_udf': False},
+])
+def test_native_scan_matches_pycdlib(tmp_path, monkeypatch, options):
+    """The native scanner must produce the same tree and metadata as pycdlib."""
+    path = _build_image(tmp_path, **options)
+
+    native = _load(path, monkeypatch, native=True)
+    reference = _load(path, monkeypatch, native=False)
+
+    assert native._image_scan is not None
+    assert native._walk_key == reference._walk_key
+    assert native.volume_descriptor == reference.volume_descriptor
+    assert native._incremental_base == reference._incremental_base
+    assert _node_summary(native.directory_tree) == _node_summary(reference.directory_tree)
+    assert native.extracted_boot_info == reference.extracted_boot_info
+
+
+def test_native_load_defers_pycdlib(tmp_path):
+    """pycdlib is only opened once file data is read."""
+    path = _build_image(tmp_path, use_joliet=True, use_rock_ridge=True)
+
+    core = ISOCore()
+    core.load_iso(path, lazy=True)
+    assert core._pycdlib is None
+
+    readme = next(n for n in core.directory_tree['children'] if n['name'].lower().startswith('readme'))
+    assert core.get_file_data(readme) == b"hello"
+    assert core._pycdlib is not None
+
+    core.close_iso()
+    assert core._pycdlib_instance is None
+
+
+def test_scan_declines_non_iso_files(tmp_path):
+    """Files that are not ISO 9660 images are left to pycdlib."""
+    junk = tmp_path / "junk.iso"
+    junk.write_bytes(b"\x00" * 40000)
+    assert iso_scanner.scan_image(str(junk)) is None
+
+    empty = tmp_path / "empty.iso"
+    empty.write_bytes(b"")
+    assert iso_scanner.scan_image(str(empty)) is None
+
+
+def test_scan_missing_file_raises(tmp_path):
+    with pytest.raises(FileNotFoundError):
+        iso_scanner.scan_image(str(tmp_path / "missing.iso"))
@@ -0,0 +1,69 @@
+import pytest
+import iso_cli
+from iso_logic import ISOCore, ImageTooLargeError
+from layout_planner import HYBRID_ALIGNMENT, fitting_media, plan_layout
+from constants import CD_SIZE_BYTES, DVD_SIZE_BYTES
+
+
+def _add_files(core, tmp_path, sizes, target=None):
+    for number, size in enumerate(sizes):
+        path = tmp_path / f"file{number:02d}.txt"
+        path.write_bytes(b"x" * size)
+        core.add_file_to_directory(str(path), target or core.directory_tree)
+
+
+def test_empty_image():
+    core = ISOCore()
+    # The sizes pycdlib gives a new image without files
+    assert core.plan_layout(use_joliet=False, use_rock_ridge=False, use_udf=False).total_sectors == 24
+    assert core.plan_layout(use_joliet=True, use_rock_ridge=False, use_udf=False).total_sectors == 30
+    assert core.plan_layout(use_joliet=False, use_rock_ridge=True, use_udf=False).total_sectors == 25
+
+
+def test_directory_records_and_file_data(tmp_path):
+    core = ISOCore()
+    # FILE00.TXT;1 records are 46 bytes: 43 fit next to . and .. in the first sector
+    _add_files(core, tmp_path, [0, 1, 2048, 2049] + [10] * 56)
+    plan = core.plan_layout(use_joliet=False, use_rock_ridge=False, use_udf=False)
+    assert plan.directories == 2
+    assert plan.file_data == 0 + 1 + 1 + 2 + 56
+
+    core.add_folder_to_directory("sub", core.directory_tree)
+    with_udf = core.plan_layout(use_joliet=True, use_rock_ridge=True, use_udf=True)
+    assert with_udf.directories > plan.directories and with_udf.joliet_directories >= 3
+    # Up to the partition; the file set descriptor and terminator; the root's file entry
+    # and 61 identifiers of 52 bytes; sub's file entry and identifiers; 60 files; the end anchor
+    assert with_udf.system_area + with_udf.descriptors + with_udf.udf == 257 + 2 + (1 + 2) + (1 + 1) + 60 + 1
+
+
+def test_boot_images_and_hybrid_padding(tmp_path):
+    core = ISOCore()
+    boot = tmp_path / "isolinux.bin"
+    boot.write_bytes(b"b" * 5000)
+    core.boot_image_path = str(boot)
+    plan = core.plan_layout(make_hybrid=True)
+    assert plan.boot == 1 + 3
+    assert plan.total_size % HYBRID_ALIGNMENT == 0 and plan.padding > 0
+    assert plan_layout(core.directory_tree, boot_images=[("isolinux.bin", 5000)]).padding == 0
+
+
+def test_fitting_media():
+    assert fitting_media(CD_SIZE_BYTES) == ["CD", "DVD", "DVD-DL", "BD"]
+    assert fitting_media(DVD_SIZE_BYTES + 1) == ["DVD-DL", "BD"]
+
+
+def test_too_large_image_is_not_written(tmp_path):
+    core = ISOCore()
+    _add_files(core, tmp_path, [100000])
+    output = tmp_path / "big.iso"
+    with pytest.raises(ImageTooLargeError) as info:
+        core.save_iso(str(output), use_joliet=True, use_rock_ridge=True, max_size=50000)
+    assert info.value.size > 100000 and not output.exists()
+
+
+def test_cli_dry_run(tmp_path, capsys):
+    (tmp_path / "src").mkdir()
+    (tmp_path / "src" / "a.txt").write_bytes(b"a" * 3000)
+    output = tmp_path / "out.iso"
+    assert iso_cli.main(["build", str(tmp_path / "src"), "-o", str(output), "--dry-run", "--media", "cd"]) == 0
+    assert "fits on CD, DVD" in capsys.readouterr().out and not output.exists()
@@ -0,0 +1,90 @@
+import pytest
+from iso_logic import ISOCore
+from node_store import NodeStore, NodeHandle
+from commands import CommandHistory, AddFileCommand, RemoveNodeCommand, RenameNodeCommand
+
+
+@pytest.fixture
+def compact_core():
+    """Provides an ISOCore that keeps its tree in a NodeStore."""
+    return ISOCore(compact_tree=True)
+
+
+def test_handles_behave_like_node_dicts():
+    store = NodeStore()
+    root = store.create_root({'name': '/', 'is_directory': True, 'is_hidden': False, 'size': 0,
+                              'date': 'Unknown', 'children': [], 'parent': None, 'iso_path': '/'})
+    root['children'].append({
+        'name': 'A.TXT;1', 'is_directory': False, 'is_hidden': True, 'size': 5,
+        'date': '2024-01-02 03:04:05', 'children': [], 'parent': root, 'iso_path': '/A.TXT;1',
+        'is_new': False, 'custom': 'kept'
+    })
+
+    child = root['children'][0]
+    assert isinstance(child, NodeHandle)
+    assert child['parent'] is root
+    assert root['parent'] is root
+    assert child['name'] == 'A.TXT;1'
+    assert child['is_hidden'] is True
+    assert child['size'] == 5
+    assert child['date'] == '2024-01-02 03:04:05'
+    assert child['custom'] == 'kept'
+    assert child.get('file_data') is None
+    assert 'children_loaded' not in child
+    assert child is root['children'][0]
+
+    # Renaming keeps the path the node has in the source image.
+    child['name'] = 'renamed.txt'
+    assert child['iso_path'] == '/A.TXT;1'
+
+
+def test_unparsed_dates_round_trip():
+    store = NodeStore()
+    root = store.create_root({'name': '/', 'is_directory': True, 'date': '', 'children': []})
+    assert root['date'] == ''
+    root['date'] = 'Unknown'
+    assert root['date'] == 'Unknown'
+
+
+def test_compact_tree_edit_and_undo(compact_core, tmp_path):
+    root = compact_core.directory_tree
+    file_path = tmp_path / "data.bin"
+    file_path.write_bytes(b"abc")
+    history = CommandHistory()
+
+    assert history.execute(AddFileCommand(compact_core, str(file_path), root))
+    node = root['children'][0]
+    assert node['file_data'] == b"abc" and node['is_new'] is True
+
+    assert history.execute(RenameNodeCommand(node, 'data.bin', 'other.bin'))
+    assert root['children'][0]['name'] == 'other.bin'
+
+    assert history.execute(RemoveNodeCommand(compact_core, node))
+    assert len(root['children']) == 0
+    history.undo()
+    assert root['children'][0] is node
+    history.undo()
+    assert node['name'] == 'data.bin'
+
+
+def test_compact_tree_save_and_load(compact_core, tmp_path):
+    (tmp_path / "a.txt").write_bytes(b"alpha")
+    (tmp_path / "b.txt").write_bytes(b"beta")
+    root = compact_core.directory_tree
+    compact_core.add_folder_to_directory("sub", root)
+    compact_core.add_file_to_directory(str(tmp_path / "a.txt"), root)
+    compact_core.add_file_to_directory(str(tmp_path / "b.txt"), root['children'][0])
+    output = tmp_path / "compact.iso"
+    compact_core.save_iso(str(output), use_joliet=True, use_rock_ridge=True)
+
+    loaded = ISOCore(compact_tree=True)
+    loaded.load_iso(str(output), lazy=True)
+    assert isinstance(loaded.directory_tree, NodeHandle)
+
+    entries = sorted(loaded.iter_entries())
+    assert [(name, is_dir) for name, is_dir, _ in entries] == [('a.txt', False), ('b.txt', False), ('sub', True)]
+
+    sub = next(c for c in loaded.directory_tree['children'] if c['name'] == 'sub')
+    b_node = sub['children'][0]
+    assert loaded.get_file_data(b_node) == b"beta"
+    assert loaded.get_node_path(b_node) == '/sub/b.txt'
@@ -0,0 +1,69 @@
+import json
+import pytest
+import iso_cli
+import profiler
+from iso_logic import ISOCore, ExtractionEngine
+
+
+@pytest.fixture
+def active():
+    yield profiler.enable()
+    profiler.disable()
+
+
+def test_phases_and_counters_of_a_save_and_extract(tmp_path, active):
+    source = tmp_path / "a.bin"
+    source.write_bytes(b"a" * 5000)
+    core = ISOCore()
+    core.add_file_to_directory(str(source), core.directory_tree)
+    output = tmp_path / "out.iso"
+    core.save_iso(str(output), use_joliet=True, use_rock_ridge=True)
+
+    loaded = ISOCore()
+    loaded.load_iso(str(output))
+    ExtractionEngine(loaded, loaded.directory_tree, str(tmp_path / "extracted")).run()
+
+    report = active.report()
+    assert {'save', 'build', 'build.tree', 'build.write', 'load', 'extract'} <= set(report['phases'])
+    assert report['phases']['save']['calls'] == 1
+    assert report['phases']['save']['seconds'] >= report['phases']['build.write']['seconds']
+    # Read back from the image to extract it
+    assert report['counters']['bytes_read'] >= 5000
+    assert report['counters']['bytes_written'] >= output.stat().st_size + 5000
+    assert report['counters']['files'] == 2
+    assert set(report['throughput']) == {'bytes_read_per_second', 'bytes_written_per_second'}
+
+    events = active.trace()['traceEvents']
+    assert {event['name'] for event in events} >= {'build.write', 'extract'}
+    assert all(event['ph'] == 'X' and event['dur'] >= 0 for event in events)
+
+
+def test_disabled_profiling_records_nothing():
+    assert profiler.active() is None
+    with profiler.phase('anything'):
+        profiler.count('bytes_read', 10)
+    assert profiler.disable() is None
+
+
+def test_cli_report_and_trace(tmp_path):
+    (tmp_path / "src").mkdir()
+    (tmp_path / "src" / "a.txt").write_bytes(b"a" * 3000)
+    report_path, trace_path = tmp_path / "report.json", tmp_path / "trace.json"
+    assert iso_cli.main(["--profile", str(report_path), "--trace", str(trace_path),
+                         "build", str(tmp_path / "src"), "-o", str(tmp_path / "out.iso")]) == 0
+    report = json.loads(report_path.read_text())
+    assert {'import', 'build'} <= set(report['phases']) and report['counters']['files'] == 1
+    assert report['wall_seconds'] > 0
+    assert json.loads(trace_path.read_text())['traceEvents']
+    assert profiler.active() is None
+
+
+def test_throughput_meter(monkeypatch):
+    clock = iter([0.0, 1.0, 2.0, 10.0])
+    monkeypatch.setattr(profiler.time, 'monotonic', lambda: next(clock))
+    meter = profiler.ThroughputMeter(window=2.0)
+    assert meter.update(0) == 0.0
+    assert meter.update(1000) == 1000
+    assert meter.update(3000) == 1500
+    # Old samples leave the window
+    assert meter.update(3000) == 0.0
@@ -0,0 +1,64 @@
+import errno
+import hashlib
+import os
+import pytest
+import ripper
+from ripper import DiscRipper
+
+
+@pytest.fixture
+def disc(tmp_path):
+    """A 'disc' of 300 sectors that each start with their sector number."""
+    data = b"".join(i.to_bytes(4, 'little').ljust(2048, b"\xa5") for i in range(300))
+    path = tmp_path / "disc.bin"
+    path.write_bytes(data)
+    return str(path), data
+
+
+def test_rip_copies_and_hashes(disc, tmp_path):
+    source, data = disc
+    progress = []
+    rip = DiscRipper(source, str(tmp_path / "out.iso"), ['md5', 'sha256'], read_size=64 * 1024,
+                     progress_callback=lambda done, total: progress.append((done, total)))
+    rip.run()
+
+    assert (tmp_path / "out.iso").read_bytes() == data
+    assert rip.checksums == {'md5': hashlib.md5(data).hexdigest(), 'sha256': hashlib.sha256(data).hexdigest()}
+    assert progress[0] == (0, len(data)) and progress[-1] == (len(data), len(data))
+    assert rip.bad_sectors == []
+
+
+def test_rip_retries_and_maps_bad_sectors(disc, tmp_path, monkeypatch):
+    source, data = disc
+    real_preadv = os.preadv
+    attempts = {}
+
+    def flaky_preadv(fd, buffers, offset):
+        length = sum(len(b) for b in buffers)
+        sectors = range(offset // 2048, (offset + length + 2047) // 2048)
+        # Sector 100 never reads; sector 200 reads on its second attempt
+        if 100 in sectors or (200 in sectors and attempts.setdefault(offset, 0) < 1):
+            attempts[offset] = attempts.get(offset, 0) + 1
+            raise OSError(errno.EIO, "Input/output error")
+        return real_preadv(fd, buffers, offset)
+
+    monkeypatch.setattr(ripper.os, 'preadv', flaky_preadv)
+    rip = DiscRipper(source, str(tmp_path / "out.iso"), read_size=32 * 2048)
+    rip.run()
+
+    output = (tmp_path / "out.iso").read_bytes()
+    assert rip.bad_sectors == [100]
+    assert output[100 * 2048:101 * 2048] == bytes(2048)
+    assert output[:100 * 2048] == data[:100 * 2048] and output[101 * 2048:] == data[101 * 2048:]
+    rip.write_bad_sector_map(str(tmp_path / "out.iso.badsectors"))
+    assert (tmp_path / "out.iso.badsectors").read_text().splitlines()[1:] == ["100"]
+
+
+def test_rip_cancel_removes_output(disc, tmp_path):
+    source, _ = disc
+    output = tmp_path / "out.iso"
+    rip = DiscRipper(source, str(output), read_size=2048,
+                     progress_callback=lambda done, total: done > 10 * 2048 and rip.cancel())
+    with pytest.raises(InterruptedError):
+        rip.run()
+    assert not output.exists()
@@ -0,0 +1,96 @@
+import os
+import threading
+import time
+import scheduler
+from scheduler import (JobScheduler, PRIORITY_INTERACTIVE, PRIORITY_NORMAL, PRIORITY_BACKGROUND,
+                       FINISHED, FAILED, CANCELLED)
+
+
+def test_jobs_on_one_device_are_serialized(monkeypatch):
+    # Paths name their device: 'a/...' is on device a
+    monkeypatch.setattr(scheduler, 'device_of', lambda path: path.split('/')[0])
+    jobs = JobScheduler(max_workers=4)
+    lock = threading.Lock()
+    running = {'a': 0, 'b': 0}
+    peaks = {'a': 0, 'b': 0}
+    both = threading.Barrier(2, timeout=5)
+
+    def work(device, meet):
+        def run(job):
+            with lock:
+                running[device] += 1
+                peaks[device] = max(peaks[device], running[device])
+            if meet:
+                # Only returns if a job on the other device runs at the same time
+                both.wait()
+            with lock:
+                running[device] -= 1
+        return run
+
+    submitted = [jobs.submit(work('a', n == 0), paths=['a/x.iso']) for n in range(3)]
+    submitted.append(jobs.submit(work('b', True), paths=['b/y.iso']))
+    for job in submitted:
+        assert job.wait(5) and job.state == FINISHED
+    assert peaks == {'a': 1, 'b': 1}
+    jobs.shutdown()
+
+
+def test_idle_worker_does_not_hold_back_other_devices(monkeypatch):
+    monkeypatch.setattr(scheduler, 'device_of', lambda path: path.split('/')[0])
+    jobs = JobScheduler(max_workers=2)
+    assert jobs.submit(lambda job: None).wait(5)
+    while jobs._idle != 1:
+        time.sleep(0.001)
+    both = threading.Barrier(2, timeout=5)
+    submitted = [jobs.submit(lambda job: both.wait(), paths=[f'{device}/x.iso']) for device in 'ab']
+    for job in submitted:
+        assert job.wait(5) and job.state == FINISHED
+    jobs.shutdown()
+
+
+def test_priorities_order_the_queue(tmp_path):
+    jobs = JobScheduler(max_workers=1)
+    started, release = threading.Event(), threading.Event()
+    order = []
+    blocker = jobs.submit(lambda job: started.set() or release.wait(5))
+    assert started.wait(5)
+    for name, priority in (('hash', PRIORITY_BACKGROUND), ('save', PRIORITY_NORMAL), ('load', PRIORITY_INTERACTIVE)):
+        jobs.submit(lambda job: order.append(job.name), name=name, paths=[str(tmp_path)], priority=priority)
+    assert [job.name for job in jobs.jobs()] == ['job', 'load', 'save', 'hash']
+    release.set()
+    jobs.shutdown()
+    assert blocker.state == FINISHED and order == ['load', 'save', 'hash']
+
+
+def test_cancel_progress_and_failures(tmp_path):
+    jobs = JobScheduler(max_workers=1)
+    started, stopped = threading.Event(), threading.Event()
+    progress = []
+
+    def long_running(job):
+        job.on_cancel(stopped.set)
+        job.report(1, 10)
+        started.set()
+        stopped.wait(5)
+        if job.is_cancelled():
+            raise InterruptedError("cancelled")
+
+    running = jobs.submit(long_running, paths=[str(tmp_path)])
+    running.on_progress(lambda job: progress.append((job.done_bytes, job.total_bytes)))
+    queued = jobs.submit(lambda job: progress.append('ran'))
+    done = []
+    queued.on_done(done.append)
+    assert started.wait(5)
+    queued.cancel()
+    assert queued.state == CANCELLED and done == [queued] and not queued.started
+    running.cancel()
+    assert running.wait(5) and running.state == CANCELLED and isinstance(running.exception, InterruptedError)
+
+    failing = jobs.submit(lambda job: 1 / 0)
+    assert failing.wait(5) and failing.state == FAILED and isinstance(failing.exception, ZeroDivisionError)
+    jobs.shutdown()
+    assert 'ran' not in progress
+
+
+def test_device_of_missing_output(tmp_path):
+    assert scheduler.device_of(str(tmp_path / "new" / "out.iso")) == os.stat(tmp_path).st_dev
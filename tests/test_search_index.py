@@ -0,0 +1,88 @@
+import pytest
+from iso_logic import ISOCore
+from commands import RemoveNodeCommand, RenameNodeCommand
+from search_index import SearchIndex, SearchQuery
+
+
+def _find(index, text, **kwargs):
+    query = SearchQuery(text, **kwargs)
+    # Names are compared in lower case, as they depend on the namespace the image is read from
+    return sorted(node['name'].lower() for node in index.resolve(index.search(query), query))
+
+
+@pytest.fixture
+def image_path(tmp_path):
+    """Saves an image with a few files in nested directories and returns its path."""
+    core = ISOCore()
+    for name in ("readme.txt", "setup.exe", "notes.md"):
+        (tmp_path / name).write_bytes(name.encode())
+    core.add_file_to_directory(str(tmp_path / "readme.txt"), core.directory_tree)
+    core.add_folder_to_directory("docs", core.directory_tree)
+    docs = core.directory_tree['children'][-1]
+    core.add_file_to_directory(str(tmp_path / "notes.md"), docs)
+    core.add_folder_to_directory("deep", docs)
+    core.add_file_to_directory(str(tmp_path / "setup.exe"), docs['children'][-1])
+    output = tmp_path / "search.iso"
+    core.save_iso(str(output), use_joliet=True, use_rock_ridge=True)
+    return str(output)
+
+
+def test_search_lazily_loaded_image(image_path):
+    core = ISOCore()
+    core.load_iso(image_path, lazy=True)
+    index = SearchIndex(core)
+    index.reset()
+    assert not index.wait_ready(0)
+    assert index.build()
+
+    assert _find(index, "SETUP") == ['setup.exe']
+    assert _find(index, "e") == ['deep', 'notes.md', 'readme.txt', 'setup.exe']
+    assert _find(index, r"^[a-z]+\.exe$", use_regex=True) == ['setup.exe']
+
+    # Resolving a match loads the directories above it.
+    match = index.resolve(index.search(SearchQuery("setup")), SearchQuery("setup"))[0]
+    assert match['parent']['parent']['name'].lower() == 'docs'
+    assert _find(index, match['name'][:5], case_sensitive=True) == ['setup.exe']
+    assert _find(index, match['name'][:5].swapcase(), case_sensitive=True) == []
+    with pytest.raises(Exception):
+        SearchQuery("(", use_regex=True)
+
+
+def test_search_follows_edits(image_path, tmp_path):
+    core = ISOCore()
+    core.load_iso(image_path, lazy=True)
+    index = SearchIndex(core)
+    index.reset()
+    index.build()
+
+    (tmp_path / "report.pdf").write_bytes(b"pdf")
+    core.add_file_to_directory(str(tmp_path / "report.pdf"), core.directory_tree)
+    assert _find(index, "report") == ['report.pdf']
+
+    readme = next(c for c in core.directory_tree['children'] if c['name'].lower().startswith('readme'))
+    rename = RenameNodeCommand(readme, readme['name'], 'intro.txt', core=core)
+    rename.execute()
+    assert _find(index, "readme") == []
+    assert _find(index, "intro") == ['intro.txt']
+    rename.undo()
+    assert _find(index, "readme") == ['readme.txt']
+
+    docs = next(c for c in core.directory_tree['children'] if c['name'].lower() == 'docs')
+    remove = RemoveNodeCommand(core, docs)
+    remove.execute()
+    assert _find(index, "setup") == []
+    remove.undo()
+    assert _find(index, "setup") == ['setup.exe']
+
+
+def test_search_new_image_is_ready_at_once(tmp_path):
+    core = ISOCore()
+    (tmp_path / "a.bin").write_bytes(b"a")
+    core.add_file_to_directory(str(tmp_path / "a.bin"), core.directory_tree)
+    index = SearchIndex(core)
+    index.reset()
+    assert index.wait_ready(0)
+    assert _find(index, "a.b") == ['a.bin']
+    core.remove_node(core.directory_tree['children'][0])
+    assert _find(index, "a.b") == []
+    assert len(index) == 0
@@ -0,0 +1,75 @@
+import pytest
+
+pytest.importorskip("PySide6")
+
+from iso_logic import ISOCore
+from commands import RenameNodeCommand
+from tree_model import ISOTreeModel
+
+
+def _names(model, parent):
+    return [model.data(model.index(row, 0, parent)) for row in range(model.rowCount(parent))]
+
+
+@pytest.fixture
+def populated(tmp_path):
+    """A core with seven files and one folder in the root, shown through a model fetching three rows at a time."""
+    core = ISOCore()
+    for name in "gfedcba":
+        path = tmp_path / f"{name}.txt"
+        path.write_bytes(name.encode())
+        core.add_file_to_directory(str(path), core.directory_tree)
+    core.add_folder_to_directory("sub", core.directory_tree)
+    model = ISOTreeModel(core, lambda size: f"{size} B", batch_size=3)
+    return core, model
+
+
+def test_rows_are_fetched_in_batches(populated):
+    core, model = populated
+    root = model.index(0, 0)
+    assert model.data(root) == '/'
+    assert model.rowCount(root) == 0 and model.canFetchMore(root)
+
+    model.fetchMore(root)
+    assert _names(model, root) == ['sub [NEW]', 'a.txt [NEW]', 'b.txt [NEW]']
+    while model.canFetchMore(root):
+        model.fetchMore(root)
+    assert model.rowCount(root) == 8
+    assert model.data(model.index(1, 1, root)) == "1 B"
+    assert model.node_from_index(model.index(0, 0, root)) is core.directory_tree['children'][-1]
+
+
+def test_edits_update_rows_in_place(populated, tmp_path):
+    core, model = populated
+    root = model.index(0, 0)
+    model.fetchMore(root)
+
+    # Sorts into the fetched rows.
+    (tmp_path / "aa.txt").write_bytes(b"aa")
+    core.add_file_to_directory(str(tmp_path / "aa.txt"), core.directory_tree)
+    assert _names(model, root) == ['sub [NEW]', 'a.txt [NEW]', 'aa.txt [NEW]', 'b.txt [NEW]']
+
+    # Moves past the fetched rows, then back to the top.
+    node = core.directory_tree['children'][-1]
+    RenameNodeCommand(node, 'aa.txt', 'zz.txt', core=core).execute()
+    assert model.rowCount(root) == 3
+    RenameNodeCommand(node, 'zz.txt', '0.txt', core=core).execute()
+    assert _names(model, root)[:2] == ['sub [NEW]', '0.txt [NEW]']
+
+    core.remove_node(node)
+    assert _names(model, root) == ['sub [NEW]', 'a.txt [NEW]', 'b.txt [NEW]']
+    assert not model.index_from_node(node).isValid()
+
+
+def test_visible_nodes_filter(populated):
+    core, model = populated
+    match = next(c for c in core.directory_tree['children'] if c['name'] == 'c.txt')
+    model.set_visible_nodes([core.directory_tree, match])
+    root = model.index(0, 0)
+    model.fetchMore(root)
+    assert _names(model, root) == ['c.txt [NEW]']
+    assert not model.canFetchMore(root)
+
+    model.set_visible_nodes(None)
+    model.fetchMore(model.index(0, 0))
+    assert model.rowCount(model.index(0, 0)) == 3
@@ -0,0 +1,361 @@
+"""
+Qt item model over ISOCore.directory_tree.
+
+The model creates rows only for directories the view has expanded, in
+batches through canFetchMore()/fetchMore(). It listens to the core's tree
+edits (see iso_logic.TreeListener) and answers each one with a targeted
+rowsInserted, rowsRemoved, rowsMoved or dataChanged signal, so an edit
+costs time in the size of the touched directory, not of the whole tree.
+"""
+
+import logging
+from bisect import bisect_left, bisect_right
+from typing import Any, Callable, List, Optional, Set, Tuple
+
+from PySide6.QtCore import QAbstractItemModel, QModelIndex, Qt
+
+from constants import ITEM_TYPE_DIRECTORY, ITEM_TYPE_FILE, TREE_FETCH_BATCH_SIZE
+
+logger = logging.getLogger(__name__)
+
+TreeNode = Any
+SortKey = Tuple[bool, str]
+
+
+def sort_key(node: TreeNode) -> SortKey:
+    """Directories first, then files, both alphabetically ignoring case."""
+    return (not node.get('is_directory', False), node.get('name', '').lower())
+
+
+class _Entry:
+    """
+    One row of the model. Directory entries also hold their fetched rows and
+    the sorted children that have not been fetched yet.
+    """
+    __slots__ = ('node', 'parent', 'row', 'rows', 'keys', 'pending', 'pending_keys')
+
+    def __init__(self, node: Optional[TreeNode], parent: Optional['_Entry'], row: int) -> None:
+        self.node = node
+        self.parent = parent
+        self.row = row
+        # None until the directory is first fetched
+        self.rows: Optional[List['_Entry']] = None
+        self.keys: List[SortKey] = []
+        self.pending: List[TreeNode] = []
+        self.pending_keys: List[SortKey] = []
+
+
+class ISOTreeModel(QAbstractItemModel):
+    """
+    Presents the directory tree with the columns Name, Size, Date Modified and Type.
+
+    The root directory is the single top-level row. Children are sorted with
+    directories first; hidden entries are left out unless show_hidden is set.
+    """
+    HEADERS = ['Name', 'Size', 'Date Modified', 'Type']
+
+    def __init__(self, core: Any, size_formatter: Callable[[int], str],
+                 batch_size: int = TREE_FETCH_BATCH_SIZE, parent: Any = None) -> None:
+        """
+        Args:
+            core (ISOCore): The core whose directory_tree is shown.
+            size_formatter: Turns a size in bytes into the Size column text.
+            batch_size (int): Rows created per fetchMore() call.
+            parent (QObject): The Qt parent object.
+        """
+        super().__init__(parent)
+        self.core = core
+        self.size_formatter = size_formatter
+        self.batch_size = batch_size
+        self.show_hidden = False
+        # ids of the nodes to show while a search filter is active, and the
+        # nodes themselves: compact-tree handles are only cached weakly, and the
+        # id of a collected one can be reused by any other node
+        self._visible_ids: Optional[Set[int]] = None
+        self._visible_nodes: Optional[List[TreeNode]] = None
+        self._root = _Entry(None, None, 0)
+        self._entries = {}
+        self._build_root()
+        core.tree_listeners.append(self)
+
+    # --- Building -----------------------------------------------------------
+
+    def _build_root(self) -> None:
+        """Starts over with only the root directory row, or no rows if there is no tree."""
+        self._root = _Entry(None, None, 0)
+        self._root.rows = []
+        self._entries = {}
+        tree = self.core.directory_tree
+        if tree is not None:
+            self._root.rows.append(self._new_entry(tree, self._root, 0))
+            self._root.keys.append(sort_key(tree))
+
+    def _new_entry(self, node: TreeNode, parent: _Entry, row: int) -> _Entry:
+        entry = _Entry(node, parent, row)
+        self._entries[id(node)] = entry
+        return entry
+
+    def _drop_entries(self, entry: _Entry) -> None:
+        """Forgets an entry and every fetched entry below it."""
+        stack = [entry]
+        while stack:
+            current = stack.pop()
+            if self._entries.get(id(current.node)) is current:
+                del self._entries[id(current.node)]
+            if current.rows:
+                stack.extend(current.rows)
+
+    def _is_visible(self, node: TreeNode) -> bool:
+        if node.get('is_hidden') and not self.show_hidden:
+            return False
+        return self._visible_ids is None or id(node) in self._visible_ids
+
+    def reset(self) -> None:
+        """Rebuilds the model from core.directory_tree, e.g. after an image was loaded."""
+        self.beginResetModel()
+        self._build_root()
+        self.endResetModel()
+
+    def clear(self) -> None:
+        """Shows nothing, e.g. while a background load replaces the tree."""
+        self.beginResetModel()
+        self._root = _Entry(None, None, 0)
+        self._root.rows = []
+        self._entries = {}
+        self.endResetModel()
+
+    def set_show_hidden(self, show_hidden: bool) -> None:
+        """Shows or hides entries with the hidden flag."""
+        if show_hidden != self.show_hidden:
+            self.show_hidden = show_hidden
+            self.reset()
+
+    def set_visible_nodes(self, nodes: Optional[List[TreeNode]]) -> None:
+        """
+        Restricts the model to the given nodes, e.g. search matches and their
+        ancestors; None shows everything again.
+        """
+        self._visible_nodes = None if nodes is None else list(nodes)
+        self._visible_ids = None if nodes is None else {id(node) for node in self._visible_nodes}
+        self.reset()
+
+    # --- Lookups ------------------------------------------------------------
+
+    def _entry(self, index: QModelIndex) -> _Entry:
+        return index.internalPointer() if index.isValid() else self._root
+
+    def _index_of(self, entry: _Entry, column: int = 0) -> QModelIndex:
+        if entry is self._root:
+            return QModelIndex()
+        return self.createIndex(entry.row, column, entry)
+
+    def node_from_index(self, index: QModelIndex) -> Optional[TreeNode]:
+        """Returns the tree node shown at an index, or None for an invalid index."""
+        return index.internalPointer().node if index.isValid() else None
+
+    def index_from_node(self, node: TreeNode) -> QModelIndex:
+        """Returns the index of a node, or an invalid index if its row has not been created yet."""
+        entry = self._entries.get(id(node))
+        return self._index_of(entry) if entry else QModelIndex()
+
+    # --- QAbstractItemModel -------------------------------------------------
+
+    def index(self, row: int, column: int, parent: QModelIndex = QModelIndex()) -> QModelIndex:
+        parent_entry = self._entry(parent)
+        rows = parent_entry.rows
+        if rows is None or not 0 <= row < len(rows) or not 0 <= column < len(self.HEADERS):
+            return QModelIndex()
+        return self.createIndex(row, column, rows[row])
+
+    def parent(self, index: QModelIndex = QModelIndex()) -> QModelIndex:
+        if not index.isValid():
+            return QModelIndex()
+        return self._index_of(index.internalPointer().parent)
+
+    def rowCount(self, parent: QModelIndex = QModelIndex()) -> int:
+        if parent.column() > 0:
+            return 0
+        rows = self._entry(parent).rows
+        return len(rows) if rows is not None else 0
+
+    def columnCount(self, parent: QModelIndex = QModelIndex()) -> int:
+        return len(self.HEADERS)
+
+    def hasChildren(self, parent: QModelIndex = QModelIndex()) -> bool:
+        entry = self._entry(parent)
+        if entry is self._root:
+            return bool(entry.rows)
+        node = entry.node
+        if not node.get('is_directory'):
+            return False
+        if entry.rows is not None:
+            return bool(entry.rows or entry.pending)
+        return bool(node.get('children')) or not node.get('children_loaded', True)
+
+    def canFetchMore(self, parent: QModelIndex) -> bool:
+        entry = self._entry(parent)
+        if entry is self._root or not entry.node.get('is_directory'):
+            return False
+        return entry.rows is None or bool(entry.pending)
+
+    def fetchMore(self, parent: QModelIndex) -> None:
+        entry = self._entry(parent)
+        if entry is self._root or not entry.node.get('is_directory'):
+            return
+        if entry.rows is None:
+            children = [c for c in self.core.load_children(entry.node) if self._is_visible(c)]
+            children.sort(key=sort_key)
+            entry.rows = []
+            entry.pending = children
+            entry.pending_keys = [sort_key(c) for c in children]
+
+        count = min(self.batch_size, len(entry.pending))
+        if not count:
+            return
+        first = len(entry.rows)
+        self.beginInsertRows(parent, first, first + count - 1)
+        for offset, node in enumerate(entry.pending[:count]):
+            entry.rows.append(self._new_entry(node, entry, first + offset))
+        entry.keys.extend(entry.pending_keys[:count])
+        del entry.pending[:count]
+        del entry.pending_keys[:count]
+        self.endInsertRows()
+
+    def data(self, index: QModelIndex, role: int = Qt.DisplayRole) -> Any:
+        if not index.isValid() or role != Qt.DisplayRole:
+            return None
+        entry = index.internalPointer()
+        node = entry.node
+        column = index.column()
+        if entry.parent is self._root:
+            return ['/', '', node.get('date', ''), ITEM_TYPE_DIRECTORY][column]
+        if column == 0:
+            return node.get('name', '') + (" [NEW]" if node.get('is_new') else "")
+        if column == 1:
+            return '' if node.get('is_directory') else self.size_formatter(node.get('size', 0))
+        if column == 2:
+            return node.get('date', '')
+        return ITEM_TYPE_DIRECTORY if node.get('is_directory') else ITEM_TYPE_FILE
+
+    def headerData(self, section: int, orientation: Qt.Orientation, role: int = Qt.DisplayRole) -> Any:
+        if orientation == Qt.Horizontal and role == Qt.DisplayRole and 0 <= section < len(self.HEADERS):
+            return self.HEADERS[section]
+        return None
+
+    # --- TreeListener -------------------------------------------------------
+
+    def node_inserted(self, parent: TreeNode, node: TreeNode) -> None:
+        parent_entry = self._entries.get(id(parent))
+        if parent_entry is None or not self._is_visible(node):
+            return
+        if parent_entry.rows is None:
+            siblings = [c for c in parent_entry.node.get('children', []) if c is not node and self._is_visible(c)]
+            if siblings or not parent_entry.node.get('children_loaded', True):
+                # Still collapsed with an expander; the first fetch picks the node up.
+                return
+            # The directory was empty: insert a row so the view shows an expander.
+            parent_entry.rows = []
+        self._insert(parent_entry, node)
+
+    def node_removed(self, parent: TreeNode, node: TreeNode) -> None:
+        entry = self._entries.get(id(node))
+        if entry is not None and entry.parent is not None and entry.parent.node is parent:
+            self._remove_row(entry)
+            return
+        parent_entry = self._entries.get(id(parent))
+        if parent_entry is not None:
+            self._remove_pending(parent_entry, node)
+
+    def node_changed(self, node: TreeNode) -> None:
+        entry = self._entries.get(id(node))
+        if entry is None:
+            parent_entry = self._entries.get(id(node.get('parent')))
+            if parent_entry is not None and self._remove_pending(parent_entry, node):
+                self._insert(parent_entry, node)
+            return
+
+        parent_entry = entry.parent
+        if parent_entry is self._root:
+            self._emit_row_changed(entry)
+            return
+        key = sort_key(node)
+        row = entry.row
+        del parent_entry.keys[row]
+        if parent_entry.pending and key >= parent_entry.pending_keys[0]:
+            # It now sorts after the fetched rows.
+            parent_entry.keys.insert(row, key)
+            self._remove_row(entry)
+            self._insert_pending(parent_entry, node, key)
+            return
+
+        new_row = bisect_right(parent_entry.keys, key)
+        if new_row == row:
+            parent_entry.keys.insert(row, key)
+            self._emit_row_changed(entry)
+            return
+
+        parent_index = self._index_of(parent_entry)
+        # Qt counts the destination in rows before the move.
+        destination = new_row if new_row < row else new_row + 1
+        if not self.beginMoveRows(parent_index, row, row, parent_index, destination):
+            parent_entry.keys.insert(row, key)
+            self._emit_row_changed(entry)
+            return
+        rows = parent_entry.rows
+        rows.pop(row)
+        rows.insert(new_row, entry)
+        parent_entry.keys.insert(new_row, key)
+        for i in range(min(row, new_row), max(row, new_row) + 1):
+            rows[i].row = i
+        self.endMoveRows()
+        self._emit_row_changed(entry)
+
+    # --- Row bookkeeping ----------------------------------------------------
+
+    def _insert(self, parent_entry: _Entry, node: TreeNode) -> None:
+        """Inserts a node at its sorted position, as a row or among the unfetched children."""
+        key = sort_key(node)
+        if parent_entry.pending and key >= parent_entry.pending_keys[0]:
+            self._insert_pending(parent_entry, node, key)
+            return
+        row = bisect_right(parent_entry.keys, key)
+        self.beginInsertRows(self._index_of(parent_entry), row, row)
+        parent_entry.rows.insert(row, self._new_entry(node, parent_entry, row))
+        parent_entry.keys.insert(row, key)
+        for i in range(row + 1, len(parent_entry.rows)):
+            parent_entry.rows[i].row = i
+        self.endInsertRows()
+
+    @staticmethod
+    def _insert_pending(parent_entry: _Entry, node: TreeNode, key: SortKey) -> None:
+        position = bisect_right(parent_entry.pending_keys, key)
+        parent_entry.pending.insert(position, node)
+        parent_entry.pending_keys.insert(position, key)
+
+    @staticmethod
+    def _remove_pending(parent_entry: _Entry, node: TreeNode) -> bool:
+        """Removes a node from the unfetched children; returns True if it was there."""
+        pending = parent_entry.pending
+        # Keys can be stale after a rename, so look the node up by identity.
+        start = bisect_left(parent_entry.pending_keys, sort_key(node))
+        order = list(range(start, len(pending))) + list(range(start))
+        for position in order:
+            if pending[position] is node:
+                del pending[position]
+                del parent_entry.pending_keys[position]
+                return True
+        return False
+
+    def _remove_row(self, entry: _Entry) -> None:
+        parent_entry = entry.parent
+        row = entry.row
+        self.beginRemoveRows(self._index_of(parent_entry), row, row)
+        del parent_entry.rows[row]
+        del parent_entry.keys[row]
+        for i in range(row, len(parent_entry.rows)):
+            parent_entry.rows[i].row = i
+        self._drop_entries(entry)
+        self.endRemoveRows()
+
+    def _emit_row_changed(self, entry: _Entry) -> None:
+        self.dataChanged.emit(self._index_of(entry, 0), self._index_of(entry, len(self.HEADERS) - 1))